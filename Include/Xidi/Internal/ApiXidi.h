@@ -35,7 +35,10 @@ namespace Xidi
       ImportFunctions,
 
       /// IImportFunctions2
-      ImportFunctions2
+      ImportFunctions2,
+
+      /// IMappers
+      Mappers
     };
 
     /// Xidi API base class. All API classes must inherit from this class.
@@ -111,6 +114,24 @@ namespace Xidi
       inline IImportFunctions2(void) : IXidi(EClass::ImportFunctions2) {}
     };
 
+    /// Xidi API class for managing the mappers that Xidi uses to map physical controllers to virtual
+    /// controllers.
+    class IMappers : public IXidi
+    {
+    public:
+
+      /// Reads the configuration file again and replaces the mappers in use with the ones it
+      /// specifies, including any custom mappers it defines. Takes effect without needing to
+      /// restart the application. Other settings in the configuration file are not reloaded.
+      /// @return `true` if the mappers were reloaded, `false` if there were errors, in which case
+      /// the mappers in use are unchanged.
+      virtual bool ReloadMappers(void) = 0;
+
+    protected:
+
+      inline IMappers(void) : IXidi(EClass::Mappers) {}
+    };
+
     /// Interface for accessing and replacing the functions for a single library's import table.
     class IMutableImportTable
     {
@@ -11,90 +11,251 @@
 
 #pragma once
 
-#include <condition_variable>
-#include <shared_mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <stop_token>
+#include <thread>
+#include <type_traits>
 
 namespace Xidi
 {
   /// Wraps data in a way that is concurrency-safe following a single-producer multiple-consumer
-  /// threading model.
+  /// threading model. Implemented as a sequence lock, which means readers never block the producer
+  /// and never block each other. Instead, a reader that happens to overlap with a write simply
+  /// retries its read. This is suitable for small trivially-copyable data types that are read much
+  /// more frequently than they are written. The sequence number also identifies the generation of
+  /// the data, which advances with each write. Threads waiting for updates keep the generation they
+  /// last observed and block until it advances, so neither waiting nor updating requires any locks.
   /// @tparam DataType Underlying wrapped data type.
   template <typename DataType> class ConcurrencyWrapper
   {
+    static_assert(
+        std::is_trivially_copyable_v<DataType>,
+        "Wrapped data type must be trivially copyable.");
+
   public:
 
-    /// Retrieves and returns the stored data in a concurrency-safe way.
+    /// Identifies a particular version of the wrapped data. Advances by one with each write.
+    using TGeneration = uint32_t;
+
+    inline ConcurrencyWrapper(void)
+        : sequence(0), dataWords(), waiterCount(0), lastWrittenData()
+    {
+      TDataWord initialDataWords[kDataWordCount] = {};
+      std::memcpy(initialDataWords, &lastWrittenData, sizeof(lastWrittenData));
+
+      for (size_t i = 0; i < kDataWordCount; ++i)
+        dataWords[i].store(initialDataWords[i], std::memory_order_relaxed);
+    }
+
+    /// Retrieves and returns the stored data in a concurrency-safe way. Never blocks, but may need
+    /// to retry if the read overlaps with a write.
     /// @return Underlying wrapped data.
-    inline DataType Get(void)
+    inline DataType Get(void) const
+    {
+      TGeneration generation = 0;
+      return Get(generation);
+    }
+
+    /// Retrieves and returns the stored data in a concurrency-safe way, along with their
+    /// generation. Never blocks, but may need to retry if the read overlaps with a write.
+    /// @param [out] generation Filled in with the generation of the data that were read.
+    /// @return Underlying wrapped data.
+    inline DataType Get(TGeneration& generation) const
+    {
+      TDataWord readDataWords[kDataWordCount];
+      uint32_t sequenceBeforeRead = 0;
+      uint32_t sequenceAfterRead = 0;
+
+      do
+      {
+        // A write in progress means there is no point in trying to read the data words until the
+        // write completes.
+        sequenceBeforeRead = sequence.load(std::memory_order_acquire);
+        while (0 != (sequenceBeforeRead & kSequenceWriteInProgress))
+        {
+          std::this_thread::yield();
+          sequenceBeforeRead = sequence.load(std::memory_order_acquire);
+        }
+
+        for (size_t i = 0; i < kDataWordCount; ++i)
+          readDataWords[i] = dataWords[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        sequenceAfterRead = sequence.load(std::memory_order_relaxed);
+      }
+      while ((sequenceBeforeRead & ~kSequenceWakeToggle) !=
+             (sequenceAfterRead & ~kSequenceWakeToggle));
+
+      generation = GenerationFromSequence(sequenceBeforeRead);
+
+      DataType readData;
+      std::memcpy(&readData, readDataWords, sizeof(readData));
+      return readData;
+    }
+
+    /// Retrieves the generation of the stored data without reading the data themselves.
+    /// @return Generation of the stored data.
+    inline TGeneration GetGeneration(void) const
     {
-      std::shared_lock lock(mutex);
-      return data;
+      return GenerationFromSequence(sequence.load(std::memory_order_acquire));
     }
 
-    /// Writes to the stored data in a concurrency-safe way.
+    /// Writes to the stored data in a concurrency-safe way, advances the generation, and notifies
+    /// all waiting threads of the change.
     /// @param [in] newData New data to be stored.
     inline void Set(const DataType& newData)
     {
-      std::unique_lock lock(mutex);
-      data = newData;
+      lastWrittenData = newData;
+
+      TDataWord newDataWords[kDataWordCount] = {};
+      std::memcpy(newDataWords, &newData, sizeof(newData));
+      SetDataWords(newDataWords);
     }
 
-    /// Updates the stored data in a concurrency-safe way and notifies all waiting threads of the
-    /// change. Operations are conditional on the new data being different than the currently-stored
-    /// data.
+    /// Updates the stored data in a concurrency-safe way, advances the generation, and notifies
+    /// all waiting threads of the change. Operations are conditional on the new data being
+    /// different than the currently-stored data.
     /// @param [in] newData New data to be stored.
     /// @return `true` if the new data differ from the old and hence an update was performed,
     /// `false` otherwise.
     inline bool Update(const DataType& newData)
     {
-      // This unguarded read is safe because by design only one thread, the one that produces
-      // updated data, ever invokes this method. All other threads use guarded reads.
-      if (newData != data)
-      {
-        Set(newData);
-        updateNotifier.notify_all();
-        return true;
-      }
+      // By design only one thread, the one that produces updated data, ever invokes this method.
+      // Comparing against that thread's own copy of the data it last wrote avoids going through
+      // the sequence number, and using the equality operator means any padding bytes, whose
+      // values are unspecified, do not cause spurious updates.
+      if (newData == lastWrittenData) return false;
 
-      return false;
+      Set(newData);
+      return true;
     }
 
-    /// Waits for the stored data to be updated.
+    /// Waits for the stored data to be updated beyond the generation last known to the caller.
     /// This function is fully concurrency-safe. If needed, the caller can interrupt the wait using
     /// a stop token.
-    /// @param [in,out] externalData On input, used to identify the last-known data for the calling
-    /// thread. On output, filled in with the updated data.
+    /// @param [in,out] lastKnownGeneration On input, generation of the last-known data for the
+    /// calling thread. On output, generation of the updated data.
+    /// @param [out] updatedData Filled in with the updated data.
     /// @param [in] stopToken Token that allows the wait to be interrupted.
     /// @return `true` if the wait succeeded and an update occurred, `false` if no updates were made
-    /// due to invalid parameter or interrupted wait.
-    inline bool WaitForUpdate(DataType& externalData, std::stop_token stopToken)
+    /// due to interrupted wait.
+    inline bool WaitForUpdate(
+        TGeneration& lastKnownGeneration, DataType& updatedData, std::stop_token stopToken)
     {
-      std::shared_lock lock(mutex);
+      if (true == stopToken.stop_requested()) return false;
 
-      updateNotifier.wait(
-          lock,
+      // Requesting a stop flips the wake toggle, which changes the sequence number without
+      // advancing the generation. This wakes all waiting threads, and those that were not asked to
+      // stop just go back to waiting.
+      std::stop_callback stopCallback(
           stopToken,
-          [this, &externalData]() -> bool
+          [this]() -> void
           {
-            return (data != externalData);
+            sequence.fetch_xor(kSequenceWakeToggle, std::memory_order_seq_cst);
+            sequence.notify_all();
           });
 
-      if (stopToken.stop_requested()) return false;
+      // Incrementing the waiter count and then checking the sequence number, both with sequential
+      // consistency, pairs with the opposite order used by writers. Either this thread is counted
+      // and will be notified, or it will see the new generation and not block at all.
+      waiterCount.fetch_add(1, std::memory_order_seq_cst);
 
-      externalData = data;
+      while (true)
+      {
+        const uint32_t currentSequence = sequence.load(std::memory_order_seq_cst);
+        if (GenerationFromSequence(currentSequence) != lastKnownGeneration) break;
+        if (true == stopToken.stop_requested()) break;
+
+        sequence.wait(currentSequence, std::memory_order_seq_cst);
+      }
+
+      waiterCount.fetch_sub(1, std::memory_order_relaxed);
+
+      if (true == stopToken.stop_requested()) return false;
+
+      updatedData = Get(lastKnownGeneration);
       return true;
     }
 
   private:
 
-    /// Wrapped data.
-    DataType data;
+    /// Type used for each of the individually-atomic words into which the wrapped data are split.
+    using TDataWord = uint32_t;
+
+    /// Number of words needed to hold the wrapped data.
+    static constexpr size_t kDataWordCount =
+        ((sizeof(DataType) + sizeof(TDataWord) - 1) / sizeof(TDataWord));
+
+    /// Sequence number bit that is set while a write is in progress.
+    static constexpr uint32_t kSequenceWriteInProgress = 0b01;
+
+    /// Sequence number bit that is flipped to wake waiting threads without a write.
+    static constexpr uint32_t kSequenceWakeToggle = 0b10;
+
+    /// Amount by which the sequence number advances with each completed write. The generation
+    /// occupies all of the sequence number bits above those used for flags.
+    static constexpr uint32_t kSequenceGenerationIncrement = 0b100;
+
+    /// Extracts the generation from a sequence number.
+    /// @param [in] sequenceValue Sequence number.
+    /// @return Generation that the sequence number identifies.
+    static constexpr TGeneration GenerationFromSequence(uint32_t sequenceValue)
+    {
+      return (sequenceValue / kSequenceGenerationIncrement);
+    }
+
+    /// Writes the stored data words, advances the generation, and notifies waiting threads.
+    /// @param [in] newDataWords New data, already split into words.
+    inline void SetDataWords(const TDataWord (&newDataWords)[kDataWordCount])
+    {
+      // Writers claim exclusive access by setting the write-in-progress bit. In the expected
+      // single-producer case this always succeeds on the first attempt, unless a stop request
+      // flips the wake toggle at the same time.
+      uint32_t sequenceBeforeWrite = sequence.load(std::memory_order_relaxed);
+      do
+      {
+        while (0 != (sequenceBeforeWrite & kSequenceWriteInProgress))
+        {
+          std::this_thread::yield();
+          sequenceBeforeWrite = sequence.load(std::memory_order_relaxed);
+        }
+      }
+      while (false ==
+             sequence.compare_exchange_weak(
+                 sequenceBeforeWrite,
+                 sequenceBeforeWrite | kSequenceWriteInProgress,
+                 std::memory_order_relaxed));
+
+      std::atomic_thread_fence(std::memory_order_release);
+
+      for (size_t i = 0; i < kDataWordCount; ++i)
+        dataWords[i].store(newDataWords[i], std::memory_order_relaxed);
+
+      // Completing the write clears the write-in-progress bit and advances the generation in a
+      // single addition, which leaves the wake toggle untouched in case it was flipped during the
+      // write.
+      sequence.fetch_add(
+          kSequenceGenerationIncrement - kSequenceWriteInProgress, std::memory_order_seq_cst);
+      if (0 != waiterCount.load(std::memory_order_seq_cst)) sequence.notify_all();
+    }
+
+    /// Sequence number used to detect overlap between reads and writes and to identify the
+    /// generation of the data. The lowest bit is set while a write is in progress, the next bit is
+    /// flipped to wake waiting threads, and the remaining bits hold the generation.
+    std::atomic<uint32_t> sequence;
+
+    /// Wrapped data, stored as a sequence of words that can be individually read and written
+    /// atomically. Consistency of the data as a whole is provided by the sequence number.
+    std::atomic<TDataWord> dataWords[kDataWordCount];
 
-    /// Condition variable used to wait for updates to the underlying wrapped data.
-    std::condition_variable_any updateNotifier;
+    /// Number of threads currently waiting for an update. Allows writes to skip the notification
+    /// step entirely when there is nobody to notify.
+    std::atomic<uint32_t> waiterCount;
 
-    /// Mutex for protecting against concurrent accesses to the underlying wrapped data.
-    std::shared_mutex mutex;
+    /// Copy of the data most recently written. Only ever accessed by the thread that produces
+    /// updated data.
+    DataType lastWrittenData;
   };
 } // namespace Xidi
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
 
 #include "ControllerTypes.h"
@@ -63,6 +64,62 @@ namespace Xidi
       uint8_t ApplyRawTriggerTransform(
           uint8_t triggerValue, unsigned int deadzonePercent, unsigned int saturationPercent);
 
+      /// Holds the result of applying deadzone and saturation transformations to every possible raw
+      /// analog value. Deadzone and saturation are fixed at construction time, so transforming a
+      /// value is just a table lookup. Produces results identical to #ApplyRawAnalogTransform.
+      class RawAnalogTransformTable
+      {
+      public:
+
+        /// Builds the table for the specified transformation parameters.
+        /// @param [in] deadzonePercent Percentage of the analog range for which the deadzone
+        /// should be applied.
+        /// @param [in] saturationPercent Percentage of the analog range at which the value
+        /// saturates.
+        RawAnalogTransformTable(unsigned int deadzonePercent, unsigned int saturationPercent);
+
+        /// Applies deadzone and saturation transformations to a raw analog value.
+        /// @param [in] analogValue Analog value to transform.
+        /// @return Transformed analog value.
+        inline int16_t Apply(int16_t analogValue) const
+        {
+          return table[static_cast<uint16_t>(analogValue)];
+        }
+
+      private:
+
+        /// Transformed values, indexed by the bit pattern of the raw analog value.
+        std::array<int16_t, 1 + UINT16_MAX> table;
+      };
+
+      /// Holds the result of applying deadzone and saturation transformations to every possible raw
+      /// trigger value. Deadzone and saturation are fixed at construction time, so transforming a
+      /// value is just a table lookup. Produces results identical to #ApplyRawTriggerTransform.
+      class RawTriggerTransformTable
+      {
+      public:
+
+        /// Builds the table for the specified transformation parameters.
+        /// @param [in] deadzonePercent Percentage of the trigger range for which the deadzone
+        /// should be applied.
+        /// @param [in] saturationPercent Percentage of the trigger range at which the value
+        /// saturates.
+        RawTriggerTransformTable(unsigned int deadzonePercent, unsigned int saturationPercent);
+
+        /// Applies deadzone and saturation transformations to a raw trigger value.
+        /// @param [in] triggerValue Trigger value to transform.
+        /// @return Transformed trigger value.
+        inline uint8_t Apply(uint8_t triggerValue) const
+        {
+          return table[triggerValue];
+        }
+
+      private:
+
+        /// Transformed values, indexed by raw trigger value.
+        std::array<uint8_t, 1 + UINT8_MAX> table;
+      };
+
       /// Determines if an analog reading is considered "pressed" as a digital button in the
       /// negative direction.
       /// @param [in] analogValue Analog reading from the XInput controller.
@@ -110,6 +167,49 @@ namespace Xidi
       /// circular range of motion to a square range of motion.
       SAnalogStickCoordinates TransformCoordinatesCircleToSquare(
           SAnalogStickCoordinates cirleCoords, double amountFraction);
+
+      /// Applies the same correction as #TransformCoordinatesCircleToSquare, but with the amount
+      /// fixed at construction time so that the transformation can be precomputed. Uses only
+      /// integer arithmetic and small interpolated lookup tables at transformation time. Results
+      /// are within one unit of those produced by #TransformCoordinatesCircleToSquare.
+      class CircleToSquareTransform
+      {
+      public:
+
+        /// Builds the lookup tables for the specified amount of transformation.
+        /// @param [in] amountFraction Value between 0.0 and 1.0 that determines the amount of
+        /// transformation to apply.
+        CircleToSquareTransform(double amountFraction);
+
+        /// Applies the circle-to-square correction to the specified coordinates.
+        /// @param [in] circleCoords Physical coordinates read from the analog stick, assumed to be
+        /// on a circular range of motion.
+        /// @return Replacement analog stick coordinates after the transformation is applied from a
+        /// circular range of motion to a square range of motion.
+        SAnalogStickCoordinates Apply(SAnalogStickCoordinates circleCoords) const;
+
+      private:
+
+        /// Number of bits used to identify a segment of the angle multiplier table.
+        static constexpr unsigned int kAngleSegmentBits = 10;
+
+        /// Number of bits used to identify a segment of the radius multiplier table.
+        static constexpr unsigned int kRadiusSegmentBits = 9;
+
+        /// Whether or not any transformation is applied at all.
+        bool isEnabled;
+
+        /// Multiplier applied to both coordinates, expressed in fixed point with 30 fractional
+        /// bits. Indexed by the ratio of the smaller coordinate magnitude to the larger one, at
+        /// evenly-spaced points from 0 to 1 inclusive. Intermediate ratios are interpolated.
+        std::array<uint32_t, 2 + (1u << kAngleSegmentBits)> angleMultipliers;
+
+        /// Additional multiplier applied to coordinates whose radius exceeds the analog range,
+        /// expressed in fixed point with 30 fractional bits. Indexed by squared radius, at
+        /// evenly-spaced points starting at the maximum analog value squared. Intermediate values
+        /// are interpolated.
+        std::array<uint32_t, 2 + (1u << kRadiusSegmentBits)> radiusMultipliers;
+      };
     } // namespace Math
   }   // namespace Controller
 } // namespace Xidi
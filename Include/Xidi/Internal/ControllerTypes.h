@@ -547,5 +547,20 @@ namespace Xidi
     };
 
     static_assert(sizeof(SPhysicalState) <= 16, "Data structure size constraint violation.");
+
+    /// Single timestamped sample of physical controller state, along with the raw virtual
+    /// controller state to which it was mapped at the time it was read.
+    struct SPhysicalSample
+    {
+      /// System time, in milliseconds, at which the sample was read. Uses the same time base as
+      /// buffered events.
+      uint32_t timestamp;
+
+      /// Physical controller state.
+      SPhysicalState physicalState;
+
+      /// Raw virtual controller state produced by mapping the physical controller state.
+      SState rawVirtualState;
+    };
   } // namespace Controller
 } // namespace Xidi
@@ -17,9 +17,11 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <span>
 #include <vector>
 
 #include "ControllerTypes.h"
+#include "ElementMapperArena.h"
 #include "Keyboard.h"
 #include "Mouse.h"
 
@@ -27,6 +29,348 @@ namespace Xidi
 {
   namespace Controller
   {
+    class IElementMapper;
+
+    /// Flattened representation of the element mappers that handle a set of XInput controller
+    /// elements. Element mappers are compiled into a contiguous array of instructions, each of
+    /// which reads the value of one XInput controller element, optionally transforms it, and makes
+    /// one contribution to one target. Composite element mappers disappear during compilation, and
+    /// executing the program is a single pass over the array without any virtual function calls
+    /// except for element mappers that cannot be compiled. Results are identical to invoking the
+    /// element mappers directly.
+    class ElementMapperProgram
+    {
+    public:
+
+      /// Enumerates the types of values that XInput controller elements can produce.
+      enum class EValueType : uint8_t
+      {
+        /// Analog stick axis, in the standard XInput axis range -32768 to +32767.
+        Analog,
+
+        /// Button, either 0 if not pressed or 1 if pressed.
+        Button,
+
+        /// Trigger, in the standard XInput trigger range 0 to 255.
+        Trigger
+      };
+
+      /// Enumerates the transformations that can be applied to a value before it is used.
+      enum class EValueTransform : uint8_t
+      {
+        /// Value is used as-is.
+        None,
+
+        /// Value is inverted, as if by an invert element mapper.
+        Invert,
+
+        /// Value is replaced with a button that is pressed, regardless of its original value.
+        ForcePressed,
+
+        /// Value is replaced with a button that is not pressed, regardless of its original value.
+        ForceReleased
+      };
+
+      /// Enumerates the operations that instructions can perform. Apart from jumps, each one
+      /// corresponds to a contribution that a leaf element mapper can make.
+      enum class EOpcode : uint8_t
+      {
+        /// Contributes to a virtual controller axis, like an axis element mapper.
+        Axis,
+
+        /// Contributes to a virtual controller axis, like a digital axis element mapper.
+        DigitalAxis,
+
+        /// Contributes to a virtual controller button, like a button element mapper.
+        Button,
+
+        /// Contributes to a virtual controller POV direction, like a POV element mapper.
+        Pov,
+
+        /// Contributes to a virtual keyboard key, like a keyboard element mapper.
+        Keyboard,
+
+        /// Makes a neutral contribution to a virtual keyboard key.
+        KeyboardNeutral,
+
+        /// Contributes to a virtual mouse axis, like a mouse axis element mapper.
+        MouseAxis,
+
+        /// Makes a neutral contribution to a virtual mouse axis.
+        MouseAxisNeutral,
+
+        /// Contributes to a virtual mouse button, like a mouse button element mapper.
+        MouseButton,
+
+        /// Makes a neutral contribution to a virtual mouse button.
+        MouseButtonNeutral,
+
+        /// Contributes to the virtual mouse speed, like a mouse speed modifier element mapper.
+        MouseSpeedModifier,
+
+        /// Makes a neutral contribution to the virtual mouse speed.
+        MouseSpeedModifierNeutral,
+
+        /// Invokes an element mapper that could not be compiled through its interface.
+        Invoke,
+
+        /// Invokes an element mapper that could not be compiled through its interface to make a
+        /// neutral contribution.
+        InvokeNeutral,
+
+        /// Continues execution at the jump target if the value is on the negative side, using the
+        /// same definition of positive and negative as split element mappers.
+        JumpIfNegative,
+
+        /// Unconditionally continues execution at the jump target.
+        Jump
+      };
+
+      /// Target of a virtual controller axis contribution.
+      struct SAxisOperand
+      {
+        EAxis axis;
+        EAxisDirection direction;
+      };
+
+      /// Target of a virtual mouse axis contribution, along with whether or not the built-in
+      /// deadzone and saturation properties apply to it. Those properties are governed by
+      /// configuration, which is resolved once when the instruction is compiled.
+      struct SMouseAxisOperand
+      {
+        Mouse::EMouseAxis axis;
+        EAxisDirection direction;
+        bool applyProperties;
+      };
+
+      /// Holds the operation-specific part of an instruction.
+      union UOperand
+      {
+        SAxisOperand axis;
+        EButton button;
+        EPovDirection povDirection;
+        Keyboard::TKeyIdentifier key;
+        SMouseAxisOperand mouseAxis;
+        Mouse::EMouseButton mouseButton;
+        unsigned int mouseSpeedScalingFactor;
+        const IElementMapper* elementMapper;
+        uint32_t jumpTarget;
+      };
+
+      /// Single instruction within a program.
+      struct SInstruction
+      {
+        /// Operation to perform.
+        EOpcode opcode;
+
+        /// Type of value produced by the XInput controller element that is the source.
+        EValueType valueType;
+
+        /// Transformation to apply to the source value before using it.
+        EValueTransform valueTransform;
+
+        /// Index of the XInput controller element that is the source, which identifies both the
+        /// value to read and the opaque source identifier to use for contributions.
+        uint8_t sourceIndex;
+
+        /// Operation-specific target or parameter.
+        UOperand operand;
+      };
+
+      static_assert(sizeof(SInstruction) <= 16, "Data structure size constraint violation.");
+
+      /// Identifies a contiguous range of instructions within a program.
+      struct SInstructionRange
+      {
+        /// Index of the first instruction in the range.
+        uint32_t begin;
+
+        /// Index one past the last instruction in the range.
+        uint32_t end;
+
+        /// Determines whether or not the range contains any instructions.
+        /// @return `true` if so, `false` otherwise.
+        constexpr bool IsEmpty(void) const
+        {
+          return (begin >= end);
+        }
+      };
+
+      /// Holds the contributions made by executing instructions for many sets of XInput controller
+      /// element values at once. Contributions are laid out in columns, one column per virtual
+      /// controller element with one entry per set of values, so that each instruction is applied
+      /// to all sets of values in a single pass over contiguous memory.
+      struct SColumnAccumulators
+      {
+        /// Maximum number of sets of values that can be processed at once.
+        static constexpr size_t kColumnSize = 64;
+
+        /// Sum of all contributions to each axis, without saturation.
+        alignas(16) std::array<std::array<int32_t, kColumnSize>, static_cast<int>(EAxis::Count)>
+            axis;
+
+        /// Buttons that are pressed, one bit per button.
+        std::array<uint32_t, kColumnSize> button;
+
+        /// POV directions that are pressed, one bit per direction.
+        std::array<uint8_t, kColumnSize> povDirection;
+      };
+
+      static_assert(
+          static_cast<int>(EButton::Count) <= 32, "Buttons must fit into a 32-bit bitmask.");
+      static_assert(
+          static_cast<int>(EPovDirection::Count) <= 8,
+          "POV directions must fit into an 8-bit bitmask.");
+
+      /// Appends instructions to a program on behalf of element mappers. Each compiler handles a
+      /// single XInput controller element and keeps track of how its value is transformed as
+      /// composite element mappers are flattened.
+      class Compiler
+      {
+      public:
+
+        /// Creates a compiler for the specified XInput controller element.
+        /// @param [in,out] program Program to which instructions are appended.
+        /// @param [in] sourceIndex Index of the XInput controller element that is the source.
+        /// @param [in] valueType Type of value produced by the XInput controller element.
+        inline Compiler(ElementMapperProgram& program, uint8_t sourceIndex, EValueType valueType)
+            : program(program),
+              sourceIndex(sourceIndex),
+              valueType(valueType),
+              valueTransform(EValueTransform::None)
+        {}
+
+        /// Compiles an element mapper's contribution. Does nothing if the element mapper is not
+        /// present.
+        /// @param [in] elementMapper Element mapper to compile, or `nullptr`.
+        void CompileContribution(const IElementMapper* elementMapper);
+
+        /// Compiles an element mapper's neutral contribution. Does nothing if the element mapper is
+        /// not present.
+        /// @param [in] elementMapper Element mapper to compile, or `nullptr`.
+        void CompileNeutral(const IElementMapper* elementMapper);
+
+        /// Compiles an element mapper's contribution such that it receives an inverted value, as if
+        /// it were wrapped by an invert element mapper.
+        /// @param [in] elementMapper Element mapper to compile, or `nullptr`.
+        void CompileInvertedContribution(const IElementMapper* elementMapper);
+
+        /// Compiles a pair of element mappers such that one or the other makes a contribution
+        /// depending on the value, as if they were wrapped by a split element mapper.
+        /// @param [in] positiveMapper Element mapper that contributes when the value is positive,
+        /// or `nullptr`.
+        /// @param [in] negativeMapper Element mapper that contributes when the value is negative,
+        /// or `nullptr`.
+        void CompileSplitContribution(
+            const IElementMapper* positiveMapper, const IElementMapper* negativeMapper);
+
+        /// Appends an instruction that makes a contribution, or a neutral contribution, on behalf
+        /// of a leaf element mapper.
+        /// @param [in] opcode Operation to perform.
+        /// @param [in] operand Operation-specific target or parameter.
+        void Emit(EOpcode opcode, UOperand operand);
+
+      private:
+
+        /// Appends an instruction that reads the value as transformed at the current point in
+        /// compilation.
+        /// @param [in] opcode Operation to perform.
+        /// @param [in] operand Operation-specific target or parameter.
+        /// @return Index of the newly-appended instruction.
+        uint32_t Append(EOpcode opcode, UOperand operand);
+
+        /// Program to which instructions are appended.
+        ElementMapperProgram& program;
+
+        /// Index of the XInput controller element that is the source.
+        const uint8_t sourceIndex;
+
+        /// Type of value produced by the XInput controller element.
+        const EValueType valueType;
+
+        /// Transformation that applies to the value at the current point in compilation.
+        EValueTransform valueTransform;
+      };
+
+      /// Executes this program, making all of its contributions.
+      /// @param [in,out] controllerState Controller state data structure to be updated.
+      /// @param [in] sourceValues Values of all XInput controller elements, indexed by source
+      /// index. Must contain an entry for every source index used by this program.
+      /// @param [in] sourceIdentifierBase Opaque source identifier of the XInput controller element
+      /// at source index 0. Source identifiers of all others are offset by their source indices.
+      inline void Execute(
+          SState& controllerState,
+          std::span<const int32_t> sourceValues,
+          uint32_t sourceIdentifierBase) const
+      {
+        Execute(
+            controllerState,
+            sourceValues,
+            sourceIdentifierBase,
+            {.begin = 0, .end = static_cast<uint32_t>(instructions.size())});
+      }
+
+      /// Executes part of this program, making only the contributions of the instructions in the
+      /// specified range. Jumps within the range must not target instructions outside of it.
+      /// @param [in,out] controllerState Controller state data structure to be updated.
+      /// @param [in] sourceValues Values of all XInput controller elements, indexed by source
+      /// index. Must contain an entry for every source index used within the range.
+      /// @param [in] sourceIdentifierBase Opaque source identifier of the XInput controller element
+      /// at source index 0. Source identifiers of all others are offset by their source indices.
+      /// @param [in] range Range of instructions to execute.
+      void Execute(
+          SState& controllerState,
+          std::span<const int32_t> sourceValues,
+          uint32_t sourceIdentifierBase,
+          SInstructionRange range) const;
+
+      /// Executes part of this program for many sets of XInput controller element values at once,
+      /// one instruction at a time across all of them. Only suitable for ranges whose
+      /// contributions can be undone, as determined by #IsReversible, because any other
+      /// contributions would be made out of order. All instructions in the range must read from
+      /// the same XInput controller element, which is the case for ranges located using
+      /// #FindSourceInstructions.
+      /// @param [in,out] accumulators Column-wise contributions to be updated, one entry per set
+      /// of values.
+      /// @param [in] sourceValueColumn Values of the XInput controller element, one per set. Only
+      /// up to SColumnAccumulators::kColumnSize values are used.
+      /// @param [in] range Range of instructions to execute.
+      void ExecuteColumns(
+          SColumnAccumulators& accumulators,
+          std::span<const int32_t> sourceValueColumn,
+          SInstructionRange range) const;
+
+      /// Locates the instructions that read from the specified XInput controller element. Programs
+      /// are compiled one XInput controller element at a time, so these instructions are always
+      /// contiguous.
+      /// @param [in] sourceIndex Index of the XInput controller element of interest.
+      /// @return Range of instructions that read from the XInput controller element, which is
+      /// empty if there are none.
+      SInstructionRange FindSourceInstructions(uint8_t sourceIndex) const;
+
+      /// Determines whether or not all of the contributions made by the instructions in the
+      /// specified range can later be undone. This is the case for instructions that only affect
+      /// virtual controller axes, buttons, and POV directions, because these contributions do not
+      /// depend on anything already present in the virtual controller state. Keyboard and mouse
+      /// contributions have external side effects and element mappers that could not be compiled
+      /// can do anything, so neither can be undone.
+      /// @param [in] range Range of instructions to check.
+      /// @return `true` if all contributions in the range can be undone, `false` otherwise.
+      bool IsReversible(SInstructionRange range) const;
+
+      /// Retrieves the number of instructions in this program.
+      /// @return Number of instructions.
+      inline size_t GetInstructionCount(void) const
+      {
+        return instructions.size();
+      }
+
+    private:
+
+      /// All instructions, in execution order.
+      std::vector<SInstruction> instructions;
+    };
+
     /// Interface for mapping an XInput controller element's state reading to an internal controller
     /// state data structure value. An instance of this object exists for each XInput controller
     /// element in a mapper.
@@ -34,12 +378,45 @@ namespace Xidi
     {
     public:
 
+      /// Description of the structure of an element mapper, meaning its type along with all of the
+      /// configuration that determines its behavior, including the structure of any underlying
+      /// element mappers. Element mappers whose structure keys are equal behave identically and
+      /// can therefore be used interchangeably.
+      struct SStructure
+      {
+        /// Flat sequence of values that identifies the structure being described.
+        std::vector<uint32_t> key;
+
+        /// Number of bytes occupied by the element mapper objects being described.
+        size_t footprint = 0;
+      };
+
       virtual ~IElementMapper(void) = default;
 
+      /// Element mappers are allocated from whatever element mapper arena is active on the
+      /// calling thread, if any, so that element mappers created together are stored together.
+      static inline void* operator new(size_t size)
+      {
+        return ElementMapperArena::Allocate(size);
+      }
+
+      static inline void operator delete(void* ptr)
+      {
+        ElementMapperArena::Deallocate(ptr);
+      }
+
       /// Allocates, constructs, and returns a pointer to a copy of this element mapper.
       /// @return Smart pointer to a copy of this element mapper.
       virtual std::unique_ptr<IElementMapper> Clone(void) const = 0;
 
+      /// Appends a description of this element mapper's structure, which allows structurally
+      /// identical element mappers to be shared rather than duplicated. It is optional to override
+      /// this method, as the default implementation reports that the structure cannot be
+      /// described, which prevents this element mapper from ever being shared.
+      /// @param [in,out] structure Structure description to which to append.
+      /// @return `true` if the structure was described, `false` otherwise.
+      virtual bool DescribeStructure(SStructure& structure) const;
+
       /// Calculates the contribution to controller state from a given analog reading in the
       /// standard XInput axis range -32768 to +32767. Contribution is aggregated with anything that
       /// already exists in the controller state.
@@ -92,6 +469,18 @@ namespace Xidi
       /// #GetTargetElementCount.
       /// @return Identifier of the targert virtual controller element, if it exists.
       virtual std::optional<SElementIdentifier> GetTargetElementAt(int index) const = 0;
+
+      /// Compiles the contribution this element mapper makes into program instructions. It is
+      /// optional to override this method, as the default implementation compiles to an
+      /// instruction that invokes this element mapper through its interface.
+      /// @param [in,out] compiler Compiler to use for appending instructions.
+      virtual void CompileContribution(ElementMapperProgram::Compiler& compiler) const;
+
+      /// Compiles the neutral contribution this element mapper makes into program instructions.
+      /// It is optional to override this method, as the default implementation compiles to an
+      /// instruction that invokes this element mapper through its interface.
+      /// @param [in,out] compiler Compiler to use for appending instructions.
+      virtual void CompileNeutral(ElementMapperProgram::Compiler& compiler) const;
     };
 
     /// Maps a single XInput controller element such that it contributes to an axis value on a
@@ -126,6 +515,7 @@ namespace Xidi
 
       // IElementMapper
       std::unique_ptr<IElementMapper> Clone(void) const override;
+      bool DescribeStructure(SStructure& structure) const override;
       void ContributeFromAnalogValue(
           SState& controllerState,
           int16_t analogValue,
@@ -140,6 +530,8 @@ namespace Xidi
           uint32_t sourceIdentifier = 0) const override;
       int GetTargetElementCount(void) const override;
       std::optional<SElementIdentifier> GetTargetElementAt(int index) const override;
+      void CompileContribution(ElementMapperProgram::Compiler& compiler) const override;
+      void CompileNeutral(ElementMapperProgram::Compiler& compiler) const override;
 
     private:
 
@@ -166,6 +558,7 @@ namespace Xidi
 
       // IElementMapper
       std::unique_ptr<IElementMapper> Clone(void) const override;
+      bool DescribeStructure(SStructure& structure) const override;
       void ContributeFromAnalogValue(
           SState& controllerState,
           int16_t analogValue,
@@ -180,6 +573,8 @@ namespace Xidi
           uint32_t sourceIdentifier = 0) const override;
       int GetTargetElementCount(void) const override;
       std::optional<SElementIdentifier> GetTargetElementAt(int index) const override;
+      void CompileContribution(ElementMapperProgram::Compiler& compiler) const override;
+      void CompileNeutral(ElementMapperProgram::Compiler& compiler) const override;
 
     private:
 
@@ -217,6 +612,7 @@ namespace Xidi
 
       // IElementMapper
       std::unique_ptr<IElementMapper> Clone(void) const override;
+      bool DescribeStructure(SStructure& structure) const override;
       void ContributeFromAnalogValue(
           SState& controllerState,
           int16_t analogValue,
@@ -232,6 +628,8 @@ namespace Xidi
       void ContributeNeutral(SState& controllerState, uint32_t sourceIdentifier = 0) const override;
       int GetTargetElementCount(void) const override;
       std::optional<SElementIdentifier> GetTargetElementAt(int index) const override;
+      void CompileContribution(ElementMapperProgram::Compiler& compiler) const override;
+      void CompileNeutral(ElementMapperProgram::Compiler& compiler) const override;
 
     private:
 
@@ -278,6 +676,7 @@ namespace Xidi
 
       // AxisMapper
       std::unique_ptr<IElementMapper> Clone(void) const override;
+      bool DescribeStructure(SStructure& structure) const override;
       void ContributeFromAnalogValue(
           SState& controllerState,
           int16_t analogValue,
@@ -286,6 +685,7 @@ namespace Xidi
           SState& controllerState,
           uint8_t triggerValue,
           uint32_t sourceIdentifier = 0) const override;
+      void CompileContribution(ElementMapperProgram::Compiler& compiler) const override;
     };
 
     /// Inverts the input reading from an XInput controller element and then forwards it to another
@@ -312,6 +712,7 @@ namespace Xidi
 
       // IElementMapper
       std::unique_ptr<IElementMapper> Clone(void) const override;
+      bool DescribeStructure(SStructure& structure) const override;
       void ContributeFromAnalogValue(
           SState& controllerState,
           int16_t analogValue,
@@ -327,6 +728,8 @@ namespace Xidi
       void ContributeNeutral(SState& controllerState, uint32_t sourceIdentifier = 0) const override;
       int GetTargetElementCount(void) const override;
       std::optional<SElementIdentifier> GetTargetElementAt(int index) const override;
+      void CompileContribution(ElementMapperProgram::Compiler& compiler) const override;
+      void CompileNeutral(ElementMapperProgram::Compiler& compiler) const override;
 
     private:
 
@@ -355,6 +758,7 @@ namespace Xidi
 
       // IElementMapper
       std::unique_ptr<IElementMapper> Clone(void) const override;
+      bool DescribeStructure(SStructure& structure) const override;
       void ContributeFromAnalogValue(
           SState& controllerState,
           int16_t analogValue,
@@ -370,6 +774,8 @@ namespace Xidi
       void ContributeNeutral(SState& controllerState, uint32_t sourceIdentifier = 0) const override;
       int GetTargetElementCount(void) const override;
       std::optional<SElementIdentifier> GetTargetElementAt(int index) const override;
+      void CompileContribution(ElementMapperProgram::Compiler& compiler) const override;
+      void CompileNeutral(ElementMapperProgram::Compiler& compiler) const override;
 
     private:
 
@@ -411,6 +817,7 @@ namespace Xidi
 
       // IElementMapper
       std::unique_ptr<IElementMapper> Clone(void) const override;
+      bool DescribeStructure(SStructure& structure) const override;
       void ContributeFromAnalogValue(
           SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const override;
       void ContributeFromButtonValue(
@@ -420,6 +827,8 @@ namespace Xidi
       void ContributeNeutral(SState& controllerState, uint32_t sourceIdentifier) const override;
       int GetTargetElementCount(void) const override;
       std::optional<SElementIdentifier> GetTargetElementAt(int index) const override;
+      void CompileContribution(ElementMapperProgram::Compiler& compiler) const override;
+      void CompileNeutral(ElementMapperProgram::Compiler& compiler) const override;
 
     private:
 
@@ -454,6 +863,7 @@ namespace Xidi
 
       // IElementMapper
       std::unique_ptr<IElementMapper> Clone(void) const override;
+      bool DescribeStructure(SStructure& structure) const override;
       void ContributeFromAnalogValue(
           SState& controllerState,
           int16_t analogValue,
@@ -469,6 +879,8 @@ namespace Xidi
       void ContributeNeutral(SState& controllerState, uint32_t sourceIdentifier = 0) const override;
       int GetTargetElementCount(void) const override;
       std::optional<SElementIdentifier> GetTargetElementAt(int index) const override;
+      void CompileContribution(ElementMapperProgram::Compiler& compiler) const override;
+      void CompileNeutral(ElementMapperProgram::Compiler& compiler) const override;
 
     private:
 
@@ -495,6 +907,7 @@ namespace Xidi
 
       // IElementMapper
       std::unique_ptr<IElementMapper> Clone(void) const override;
+      bool DescribeStructure(SStructure& structure) const override;
       void ContributeFromAnalogValue(
           SState& controllerState,
           int16_t analogValue,
@@ -510,6 +923,8 @@ namespace Xidi
       void ContributeNeutral(SState& controllerState, uint32_t sourceIdentifier = 0) const override;
       int GetTargetElementCount(void) const override;
       std::optional<SElementIdentifier> GetTargetElementAt(int index) const override;
+      void CompileContribution(ElementMapperProgram::Compiler& compiler) const override;
+      void CompileNeutral(ElementMapperProgram::Compiler& compiler) const override;
 
     private:
 
@@ -537,6 +952,7 @@ namespace Xidi
 
       // IElementMapper
       std::unique_ptr<IElementMapper> Clone(void) const override;
+      bool DescribeStructure(SStructure& structure) const override;
       void ContributeFromAnalogValue(
           SState& controllerState,
           int16_t analogValue,
@@ -551,6 +967,8 @@ namespace Xidi
           uint32_t sourceIdentifier = 0) const override;
       int GetTargetElementCount(void) const override;
       std::optional<SElementIdentifier> GetTargetElementAt(int index) const override;
+      void CompileContribution(ElementMapperProgram::Compiler& compiler) const override;
+      void CompileNeutral(ElementMapperProgram::Compiler& compiler) const override;
 
     private:
 
@@ -602,6 +1020,7 @@ namespace Xidi
 
       // IElementMapper
       std::unique_ptr<IElementMapper> Clone(void) const override;
+      bool DescribeStructure(SStructure& structure) const override;
       void ContributeFromAnalogValue(
           SState& controllerState,
           int16_t analogValue,
@@ -617,6 +1036,8 @@ namespace Xidi
       void ContributeNeutral(SState& controllerState, uint32_t sourceIdentifier = 0) const override;
       int GetTargetElementCount(void) const override;
       std::optional<SElementIdentifier> GetTargetElementAt(int index) const override;
+      void CompileContribution(ElementMapperProgram::Compiler& compiler) const override;
+      void CompileNeutral(ElementMapperProgram::Compiler& compiler) const override;
 
     private:
 
@@ -0,0 +1,76 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file ElementMapperArena.h
+ *   Declaration of arenas from which element mappers that are created together are allocated
+ *   together.
+ **************************************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    /// Bump allocator for element mappers. While an arena object exists, it is active on the
+    /// thread that created it, and all element mappers created on that thread are allocated
+    /// contiguously from it instead of individually from the heap. This is intended to be used
+    /// while reading mappers from a configuration file, which creates large numbers of small
+    /// element mappers whose lifetimes are all tied to the same set of mappers. Memory is never
+    /// returned to an arena piecemeal. Rather, all of the memory in an arena is released at once
+    /// after the arena object is destroyed and all of the element mappers allocated from it have
+    /// also been destroyed, which can happen on any thread.
+    class ElementMapperArena
+    {
+    public:
+
+      /// Internal state of an arena, which can outlive the arena object itself. Defined
+      /// internally.
+      struct SArenaState;
+
+      /// Creates an arena and makes it active on the calling thread. Any arena that was previously
+      /// active on the calling thread becomes active again once this one is destroyed.
+      ElementMapperArena(void);
+
+      ElementMapperArena(const ElementMapperArena& other) = delete;
+
+      ~ElementMapperArena(void);
+
+      /// Allocates memory for an element mapper. If an arena is active on the calling thread the
+      /// memory comes from that arena, otherwise it comes from the heap.
+      /// @param [in] size Number of bytes to allocate.
+      /// @return Pointer to the allocated memory.
+      static void* Allocate(size_t size);
+
+      /// Deallocates memory that was previously allocated for an element mapper.
+      /// Concurrency-safe.
+      /// @param [in] ptr Pointer to the memory to deallocate, which may be `nullptr`.
+      static void Deallocate(void* ptr);
+
+      /// Determines if the specified memory was allocated from this arena. Intended for tests.
+      /// @param [in] ptr Pointer previously returned from #Allocate.
+      /// @return `true` if the memory was allocated from this arena, `false` otherwise.
+      bool Contains(const void* ptr) const;
+
+      /// Retrieves the number of bytes of this arena that have been used by allocations so far,
+      /// including any per-allocation overhead. Intended for tests.
+      /// @return Number of bytes used.
+      size_t GetUsedBytes(void) const;
+
+    private:
+
+      /// Internal state of this arena.
+      SArenaState* const arenaState;
+
+      /// Internal state of the arena that was active on the creating thread when this arena was
+      /// created, if any.
+      SArenaState* const previousArenaState;
+    };
+  } // namespace Controller
+} // namespace Xidi
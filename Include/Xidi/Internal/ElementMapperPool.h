@@ -0,0 +1,86 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file ElementMapperPool.h
+ *   Declaration of the pool through which structurally identical element mappers are shared
+ *   instead of being duplicated.
+ **************************************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "ElementMapper.h"
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    /// Interns element mappers so that each structurally identical element mapper is stored once
+    /// and shared by all mappers that use it. Element mappers are immutable, so sharing them is
+    /// safe. The pool does not keep element mappers alive, so an interned element mapper is
+    /// destroyed as soon as nothing else refers to it. Permanent element mappers, such as those
+    /// defined as compile-time constants, can also be interned, in which case they are preferred
+    /// over any structurally identical element mappers. All functionality is concurrency-safe.
+    class ElementMapperPool
+    {
+    public:
+
+      /// Statistics that describe how effectively element mappers are being shared.
+      struct SStatistics
+      {
+        /// Number of distinct interned element mappers that are still in use, not including
+        /// permanent element mappers.
+        size_t internedCount;
+
+        /// Number of distinct permanent element mappers that are interned. References to them
+        /// are not counted.
+        size_t permanentCount;
+
+        /// Number of references held to interned element mappers. Without sharing, each of these
+        /// references would refer to its own separate element mapper object.
+        size_t referenceCount;
+
+        /// Number of bytes saved by sharing interned element mappers instead of holding a separate
+        /// copy of each one for each reference.
+        size_t bytesSaved;
+      };
+
+      ElementMapperPool(void) = delete;
+
+      /// Retrieves statistics that describe how effectively element mappers are being shared.
+      /// Values are approximate if element mappers are being created or destroyed concurrently.
+      /// @return Current statistics.
+      static SStatistics GetStatistics(void);
+
+      /// Determines if the specified element mapper can be shared. Element mappers whose structures
+      /// cannot be described might have behavior that depends on the identity of the object, so
+      /// they are never shared.
+      /// @param [in] elementMapper Element mapper to check.
+      /// @return `true` if the element mapper can be shared, `false` otherwise.
+      static bool IsShareable(const IElementMapper& elementMapper);
+
+      /// Interns the specified element mapper. If a structurally identical element mapper has
+      /// already been interned and is still in use, it is returned instead. Element mappers whose
+      /// structures cannot be described are never shared and are returned unchanged.
+      /// @param [in] elementMapper Element mapper to intern. Must not be `nullptr`.
+      /// @return Element mapper to use in place of the one supplied.
+      static std::shared_ptr<const IElementMapper> Intern(
+          std::shared_ptr<const IElementMapper> elementMapper);
+
+      /// Interns the specified permanent element mapper. Any structurally identical element mapper
+      /// interned afterwards is replaced with it. If a structurally identical permanent element
+      /// mapper has already been interned, it is returned instead.
+      /// @param [in] elementMapper Element mapper to intern, which must exist for the lifetime of
+      /// the process and must be able to describe its structure.
+      /// @return Non-owning pointer to the element mapper to use in place of the one supplied.
+      static std::shared_ptr<const IElementMapper> InternPermanent(
+          const IElementMapper& elementMapper);
+    };
+  } // namespace Controller
+} // namespace Xidi
@@ -35,5 +35,13 @@ namespace Xidi
     /// Performs run-time initialization.
     /// This function only performs operations that are safe to perform within a DLL entry point.
     void Initialize(void);
+
+    /// Reads the configuration file again and replaces the configured mappers with the ones it
+    /// specifies, rebuilding all custom mappers in the process. Threads that use the configured
+    /// mappers switch to the replacements without blocking. Other settings in the configuration
+    /// file are not reloaded. If there are any errors, the existing mappers remain in use.
+    /// Concurrency-safe.
+    /// @return `true` if the mappers were reloaded, `false` otherwise.
+    bool ReloadMappers(void);
   } // namespace Globals
 } // namespace Xidi
@@ -0,0 +1,243 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file LatencyInstrumentation.h
+ *   Declaration of instrumentation for measuring input latency at each stage of the path from
+ *   physical controller to application.
+ **************************************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "ControllerTypes.h"
+#include "PeriodicJobScheduler.h"
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    namespace Latency
+    {
+      /// Clock used for all latency measurements. Monotonic and high-resolution.
+      using TClock = std::chrono::steady_clock;
+
+      /// Type used to represent a single point in time at which a stage completed.
+      using TTimestamp = TClock::time_point;
+
+      /// Enumerates the stages along the path from physical controller to application for which
+      /// latency is measured. Each stage is measured from the end of the previous stage.
+      enum class EStage : uint8_t
+      {
+        /// Reading the physical controller state from the hardware.
+        PhysicalRead,
+
+        /// Mapping the physical controller state to a raw virtual controller state.
+        Mapping,
+
+        /// Publishing the raw virtual controller state so that it is visible to all virtual
+        /// controllers, including notifying any that are waiting.
+        Publication,
+
+        /// Waking up a virtual controller and having it refresh its state from the published raw
+        /// virtual controller state. Measured from the start of publication.
+        VirtualRefresh,
+
+        /// Waiting for the application to read the refreshed virtual controller state.
+        ApplicationDelivery,
+
+        /// Entire path, from completion of the physical read to application delivery. This is the
+        /// staleness of the data as observed by the application.
+        Total,
+
+        /// Sentinel value, total number of enumerators.
+        Count
+      };
+
+      /// Holds the points in time at which a single physical controller state sample completed
+      /// each stage of its journey to the application.
+      struct SSampleTimestamps
+      {
+        /// Point in time immediately before the physical controller was read.
+        TTimestamp physicalReadStart;
+
+        /// Point in time immediately after the physical controller was read.
+        TTimestamp physicalReadEnd;
+
+        /// Point in time at which the mapper finished producing a raw virtual controller state.
+        TTimestamp mapped;
+
+        /// Point in time at which publication of the raw virtual controller state began. Virtual
+        /// controllers can observe the sample any time after this point.
+        TTimestamp publicationStart;
+
+        /// Point in time at which a virtual controller refreshed its state using the sample.
+        TTimestamp refreshed;
+      };
+
+      /// Summary statistics for a single latency histogram. All durations are in nanoseconds and
+      /// are approximate, being accurate to within the resolution of the histogram buckets.
+      struct SStatistics
+      {
+        /// Number of measurements recorded.
+        uint64_t count;
+
+        /// Median latency.
+        uint64_t p50;
+
+        /// 99th percentile latency.
+        uint64_t p99;
+
+        /// Maximum latency. This value is exact.
+        uint64_t max;
+      };
+
+      /// Concurrency-safe histogram of latency measurements. Buckets are arranged log-linearly,
+      /// meaning each power-of-two range of values is subdivided into a fixed number of equal-width
+      /// buckets. This keeps the relative error of every bucket bounded without needing very many
+      /// buckets to cover everything from nanoseconds to seconds.
+      class Histogram
+      {
+      public:
+
+        /// Number of bits of sub-bucket precision within each power-of-two range.
+        static constexpr unsigned int kSubBucketBits = 3;
+
+        /// Number of sub-buckets within each power-of-two range.
+        static constexpr unsigned int kSubBucketCount = (1u << kSubBucketBits);
+
+        /// Largest representable latency value, in nanoseconds. Larger values are clamped.
+        /// Approximately 17 seconds.
+        static constexpr uint64_t kMaxValue = ((1ull << 34) - 1);
+
+        /// Number of buckets needed to cover all representable values.
+        static constexpr unsigned int kBucketCount = (34 - kSubBucketBits + 1) * kSubBucketCount;
+
+        /// Determines the bucket index into which the specified value falls.
+        /// @param [in] value Latency value, in nanoseconds.
+        /// @return Index of the corresponding bucket.
+        static unsigned int BucketIndexForValue(uint64_t value);
+
+        /// Determines the largest value that falls into the bucket with the specified index.
+        /// @param [in] bucketIndex Index of the bucket of interest.
+        /// @return Largest latency value, in nanoseconds, that the bucket can hold.
+        static uint64_t BucketUpperBound(unsigned int bucketIndex);
+
+        /// Computes and returns summary statistics for this histogram. Concurrency-safe, although
+        /// the result may not reflect a consistent snapshot if measurements are recorded while the
+        /// statistics are being computed.
+        /// @return Summary statistics.
+        SStatistics GetStatistics(void) const;
+
+        /// Records a single latency measurement. Concurrency-safe.
+        /// @param [in] latency Latency value to record.
+        void Record(TClock::duration latency);
+
+        /// Discards all recorded measurements. Concurrency-safe.
+        void Reset(void);
+
+      private:
+
+        /// Number of measurements in each bucket.
+        std::array<std::atomic<uint32_t>, kBucketCount> buckets = {};
+
+        /// Largest measurement seen so far, in nanoseconds.
+        std::atomic<uint64_t> maxValue = 0;
+      };
+
+      /// Initializes latency instrumentation based on the configuration file. If enabled, a job is
+      /// added to the specified scheduler to periodically output latency statistics to the log.
+      /// Intended to be invoked once during physical controller initialization.
+      /// @param [in] scheduler Scheduler to which to add the periodic reporting job.
+      void Initialize(PeriodicJobScheduler& scheduler);
+
+      /// Determines whether or not latency instrumentation is enabled. All recording functions do
+      /// nothing if it is not.
+      /// @return `true` if so, `false` otherwise.
+      bool IsEnabled(void);
+
+      /// Enables or disables latency instrumentation, regardless of configuration. Intended for
+      /// testing.
+      /// @param [in] enabled Whether or not latency instrumentation should be enabled.
+      void SetEnabled(bool enabled);
+
+      /// Captures the current time for use as a stage completion timestamp. This is always
+      /// inexpensive, but callers should still avoid doing it when instrumentation is disabled.
+      /// @return Current time.
+      inline TTimestamp Now(void)
+      {
+        return TClock::now();
+      }
+
+      /// Retrieves the stage completion timestamps of the most recently published sample for the
+      /// specified physical controller. Concurrency-safe.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @return Timestamps of the most recently published sample.
+      SSampleTimestamps GetPublishedSampleTimestamps(TControllerIdentifier controllerIdentifier);
+
+      /// Computes and returns latency statistics for the specified physical controller and stage.
+      /// Concurrency-safe.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @param [in] stage Stage of interest.
+      /// @return Summary statistics for the specified stage.
+      SStatistics GetStatistics(TControllerIdentifier controllerIdentifier, EStage stage);
+
+      /// Outputs latency statistics for all physical controllers and all stages to the log.
+      void OutputStatistics(void);
+
+      /// Records latency measurements for an application reading virtual controller state, along
+      /// with the total latency of the sample from which that state came. Concurrency-safe.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @param [in] timestamps Timestamps of the sample being delivered.
+      /// @param [in] delivered Point in time at which the application read the state.
+      void RecordApplicationDelivery(
+          TControllerIdentifier controllerIdentifier,
+          const SSampleTimestamps& timestamps,
+          TTimestamp delivered);
+
+      /// Records latency measurements for a physical controller sample that has been read and
+      /// mapped, regardless of whether or not it goes on to be published. Intended to be invoked
+      /// only by the thread that polls physical controllers.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @param [in] timestamps Timestamps of the sample, filled in up to and including mapping.
+      void RecordPhysicalSampleMapped(
+          TControllerIdentifier controllerIdentifier, const SSampleTimestamps& timestamps);
+
+      /// Makes the timestamps of a physical controller sample that is about to be published
+      /// available to virtual controllers. This happens before publication so that any virtual
+      /// controller that observes the published sample is guaranteed to also observe its
+      /// timestamps. Intended to be invoked only by the thread that polls physical controllers.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @param [in] timestamps Timestamps of the sample, filled in up to and including the start
+      /// of publication.
+      void RecordPhysicalSamplePublicationStart(
+          TControllerIdentifier controllerIdentifier, const SSampleTimestamps& timestamps);
+
+      /// Records the latency measurement for publishing a physical controller sample. Intended to
+      /// be invoked only by the thread that polls physical controllers.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @param [in] timestamps Timestamps of the sample, filled in up to and including the start
+      /// of publication.
+      /// @param [in] publicationEnd Point in time at which publication completed.
+      void RecordPhysicalSamplePublished(
+          TControllerIdentifier controllerIdentifier,
+          const SSampleTimestamps& timestamps,
+          TTimestamp publicationEnd);
+
+      /// Records the latency measurement for a virtual controller refreshing its state using a
+      /// published sample. Concurrency-safe.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @param [in] timestamps Timestamps of the sample, filled in up to and including the time
+      /// of the virtual controller refresh.
+      void RecordVirtualRefresh(
+          TControllerIdentifier controllerIdentifier, const SSampleTimestamps& timestamps);
+    } // namespace Latency
+  } // namespace Controller
+} // namespace Xidi
@@ -12,14 +12,22 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <optional>
 #include <string_view>
 
+#include <Infra/Core/Configuration.h>
+
 #include "ApiBitSet.h"
 #include "ApiWindows.h"
+#include "ControllerMath.h"
 #include "ControllerTypes.h"
 #include "ElementMapper.h"
 #include "ForceFeedbackTypes.h"
+#include "MapperSet.h"
 
 /// Computes the index of the specified named controller element in the unnamed array representation
 /// of the element map.
@@ -49,30 +57,41 @@ namespace Xidi
 
       /// Physical controller element mappers, one per controller element.
       /// For controller elements that are not used, a value of `nullptr` may be used instead.
+      /// Element mappers are immutable, so wherever possible they are shared rather than copied
+      /// whenever an element map is copied, and structurally identical element mappers are shared
+      /// across mappers.
       struct SElementMap
       {
-        std::unique_ptr<const IElementMapper> stickLeftX = nullptr;
-        std::unique_ptr<const IElementMapper> stickLeftY = nullptr;
-        std::unique_ptr<const IElementMapper> stickRightX = nullptr;
-        std::unique_ptr<const IElementMapper> stickRightY = nullptr;
-        std::unique_ptr<const IElementMapper> dpadUp = nullptr;
-        std::unique_ptr<const IElementMapper> dpadDown = nullptr;
-        std::unique_ptr<const IElementMapper> dpadLeft = nullptr;
-        std::unique_ptr<const IElementMapper> dpadRight = nullptr;
-        std::unique_ptr<const IElementMapper> triggerLT = nullptr;
-        std::unique_ptr<const IElementMapper> triggerRT = nullptr;
-        std::unique_ptr<const IElementMapper> buttonA = nullptr;
-        std::unique_ptr<const IElementMapper> buttonB = nullptr;
-        std::unique_ptr<const IElementMapper> buttonX = nullptr;
-        std::unique_ptr<const IElementMapper> buttonY = nullptr;
-        std::unique_ptr<const IElementMapper> buttonLB = nullptr;
-        std::unique_ptr<const IElementMapper> buttonRB = nullptr;
-        std::unique_ptr<const IElementMapper> buttonBack = nullptr;
-        std::unique_ptr<const IElementMapper> buttonStart = nullptr;
-        std::unique_ptr<const IElementMapper> buttonLS = nullptr;
-        std::unique_ptr<const IElementMapper> buttonRS = nullptr;
+        std::shared_ptr<const IElementMapper> stickLeftX = nullptr;
+        std::shared_ptr<const IElementMapper> stickLeftY = nullptr;
+        std::shared_ptr<const IElementMapper> stickRightX = nullptr;
+        std::shared_ptr<const IElementMapper> stickRightY = nullptr;
+        std::shared_ptr<const IElementMapper> dpadUp = nullptr;
+        std::shared_ptr<const IElementMapper> dpadDown = nullptr;
+        std::shared_ptr<const IElementMapper> dpadLeft = nullptr;
+        std::shared_ptr<const IElementMapper> dpadRight = nullptr;
+        std::shared_ptr<const IElementMapper> triggerLT = nullptr;
+        std::shared_ptr<const IElementMapper> triggerRT = nullptr;
+        std::shared_ptr<const IElementMapper> buttonA = nullptr;
+        std::shared_ptr<const IElementMapper> buttonB = nullptr;
+        std::shared_ptr<const IElementMapper> buttonX = nullptr;
+        std::shared_ptr<const IElementMapper> buttonY = nullptr;
+        std::shared_ptr<const IElementMapper> buttonLB = nullptr;
+        std::shared_ptr<const IElementMapper> buttonRB = nullptr;
+        std::shared_ptr<const IElementMapper> buttonBack = nullptr;
+        std::shared_ptr<const IElementMapper> buttonStart = nullptr;
+        std::shared_ptr<const IElementMapper> buttonLS = nullptr;
+        std::shared_ptr<const IElementMapper> buttonRS = nullptr;
       };
 
+      /// Number of controller elements in an element map.
+      static constexpr unsigned int kElementMapSize =
+          sizeof(SElementMap) / sizeof(std::shared_ptr<const IElementMapper>);
+
+      /// Values read from all controller elements, after all transformations configured for the
+      /// physical controller are applied, in the order they appear in an element map.
+      using TSourceValues = std::array<int32_t, kElementMapSize>;
+
       /// Physical force feedback actuator mappers, one per force feedback actuator.
       /// For force feedback actuators that are not used, the `valid` bit is set to 0.
       /// Names correspond to the enumerators in the #ForceFeedback::EActuator enumeration.
@@ -93,8 +112,7 @@ namespace Xidi
       union UElementMap
       {
         SElementMap named;
-        std::unique_ptr<const IElementMapper>
-            all[sizeof(SElementMap) / sizeof(std::unique_ptr<const IElementMapper>)];
+        std::shared_ptr<const IElementMapper> all[kElementMapSize];
 
         static_assert(sizeof(named) == sizeof(all), "Element map field mismatch.");
 
@@ -150,6 +168,59 @@ namespace Xidi
           sizeof(UForceFeedbackActuatorMap::named) == sizeof(UForceFeedbackActuatorMap::all),
           "Force feedback actuator field mismatch.");
 
+      /// Location within the compiled contribution program of the instructions that belong to a
+      /// single controller element. Intended for internal use only.
+      struct SElementProgramSegment
+      {
+        /// Instructions that make the controller element's contributions.
+        ElementMapperProgram::SInstructionRange instructions;
+
+        /// Whether or not all of the contributions can later be undone.
+        bool isReversible;
+      };
+
+      /// Holds all of the transformations that are applied to raw analog values read from a
+      /// physical controller before they are supplied to element mappers.
+      struct SPhysicalControllerTransforms
+      {
+        Math::CircleToSquareTransform circleToSquareStickLeft;
+        Math::CircleToSquareTransform circleToSquareStickRight;
+        Math::RawAnalogTransformTable rawStickLeft;
+        Math::RawAnalogTransformTable rawStickRight;
+        Math::RawTriggerTransformTable rawTriggerLT;
+        Math::RawTriggerTransformTable rawTriggerRT;
+      };
+
+      /// Holds everything needed to map physical controller states incrementally, based on what
+      /// changed since the previous mapping. Each physical controller that is mapped this way needs
+      /// its own instance, and instances must not be used concurrently. A default-constructed
+      /// instance causes the next mapping to be done from scratch.
+      struct SIncrementalMappingState
+      {
+        /// Mapper that most recently used this object, or `nullptr` if none has.
+        const Mapper* mapper = nullptr;
+
+        /// Transformations that were applied to raw analog values during the most recent mapping,
+        /// or `nullptr` if there has not been one.
+        const SPhysicalControllerTransforms* transforms = nullptr;
+
+        /// Physical controller state that was most recently mapped.
+        SPhysicalState physicalState = {};
+
+        /// Controller element values that were most recently mapped.
+        TSourceValues sourceValues = {};
+
+        /// Sum of all reversible contributions to each axis, without saturation.
+        std::array<int32_t, static_cast<int>(EAxis::Count)> axisContributions = {};
+
+        /// Number of controller elements whose reversible contributions press each button.
+        std::array<uint8_t, static_cast<int>(EButton::Count)> buttonContributions = {};
+
+        /// Number of controller elements whose reversible contributions press each POV direction.
+        std::array<uint8_t, static_cast<int>(EPovDirection::Count)> povDirectionContributions =
+            {};
+      };
+
       /// Set of axes that must be present on all virtual controllers.
       /// Contents are based on expectations of both DirectInput and WinMM state data structures.
       /// If no element mappers contribute to these axes then they will be continually reported as
@@ -184,6 +255,15 @@ namespace Xidi
           SElementMap&& elements,
           SForceFeedbackActuatorMap forceFeedbackActuators = kDefaultForceFeedbackActuatorMap);
 
+      /// Same as above, but registration by name can be deferred. Mappers built to replace
+      /// existing mappers of the same name are not registered until they are published, at which
+      /// point #PublishConfigured registers them.
+      Mapper(
+          const std::wstring_view name,
+          SElementMap&& elements,
+          SForceFeedbackActuatorMap forceFeedbackActuators,
+          bool registerName);
+
       /// Does not require or register a name for this mapper. This version is primarily useful for
       /// testing. Requires that a unique mapper be specified for each controller element, which in
       /// turn becomes owned by this object. For controller elements that are not used, `nullptr`
@@ -192,6 +272,10 @@ namespace Xidi
           SElementMap&& elements,
           SForceFeedbackActuatorMap forceFeedbackActuators = kDefaultForceFeedbackActuatorMap);
 
+      /// Copies the element mappers of another mapper, which requires compiling them again because
+      /// compiled programs can refer to the element mappers that were compiled.
+      Mapper(const Mapper& other);
+
       /// In general, mapper objects should not be destroyed once created.
       /// However, tests may create mappers as temporaries that end up being destroyed.
       ~Mapper(void);
@@ -199,25 +283,57 @@ namespace Xidi
       /// Dumps information about all registered mappers.
       static void DumpRegisteredMappers(void);
 
+      /// Retrieves the built-in mappers, creating and registering them if this is the first time
+      /// they are needed. Built-in mappers are defined in "MapperDefinitions.cpp" and exist for the
+      /// rest of the lifetime of the process once created. The first one is the default mapper.
+      /// @return All built-in mappers.
+      static std::span<const Mapper> GetBuiltIn(void);
+
       /// Retrieves and returns a pointer to the mapper object whose name is specified.
       /// Mapper objects are created and managed internally, so this operation does not dynamically
       /// allocate or deallocate memory, nor should the caller attempt to free the returned pointer.
-      /// @param [in] mapperName Name of the desired mapper. Supported built-in values are defined
-      /// in "MapperDefinitions.cpp" as mapper instances, but more could be built and registered at
-      /// runtime.
+      /// @param [in] mapperName Name of the desired mapper, or empty for the default mapper.
+      /// Supported built-in values are defined in "MapperDefinitions.cpp" as mapper instances, but
+      /// more could be built and registered at runtime.
       /// @return Pointer to the mapper of specified name, or `nullptr` if said mapper is
       /// unavailable.
       static const Mapper* GetByName(std::wstring_view mapperName);
 
       /// Retrieves and returns a pointer to the mapper object whose type is read from the
       /// configuration file for the specified controller identifier. If no mapper specified there,
-      /// then the default mapper type is used instead.
+      /// then the default mapper type is used instead. Configured mappers can be replaced at
+      /// runtime, after which the returned mapper might be destroyed, so callers that use the
+      /// configured mappers for any length of time should use #ReadConfigured instead.
       /// @param [in] controllerIdentifier Identifier of the controller for which a mapper is
       /// requested.
       static const Mapper* GetConfigured(TControllerIdentifier controllerIdentifier);
 
+      /// Creates a reader for the mapper set that holds the configured mapper for every physical
+      /// controller. The mappers it reads remain valid for as long as the reader exists and does
+      /// not refresh.
+      /// @return Reader for the configured mapper set.
+      static MapperSetReader ReadConfigured(void);
+
+      /// Determines which mapper is configured for each physical controller and publishes the
+      /// result, replacing the configured mappers for all readers. Mappers built to replace
+      /// existing ones are preferred over registered mappers of the same name, and they are
+      /// registered by name as part of publication.
+      /// @param [in] configData Configuration data from which to read the mapper assignments.
+      /// @param [in] replacementMappers Mappers built to replace existing ones, which become owned
+      /// by the published mapper set. None of them should already be registered.
+      /// @return Generation number of the published mapper set.
+      static uint64_t PublishConfigured(
+          const Infra::Configuration::ConfigurationData& configData,
+          MapperSet::TOwnedMappers&& replacementMappers);
+
+      /// Retrieves and returns the transformations that the configuration file specifies for raw
+      /// analog values read from physical controllers. These are created the first time this
+      /// function is invoked and are the same for all physical controllers.
+      /// @return Read-only reference to the configured transformations.
+      static const SPhysicalControllerTransforms& GetConfiguredPhysicalControllerTransforms(void);
+
       /// Retrieves and returns a pointer to the default mapper object.
-      /// @return Pointer to the default mapper object, or `nullptr` if there is no default.
+      /// @return Pointer to the default mapper object.
       static inline const Mapper* GetDefault(void)
       {
         return GetByName(L"");
@@ -237,8 +353,9 @@ namespace Xidi
         return (nullptr != GetByName(mapperName));
       }
 
-      /// Returns a copy of this mapper's element map.
-      /// Useful for dynamically generating new mappers using this mapper as a template.
+      /// Returns a copy of this mapper's element map. Wherever possible the copy shares this
+      /// mapper's element mappers rather than duplicating them. Useful for dynamically generating
+      /// new mappers using this mapper as a template.
       /// @return Copy of this mapper's element map.
       inline UElementMap CloneElementMap(void) const
       {
@@ -296,6 +413,64 @@ namespace Xidi
       SState MapStatePhysicalToVirtual(
           SPhysicalState physicalState, uint32_t sourceControllerIdentifier) const;
 
+      /// Maps from physical controller state to virtual controller state incrementally. Only the
+      /// element mappers whose controller elements changed since the previous mapping are
+      /// evaluated again, and their previous contributions are replaced with new ones. Element
+      /// mappers whose contributions cannot be undone, such as those with keyboard or mouse side
+      /// effects, are evaluated every time. Results are identical to those of the non-incremental
+      /// version. Does not apply any properties configured by the application, such as deadzone
+      /// and range.
+      /// @param [in] physicalState Physical controller state from which to read.
+      /// @param [in] sourceControllerIdentifier Opaque identifier of the physical controller
+      /// associated with the state being mapped.
+      /// @param [in,out] incrementalState Information about the previous mapping for the same
+      /// physical controller, updated to reflect this mapping.
+      /// @return Controller state object that was filled as a result of the mapping.
+      inline SState MapStatePhysicalToVirtual(
+          SPhysicalState physicalState,
+          uint32_t sourceControllerIdentifier,
+          SIncrementalMappingState& incrementalState) const
+      {
+        return MapStatePhysicalToVirtual(
+            physicalState,
+            sourceControllerIdentifier,
+            incrementalState,
+            GetConfiguredPhysicalControllerTransforms());
+      }
+
+      /// Maps from physical controller state to virtual controller state incrementally, using
+      /// the specified transformations for raw analog values instead of the configured ones.
+      /// Otherwise identical to the incremental version that uses configured transformations.
+      /// @param [in] physicalState Physical controller state from which to read.
+      /// @param [in] sourceControllerIdentifier Opaque identifier of the physical controller
+      /// associated with the state being mapped.
+      /// @param [in,out] incrementalState Information about the previous mapping for the same
+      /// physical controller, updated to reflect this mapping.
+      /// @param [in] transforms Transformations to apply to raw analog values.
+      /// @return Controller state object that was filled as a result of the mapping.
+      SState MapStatePhysicalToVirtual(
+          SPhysicalState physicalState,
+          uint32_t sourceControllerIdentifier,
+          SIncrementalMappingState& incrementalState,
+          const SPhysicalControllerTransforms& transforms) const;
+
+      /// Maps many physical controller states to virtual controller states at once. Intended for
+      /// bulk processing of streams of physical controller states, such as for replay,
+      /// benchmarking, and offline analysis. States are processed in blocks, and within each
+      /// block as many steps as possible are applied to all states together. Results are identical
+      /// to mapping each state individually and in order using the non-incremental version. Does
+      /// not apply any properties configured by the application, such as deadzone and range.
+      /// @param [in] physicalStates Physical controller states from which to read.
+      /// @param [out] controllerStates Filled with the virtual controller state that corresponds
+      /// to each physical controller state. If the sizes differ, only as many states are mapped as
+      /// fit into both.
+      /// @param [in] sourceControllerIdentifier Opaque identifier of the physical controller
+      /// associated with the states being mapped.
+      void MapStatesPhysicalToVirtual(
+          std::span<const SPhysicalState> physicalStates,
+          std::span<SState> controllerStates,
+          uint32_t sourceControllerIdentifier) const;
+
       /// Maps from physical controller state to virtual controller state in which the physical
       /// controller is completely neutral and possibly even disconnected. Does not apply any
       /// properties configured by the application, such as deadzone and range.
@@ -309,6 +484,21 @@ namespace Xidi
       /// All controller element mappers.
       const UElementMap elements;
 
+      /// All controller element mappers compiled into a program that makes their contributions.
+      /// Initialization of this member depends on prior initialization of #elements so it must
+      /// come after.
+      const ElementMapperProgram contributionProgram;
+
+      /// Location of each controller element's instructions within #contributionProgram.
+      /// Initialization of this member depends on prior initialization of #contributionProgram so
+      /// it must come after.
+      const std::array<SElementProgramSegment, kElementMapSize> contributionProgramSegments;
+
+      /// All controller element mappers compiled into a program that makes their neutral
+      /// contributions. Initialization of this member depends on prior initialization of
+      /// #elements so it must come after.
+      const ElementMapperProgram neutralProgram;
+
       /// All force feedback actuator mappings.
       const UForceFeedbackActuatorMap forceFeedbackActuators;
 
@@ -320,5 +510,129 @@ namespace Xidi
       /// Name of this mapper.
       const std::wstring_view name;
     };
+
+    /// Holds everything needed to map the states of a single physical controller, all of which is
+    /// resolved once when the context is created. Mapping through a context involves no
+    /// configuration lookups and no one-time initialization checks, which makes it suitable for
+    /// use in the physical controller polling loop. Mapping is incremental, so each context should
+    /// only be used for a single physical controller. Contexts can either use a fixed mapper or
+    /// follow the configured mapper for a physical controller, in which case they switch to a
+    /// replacement mapper as soon as it is published without needing any locks. Not
+    /// concurrency-safe.
+    class MappingContext
+    {
+    public:
+
+      /// Creates a mapping context that follows the configured mapper for the specified physical
+      /// controller and uses the transformations specified in the configuration file.
+      /// @param [in] controllerIdentifier Identifier of the physical controller whose configured
+      /// mapper is to be used.
+      /// @param [in] sourceControllerIdentifier Opaque identifier of the physical controller whose
+      /// states are to be mapped.
+      inline MappingContext(
+          TControllerIdentifier controllerIdentifier, uint32_t sourceControllerIdentifier)
+          : mapper(nullptr),
+            transforms(&Mapper::GetConfiguredPhysicalControllerTransforms()),
+            sourceControllerIdentifier(sourceControllerIdentifier),
+            incrementalState(),
+            configuredMappers(Mapper::ReadConfigured()),
+            controllerIdentifier(controllerIdentifier)
+      {
+        mapper = configuredMappers.value()->GetMapper(controllerIdentifier);
+      }
+
+      /// Creates a mapping context that uses the transformations specified in the configuration
+      /// file.
+      /// @param [in] mapper Mapper to use for all mappings.
+      /// @param [in] sourceControllerIdentifier Opaque identifier of the physical controller whose
+      /// states are to be mapped.
+      inline MappingContext(const Mapper* mapper, uint32_t sourceControllerIdentifier)
+          : MappingContext(
+                mapper,
+                sourceControllerIdentifier,
+                Mapper::GetConfiguredPhysicalControllerTransforms())
+      {}
+
+      /// Creates a mapping context that uses the specified transformations.
+      /// @param [in] mapper Mapper to use for all mappings.
+      /// @param [in] sourceControllerIdentifier Opaque identifier of the physical controller whose
+      /// states are to be mapped.
+      /// @param [in] transforms Transformations to apply to raw analog values, which must outlive
+      /// the context.
+      inline MappingContext(
+          const Mapper* mapper,
+          uint32_t sourceControllerIdentifier,
+          const Mapper::SPhysicalControllerTransforms& transforms)
+          : mapper(mapper),
+            transforms(&transforms),
+            sourceControllerIdentifier(sourceControllerIdentifier),
+            incrementalState(),
+            configuredMappers(),
+            controllerIdentifier()
+      {}
+
+      /// Retrieves the mapper that this context uses.
+      /// @return Pointer to the mapper.
+      inline const Mapper* GetMapper(void) const
+      {
+        return mapper;
+      }
+
+      /// Switches to the configured mapper if a replacement for it has been published. Has no
+      /// effect on contexts that use a fixed mapper. Switching mappers restarts incremental
+      /// mapping.
+      /// @return `true` if this context switched to a different mapper, `false` otherwise.
+      inline bool Refresh(void)
+      {
+        if ((false == configuredMappers.has_value()) || (false == configuredMappers->Refresh()))
+          return false;
+
+        // The previous mapper might already be destroyed, and a replacement mapper could even
+        // occupy the same memory, so the incremental mapping state cannot be trusted.
+        mapper = configuredMappers.value()->GetMapper(controllerIdentifier);
+        incrementalState = Mapper::SIncrementalMappingState();
+        return true;
+      }
+
+      /// Maps from physical controller state to virtual controller state. Mapping is incremental,
+      /// based on the physical controller state most recently mapped using this context.
+      /// @param [in] physicalState Physical controller state from which to read.
+      /// @return Controller state object that was filled as a result of the mapping.
+      inline SState MapStatePhysicalToVirtual(const SPhysicalState& physicalState)
+      {
+        Refresh();
+        return mapper->MapStatePhysicalToVirtual(
+            physicalState, sourceControllerIdentifier, incrementalState, *transforms);
+      }
+
+      /// Maps from physical controller state to virtual controller state in which the physical
+      /// controller is completely neutral and possibly even disconnected.
+      /// @return Controller state object that was filled as a result of the mapping.
+      inline SState MapNeutralPhysicalToVirtual(void) const
+      {
+        return mapper->MapNeutralPhysicalToVirtual(sourceControllerIdentifier);
+      }
+
+    private:
+
+      /// Mapper to use for all mappings.
+      const Mapper* mapper;
+
+      /// Transformations to apply to raw analog values.
+      const Mapper::SPhysicalControllerTransforms* transforms;
+
+      /// Opaque identifier of the physical controller whose states are being mapped.
+      uint32_t sourceControllerIdentifier;
+
+      /// Information about the previous mapping, used to make the next one incremental.
+      Mapper::SIncrementalMappingState incrementalState;
+
+      /// Reader for the configured mappers, present only if this context follows the configured
+      /// mapper for a physical controller.
+      std::optional<MapperSetReader> configuredMappers;
+
+      /// Identifier of the physical controller whose configured mapper this context follows.
+      TControllerIdentifier controllerIdentifier;
+    };
   } // namespace Controller
 } // namespace Xidi
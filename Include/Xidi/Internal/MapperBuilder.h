@@ -21,6 +21,7 @@
 #include "ElementMapper.h"
 #include "ForceFeedbackTypes.h"
 #include "Mapper.h"
+#include "MapperSet.h"
 
 namespace Xidi
 {
@@ -70,6 +71,9 @@ namespace Xidi
 
         /// Flag for specifying if this blueprint is valid for building.
         bool buildCanAttempt = true;
+
+        /// Mapper object that was built from this blueprint, if the build was successful.
+        const Mapper* builtMapper = nullptr;
       };
 
       /// Attempts to build mapper objects based on all of the blueprints known to this mapper
@@ -80,18 +84,39 @@ namespace Xidi
 
       /// Attempts to use a blueprint to build a mapper object of the specified name.
       /// Once a build attempt is made on a blueprint, that blueprint can no longer be modified.
-      /// This method will fail if a mapper already exists with the specified name or if there is a
-      /// blueprint template issue. If this method succeeds, then a mapper object was successfully
-      /// created and can now be referenced by name. Any returned pointers are owned by the internal
-      /// mapper registry.
+      /// This method will fail if a mapper already exists with the specified name, unless it is a
+      /// custom mapper being replaced, or if there is a blueprint template issue. If this method
+      /// succeeds, then a mapper object was successfully created and can now be referenced by
+      /// name. Any returned pointers are owned by the internal mapper registry, except for
+      /// replacement mappers, which are owned by this object.
       /// @param [in] mapperName Name that identifies the mapper described by a blueprint.
       /// @return Pointer to the new mapper object if successful, `nullptr` otherwise.
       const Mapper* Build(std::wstring_view mapperName);
 
-      /// Deletes all blueprints held by this object, resetting it to a pristine state.
+      /// Deletes all blueprints held by this object, along with any replacement mappers built from
+      /// them that were not released, resetting it to a pristine state.
       inline void Clear(void)
       {
         blueprints.clear();
+        builtReplacementMappers.clear();
+      }
+
+      /// Configures this object to build mappers that replace custom mappers built previously, as
+      /// happens when the configuration file is read again at runtime. Blueprints can then reuse
+      /// the names of previously-built custom mappers, but still not the names of any other
+      /// mappers. Mappers built this way are neither registered by name nor owned by the internal
+      /// mapper registry. Instead they are owned by this object until released using
+      /// #ReleaseReplacementMappers.
+      inline void EnableReplacement(void)
+      {
+        buildsReplacements = true;
+      }
+
+      /// Transfers ownership of all replacement mappers built so far to the caller.
+      /// @return Replacement mappers, which are empty unless replacement is enabled.
+      inline MapperSet::TOwnedMappers ReleaseReplacementMappers(void)
+      {
+        return std::move(builtReplacementMappers);
       }
 
       /// Removes an element mapper from this blueprint's element map specification so it is not
@@ -253,8 +278,21 @@ namespace Xidi
 
     private:
 
+      /// Determines if a blueprint is allowed to use the specified name for the mapper it
+      /// describes, which is the case if no mapper of the same name exists or, if this object
+      /// builds replacements, if the mapper of the same name is a custom mapper.
+      /// @param [in] mapperName Name of the mapper to check.
+      /// @return `true` if the name is available, `false` otherwise.
+      bool IsMapperNameAvailable(std::wstring_view mapperName) const;
+
       /// Holds all known mapper blueprints.
       std::map<std::wstring_view, SBlueprint> blueprints;
+
+      /// Holds all replacement mappers built by this object and not yet released.
+      MapperSet::TOwnedMappers builtReplacementMappers;
+
+      /// Whether or not this object builds mappers that replace custom mappers built previously.
+      bool buildsReplacements = false;
     };
   } // namespace Controller
 } // namespace Xidi
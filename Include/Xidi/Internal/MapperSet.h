@@ -0,0 +1,194 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file MapperSet.h
+ *   Declaration of immutable sets of mappers assigned to physical controllers, which can be
+ *   replaced at runtime without blocking the threads that use them.
+ **************************************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ControllerTypes.h"
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    class Mapper;
+    class MapperSetReader;
+
+    /// Immutable assignment of mappers to physical controllers. At most one mapper set is
+    /// published at any given time, and publishing a new one replaces it for all readers. Readers
+    /// access the published mapper set through #MapperSetReader objects, which never block. A
+    /// mapper set that is replaced is retired and then destroyed by a later publication, along
+    /// with any mappers it owns, once no reader is still reading from it.
+    class MapperSet
+    {
+    public:
+
+      /// Type used to hold the mapper assigned to each physical controller.
+      using TMapperArray = std::array<const Mapper*, kPhysicalControllerCount>;
+
+      /// Type used to hold mappers owned by a mapper set.
+      using TOwnedMappers = std::vector<std::unique_ptr<const Mapper>>;
+
+      /// Creates a mapper set.
+      /// @param [in] mappers Mapper assigned to each physical controller. None of them can be
+      /// `nullptr`.
+      /// @param [in] ownedMappers Mappers that become owned by the new mapper set and are
+      /// destroyed along with it. Mappers that are not owned by a mapper set must outlive every
+      /// mapper set that refers to them.
+      MapperSet(const TMapperArray& mappers, TOwnedMappers&& ownedMappers = TOwnedMappers());
+
+      MapperSet(const MapperSet& other) = delete;
+
+      ~MapperSet(void);
+
+      /// Publishes a mapper set, replacing whatever mapper set was previously published. Readers
+      /// switch to the new mapper set the next time they refresh. The replaced mapper set is
+      /// retired, and any retired mapper sets that no reader is still reading from are destroyed.
+      /// Concurrency-safe, but concurrent publications are serialized.
+      /// @param [in] mapperSet Mapper set to publish, which becomes owned internally.
+      /// @return Generation number assigned to the newly-published mapper set.
+      static uint64_t Publish(std::unique_ptr<MapperSet> mapperSet);
+
+      /// Destroys all retired mapper sets that no reader is still reading from. This happens
+      /// automatically whenever a mapper set is published, so invoking this function directly is
+      /// not normally needed. Readers never reclaim anything themselves, so a retired mapper set
+      /// whose last reader moves on is destroyed at the next publication or invocation of this
+      /// function. Concurrency-safe.
+      /// @return Number of retired mapper sets that still have readers and hence remain.
+      static size_t ReclaimRetired(void);
+
+      /// Retrieves the generation number of this mapper set, which identifies the publication
+      /// that made it available. Generation numbers start at 1 and increase with every
+      /// publication.
+      /// @return Generation number, or 0 if this mapper set was never published.
+      inline uint64_t GetGeneration(void) const
+      {
+        return generation;
+      }
+
+      /// Retrieves the generation number of the mapper set that is currently published, without
+      /// reading from it. Allows information derived from the published mapper set to be cached
+      /// and only derived again once a different mapper set is published.
+      /// @return Generation number, or 0 if nothing has ever been published.
+      static inline uint64_t GetPublishedGeneration(void)
+      {
+        return publishedGeneration.load(std::memory_order_acquire);
+      }
+
+      /// Retrieves the mapper assigned to the specified physical controller.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @return Pointer to the assigned mapper.
+      inline const Mapper* GetMapper(TControllerIdentifier controllerIdentifier) const
+      {
+        return mappers[controllerIdentifier];
+      }
+
+    private:
+
+      friend class MapperSetReader;
+
+      /// Holds a pointer to the mapper set that is currently published. Readers compare this
+      /// pointer with the mapper set they are reading from to determine if they need to switch.
+      static inline std::atomic<const MapperSet*> published = nullptr;
+
+      /// Generation number of the mapper set that is currently published. Only written while
+      /// publications are serialized, after the mapper set itself is published.
+      static inline std::atomic<uint64_t> publishedGeneration = 0;
+
+      /// Mapper assigned to each physical controller.
+      const TMapperArray mappers;
+
+      /// Mappers that this mapper set owns.
+      const TOwnedMappers ownedMappers;
+
+      /// Generation number of this mapper set, assigned when it is published.
+      uint64_t generation;
+    };
+
+    /// Reads from whatever mapper set is published. Each reader protects the mapper set it is
+    /// reading from, so that mapper set and all mappers it refers to remain valid until the reader
+    /// refreshes or is destroyed, even if another mapper set is published in the meantime.
+    /// Refreshing is lock-free and, when nothing has been published since the previous refresh,
+    /// consists of a single atomic load. Intended to be used by threads that repeatedly use the
+    /// mappers assigned to physical controllers. Not concurrency-safe, so each thread should use
+    /// its own reader.
+    class MapperSetReader
+    {
+    public:
+
+      /// Element in the list of records through which readers protect the mapper sets they are
+      /// reading from. Records are allocated when needed and reused by readers created later, but
+      /// never deallocated. Defined internally.
+      struct SHazardRecord;
+
+      /// Creates a reader that reads from whatever mapper set is currently published, if any.
+      MapperSetReader(void);
+
+      /// Creates a reader that reads from the same mapper set as another reader.
+      MapperSetReader(const MapperSetReader& other);
+
+      /// Creates a reader that takes over from another reader, which becomes empty.
+      MapperSetReader(MapperSetReader&& other) noexcept;
+
+      MapperSetReader& operator=(const MapperSetReader& other) = delete;
+
+      ~MapperSetReader(void);
+
+      inline const MapperSet& operator*(void) const
+      {
+        return *mapperSet;
+      }
+
+      inline const MapperSet* operator->(void) const
+      {
+        return mapperSet;
+      }
+
+      /// Retrieves the mapper set from which this reader is reading.
+      /// @return Pointer to the mapper set, or `nullptr` if nothing has ever been published or the
+      /// reader is empty.
+      inline const MapperSet* Get(void) const
+      {
+        return mapperSet;
+      }
+
+      /// Switches this reader to the published mapper set if it is different from the one
+      /// currently being read. Intended to be invoked periodically, such as once per iteration of
+      /// a polling loop.
+      /// @return `true` if this reader switched to a different mapper set, `false` otherwise.
+      inline bool Refresh(void)
+      {
+        if (MapperSet::published.load(std::memory_order_acquire) == mapperSet) return false;
+        if (nullptr == hazardRecord) return false;
+
+        Protect();
+        return true;
+      }
+
+    private:
+
+      /// Reads and protects the mapper set that is currently published. On return the previously
+      /// protected mapper set, if any, is no longer protected by this reader.
+      void Protect(void);
+
+      /// Record through which this reader protects the mapper set it is reading from.
+      SHazardRecord* hazardRecord;
+
+      /// Mapper set from which this reader is reading.
+      const MapperSet* mapperSet;
+    };
+  } // namespace Controller
+} // namespace Xidi
@@ -0,0 +1,211 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file PeriodicJobScheduler.h
+ *   Declaration of a deadline-based scheduler that runs periodic jobs on a single worker thread.
+ **************************************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace Xidi
+{
+  /// Runs any number of periodic jobs on a single worker thread. Jobs are kept in a queue ordered
+  /// by deadline, and the worker thread sleeps until the earliest deadline arrives. Each job has
+  /// its own policy that determines its period, how that period stretches while the job is idle,
+  /// and how long to back off after the job fails. Jobs themselves are executed without any
+  /// internal locks held, so they are free to block or to interact with the scheduler.
+  class PeriodicJobScheduler
+  {
+  public:
+
+    /// Clock used for computing job deadlines.
+    using TClock = std::chrono::steady_clock;
+
+    /// Opaque identifier for a job that has been added to a scheduler.
+    using TJobIdentifier = unsigned int;
+
+    /// Enumerates the possible outcomes of a single invocation of a job.
+    enum class EJobResult
+    {
+      /// Job completed successfully and found work to do. Next invocation is scheduled one period
+      /// later.
+      Success,
+
+      /// Job completed successfully but found no work to do. Next invocation is scheduled based on
+      /// how long the job has been idle, anywhere between one period and one idle period later.
+      Idle,
+
+      /// Job encountered an error. Next invocation is scheduled one error backoff period later.
+      Error,
+
+      /// Job has no work to do for the foreseeable future. Job is parked, meaning it is not invoked
+      /// again until it is explicitly resumed.
+      Park
+    };
+
+    /// Describes how frequently a job is to be invoked. Jobs that report being idle are invoked
+    /// progressively less frequently, starting at the nominal period and increasing linearly over
+    /// the idle decay period until reaching the idle period. Any successful invocation that is not
+    /// idle immediately restores the nominal period. Setting the idle period equal to the nominal
+    /// period disables this behavior.
+    struct SJobPolicy
+    {
+      /// Nominal amount of time between successive invocations of the job.
+      std::chrono::milliseconds period;
+
+      /// Amount of time to wait before invoking the job again if it reports an error.
+      std::chrono::milliseconds errorBackoffPeriod;
+
+      /// Amount of time between successive invocations of the job once it has been idle for at
+      /// least the idle decay period. Values less than the nominal period are treated as being
+      /// equal to the nominal period.
+      std::chrono::milliseconds idlePeriod = std::chrono::milliseconds::zero();
+
+      /// Amount of time a job must be continuously idle before its period reaches the idle period.
+      std::chrono::milliseconds idleDecayPeriod = std::chrono::milliseconds::zero();
+    };
+
+    /// Type for the function that implements a job.
+    using TJobFunction = std::function<EJobResult(void)>;
+
+    PeriodicJobScheduler(void);
+
+    PeriodicJobScheduler(const PeriodicJobScheduler& other) = delete;
+
+    PeriodicJobScheduler(PeriodicJobScheduler&& other) = delete;
+
+    /// Stops the worker thread, if it is running, and waits for it to exit.
+    ~PeriodicJobScheduler(void);
+
+    /// Adds a job to this scheduler. The job is first invoked one period after it is added.
+    /// Concurrency-safe, and can be used both before and after the worker thread is started.
+    /// @param [in] policy Policy that determines how frequently the job is invoked.
+    /// @param [in] jobFunction Function that implements the job.
+    /// @return Identifier of the newly-added job.
+    TJobIdentifier AddJob(const SJobPolicy& policy, TJobFunction&& jobFunction);
+
+    /// Resumes a job that parked itself or reported being idle, scheduling it to be invoked
+    /// immediately and restoring its nominal period. If the job is currently being invoked then it
+    /// is resumed as soon as that invocation completes, even if the invocation asks for the job to
+    /// be parked or reports being idle. Has no effect on jobs that are neither parked, idle, nor
+    /// being invoked. Concurrency-safe.
+    /// @param [in] jobIdentifier Identifier of the job to resume.
+    void ResumeJob(TJobIdentifier jobIdentifier);
+
+    /// Retrieves the number of times the specified job has been invoked. Intended primarily for
+    /// diagnostics and testing. Concurrency-safe.
+    /// @param [in] jobIdentifier Identifier of the job of interest.
+    /// @return Number of completed invocations of the specified job, or 0 if the identifier is
+    /// invalid.
+    unsigned int GetJobInvocationCount(TJobIdentifier jobIdentifier);
+
+    /// Determines if the worker thread has been started.
+    /// @return `true` if so, `false` if not.
+    inline bool IsRunning(void) const
+    {
+      return workerThread.joinable();
+    }
+
+    /// Starts the worker thread. Has no effect if the worker thread is already running. Not
+    /// concurrency-safe with respect to #Stop.
+    void Start(void);
+
+    /// Stops the worker thread and waits for it to exit. Any job currently being invoked is allowed
+    /// to finish. Has no effect if the worker thread is not running. Not concurrency-safe with
+    /// respect to #Start.
+    void Stop(void);
+
+  private:
+
+    /// Holds all of the information needed to represent a single job.
+    struct SJob
+    {
+      /// Policy that determines how frequently the job is invoked.
+      SJobPolicy policy;
+
+      /// Function that implements the job.
+      TJobFunction function;
+
+      /// Number of times the job has been invoked.
+      unsigned int invocationCount;
+
+      /// Point in time at which the job most recently completed an invocation that was not idle.
+      TClock::time_point lastActiveTime;
+
+      /// Deadline of the job's entry in the deadline queue. Resuming an idle job leaves its
+      /// previous entry behind, and any entry whose deadline does not match is discarded.
+      TClock::time_point scheduledDeadline;
+
+      /// Whether or not the job is currently being invoked by the worker thread.
+      bool isBeingInvoked;
+
+      /// Whether or not the job's most recent invocation reported that it was idle.
+      bool isIdle;
+
+      /// Whether or not the job is parked, in which case it is absent from the deadline queue.
+      bool isParked;
+
+      /// Whether or not a request to resume the job arrived while it was being invoked.
+      bool resumeRequested;
+    };
+
+    /// Single entry in the deadline queue.
+    struct SQueueEntry
+    {
+      /// Point in time at which the job should next be invoked.
+      TClock::time_point deadline;
+
+      /// Identifier of the job to be invoked.
+      TJobIdentifier jobIdentifier;
+
+      constexpr bool operator>(const SQueueEntry& other) const
+      {
+        return (deadline > other.deadline);
+      }
+    };
+
+    /// Computes the amount of time to wait between invocations of a job that has been idle for the
+    /// specified amount of time.
+    /// @param [in] policy Policy associated with the job.
+    /// @param [in] idleTime Amount of time for which the job has been continuously idle.
+    /// @return Amount of time to wait before invoking the job again.
+    static TClock::duration IdleJobPeriod(const SJobPolicy& policy, TClock::duration idleTime);
+
+    /// Entry point for the worker thread.
+    /// @param [in] stopToken Token used to request that the worker thread exit.
+    void WorkerThread(std::stop_token stopToken);
+
+    /// All jobs that have been added to this scheduler, indexed by job identifier. Stored by
+    /// pointer so that job objects remain stable while the worker thread is invoking them without
+    /// any locks held.
+    std::vector<std::unique_ptr<SJob>> jobs;
+
+    /// Deadline queue, ordered such that the job with the earliest deadline is at the top.
+    std::priority_queue<SQueueEntry, std::vector<SQueueEntry>, std::greater<SQueueEntry>>
+        deadlineQueue;
+
+    /// Mutex for protecting against concurrent accesses to the job list and the deadline queue.
+    std::mutex mutex;
+
+    /// Condition variable used to wake the worker thread when the deadline queue changes or when
+    /// the worker thread is asked to stop.
+    std::condition_variable_any deadlineQueueChanged;
+
+    /// Worker thread that invokes all jobs.
+    std::jthread workerThread;
+  };
+} // namespace Xidi
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <stop_token>
 
 #include "ApiWindows.h"
@@ -22,16 +23,49 @@ namespace Xidi
 {
   namespace Controller
   {
-    /// Number of milliseconds to wait between polling attempts.
-    inline constexpr unsigned int kPhysicalPollingPeriodMilliseconds = 5;
+    /// Default number of milliseconds to wait between polling attempts while the physical
+    /// controller's state is actively changing.
+    inline constexpr unsigned int kPhysicalPollingPeriodFastDefaultMilliseconds = 1;
+
+    /// Default number of milliseconds to wait between polling attempts once the physical
+    /// controller's state has stopped changing for a while.
+    inline constexpr unsigned int kPhysicalPollingPeriodSlowDefaultMilliseconds = 10;
+
+    /// Default number of milliseconds over which the polling period transitions from fast to slow
+    /// while the physical controller's state remains unchanged.
+    inline constexpr unsigned int kPhysicalPollingPeriodDecayDefaultMilliseconds = 1000;
+
+    /// Default number of milliseconds a physical controller must go unreferenced before its
+    /// polling and force feedback actuation are suspended.
+    inline constexpr unsigned int kPhysicalParkAfterInactivityDefaultMilliseconds = 30000;
 
     /// Number of milliseconds to wait between force feedback actuation passes.
     inline constexpr unsigned int kPhysicalForceFeedbackPeriodMilliseconds = 5;
 
+    /// Number of milliseconds to wait between force feedback actuation passes once no effects have
+    /// been playing for a while. Starting an effect restores the nominal period immediately.
+    inline constexpr unsigned int kPhysicalForceFeedbackIdlePeriodMilliseconds = 100;
+
+    /// Number of milliseconds over which the force feedback actuation period transitions to the
+    /// idle period while no effects are playing.
+    inline constexpr unsigned int kPhysicalForceFeedbackIdleDecayPeriodMilliseconds = 1000;
+
     /// Number of milliseconds to wait between attempts to communicate with the physical hardware if
     /// the last attempt resulted in an error, such as the controller being disconnected.
     inline constexpr unsigned int kPhysicalErrorBackoffPeriodMilliseconds = 100;
 
+    /// Number of physical controller state samples retained in each physical controller's sample
+    /// history. Sized to cover several application polling intervals at the fastest polling rate.
+    inline constexpr unsigned int kPhysicalSampleHistoryCapacity = 64;
+
+    /// Type used to identify positions within a physical controller's sample history.
+    using TPhysicalSampleHistoryCursor = uint64_t;
+
+    /// Type used to identify successive versions of a physical controller's published states.
+    /// Advances each time the corresponding state is updated, even if the update restores a state
+    /// that was published previously.
+    using TControllerStateGeneration = uint32_t;
+
     /// Retrieves and returns the capabilities of the controller layout implemented by the mapper
     /// associated with the specified physical controller. Controller capabilities act as metadata
     /// that are used internally and can be presented to applications. Concurrency-safe.
@@ -49,6 +83,30 @@ namespace Xidi
     /// @return Raw virtual controller state data.
     SState GetCurrentRawVirtualControllerState(TControllerIdentifier controllerIdentifier);
 
+    /// Retrieves the generation of the specified controller's published physical state. Callers
+    /// that want to wait for physical state changes from now onwards should use this as their
+    /// initial last-known generation. Concurrency-safe.
+    /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+    /// @return Generation of the physical controller state.
+    TControllerStateGeneration GetPhysicalControllerStateGeneration(
+        TControllerIdentifier controllerIdentifier);
+
+    /// Retrieves the generation of the specified controller's published raw virtual state. Callers
+    /// that want to wait for raw virtual state changes from now onwards should use this as their
+    /// initial last-known generation. Concurrency-safe.
+    /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+    /// @return Generation of the raw virtual controller state.
+    TControllerStateGeneration GetRawVirtualControllerStateGeneration(
+        TControllerIdentifier controllerIdentifier);
+
+    /// Retrieves the position in the specified controller's sample history at which the next
+    /// sample will be recorded. Callers that want to read every sample from now onwards should use
+    /// this as their initial cursor. Concurrency-safe.
+    /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+    /// @return Cursor identifying the next sample to be recorded.
+    TPhysicalSampleHistoryCursor GetPhysicalControllerSampleHistoryCursor(
+        TControllerIdentifier controllerIdentifier);
+
     /// Attempts to register the specified virtual controller for force feedback with the specified
     /// physical controller. Concurrency-safe.
     /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
@@ -59,6 +117,13 @@ namespace Xidi
     ForceFeedback::Device* PhysicalControllerForceFeedbackRegister(
         TControllerIdentifier controllerIdentifier, const VirtualController* virtualController);
 
+    /// Notifies the specified physical controller that a force feedback effect was started in its
+    /// device buffer, so that actuation resumes at the nominal rate if it had slowed down due to no
+    /// effects playing. Concurrency-safe.
+    /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+    void PhysicalControllerForceFeedbackNotifyEffectStarted(
+        TControllerIdentifier controllerIdentifier);
+
     /// Unregisters the specified virtual controller for force feedback if it is currently
     /// registered with the specified physical controller. Concurrency-safe.
     /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
@@ -66,35 +131,79 @@ namespace Xidi
     void PhysicalControllerForceFeedbackUnregister(
         TControllerIdentifier controllerIdentifier, const VirtualController* virtualController);
 
+    /// Records that the specified physical controller is in use on behalf of a consumer that only
+    /// accesses it indirectly, such as an application reading the state of a virtual controller.
+    /// Activates the physical controller if this is the first time it is used and unparks it if
+    /// it is parked. Concurrency-safe.
+    /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+    void PhysicalControllerNotifyInUse(TControllerIdentifier controllerIdentifier);
+
+    /// Registers a consumer that expects to be notified whenever the specified physical
+    /// controller's state changes, even if it does not otherwise use the physical controller, such
+    /// as an application waiting on a virtual controller's state change event. Just like threads
+    /// waiting for state changes, registered consumers keep the physical controller from being
+    /// parked. Concurrency-safe.
+    /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+    void PhysicalControllerStateChangeNotificationRegister(
+        TControllerIdentifier controllerIdentifier);
+
+    /// Unregisters a consumer that was previously registered using
+    /// #PhysicalControllerStateChangeNotificationRegister. Concurrency-safe.
+    /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+    void PhysicalControllerStateChangeNotificationUnregister(
+        TControllerIdentifier controllerIdentifier);
+
+    /// Reads the oldest sample that is still available in the specified controller's sample
+    /// history at or after the specified position. Every physical state the controller reported
+    /// is recorded in the history, including those that were superseded before anyone observed
+    /// them, so reading all samples in order allows no input to be missed. Never blocks, and does
+    /// not count as using the physical controller. Concurrency-safe.
+    /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+    /// @param [in,out] cursor On input, identifies the next sample the caller wants to read. On
+    /// output, advanced past the sample that was read and past any samples that were lost because
+    /// the caller fell too far behind.
+    /// @param [out] sample Filled in with the sample that was read, if one was available.
+    /// @return `true` if a sample was read, `false` if no more samples are available.
+    bool ReadPhysicalControllerSampleHistory(
+        TControllerIdentifier controllerIdentifier,
+        TPhysicalSampleHistoryCursor& cursor,
+        SPhysicalSample& sample);
+
     /// Waits for the specified physical controller's state to change. When it does, retrieves and
-    /// returns the new state. This function is fully concurrency-safe. If needed, the caller can
-    /// interrupt the wait using a stop token.
+    /// returns the new state. Changes are identified by generation rather than by comparing states,
+    /// so the wait ends even if the state changed and then changed back. This function is fully
+    /// concurrency-safe. If needed, the caller can interrupt the wait using a stop token.
     /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
-    /// @param [in,out] state On input, used to identify the last-known physical controller state
-    /// for the calling thread. On output, filled in with the updated state of the physical
-    /// controller.
+    /// @param [in,out] lastKnownGeneration On input, generation of the last-known physical
+    /// controller state for the calling thread. On output, generation of the updated state.
+    /// @param [out] state Filled in with the updated state of the physical controller.
     /// @param [in] stopToken Token that allows the weight to be interrupted. Defaults to an empty
     /// token that does not allow interruption.
     /// @return `true` if the wait succeeded and the output structure was updated, `false` if no
     /// updates were made due to invalid parameter or interrupted wait.
     bool WaitForPhysicalControllerStateChange(
         TControllerIdentifier controllerIdentifier,
+        TControllerStateGeneration& lastKnownGeneration,
         SPhysicalState& state,
         std::stop_token stopToken = std::stop_token());
 
     /// Waits for the specified physical controller's raw virtual state to change. When it does,
-    /// retrieves and returns the new state. This function is fully concurrency-safe. If needed, the
-    /// caller can interrupt the wait using a stop token.
+    /// retrieves and returns the new state. Changes are identified by generation rather than by
+    /// comparing states, so the wait ends even if the state changed and then changed back. Waiting
+    /// does not count as using the physical controller, so if nothing else uses it then it can be
+    /// parked, after which the wait continues until it is unparked. This function is fully
+    /// concurrency-safe. If needed, the caller can interrupt the wait using a stop token.
     /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
-    /// @param [in,out] state On input, used to identify the last-known physical controller state
-    /// for the calling thread. On output, filled in with the updated state of the physical
-    /// controller.
+    /// @param [in,out] lastKnownGeneration On input, generation of the last-known raw virtual
+    /// controller state for the calling thread. On output, generation of the updated state.
+    /// @param [out] state Filled in with the updated raw virtual state of the physical controller.
     /// @param [in] stopToken Token that allows the weight to be interrupted. Defaults to an empty
     /// token that does not allow interruption.
     /// @return `true` if the wait succeeded and the output structure was updated, `false` if no
     /// updates were made due to invalid parameter or interrupted wait.
     bool WaitForRawVirtualControllerStateChange(
         TControllerIdentifier controllerIdentifier,
+        TControllerStateGeneration& lastKnownGeneration,
         SState& state,
         std::stop_token stopToken = std::stop_token());
   } // namespace Controller
@@ -0,0 +1,281 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file PhysicalControllerRecording.h
+ *   Declaration of functionality for recording physical controller sessions to a compact binary
+ *   format and replaying them through a mapper.
+ **************************************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "ApiWindows.h"
+#include "ControllerTypes.h"
+#include "Mapper.h"
+#include "PhysicalControllerSource.h"
+#include "SampleHistoryRing.h"
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    namespace Recording
+    {
+      /// Value that identifies the start of a recording. Spells "XIDR" when stored in memory.
+      inline constexpr uint32_t kRecordingMagic = 0x52444958;
+
+      /// Version of the recording format. Incremented whenever the format changes incompatibly.
+      inline constexpr uint16_t kRecordingVersion = 1;
+
+      /// Number of physical states per physical controller that can be waiting to be written to a
+      /// recording file. Sized to cover many flush periods at the fastest polling rate.
+      inline constexpr unsigned int kRecorderQueueCapacity = 1024;
+
+      /// Number of milliseconds between successive writes of queued physical states to a
+      /// recording file.
+      inline constexpr unsigned int kRecorderFlushPeriodMilliseconds = 20;
+
+      /// Fixed-size header at the start of every recording. All multi-byte values in a recording,
+      /// both here and in the records that follow, are stored in little-endian byte order.
+      struct SRecordingHeader
+      {
+        /// Must be equal to #kRecordingMagic.
+        uint32_t magic;
+
+        /// Must be equal to #kRecordingVersion.
+        uint16_t version;
+
+        /// Number of physical controllers for which the recording can hold records.
+        uint16_t controllerCount;
+      };
+
+      static_assert(sizeof(SRecordingHeader) == 8, "Recording header size constraint violation.");
+
+      /// Enumerates the fields of a physical controller state that a single record can contain. A
+      /// record only contains the fields that differ from the previous record for the same physical
+      /// controller, and each enumerator identifies one bit in the mask that says which ones.
+      /// Fields appear within a record in the same order as they are listed here.
+      enum class EField : uint8_t
+      {
+        /// Device status, stored as a single byte.
+        DeviceStatus,
+
+        /// Left stick horizontal axis, stored as a signed 16-bit value.
+        StickLeftX,
+
+        /// Left stick vertical axis, stored as a signed 16-bit value.
+        StickLeftY,
+
+        /// Right stick horizontal axis, stored as a signed 16-bit value.
+        StickRightX,
+
+        /// Right stick vertical axis, stored as a signed 16-bit value.
+        StickRightY,
+
+        /// Left trigger, stored as a single byte.
+        TriggerLT,
+
+        /// Right trigger, stored as a single byte.
+        TriggerRT,
+
+        /// All buttons, stored as an unsigned 16-bit bitmask.
+        Buttons,
+
+        /// Sentinel value, total number of enumerators.
+        Count
+      };
+
+      static_assert(
+          static_cast<unsigned int>(EField::Count) <= 8, "Field mask must fit into a single byte.");
+
+      /// Incrementally encodes physical controller states into records. Each record starts with
+      /// the time elapsed since the previous record, encoded as a variable-length integer in
+      /// microseconds, followed by one byte identifying the physical controller, one byte holding
+      /// the mask of fields present, and finally the fields themselves. The first record for each
+      /// physical controller is relative to a physical state in which nothing is connected and
+      /// everything is neutral. Not concurrency-safe.
+      class Encoder
+      {
+      public:
+
+        Encoder(void);
+
+        /// Appends a recording header to the specified buffer.
+        /// @param [in,out] buffer Buffer to which to append the header.
+        static void EncodeHeader(std::vector<uint8_t>& buffer);
+
+        /// Appends a record for the specified physical state to the specified buffer. If the
+        /// physical state is identical to the one encoded most recently for the same physical
+        /// controller then nothing is appended.
+        /// @param [in] controllerIdentifier Identifier of the physical controller whose state is
+        /// being encoded.
+        /// @param [in] timestampMicroseconds Time at which the physical state was read, relative
+        /// to the start of the recording. Must not be earlier than the timestamp of any record
+        /// previously encoded.
+        /// @param [in] physicalState Physical state to encode.
+        /// @param [in,out] buffer Buffer to which to append the record.
+        /// @return `true` if a record was appended, `false` otherwise.
+        bool EncodeRecord(
+            TControllerIdentifier controllerIdentifier,
+            uint64_t timestampMicroseconds,
+            const SPhysicalState& physicalState,
+            std::vector<uint8_t>& buffer);
+
+      private:
+
+        /// Most recently encoded physical state for each physical controller.
+        std::array<SPhysicalState, kPhysicalControllerCount> previousPhysicalState;
+
+        /// Timestamp of the most recently encoded record, in microseconds.
+        uint64_t previousTimestampMicroseconds;
+      };
+
+      /// Decodes a complete recording, including its header. Operates directly on the encoded
+      /// bytes, so the recording can be memory-mapped rather than read into a buffer.
+      /// @param [in] data Pointer to the start of the recording.
+      /// @param [in] size Size of the recording, in bytes.
+      /// @param [out] recording Filled in with the full physical state at each record, grouped by
+      /// physical controller, and suitable for playback. Only valid if this function succeeds.
+      /// @return `true` if the recording was decoded successfully, `false` if it is malformed.
+      bool Decode(
+          const uint8_t* data, size_t size, ReplayPhysicalControllerSource::TRecording& recording);
+
+      /// Loads a recording from a file by memory-mapping it and decoding its contents.
+      /// @param [in] filename Name of the file to load, which must be null-terminated.
+      /// @param [out] recording Filled in with the decoded recording. Only valid if this function
+      /// succeeds.
+      /// @return `true` if the recording was loaded successfully, `false` otherwise.
+      bool LoadFromFile(
+          std::wstring_view filename, ReplayPhysicalControllerSource::TRecording& recording);
+
+      /// Records physical controller states to a file as they are read. Physical states are
+      /// timestamped and queued without blocking, and a background thread periodically encodes
+      /// whatever is queued and writes it to the file. Each write contains only complete records,
+      /// so the file is a valid recording at all times. Concurrency-safe, as long as each physical
+      /// controller's states are recorded by only one thread at a time.
+      class Recorder
+      {
+      public:
+
+        /// Clock used for timestamping records.
+        using TClock = std::chrono::steady_clock;
+
+        /// Creates a recorder that writes to the specified file, replacing any existing file.
+        /// @param [in] filename Name of the file to which to write, which must be null-terminated.
+        Recorder(std::wstring_view filename);
+
+        Recorder(const Recorder& other) = delete;
+
+        ~Recorder(void);
+
+        /// Determines whether or not the recording file was successfully created.
+        /// @return `true` if so, `false` otherwise.
+        inline bool IsReady(void) const
+        {
+          return (INVALID_HANDLE_VALUE != fileHandle);
+        }
+
+        /// Records a physical state, timestamped with the current time. Never blocks and never
+        /// performs any file operations, so it is suitable for use on the polling path.
+        /// @param [in] controllerIdentifier Identifier of the physical controller whose state is
+        /// being recorded.
+        /// @param [in] physicalState Physical state to record.
+        void Record(
+            TControllerIdentifier controllerIdentifier, const SPhysicalState& physicalState);
+
+      private:
+
+        /// Physical state that has been recorded but not yet encoded and written to the file.
+        struct SPendingRecord
+        {
+          /// Time at which the physical state was recorded, relative to the start of the
+          /// recording.
+          uint64_t timestampMicroseconds;
+
+          /// Physical state that was recorded.
+          SPhysicalState physicalState;
+        };
+
+        /// Encodes and writes queued physical states to the file until asked to stop, and then
+        /// writes whatever remains queued. Entry point for the background thread.
+        /// @param [in] stopToken Used to indicate that the background thread should exit.
+        void WriteQueuedRecords(std::stop_token stopToken);
+
+        /// Point in time corresponding to the start of the recording.
+        const TClock::time_point kStartTime;
+
+        /// Handle of the file to which records are written.
+        HANDLE fileHandle;
+
+        /// Physical states waiting to be written, one queue per physical controller. The thread
+        /// that records a physical controller's states is the only producer for its queue, and
+        /// the background thread is the only consumer of all of them.
+        std::array<
+            SampleHistoryRing<SPendingRecord, kRecorderQueueCapacity>,
+            kPhysicalControllerCount>
+            pendingRecords;
+
+        /// Encodes physical states into records. Only used by the background thread.
+        Encoder encoder;
+
+        /// Holds records after they are encoded and before they are written to the file. Only
+        /// used by the background thread.
+        std::vector<uint8_t> buffer;
+
+        /// Used by the background thread to sleep between writes while remaining responsive to
+        /// requests to stop.
+        std::mutex writerMutex;
+
+        /// Allows the background thread to be woken up early when it is asked to stop.
+        std::condition_variable_any writerWakeup;
+
+        /// Background thread that writes queued physical states to the file.
+        std::jthread writerThread;
+      };
+
+      /// Holds the results of replaying a recording through a mapper.
+      struct SReplayResult
+      {
+        /// Virtual controller states produced by the mapper, one for each recorded sample, grouped
+        /// by physical controller.
+        std::array<std::vector<SState>, kPhysicalControllerCount> virtualStates;
+
+        /// Total number of recorded samples that were mapped.
+        uint64_t sampleCount;
+
+        /// Wall-clock time taken to replay the entire recording.
+        std::chrono::nanoseconds elapsedTime;
+
+        /// Computes the replay throughput.
+        /// @return Number of samples mapped per second, or 0 if no time elapsed.
+        double SamplesPerSecond(void) const;
+      };
+
+      /// Replays a recording through a mapper the same way the physical controller polling loop
+      /// does, with a separate thread for each physical controller, and collects everything the
+      /// mapper produces.
+      /// @param [in] recording Recording to replay.
+      /// @param [in] mapper Mapper through which to pass each recorded physical state.
+      /// @param [in] speed Speed at which to replay the recording.
+      /// @return Results of the replay.
+      SReplayResult Replay(
+          const ReplayPhysicalControllerSource::TRecording& recording,
+          const Mapper& mapper,
+          ReplayPhysicalControllerSource::ESpeed speed);
+    } // namespace Recording
+  } // namespace Controller
+} // namespace Xidi
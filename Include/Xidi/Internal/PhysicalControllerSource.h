@@ -0,0 +1,263 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file PhysicalControllerSource.h
+ *   Declaration of the interface through which physical controllers are accessed, along with all
+ *   of its implementations.
+ **************************************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stop_token>
+#include <vector>
+
+#include "ControllerTypes.h"
+#include "ForceFeedbackTypes.h"
+#include "PhysicalPacketFilter.h"
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    /// Interface for all sources of physical controller data. Physical controller functionality
+    /// accesses physical controllers exclusively through this interface, which allows hardware to
+    /// be replaced with synthetic or recorded data. Implementations must allow different physical
+    /// controllers to be accessed concurrently from different threads, but any single physical
+    /// controller is only ever accessed by one thread at a time.
+    class IPhysicalControllerSource
+    {
+    public:
+
+      virtual ~IPhysicalControllerSource(void) = default;
+
+      /// Reads the current state of the specified physical controller.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @param [out] packetNumber Packet number that accompanies the physical state. Only filled
+      /// in if the physical state indicates the controller was read successfully.
+      /// @return Physical state of the physical controller.
+      virtual SPhysicalState ReadState(
+          TControllerIdentifier controllerIdentifier,
+          PhysicalPacketFilter::TPacketNumber& packetNumber) = 0;
+
+      /// Determines whether or not this source supports blocking until the next sample of a
+      /// physical controller's state is available. Sources that do not must be polled
+      /// periodically.
+      /// @return `true` if so, `false` otherwise.
+      virtual bool SupportsWaitForNextSample(void) const
+      {
+        return false;
+      }
+
+      /// Blocks until the next sample of the specified physical controller's state is available.
+      /// Only meaningful if this source supports waiting, as indicated by the return value of
+      /// #SupportsWaitForNextSample.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @param [in] stopToken Token that allows the wait to be interrupted.
+      /// @return `true` if a new sample is available, `false` if the wait was interrupted or no
+      /// more samples will ever become available.
+      virtual bool WaitForNextSample(
+          TControllerIdentifier controllerIdentifier, std::stop_token stopToken)
+      {
+        return false;
+      }
+
+      /// Writes a vibration command to the specified physical controller.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @param [in] vibration Physical actuator vibration vector, already scaled as needed.
+      /// @return `true` if successful, `false` otherwise.
+      virtual bool WriteVibration(
+          TControllerIdentifier controllerIdentifier,
+          ForceFeedback::SPhysicalActuatorComponents vibration) = 0;
+    };
+
+    /// Physical controller source that communicates with real hardware using XInput.
+    class XInputPhysicalControllerSource : public IPhysicalControllerSource
+    {
+    public:
+
+      // IPhysicalControllerSource
+      SPhysicalState ReadState(
+          TControllerIdentifier controllerIdentifier,
+          PhysicalPacketFilter::TPacketNumber& packetNumber) override;
+      bool WriteVibration(
+          TControllerIdentifier controllerIdentifier,
+          ForceFeedback::SPhysicalActuatorComponents vibration) override;
+    };
+
+    /// Physical controller source that generates deterministic scripted waveforms at a fixed
+    /// sample rate, which can be much higher than any real hardware supports. All physical
+    /// controllers are always connected. Sticks trace circles, triggers ramp up and down, and
+    /// buttons toggle on and off, each at its own period. Intended for load testing.
+    class SyntheticPhysicalControllerSource : public IPhysicalControllerSource
+    {
+    public:
+
+      /// Clock used for pacing samples.
+      using TClock = std::chrono::steady_clock;
+
+      /// Lowest supported sample rate, in samples per second.
+      static constexpr unsigned int kSampleRateMinHz = 1;
+
+      /// Highest supported sample rate, in samples per second.
+      static constexpr unsigned int kSampleRateMaxHz = 8000;
+
+      /// Default sample rate, in samples per second.
+      static constexpr unsigned int kSampleRateDefaultHz = 1000;
+
+      /// Parameters that define the waveforms that are generated.
+      struct SWaveformScript
+      {
+        /// Number of samples generated per second. Clamped to the supported range.
+        unsigned int sampleRateHz = kSampleRateDefaultHz;
+
+        /// Time it takes each stick to trace one full circle.
+        std::chrono::milliseconds stickPeriod = std::chrono::milliseconds(1000);
+
+        /// Time it takes each trigger to ramp from released to fully pressed and back again.
+        std::chrono::milliseconds triggerPeriod = std::chrono::milliseconds(500);
+
+        /// Time for which the first button stays in each of its pressed and released states.
+        /// Each subsequent button stays in each state for one more multiple of this time.
+        std::chrono::milliseconds buttonPeriod = std::chrono::milliseconds(20);
+      };
+
+      SyntheticPhysicalControllerSource(void);
+
+      SyntheticPhysicalControllerSource(const SWaveformScript& script);
+
+      /// Computes the synthetic state of a physical controller at a given sample. Depends only on
+      /// its parameters, so the same sample always produces the same state.
+      /// @param [in] script Parameters that define the waveforms.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest. Each
+      /// physical controller's waveforms are shifted in phase relative to the others.
+      /// @param [in] sampleIndex Index of the sample of interest.
+      /// @return Synthetic physical state.
+      static SPhysicalState StateAtSample(
+          const SWaveformScript& script,
+          TControllerIdentifier controllerIdentifier,
+          uint64_t sampleIndex);
+
+      /// Retrieves the most recent vibration command written to the specified physical
+      /// controller.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @return Most recent vibration command.
+      ForceFeedback::SPhysicalActuatorComponents GetLastVibration(
+          TControllerIdentifier controllerIdentifier) const;
+
+      /// Retrieves the index of the sample the specified physical controller is currently at.
+      /// Starts at 0 and advances by one with each successful wait for the next sample.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @return Current sample index.
+      uint64_t GetSampleIndex(TControllerIdentifier controllerIdentifier) const;
+
+      // IPhysicalControllerSource
+      SPhysicalState ReadState(
+          TControllerIdentifier controllerIdentifier,
+          PhysicalPacketFilter::TPacketNumber& packetNumber) override;
+      bool SupportsWaitForNextSample(void) const override;
+      bool WaitForNextSample(
+          TControllerIdentifier controllerIdentifier, std::stop_token stopToken) override;
+      bool WriteVibration(
+          TControllerIdentifier controllerIdentifier,
+          ForceFeedback::SPhysicalActuatorComponents vibration) override;
+
+    private:
+
+      /// Parameters that define the waveforms that are generated.
+      const SWaveformScript kScript;
+
+      /// Point in time corresponding to the first sample.
+      const TClock::time_point kStartTime;
+
+      /// Index of the current sample for each physical controller.
+      std::array<std::atomic<uint64_t>, kPhysicalControllerCount> sampleIndex;
+
+      /// Most recent vibration command written to each physical controller, packed into a single
+      /// word so that it can be stored atomically.
+      std::array<std::atomic<uint64_t>, kPhysicalControllerCount> lastVibration;
+    };
+
+    /// Single recorded sample of a physical controller's state.
+    struct SReplaySample
+    {
+      /// Time at which the sample was recorded, in microseconds relative to an arbitrary but fixed
+      /// starting point that is common to all physical controllers.
+      uint64_t timestampMicroseconds;
+
+      /// Recorded physical state.
+      SPhysicalState physicalState;
+    };
+
+    /// Physical controller source that plays back previously-recorded physical controller states.
+    /// Each physical controller starts at its first recorded sample and advances by one sample
+    /// with each wait, either at the original recorded pace or as fast as possible. Physical
+    /// controllers without any recorded samples are reported as not connected.
+    class ReplayPhysicalControllerSource : public IPhysicalControllerSource
+    {
+    public:
+
+      /// Clock used for pacing samples.
+      using TClock = std::chrono::steady_clock;
+
+      /// Type used to hold all of the recorded samples for all physical controllers.
+      using TRecording = std::array<std::vector<SReplaySample>, kPhysicalControllerCount>;
+
+      /// Enumerates the speeds at which recorded samples can be played back.
+      enum class ESpeed : uint8_t
+      {
+        /// Samples are made available at the same pace at which they were recorded.
+        Original,
+
+        /// Samples are made available as quickly as they are consumed.
+        Maximum
+      };
+
+      ReplayPhysicalControllerSource(TRecording&& recording, ESpeed speed);
+
+      /// Determines whether or not all of the recorded samples for the specified physical
+      /// controller have been played back.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @return `true` if so, `false` otherwise.
+      bool IsFinished(TControllerIdentifier controllerIdentifier) const;
+
+      // IPhysicalControllerSource
+      SPhysicalState ReadState(
+          TControllerIdentifier controllerIdentifier,
+          PhysicalPacketFilter::TPacketNumber& packetNumber) override;
+      bool SupportsWaitForNextSample(void) const override;
+      bool WaitForNextSample(
+          TControllerIdentifier controllerIdentifier, std::stop_token stopToken) override;
+      bool WriteVibration(
+          TControllerIdentifier controllerIdentifier,
+          ForceFeedback::SPhysicalActuatorComponents vibration) override;
+
+    private:
+
+      /// All of the recorded samples, one sequence per physical controller.
+      const TRecording kRecording;
+
+      /// Speed at which recorded samples are played back.
+      const ESpeed kSpeed;
+
+      /// Point in time corresponding to the earliest recorded timestamp.
+      const TClock::time_point kStartTime;
+
+      /// Earliest recorded timestamp across all physical controllers, in microseconds.
+      const uint64_t kStartTimestampMicroseconds;
+
+      /// Index of the current sample for each physical controller.
+      std::array<std::atomic<size_t>, kPhysicalControllerCount> sampleIndex;
+
+      /// Whether or not each physical controller has played back all of its recorded samples.
+      std::array<std::atomic<bool>, kPhysicalControllerCount> finished;
+    };
+  } // namespace Controller
+} // namespace Xidi
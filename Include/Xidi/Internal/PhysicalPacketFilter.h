@@ -0,0 +1,75 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file PhysicalPacketFilter.h
+ *   Filter for skipping physical controller samples whose packet number has not changed.
+ **************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include "ControllerTypes.h"
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    /// Tracks the packet number that a physical controller reports along with each sample of its
+    /// state. The packet number changes whenever the physical controller's state changes, so a
+    /// sample that carries the same packet number as the previous one is known to be identical to
+    /// it without having to look at the state itself. Packet numbers are only meaningful while the
+    /// physical controller is successfully read, so any other device status resets the filter.
+    /// Not concurrency-safe. Each polling loop is expected to own its own instance.
+    class PhysicalPacketFilter
+    {
+    public:
+
+      /// Type used to represent packet numbers.
+      using TPacketNumber = uint32_t;
+
+      constexpr PhysicalPacketFilter(void) : hasLastPacketNumber(false), lastPacketNumber(0) {}
+
+      /// Determines whether or not a newly-read physical controller sample needs to be processed,
+      /// and if so remembers its packet number for comparison with subsequent samples.
+      /// @param [in] deviceStatus Device status reported along with the sample.
+      /// @param [in] packetNumber Packet number reported along with the sample. Ignored unless the
+      /// device status indicates a successful read.
+      /// @return `true` if the sample might differ from the previous one and should be processed,
+      /// `false` if it is known to be identical and can be skipped entirely.
+      constexpr bool IsNewPacket(EPhysicalDeviceStatus deviceStatus, TPacketNumber packetNumber)
+      {
+        if (EPhysicalDeviceStatus::Ok != deviceStatus)
+        {
+          Reset();
+          return true;
+        }
+
+        if ((true == hasLastPacketNumber) && (packetNumber == lastPacketNumber)) return false;
+
+        hasLastPacketNumber = true;
+        lastPacketNumber = packetNumber;
+        return true;
+      }
+
+      /// Forgets the last-seen packet number so that the next sample is always processed.
+      constexpr void Reset(void)
+      {
+        hasLastPacketNumber = false;
+        lastPacketNumber = 0;
+      }
+
+    private:
+
+      /// Whether or not a packet number has been seen since the filter was created or reset.
+      bool hasLastPacketNumber;
+
+      /// Packet number of the most recent successfully-read sample.
+      TPacketNumber lastPacketNumber;
+    };
+  } // namespace Controller
+} // namespace Xidi
@@ -0,0 +1,168 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file SampleHistoryRing.h
+ *   Utility template for a lock-free fixed-capacity history of recent samples.
+ **************************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace Xidi
+{
+  /// Holds the most recent samples of some data in a fixed-capacity ring, following a
+  /// single-producer multiple-consumer threading model. The producer appends samples and never
+  /// blocks or waits for consumers. Each consumer keeps its own cursor, which identifies the next
+  /// sample it wants to read, and can read every sample appended since then as long as it keeps up
+  /// with the producer. A consumer that falls more than a full ring behind loses the oldest samples
+  /// and continues from the oldest one still available. Each slot is individually protected by a
+  /// stamp that works like the sequence number of a sequence lock, so readers never block the
+  /// producer and detect overwritten slots without retrying.
+  /// @tparam SampleType Type of each sample.
+  /// @tparam kCapacity Number of samples retained. Must be a power of two.
+  template <typename SampleType, unsigned int kCapacity> class SampleHistoryRing
+  {
+    static_assert(
+        std::is_trivially_copyable_v<SampleType>, "Sample type must be trivially copyable.");
+    static_assert(
+        (kCapacity > 0) && (0 == (kCapacity & (kCapacity - 1))),
+        "Capacity must be a power of two.");
+
+  public:
+
+    /// Type used to identify positions within the history. Positions count the total number of
+    /// samples ever appended, so they never repeat in practice.
+    using TCursor = uint64_t;
+
+    inline SampleHistoryRing(void) : writeCursor(0), slots() {}
+
+    SampleHistoryRing(const SampleHistoryRing& other) = delete;
+
+    /// Appends a sample, overwriting the oldest one if the ring is full. Must only be invoked by
+    /// the single producer thread.
+    /// @param [in] sample Sample to append.
+    inline void Append(const SampleType& sample)
+    {
+      TDataWord sampleWords[kDataWordCount] = {};
+      std::memcpy(sampleWords, &sample, sizeof(sample));
+
+      const TCursor cursor = writeCursor.load(std::memory_order_relaxed);
+      SSlot& slot = slots[cursor & (kCapacity - 1)];
+
+      slot.stamp.store(StampForWriteInProgress(cursor), std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+
+      for (size_t i = 0; i < kDataWordCount; ++i)
+        slot.sampleWords[i].store(sampleWords[i], std::memory_order_relaxed);
+
+      slot.stamp.store(StampForWriteCompleted(cursor), std::memory_order_release);
+      writeCursor.store(cursor + 1, std::memory_order_release);
+    }
+
+    /// Retrieves the position at which the next sample will be appended. Consumers that want to
+    /// read only samples appended from now onwards should use this as their initial cursor.
+    /// @return Position of the next sample to be appended.
+    inline TCursor GetWriteCursor(void) const
+    {
+      return writeCursor.load(std::memory_order_acquire);
+    }
+
+    /// Reads the oldest available sample at or after the specified position. Never blocks.
+    /// @param [in,out] cursor On input, position of the next sample the caller wants to read. On
+    /// output, advanced past the sample that was read, including past any samples that were lost
+    /// because they had already been overwritten.
+    /// @param [out] sample Filled in with the sample that was read, if one was available.
+    /// @return `true` if a sample was read, `false` if the caller has already read all of the
+    /// samples that have been appended.
+    inline bool Read(TCursor& cursor, SampleType& sample) const
+    {
+      while (true)
+      {
+        const TCursor writeCursorNow = writeCursor.load(std::memory_order_acquire);
+        if (cursor >= writeCursorNow)
+        {
+          cursor = writeCursorNow;
+          return false;
+        }
+
+        if ((writeCursorNow - cursor) > kCapacity) cursor = writeCursorNow - kCapacity;
+
+        const SSlot& slot = slots[cursor & (kCapacity - 1)];
+        const uint64_t stampBeforeRead = slot.stamp.load(std::memory_order_acquire);
+
+        // Any stamp other than the expected one means the producer has since started to overwrite
+        // the slot with a newer sample. The desired sample is gone, so move on to the next one.
+        if (StampForWriteCompleted(cursor) != stampBeforeRead)
+        {
+          cursor += 1;
+          continue;
+        }
+
+        TDataWord sampleWords[kDataWordCount];
+        for (size_t i = 0; i < kDataWordCount; ++i)
+          sampleWords[i] = slot.sampleWords[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t stampAfterRead = slot.stamp.load(std::memory_order_relaxed);
+
+        cursor += 1;
+        if (stampAfterRead != stampBeforeRead) continue;
+
+        std::memcpy(&sample, sampleWords, sizeof(sample));
+        return true;
+      }
+    }
+
+  private:
+
+    /// Type used for each of the individually-atomic words into which each sample is split.
+    using TDataWord = uint32_t;
+
+    /// Number of words needed to hold each sample.
+    static constexpr size_t kDataWordCount =
+        ((sizeof(SampleType) + sizeof(TDataWord) - 1) / sizeof(TDataWord));
+
+    /// Single slot within the ring.
+    struct SSlot
+    {
+      /// Identifies the sample the slot holds and whether or not it is completely written.
+      std::atomic<uint64_t> stamp;
+
+      /// Sample data, stored as a sequence of words that can be individually read and written
+      /// atomically. Consistency of the sample as a whole is provided by the stamp.
+      std::atomic<TDataWord> sampleWords[kDataWordCount];
+    };
+
+    /// Computes the stamp that marks a slot as being in the process of receiving a sample.
+    /// @param [in] cursor Position of the sample being written.
+    /// @return Stamp value, which is always odd.
+    static constexpr uint64_t StampForWriteInProgress(TCursor cursor)
+    {
+      return (cursor * 2) + 1;
+    }
+
+    /// Computes the stamp that marks a slot as holding a completely-written sample. Zero, which
+    /// is the initial stamp of every slot, never identifies any sample.
+    /// @param [in] cursor Position of the sample that was written.
+    /// @return Stamp value, which is always even and non-zero.
+    static constexpr uint64_t StampForWriteCompleted(TCursor cursor)
+    {
+      return (cursor * 2) + 2;
+    }
+
+    /// Position at which the next sample will be appended.
+    std::atomic<TCursor> writeCursor;
+
+    /// Storage for all of the samples in the ring.
+    SSlot slots[kCapacity];
+  };
+} // namespace Xidi
@@ -11,9 +11,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-
-#include <boost/circular_buffer.hpp>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <tuple>
 
 #include "ControllerTypes.h"
 
@@ -22,10 +28,14 @@ namespace Xidi
   namespace Controller
   {
     /// Implements a state change event buffer for a virtual controller. Used for providing buffered
-    /// event functionality. Methods are not concurrency-safe, so some form of external concurrency
-    /// control is required. Behavior is modelled after DirectInput buffered event documentation.
-    /// For example, number of events stored is artificially limited to one less than declared
-    /// capacity.
+    /// event functionality. Implemented as a lock-free ring with a single producer, which appends
+    /// events, and a single consumer, which reads and removes them. The producer and the consumer
+    /// can operate concurrently without waiting for each other, but producer methods must not be
+    /// invoked concurrently with each other, and likewise for consumer methods. Changing the
+    /// capacity requires exclusive access. Behavior is modelled after DirectInput buffered event
+    /// documentation. For example, number of events stored is artificially limited to one less
+    /// than declared capacity, and if the event buffer is full then appending an event discards the
+    /// oldest event and triggers an overflow condition.
     class StateChangeEventBuffer
     {
     public:
@@ -88,7 +98,17 @@ namespace Xidi
         uint32_t sequence;
       };
 
-      static_assert(sizeof(SEvent) <= 16, "Data structure size constraint violation.");
+      static_assert(sizeof(SEvent) == 16, "Data structure size constraint violation.");
+
+      /// Result of reading events from an event buffer.
+      struct SReadResult
+      {
+        /// Number of events read.
+        uint32_t count;
+
+        /// Whether or not an overflow condition was present.
+        bool overflowed;
+      };
 
       /// Maximum allowed event buffer capacity, measured in number of events. Computed to allow a
       /// maximum of 1MB for event storage.
@@ -96,34 +116,50 @@ namespace Xidi
 
       /// Constructs an empty event buffer with capacity of 0, which means this event buffer is
       /// disabled until it is enabled by request.
-      inline StateChangeEventBuffer(void) : eventBuffer(), eventBufferOverflowed() {}
+      inline StateChangeEventBuffer(void)
+          : slots(), eventBufferCapacity(0), oldestPosition(0), nextPosition(0)
+      {}
 
       /// Allows read-only access to events by index, without performing any bounds-checking. Event
-      /// with index 0 is the oldest, and higher indices indicate more recent events.
+      /// with index 0 is the oldest, and higher indices indicate more recent events. Consumer
+      /// method, but the result is only meaningful if no events are being appended concurrently.
       /// @param [in] index Index of the desired event.
-      /// @return Read-only reference to the event at the desired index.
-      inline const SEvent& operator[](uint32_t index) const
+      /// @return Copy of the event at the desired index.
+      inline SEvent operator[](uint32_t index) const
       {
-        return eventBuffer[index];
+        const uint64_t position =
+            PositionFromWord(oldestPosition.load(std::memory_order_acquire)) + index;
+        return LoadSlot(slots[position % eventBufferCapacity]);
       }
 
-      /// Appends a single event to the event buffer, given its data.
+      /// Appends a single event to the event buffer, given its data. Producer method.
       /// @param [in] eventData Event data to append.
       /// @param [in] timestamp Timestamp to apply to the appended event.
       void AppendEvent(SEventData eventData, uint32_t timestamp);
 
+      /// Appends multiple events to the event buffer, given their data, in the order supplied. All
+      /// of the appended events share the same timestamp and receive consecutive sequence numbers,
+      /// and they become visible to the consumer together unless some of them need to be discarded
+      /// to make room for others. Producer method.
+      /// @param [in] eventData Event data to append, one element per event.
+      /// @param [in] timestamp Timestamp to apply to all of the appended events.
+      void AppendEvents(std::span<const SEventData> eventData, uint32_t timestamp);
+
       /// Retrieves and returns the capacity of this event buffer.
       /// @return Event buffer capacity.
       inline uint32_t GetCapacity(void) const
       {
-        return (uint32_t)eventBuffer.capacity();
+        return eventBufferCapacity;
       }
 
-      /// Retrieves and returns the number of events currently present in this event buffer.
+      /// Retrieves and returns the number of events currently present in this event buffer. The
+      /// result is approximate if events are being appended concurrently.
       /// @return Event count in this event buffer.
       inline uint32_t GetCount(void) const
       {
-        return (uint32_t)eventBuffer.size();
+        const uint64_t oldest = PositionFromWord(oldestPosition.load(std::memory_order_acquire));
+        const uint64_t next = nextPosition.load(std::memory_order_acquire);
+        return (uint32_t)std::min<uint64_t>(next - oldest, GetMaxCount());
       }
 
       /// Checks if this event buffer is enabled.
@@ -137,14 +173,87 @@ namespace Xidi
       /// @return `true` if an overflow condition is present, `false` otherwise.
       inline bool IsOverflowed(void) const
       {
-        return eventBufferOverflowed;
+        return (0 != (oldestPosition.load(std::memory_order_acquire) & kOverflowFlag));
       }
 
       /// Removes and discards the oldest events from the buffer and clears any present overflow
       /// condition. Performs appropriate bounds-checking to ensure at most the specified number
-      /// events are removed.
+      /// events are removed. Consumer method.
       /// @param [in] numEventsToPop Maximum number of events to remove.
-      void PopOldestEvents(uint32_t numEventsToPop);
+      /// @return `true` if an overflow condition was present when the events were removed, `false`
+      /// otherwise.
+      bool PopOldestEvents(uint32_t numEventsToPop);
+
+      /// Reads the oldest events from the buffer, optionally removing them. If events are removed,
+      /// then any present overflow condition is cleared. Each event read is passed to the supplied
+      /// handler along with its index, starting at 0 for the oldest event. Events are copied out
+      /// of the buffer and verified not to have been discarded concurrently before they are passed
+      /// to the handler. If the oldest events are discarded concurrently while events are being
+      /// read without being removed, reading restarts from the new oldest event, in which case the
+      /// handler can be invoked again with indices it has already seen. Consumer method.
+      /// @tparam EventHandler Callable type that accepts an index and an event.
+      /// @param [in] maxEventsToRead Maximum number of events to read.
+      /// @param [in] shouldPopEvents Whether or not the events read should also be removed.
+      /// @param [in] eventHandler Invoked once for each event read.
+      /// @return Number of events read and whether or not an overflow condition was present. If
+      /// events were removed, this includes any overflow condition triggered while reading them.
+      template <typename EventHandler> SReadResult ReadOldestEvents(
+          uint32_t maxEventsToRead, bool shouldPopEvents, EventHandler eventHandler)
+      {
+        std::array<SEvent, kReadChunkSize> eventChunk;
+        uint32_t numEventsRead = 0;
+        bool overflowedWhilePopping = false;
+        uint64_t oldestWord = oldestPosition.load(std::memory_order_acquire);
+
+        while (numEventsRead < maxEventsToRead)
+        {
+          // When events are being removed, the oldest position advances past each chunk of events
+          // as it is read. Otherwise, it stays fixed and is used only to detect discarded events.
+          const uint64_t oldest = PositionFromWord(oldestWord);
+          const uint64_t readPosition =
+              ((true == shouldPopEvents) ? oldest : (oldest + numEventsRead));
+          const uint64_t next = nextPosition.load(std::memory_order_acquire);
+          if (next <= readPosition) break;
+
+          const uint32_t numEventsInChunk = (uint32_t)std::min<uint64_t>(
+              {next - readPosition,
+               (uint64_t)(maxEventsToRead - numEventsRead),
+               (uint64_t)eventChunk.size()});
+
+          for (uint32_t i = 0; i < numEventsInChunk; ++i)
+            eventChunk[i] = LoadSlot(slots[(readPosition + i) % eventBufferCapacity]);
+
+          // The producer advances the oldest position before overwriting any event, so if the
+          // oldest position is still as expected then every event just copied is intact. This is
+          // an atomic read-modify-write even when no events are being removed so that the copies
+          // are ordered before any subsequent overwrite by the producer. Removing events clears
+          // the overflow condition in the same operation, so an overflow triggered concurrently
+          // by the producer is never lost.
+          const uint64_t newOldestWord =
+              ((true == shouldPopEvents) ? (oldest + numEventsInChunk) : oldestWord);
+          const uint64_t expectedOldestWord = oldestWord;
+          if (false ==
+              oldestPosition.compare_exchange_strong(
+                  oldestWord, newOldestWord, std::memory_order_acq_rel, std::memory_order_acquire))
+          {
+            if (false == shouldPopEvents) numEventsRead = 0;
+            continue;
+          }
+
+          for (uint32_t i = 0; i < numEventsInChunk; ++i)
+            eventHandler(numEventsRead + i, eventChunk[i]);
+
+          if (0 != (expectedOldestWord & kOverflowFlag)) overflowedWhilePopping = true;
+          numEventsRead += numEventsInChunk;
+          oldestWord = newOldestWord;
+        }
+
+        const bool overflowed =
+            (((true == shouldPopEvents) && (numEventsRead > 0)) ? overflowedWhilePopping
+                                                                : IsOverflowed());
+
+        return {.count = numEventsRead, .overflowed = overflowed};
+      }
 
       /// Sets the capacity of this event buffer.
       /// Disables this event buffer if the specified capacity is equal to 0.
@@ -153,19 +262,90 @@ namespace Xidi
       /// event buffer, an overflow condition is triggered and the oldest excess events are
       /// discarded. Buffer always maintains one free space, so the actual number of events stored
       /// is one less than capacity. This is to be consistent with documentation for
-      /// IDirectInputDevice8::GetDeviceData.
+      /// IDirectInputDevice8::GetDeviceData. Must not be invoked concurrently with any other
+      /// method.
       /// @param [in] capacity Desired event buffer capacity.
       void SetCapacity(uint32_t capacity);
 
     private:
 
-      /// Underlying event buffer object. Holds all individual event elements.
-      boost::circular_buffer<SEvent> eventBuffer;
+      /// Number of events copied out of the event buffer at a time while reading events.
+      static constexpr uint32_t kReadChunkSize = 64;
+
+      /// Bit within the word that holds the oldest position which indicates an overflow condition.
+      /// Positions never come close to reaching it.
+      static constexpr uint64_t kOverflowFlag = (1ull << 63);
+
+      /// Extracts the oldest position from the word that holds it along with the overflow flag.
+      /// @param [in] oldestPositionWord Word that holds the oldest position.
+      /// @return Oldest position without the overflow flag.
+      static constexpr uint64_t PositionFromWord(uint64_t oldestPositionWord)
+      {
+        return (oldestPositionWord & ~kOverflowFlag);
+      }
+
+      /// Assumed size of a cache line, used to keep positions written by the producer and by the
+      /// consumer from sharing a cache line.
+      static constexpr size_t kCacheLineSize = 64;
+
+      /// Storage for a single event. Stored as atomic words so that the consumer can safely copy
+      /// an event while the producer might be overwriting it, in which case the copy is discarded.
+      struct SSlot
+      {
+        std::array<std::atomic<uint64_t>, sizeof(SEvent) / sizeof(uint64_t)> words;
+      };
+
+      /// Copies an event out of a slot.
+      /// @param [in] slot Slot from which to copy.
+      /// @return Copy of the event held in the slot.
+      static inline SEvent LoadSlot(const SSlot& slot)
+      {
+        std::array<uint64_t, std::tuple_size_v<decltype(slot.words)>> words;
+        for (size_t i = 0; i < words.size(); ++i)
+          words[i] = slot.words[i].load(std::memory_order_relaxed);
+
+        SEvent event;
+        std::memcpy(&event, words.data(), sizeof(event));
+        return event;
+      }
+
+      /// Copies an event into a slot.
+      /// @param [out] slot Slot into which to copy.
+      /// @param [in] event Event to copy.
+      static inline void StoreSlot(SSlot& slot, const SEvent& event)
+      {
+        std::array<uint64_t, std::tuple_size_v<decltype(slot.words)>> words;
+        std::memcpy(words.data(), &event, sizeof(event));
+
+        for (size_t i = 0; i < words.size(); ++i)
+          slot.words[i].store(words[i], std::memory_order_relaxed);
+      }
+
+      /// Computes the maximum number of events that can be stored, which is one less than the
+      /// capacity.
+      /// @return Maximum number of events that can be stored.
+      inline uint32_t GetMaxCount(void) const
+      {
+        return ((0 == eventBufferCapacity) ? 0 : (eventBufferCapacity - 1));
+      }
+
+      /// Storage for all events, one slot per unit of capacity. Events are placed into slots by
+      /// position modulo capacity.
+      std::unique_ptr<SSlot[]> slots;
+
+      /// Capacity of the event buffer, measured in number of events.
+      uint32_t eventBufferCapacity;
+
+      /// Position of the oldest event in the event buffer, combined with the overflow flag. Advanced
+      /// by the consumer as it removes events and by the producer as it discards events to make
+      /// room for new ones. Never ahead of the next position. The overflow flag is set whenever the
+      /// producer discards previously-stored events and cleared whenever the consumer removes
+      /// events, in both cases by the same atomic operation that moves the oldest position, so
+      /// that setting and clearing it are ordered consistently with the events themselves.
+      alignas(kCacheLineSize) std::atomic<uint64_t> oldestPosition;
 
-      /// Overflow flag for the event buffer. Set whenever an operation causes the event buffer to
-      /// hit capacity and discard some previously-stored events. Cleared whenever events are
-      /// retrieved such that the event buffer goes below capacity.
-      bool eventBufferOverflowed;
+      /// Position at which the next event will be appended. Written only by the producer.
+      alignas(kCacheLineSize) std::atomic<uint64_t> nextPosition;
     };
   } // namespace Controller
 } // namespace Xidi
@@ -82,6 +82,11 @@ namespace Xidi
     /// Configuration file setting for specifying the logging verbosity level.
     inline constexpr std::wstring_view kStrConfigurationSettingLogLevel = L"Level";
 
+    /// Configuration file setting for specifying the interval, in seconds, at which input latency
+    /// statistics are output to the log. Input latency instrumentation is disabled if not positive.
+    inline constexpr std::wstring_view kStrConfigurationSettingLogLatencyReportIntervalSeconds =
+        L"LatencyReportIntervalSeconds";
+
     /// Configuration file section name for mapper-related settings.
     inline constexpr std::wstring_view kStrConfigurationSectionMapper = L"Mapper";
 
@@ -115,6 +120,67 @@ namespace Xidi
         kStrConfigurationSettingPropertiesMouseSpeedScalingFactorPercent =
             L"MouseSpeedScalingFactorPercent";
 
+    /// Configuration file setting for customizing the fast physical controller polling period.
+    /// Expressed in milliseconds, this is how frequently physical controllers are polled while
+    /// their state is actively changing.
+    inline constexpr std::wstring_view
+        kStrConfigurationSettingPropertiesPollingPeriodFastMilliseconds =
+            L"PollingPeriodFastMilliseconds";
+
+    /// Configuration file setting for customizing the slow physical controller polling period.
+    /// Expressed in milliseconds, this is how frequently physical controllers are polled once
+    /// their state has stopped changing for a while.
+    inline constexpr std::wstring_view
+        kStrConfigurationSettingPropertiesPollingPeriodSlowMilliseconds =
+            L"PollingPeriodSlowMilliseconds";
+
+    /// Configuration file setting for customizing how gradually the physical controller polling
+    /// period transitions from fast to slow. Expressed in milliseconds, this is how long a physical
+    /// controller's state must remain unchanged for the polling period to reach the slow period.
+    /// The polling period increases linearly over this interval.
+    inline constexpr std::wstring_view
+        kStrConfigurationSettingPropertiesPollingPeriodDecayMilliseconds =
+            L"PollingPeriodDecayMilliseconds";
+
+    /// Configuration file setting for customizing how long a physical controller can go unused
+    /// before it is parked. Expressed in milliseconds, this is how long nothing must reference a
+    /// physical controller for its polling and force feedback actuation to be suspended. Parking is
+    /// disabled if this is 0.
+    inline constexpr std::wstring_view
+        kStrConfigurationSettingPropertiesParkAfterInactivityMilliseconds =
+            L"ParkAfterInactivityMilliseconds";
+
+    /// Configuration file setting for selecting the source of physical controller data. Normally
+    /// physical controllers are real hardware accessed using XInput, but for testing purposes they
+    /// can be replaced with synthetic data.
+    inline constexpr std::wstring_view kStrConfigurationSettingPropertiesPhysicalControllerSource =
+        L"PhysicalControllerSource";
+
+    /// Value of the physical controller source setting that selects real hardware using XInput.
+    inline constexpr std::wstring_view kStrPhysicalControllerSourceXInput = L"XInput";
+
+    /// Value of the physical controller source setting that selects synthetic data.
+    inline constexpr std::wstring_view kStrPhysicalControllerSourceSynthetic = L"Synthetic";
+
+    /// Value of the physical controller source setting that selects playback of a recording.
+    inline constexpr std::wstring_view kStrPhysicalControllerSourceReplay = L"Replay";
+
+    /// Configuration file setting for customizing the rate at which synthetic physical controller
+    /// data are generated. Expressed in samples per second. Only used if the physical controller
+    /// source is synthetic.
+    inline constexpr std::wstring_view kStrConfigurationSettingPropertiesSyntheticSampleRateHz =
+        L"SyntheticSampleRateHz";
+
+    /// Configuration file setting for specifying the file from which to play back a recording of
+    /// physical controller states. Only used if the physical controller source is replay.
+    inline constexpr std::wstring_view kStrConfigurationSettingPropertiesReplayFile =
+        L"ReplayFile";
+
+    /// Configuration file setting for specifying a file to which all physical controller states
+    /// should be recorded as they are read. Recording is disabled if this setting is absent.
+    inline constexpr std::wstring_view kStrConfigurationSettingPropertiesRecordFile =
+        L"RecordFile";
+
     /// Configuration file setting for enabling or disabling built-in properties like deadzone and
     /// saturation, which are used for interfaces that do not normally allow for customization.
     inline constexpr std::wstring_view kStrConfigurationSettingsPropertiesUseBuiltinProperties =
@@ -16,13 +16,13 @@
 #include <cstdint>
 #include <functional>
 #include <mutex>
-#include <stop_token>
-#include <thread>
 #include <utility>
 
+#include "ConcurrencyWrapper.h"
 #include "ControllerTypes.h"
 #include "ForceFeedbackDevice.h"
 #include "ForceFeedbackTypes.h"
+#include "LatencyInstrumentation.h"
 #include "Mapper.h"
 #include "StateChangeEventBuffer.h"
 
@@ -92,6 +92,11 @@ namespace Xidi
         static constexpr unsigned int kBaseIndexPov =
             (unsigned int)EAxis::Count + (unsigned int)EButton::Count;
 
+        /// Total number of controller elements represented in the filter.
+        static constexpr unsigned int kElementCount = kBaseIndexPov + 1;
+
+        static_assert(kElementCount <= 64, "Event filter does not fit into a 64-bit mask.");
+
         /// Computes the filter index that corresponds to a given controller element, with very
         /// little error checking.
         /// @param [in] element Controller index for which the filter index is desired.
@@ -129,6 +134,15 @@ namespace Xidi
           filter.set();
         }
 
+        /// Applies the filter to a mask of controller elements, in which each bit position is the
+        /// filter index of a controller element.
+        /// @param [in] elementMask Mask of controller elements to filter.
+        /// @return Mask with only those controller elements that are contained in the filter.
+        inline uint64_t Apply(uint64_t elementMask) const
+        {
+          return (elementMask & filter.to_ullong());
+        }
+
         /// Tests if the filter contains the specified virtual controller element.
         /// @param [in] element Desired virtual controller element.
         /// @return `true` if it is contained in the filter, `false` otherwise.
@@ -155,7 +169,7 @@ namespace Xidi
       private:
 
         /// Holds the filter itself, one bit per virtual controller element.
-        std::bitset<(int)EAxis::Count + (int)EButton::Count + 1> filter;
+        std::bitset<kElementCount> filter;
       };
 
       /// Properties of an individual axis.
@@ -308,12 +322,59 @@ namespace Xidi
         }
       };
 
+      /// Axis properties compiled into a form that transforms raw axis values using only
+      /// multiplication, shifting, and clamping. Recompiled whenever axis properties change, which
+      /// is rare compared to how often axis values are transformed.
+      struct SAxisTransform
+      {
+        /// Coefficients for transforming raw axis values on one side of the neutral position.
+        /// Raw values are measured by their distance past the deadzone cutoff, which is clamped to
+        /// the distance between the deadzone and saturation cutoffs and then scaled to the
+        /// distance between the range neutral and range extreme values.
+        struct SSide
+        {
+          /// Raw analog value on this side of the axis at which the deadzone region ends.
+          int32_t deadzoneRawCutoff;
+
+          /// Either 1 or -1, based on whether raw and reportable values on this side move in the
+          /// positive or negative direction away from neutral.
+          int32_t direction;
+
+          /// Raw distance between the deadzone and saturation cutoffs, clamped to a minimum of 1
+          /// so that values past the deadzone cutoff always saturate if the two cutoffs meet.
+          uint32_t rawDistance;
+
+          /// Whole number of reportable units per unit of raw distance.
+          uint64_t wholeStep;
+
+          /// Fractional number of reportable units per unit of raw distance, expressed as a
+          /// numerator whose denominator is the raw distance.
+          uint64_t fractionStep;
+
+          /// Fixed-point reciprocal of the raw distance, used to divide products of the fractional
+          /// step without a division instruction.
+          uint64_t rawDistanceReciprocal;
+        };
+
+        /// Whether or not the transformation is applied. If not, raw values pass through unchanged.
+        bool transformationsEnabled;
+
+        /// Neutral value for the axis.
+        int32_t rangeNeutral;
+
+        /// Coefficients for raw values on the positive side of neutral.
+        SSide positive;
+
+        /// Coefficients for raw values at or on the negative side of neutral.
+        SSide negative;
+      };
+
       VirtualController(TControllerIdentifier controllerId);
 
       VirtualController(const VirtualController& other) = delete;
 
-      /// Cleans up and terminates the background monitoring thread, and unregisters this controller
-      /// for force feedback.
+      /// Stops receiving state changes from the associated physical controller, and unregisters
+      /// this controller for force feedback.
       ~VirtualController(void);
 
       /// Modifies the contents of the specified controller state object by applying this virtual
@@ -369,6 +430,10 @@ namespace Xidi
         return (nullptr != physicalControllerForceFeedbackBuffer);
       }
 
+      /// Notifies the associated physical controller that a force feedback effect was started in
+      /// its device buffer, so that effects are actuated at the nominal rate without delay.
+      void ForceFeedbackNotifyEffectStarted(void) const;
+
       /// Attempts to registers this object for force feedback operations with its associated
       /// physical controller. Only one virtual controller object can ever be registered for force
       /// feedback operations at any given time. This is conceptually equivalent to acquiring a
@@ -436,13 +501,14 @@ namespace Xidi
         return eventBuffer.GetCount();
       }
 
-      /// Retrieves a read-only reference to a buffered event at the specified index, without
-      /// performing any bounds-checking. Event with index 0 is the oldest, and higher indices
-      /// indicate more recent events. To prevent the event buffer from being modified while
-      /// accessing multiple events, the caller should first obtain this virtual controller's lock.
+      /// Retrieves a copy of a buffered event at the specified index, without performing any
+      /// bounds-checking. Event with index 0 is the oldest, and higher indices indicate more recent
+      /// events. Events can be appended at any time by state refreshes on other threads, so the
+      /// result is only meaningful if this virtual controller's state is not changing. Use
+      /// #ReadEventBufferOldestEvents to read events consistently.
       /// @param [in] index Index of the desired event.
-      /// @return Read-only reference to the event at the desired index.
-      inline const StateChangeEventBuffer::SEvent& GetEventBufferEvent(uint32_t index) const
+      /// @return Copy of the event at the desired index.
+      inline StateChangeEventBuffer::SEvent GetEventBufferEvent(uint32_t index) const
       {
         return eventBuffer[index];
       }
@@ -461,7 +527,10 @@ namespace Xidi
         return kControllerIdentifier;
       }
 
-      /// Retrieves and returns the latest view of the state of this virtual controller.
+      /// Retrieves and returns the latest view of the state of this virtual controller. Does not
+      /// acquire this virtual controller's lock, and therefore never waits for state refreshes or
+      /// event buffer operations in progress on other threads, unless latency instrumentation is
+      /// enabled.
       /// @return Current state of this virtual controller.
       SState GetState(void);
 
@@ -499,23 +568,66 @@ namespace Xidi
       }
 
       /// Removes and discards up to the specified number of the oldest events from this virtual
-      /// controller's event buffer and clears any present overflow condition.
+      /// controller's event buffer and clears any present overflow condition. Does not wait for
+      /// state refreshes in progress on other threads, unless latency instrumentation is enabled.
       /// @param [in] numEventsToPop Maximum number of events to remove.
-      void PopEventBufferOldestEvents(uint32_t numEventsToPop);
+      /// @return `true` if an overflow condition was present when the events were removed, `false`
+      /// otherwise.
+      bool PopEventBufferOldestEvents(uint32_t numEventsToPop);
+
+      /// Reads up to the specified number of the oldest events from this virtual controller's
+      /// event buffer, optionally removing them, and passes each one to the supplied handler. Does
+      /// not wait for state refreshes in progress on other threads, unless latency instrumentation
+      /// is enabled. See StateChangeEventBuffer::ReadOldestEvents for details.
+      /// @tparam EventHandler Callable type that accepts an index and an event.
+      /// @param [in] maxEventsToRead Maximum number of events to read.
+      /// @param [in] shouldPopEvents Whether or not the events read should also be removed.
+      /// @param [in] eventHandler Invoked once for each event read.
+      /// @return Number of events read and whether or not an overflow condition was present.
+      template <typename EventHandler> StateChangeEventBuffer::SReadResult
+          ReadEventBufferOldestEvents(
+              uint32_t maxEventsToRead, bool shouldPopEvents, EventHandler eventHandler)
+      {
+        // Latency instrumentation requires this virtual controller's lock, which must not be
+        // acquired while holding the event buffer consumer lock. Capacity changes acquire them in
+        // the opposite order.
+        NotifyPhysicalControllerInUse();
+
+        std::unique_lock consumerLock(eventBufferConsumerMutex);
+        const StateChangeEventBuffer::SReadResult readResult =
+            eventBuffer.ReadOldestEvents(maxEventsToRead, shouldPopEvents, eventHandler);
+        consumerLock.unlock();
+
+        if ((true == shouldPopEvents) && (readResult.count > 0) && (true == Latency::IsEnabled()))
+        {
+          auto lock = Lock();
+          RecordLatencyApplicationDelivery();
+        }
 
-      /// Generates this virtual controller's processed state view by applying this virtual
+        return readResult;
+      }
+
+      /// Recompiles this virtual controller's axis transforms from its axis properties, and then
+      /// generates this virtual controller's processed state view by applying this virtual
       /// controller's properties to its raw state view. Not concurrency-safe, and primarily
       /// intended for internal use.
       void ReapplyProperties(void);
 
+      /// Records input latency measurements for the application receiving this virtual
+      /// controller's processed state, if latency instrumentation is enabled. Not
+      /// concurrency-safe, and primarily intended for internal use.
+      void RecordLatencyApplicationDelivery(void);
+
       /// Refreshes the virtual controller's state using the supplied new state data.
       /// Primarily intended to be called by a background thread, but exposed externally for
       /// testing.
       /// @param [in] newRawVirtualStateData Raw virtual controller state data to apply to this
       /// virtual controller's internal state view.
+      /// @param [in] timestamp Time at which the new state data were sampled from the physical
+      /// controller, in milliseconds. Applied to any buffered events that result from the change.
       /// @return `true` if the state of the controller changed as a result of applying the new
       /// state data, `false` otherwise.
-      bool RefreshState(SState newRawVirtualStateData);
+      bool RefreshState(SState newRawVirtualStateData, uint32_t timestamp);
 
       /// Sets the deadzone property for a single axis.
       /// @param [in] axis Target axis.
@@ -593,13 +705,33 @@ namespace Xidi
 
     private:
 
+      /// Value of the cached capabilities mapper set generation that indicates capabilities have
+      /// not yet been cached.
+      static constexpr uint64_t kCapabilitiesNotCached = UINT64_MAX;
+
+      /// Retrieves the capabilities of this virtual controller from the cache, first refreshing
+      /// the cache if a different mapper set has been published since it was filled. Not
+      /// concurrency-safe, so this virtual controller's lock must be held.
+      /// @return Read-only reference to the cached capabilities.
+      const SCapabilities& GetCachedCapabilities(void) const;
+
+      /// Records that the associated physical controller is in use, which keeps it from being
+      /// parked while applications are reading this virtual controller. Concurrency-safe.
+      void NotifyPhysicalControllerInUse(void) const;
+
       /// Controller identifier to be used when communicating with the underlying real controller.
       const TControllerIdentifier kControllerIdentifier;
 
       /// Provides concurrency control to the data structures in this virtual controller.
       std::recursive_mutex controllerMutex;
 
-      /// Buffer for holding controller state change events.
+      /// Serializes consumers of the event buffer with each other and with event buffer capacity
+      /// changes. State refreshes, which produce events, do not acquire it, so applications
+      /// retrieving buffered events do not wait for them.
+      std::mutex eventBufferConsumerMutex;
+
+      /// Buffer for holding controller state change events. Events are only appended while
+      /// holding this virtual controller's lock, so state refreshes act as its single producer.
       StateChangeEventBuffer eventBuffer;
 
       /// Filter to be used for deciding which controller elements are allowed to generate buffered
@@ -609,23 +741,35 @@ namespace Xidi
       /// All properties associated with this virtual controller.
       SProperties properties;
 
+      /// Axis properties compiled into transforms, one element per possible axis. Kept consistent
+      /// with the axis properties whenever they change.
+      std::array<SAxisTransform, static_cast<int>(EAxis::Count)> axisTransforms;
+
       /// State of the virtual controller as of the last refresh.
       /// Raw values, with no properties or other processing applied.
       SState stateRaw;
 
       /// State of the virtual controller as of the last refresh.
-      /// Fully processed, all properties have been applied.
-      SState stateProcessed;
+      /// Fully processed, all properties have been applied. Only ever written while holding this
+      /// virtual controller's lock, but can be read at any time without holding it.
+      ConcurrencyWrapper<SState> stateProcessed;
+
+      /// Latency instrumentation timestamps of the sample that produced the processed state, if it
+      /// has not yet been delivered to the application. Only used if latency instrumentation is
+      /// enabled.
+      Latency::SSampleTimestamps undeliveredSampleTimestamps;
 
       /// State change event notification handle, optionally provided by applications.
       /// The underlying event object is owned by the application, not by this object.
       HANDLE stateChangeEventHandle;
 
-      /// Background thread that monitors the associated physical controller for updates.
-      std::thread physicalControllerMonitor;
+      /// Capabilities of this virtual controller, cached so that applying properties to each state
+      /// refresh does not need to read the configured mappers.
+      mutable SCapabilities cachedCapabilities;
 
-      /// Used to indicate that the physical controller monitor thread should stop running.
-      std::stop_source physicalControllerMonitorStop;
+      /// Generation of the mapper set that was published when the cached capabilities were
+      /// obtained, or #kCapabilitiesNotCached if they have not yet been obtained.
+      mutable uint64_t cachedCapabilitiesMapperSetGeneration;
 
       /// Pointer to the physical device force feedback buffer. Valid only if this virtual
       /// controller object is registered for force feedback, `nullptr` all other times.
@@ -18,6 +18,8 @@
 #include "ForceFeedbackDevice.h"
 #include "Mapper.h"
 #include "PhysicalController.h"
+#include "PhysicalPacketFilter.h"
+#include "SampleHistoryRing.h"
 #include "VirtualController.h"
 
 namespace XidiTest
@@ -45,10 +47,24 @@ namespace XidiTest
 
     ~MockPhysicalController(void);
 
-    /// Advances to the next physical state.
+    /// Advances to the next physical state, along with the packet number if requested.
     /// Intended to be invoked internally only.
     void AdvancePhysicalState(void);
 
+    /// Records the current physical state in the sample history, in the same way as the real
+    /// physical controller polling loop does whenever it reads a new physical state.
+    /// Intended to be invoked internally only.
+    void AppendCurrentSampleToHistory(void);
+
+    /// Determines whether or not the current physical state needs to be processed, based on its
+    /// packet number, in the same way as the real physical controller polling loop.
+    /// Intended to be invoked internally only.
+    /// @return `true` if the current packet number is new, `false` if it was already seen.
+    inline bool ConsumeCurrentPacket(void)
+    {
+      return packetFilter.IsNewPacket(GetCurrentPhysicalState().deviceStatus, currentPacketNumber);
+    }
+
     /// Unregisters a virtual controller for force feedback.
     /// @param [in] controllerToRegister Pointer to the virtual controller object that should be
     /// unregistered for force feedback.
@@ -66,11 +82,40 @@ namespace XidiTest
     /// @return Current physical state being reported to the test cases that request it.
     SPhysicalState GetCurrentPhysicalState(void) const;
 
+    /// Retrieves and returns the packet number that accompanies the current physical state.
+    /// @return Current packet number.
+    inline PhysicalPacketFilter::TPacketNumber GetCurrentPacketNumber(void) const
+    {
+      return currentPacketNumber;
+    }
+
     /// Retrieves and returns the current raw virtual state, which is derived on-the-fly from the
     /// raw virtual state.
     /// @return Current raw virtual state being reported to the test cases that request it.
     SState GetCurrentRawVirtualState(void) const;
 
+    /// Retrieves and returns the generation of the published physical state.
+    /// @return Current physical state generation.
+    inline TControllerStateGeneration GetPhysicalStateGeneration(void) const
+    {
+      return physicalStateGeneration;
+    }
+
+    /// Retrieves and returns the generation of the published raw virtual state.
+    /// @return Current raw virtual state generation.
+    inline TControllerStateGeneration GetRawVirtualStateGeneration(void) const
+    {
+      return rawVirtualStateGeneration;
+    }
+
+    /// Provides read-only access to the sample history.
+    /// @return Reference to the sample history object.
+    inline const ::Xidi::SampleHistoryRing<SPhysicalSample, kPhysicalSampleHistoryCapacity>&
+        GetSampleHistory(void) const
+    {
+      return sampleHistory;
+    }
+
     /// Provides access to the force feedback device object.
     /// @return Reference to the force feedback device object.
     inline ForceFeedback::Device& GetForceFeedbackDevice(void)
@@ -86,6 +131,12 @@ namespace XidiTest
       forceFeedbackRegistration.insert(controllerToRegister);
     }
 
+    /// Publishes the current physical and raw virtual states, advancing the generation of each one
+    /// that differs from what was previously published, in the same way as the real physical
+    /// controller polling loop does whenever it reads a new physical state.
+    /// Intended to be invoked internally only.
+    void PublishCurrentState(void);
+
     /// Checks if the specified virtual controller is registered for force feedback.
     /// @return `true` if so, `false` if not.
     inline bool IsVirtualControllerRegisteredForForceFeedback(
@@ -112,7 +163,10 @@ namespace XidiTest
     /// Requests an advancement to the next physical state.
     /// Test will fail due to a test implementation issue if attempting to advance past the end of
     /// the physical state array.
-    void RequestAdvancePhysicalState(void);
+    /// @param [in] advancePacketNumber Whether or not the packet number should also advance. Real
+    /// physical controllers always advance the packet number when their state changes, so tests
+    /// can leave it unchanged to verify that samples are skipped based on packet number alone.
+    void RequestAdvancePhysicalState(bool advancePacketNumber = true);
 
   private:
 
@@ -135,6 +189,32 @@ namespace XidiTest
     /// physical state array.
     bool advanceRequested;
 
+    /// Flag which specifies whether or not the pending advancement to the next physical state
+    /// should also advance the packet number.
+    bool advancePacketNumberRequested;
+
+    /// Packet number that accompanies the current physical state.
+    PhysicalPacketFilter::TPacketNumber currentPacketNumber;
+
+    /// Filter used to skip physical states whose packet number has already been seen.
+    PhysicalPacketFilter packetFilter;
+
+    /// Most recently published physical state.
+    SPhysicalState publishedPhysicalState;
+
+    /// Most recently published raw virtual state.
+    SState publishedRawVirtualState;
+
+    /// Generation of the published physical state. Advances whenever it changes.
+    TControllerStateGeneration physicalStateGeneration;
+
+    /// Generation of the published raw virtual state. Advances whenever it changes.
+    TControllerStateGeneration rawVirtualStateGeneration;
+
+    /// History of physical states that have been reported, along with the raw virtual states to
+    /// which they map. Timestamps are the indices of the physical states.
+    ::Xidi::SampleHistoryRing<SPhysicalSample, kPhysicalSampleHistoryCapacity> sampleHistory;
+
     /// Force feedback device associated with the physical controller.
     /// Initialized to use a base timestamp of 0.
     ForceFeedback::Device forceFeedbackDevice;
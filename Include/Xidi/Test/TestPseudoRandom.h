@@ -0,0 +1,43 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file TestPseudoRandom.h
+ *   Deterministic pseudo-random number generation that can be used for tests.
+ **************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+namespace XidiTest
+{
+  /// Generates a deterministic sequence of pseudo-random values using a linear congruential
+  /// generator. Intended for tests that need varied inputs but must produce the same inputs every
+  /// time they run. The low-order bits have short periods, so values should be taken from the
+  /// high-order bits.
+  class TestPseudoRandom
+  {
+  public:
+
+    /// Creates a generator whose sequence is determined by the specified seed.
+    /// @param [in] seed Initial state of the generator.
+    constexpr TestPseudoRandom(uint32_t seed = 1) : state(seed) {}
+
+    /// Advances the generator and retrieves its next value.
+    /// @return Next pseudo-random value in the sequence.
+    constexpr uint32_t Next(void)
+    {
+      state = (state * 1664525) + 1013904223;
+      return state;
+    }
+
+  private:
+
+    /// Current state of the generator, which is also the value most recently generated.
+    uint32_t state;
+  };
+} // namespace XidiTest
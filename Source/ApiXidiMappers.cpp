@@ -0,0 +1,34 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file ApiXidiMappers.cpp
+ *   Implementation of the Mappers interface part of the Xidi API.
+ **************************************************************************************************/
+
+#include "ApiXidi.h"
+#include "Globals.h"
+
+namespace Xidi
+{
+  namespace Api
+  {
+    /// Implements the Xidi API interface #IMappers.
+    class MappersManager : public IMappers
+    {
+    public:
+
+      // IMappers
+      bool ReloadMappers(void) override
+      {
+        return Globals::ReloadMappers();
+      }
+    };
+
+    // Singleton Xidi API implementation object.
+    static MappersManager mappersManager;
+  } // namespace Api
+} // namespace Xidi
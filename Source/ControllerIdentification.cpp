@@ -63,11 +63,12 @@ namespace Xidi
   static inline bool DoesControllerSupportForceFeedback(
       Controller::TControllerIdentifier controllerId)
   {
-    const Controller::Mapper* const mapper =
-        Controller::Mapper::GetConfigured((Controller::TControllerIdentifier)controllerId);
-    if (nullptr == mapper) return false;
+    if (controllerId >= Controller::kPhysicalControllerCount) return false;
 
-    return mapper->GetCapabilities().ForceFeedbackIsSupported();
+    return Controller::Mapper::ReadConfigured()
+        ->GetMapper((Controller::TControllerIdentifier)controllerId)
+        ->GetCapabilities()
+        .ForceFeedbackIsSupported();
   }
 
   /// Extracts and returns the instance index from a Xidi virtual controller's GUID.
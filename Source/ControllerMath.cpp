@@ -12,7 +12,11 @@
 
 #include "ControllerMath.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 
 #include "ControllerTypes.h"
 
@@ -22,6 +26,43 @@ namespace Xidi
   {
     namespace Math
     {
+      /// Number of fractional bits in the fixed-point multipliers used for circle-to-square
+      /// transformations.
+      static constexpr unsigned int kCircleToSquareMultiplierFractionBits = 30;
+
+      /// Squared radius at and below which no radius correction is needed for circle-to-square
+      /// transformations.
+      static constexpr int64_t kCircleToSquareSquaredRadiusMin =
+          (int64_t)kAnalogValueMax * (int64_t)kAnalogValueMax;
+
+      /// Largest possible squared radius of a raw analog stick reading.
+      static constexpr int64_t kCircleToSquareSquaredRadiusMax =
+          2 * (int64_t)INT16_MIN * (int64_t)INT16_MIN;
+
+      /// Number of bits by which the squared radius in excess of the minimum is shifted to obtain
+      /// a radius multiplier table index.
+      static constexpr unsigned int kCircleToSquareRadiusSegmentShift = 21;
+
+      /// Linearly interpolates between two adjacent entries in a fixed-point multiplier table.
+      /// @param [in] table Table from which to read.
+      /// @param [in] position Position within the table, with the specified number of fractional
+      /// bits.
+      /// @param [in] fractionBits Number of bits in the position that identify a point between
+      /// two adjacent table entries.
+      /// @return Interpolated fixed-point multiplier.
+      template <size_t kTableSize> static inline int64_t InterpolateMultiplier(
+          const std::array<uint32_t, kTableSize>& table,
+          uint64_t position,
+          unsigned int fractionBits)
+      {
+        const size_t index = static_cast<size_t>(position >> fractionBits);
+        const int64_t fraction = static_cast<int64_t>(position & ((1ull << fractionBits) - 1));
+        const int64_t base = static_cast<int64_t>(table[index]);
+        const int64_t next = static_cast<int64_t>(table[index + 1]);
+
+        return base + (((next - base) * fraction) >> fractionBits);
+      }
+
       int16_t ApplyRawAnalogTransform(
           int16_t analogValue, unsigned int deadzonePercent, unsigned int saturationPercent)
       {
@@ -70,6 +111,92 @@ namespace Xidi
         return kTriggerValueMin + (uint8_t)(transformedTriggerBase * transformationScaleFactor);
       }
 
+      RawAnalogTransformTable::RawAnalogTransformTable(
+          unsigned int deadzonePercent, unsigned int saturationPercent)
+      {
+        for (size_t i = 0; i < table.size(); ++i)
+          table[i] = ApplyRawAnalogTransform(
+              static_cast<int16_t>(static_cast<uint16_t>(i)), deadzonePercent, saturationPercent);
+      }
+
+      RawTriggerTransformTable::RawTriggerTransformTable(
+          unsigned int deadzonePercent, unsigned int saturationPercent)
+      {
+        for (size_t i = 0; i < table.size(); ++i)
+          table[i] = ApplyRawTriggerTransform(
+              static_cast<uint8_t>(i), deadzonePercent, saturationPercent);
+      }
+
+      CircleToSquareTransform::CircleToSquareTransform(double amountFraction)
+          : isEnabled(0.0 != amountFraction), angleMultipliers(), radiusMultipliers()
+      {
+        static_assert(
+            ((kCircleToSquareSquaredRadiusMax - kCircleToSquareSquaredRadiusMin) >>
+             kCircleToSquareRadiusSegmentShift) <= (1u << kRadiusSegmentBits),
+            "Radius multiplier table is too small for the range of possible squared radii.");
+
+        constexpr double kMultiplierScale = (double)(1ull << kCircleToSquareMultiplierFractionBits);
+
+        // Coordinates whose smaller-to-larger magnitude ratio is t lie at a distance of
+        // sqrt(1 + t^2) times the larger magnitude from the center, so multiplying by that amount
+        // moves them from the circle to the square. Partial amounts use a fractional power of it.
+        for (size_t i = 0; i < angleMultipliers.size(); ++i)
+        {
+          const double ratio = (double)i / (double)(1u << kAngleSegmentBits);
+          angleMultipliers[i] = static_cast<uint32_t>(std::round(
+              std::pow(1.0 + (ratio * ratio), amountFraction / 2.0) * kMultiplierScale));
+        }
+
+        // Once the radius is limited to the analog range, the full multiplier is reduced by the
+        // ratio of the limit to the actual radius.
+        for (size_t i = 0; i < radiusMultipliers.size(); ++i)
+        {
+          const double squaredRadius = (double)kCircleToSquareSquaredRadiusMin +
+              (double)(i << kCircleToSquareRadiusSegmentShift);
+          const double radiusRatio = (double)kCircleToSquareSquaredRadiusMin / squaredRadius;
+          radiusMultipliers[i] = static_cast<uint32_t>(
+              std::round(std::pow(radiusRatio, amountFraction / 2.0) * kMultiplierScale));
+        }
+      }
+
+      SAnalogStickCoordinates CircleToSquareTransform::Apply(
+          SAnalogStickCoordinates circleCoords) const
+      {
+        if (false == isEnabled) return circleCoords;
+
+        const int64_t xMagnitude = std::abs(static_cast<int64_t>(circleCoords.x));
+        const int64_t yMagnitude = std::abs(static_cast<int64_t>(circleCoords.y));
+        const int64_t largerMagnitude = std::max(xMagnitude, yMagnitude);
+        const int64_t smallerMagnitude = std::min(xMagnitude, yMagnitude);
+        if (0 == largerMagnitude) return circleCoords;
+
+        const uint64_t ratio = (static_cast<uint64_t>(smallerMagnitude) << 32) /
+            static_cast<uint64_t>(largerMagnitude);
+        int64_t multiplier =
+            InterpolateMultiplier(angleMultipliers, ratio, 32 - kAngleSegmentBits);
+
+        const int64_t squaredRadius = (xMagnitude * xMagnitude) + (yMagnitude * yMagnitude);
+        if (squaredRadius > kCircleToSquareSquaredRadiusMin)
+        {
+          multiplier = (multiplier *
+                        InterpolateMultiplier(
+                            radiusMultipliers,
+                            static_cast<uint64_t>(squaredRadius - kCircleToSquareSquaredRadiusMin),
+                            kCircleToSquareRadiusSegmentShift)) >>
+              kCircleToSquareMultiplierFractionBits;
+        }
+
+        const int64_t xTransformed = std::min<int64_t>(
+            kAnalogValueMax, (xMagnitude * multiplier) >> kCircleToSquareMultiplierFractionBits);
+        const int64_t yTransformed = std::min<int64_t>(
+            kAnalogValueMax, (yMagnitude * multiplier) >> kCircleToSquareMultiplierFractionBits);
+
+        return SAnalogStickCoordinates{
+            .x = static_cast<int16_t>((circleCoords.x < 0) ? -xTransformed : xTransformed),
+            .y = static_cast<int16_t>((circleCoords.y < 0) ? -yTransformed : yTransformed),
+        };
+      }
+
       SAnalogStickCoordinates TransformCoordinatesCircleToSquare(
           SAnalogStickCoordinates circleCoords, double amountFraction)
       {
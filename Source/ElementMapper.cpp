@@ -12,9 +12,12 @@
 
 #include "ElementMapper.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstdint>
 #include <optional>
+#include <span>
 
 #include "ControllerMath.h"
 #include "ControllerTypes.h"
@@ -23,17 +26,22 @@
 #include "Mouse.h"
 #include "Strings.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define XIDI_ELEMENT_MAPPER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Xidi
 {
   namespace Controller
   {
-    std::unique_ptr<IElementMapper> AxisMapper::Clone(void) const
-    {
-      return std::make_unique<AxisMapper>(*this);
-    }
-
-    void AxisMapper::ContributeFromAnalogValue(
-        SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const
+    /// Computes the contribution an axis element mapper makes to its target axis from an analog
+    /// value.
+    /// @param [in] direction Direction of the target axis to which the contribution is made.
+    /// @param [in] analogValue Raw analog value from the XInput controller.
+    /// @return Value to add to the target axis.
+    static inline int32_t AxisContributionFromAnalogValue(
+        EAxisDirection direction, int16_t analogValue)
     {
       int32_t axisValueToContribute = (int32_t)analogValue;
 
@@ -51,11 +59,16 @@ namespace Xidi
           break;
       }
 
-      controllerState[axis] += axisValueToContribute;
+      return axisValueToContribute;
     }
 
-    void AxisMapper::ContributeFromButtonValue(
-        SState& controllerState, bool buttonPressed, uint32_t sourceIdentifier) const
+    /// Computes the contribution an axis element mapper makes to its target axis from a button
+    /// value.
+    /// @param [in] direction Direction of the target axis to which the contribution is made.
+    /// @param [in] buttonPressed Button state from the XInput controller.
+    /// @return Value to add to the target axis.
+    static inline int32_t AxisContributionFromButtonValue(
+        EAxisDirection direction, bool buttonPressed)
     {
       int32_t axisValueToContribute = 0;
 
@@ -74,11 +87,16 @@ namespace Xidi
           break;
       }
 
-      controllerState[axis] += axisValueToContribute;
+      return axisValueToContribute;
     }
 
-    void AxisMapper::ContributeFromTriggerValue(
-        SState& controllerState, uint8_t triggerValue, uint32_t sourceIdentifier) const
+    /// Computes the contribution an axis element mapper makes to its target axis from a trigger
+    /// value.
+    /// @param [in] direction Direction of the target axis to which the contribution is made.
+    /// @param [in] triggerValue Raw trigger value from the XInput controller.
+    /// @return Value to add to the target axis.
+    static inline int32_t AxisContributionFromTriggerValue(
+        EAxisDirection direction, uint8_t triggerValue)
     {
       constexpr double kBidirectionalStepSize = (double)(kAnalogValueMax - kAnalogValueMin) /
           (double)(kTriggerValueMax - kTriggerValueMin);
@@ -107,7 +125,932 @@ namespace Xidi
           break;
       }
 
-      controllerState[axis] += axisValueToContribute;
+      return axisValueToContribute;
+    }
+
+    /// Computes the contribution a digital axis element mapper makes to its target axis from an
+    /// analog value.
+    /// @param [in] direction Direction of the target axis to which the contribution is made.
+    /// @param [in] analogValue Raw analog value from the XInput controller.
+    /// @return Value to add to the target axis.
+    static inline int32_t DigitalAxisContributionFromAnalogValue(
+        EAxisDirection direction, int16_t analogValue)
+    {
+      int32_t axisValueToContribute = 0;
+
+      switch (direction)
+      {
+        case EAxisDirection::Both:
+          if (Math::IsAnalogPressedNegative(analogValue))
+            axisValueToContribute = kAnalogValueMin;
+          else if (Math::IsAnalogPressedPositive(analogValue))
+            axisValueToContribute = kAnalogValueMax;
+          break;
+
+        case EAxisDirection::Positive:
+          if (Math::IsAnalogPressedPositive(analogValue)) axisValueToContribute = kAnalogValueMax;
+          break;
+
+        case EAxisDirection::Negative:
+          if (Math::IsAnalogPressedNegative(analogValue)) axisValueToContribute = kAnalogValueMin;
+          break;
+      }
+
+      return axisValueToContribute;
+    }
+
+    /// Determines whether or not the built-in deadzone and saturation properties apply to mouse
+    /// axis contributions, based on configuration. Involves a configuration lookup the first time it
+    /// is invoked, so it is resolved when mappers are compiled rather than while they execute.
+    /// @return `true` if the built-in properties apply, `false` otherwise.
+    static bool AreMouseAxisPropertiesEnabled(void)
+    {
+      static const bool kEnableMouseAxisProperties =
+          Globals::GetConfigurationData()
+              [Strings::kStrConfigurationSectionProperties]
+              [Strings::kStrConfigurationSettingsPropertiesUseBuiltinProperties]
+                  .ValueOr(true);
+
+      return kEnableMouseAxisProperties;
+    }
+
+    /// Computes the contribution a mouse axis element mapper makes to its target mouse axis from
+    /// an analog value.
+    /// @param [in] direction Direction of the target mouse axis to which the contribution is made.
+    /// @param [in] analogValue Raw analog value from the XInput controller.
+    /// @param [in] applyProperties Whether or not to apply the built-in deadzone and saturation.
+    /// @return Mouse movement to submit for the target mouse axis.
+    static inline int MouseAxisContributionFromAnalogValue(
+        EAxisDirection direction, int16_t analogValue, bool applyProperties)
+    {
+      constexpr double kAnalogToMouseScalingFactor =
+          (double)(Mouse::kMouseMovementUnitsMax - Mouse::kMouseMovementUnitsMin) /
+          (double)(kAnalogValueMax - kAnalogValueMin);
+
+      constexpr unsigned int kAnalogMouseDeadzonePercent = 8;
+      constexpr unsigned int kAnalogMouseSaturationPercent = 92;
+      const int16_t analogValueForContribution =
+          (applyProperties
+               ? Math::ApplyRawAnalogTransform(
+                     analogValue, kAnalogMouseDeadzonePercent, kAnalogMouseSaturationPercent)
+               : analogValue);
+
+      const double mouseAxisValueRaw =
+          ((double)(analogValueForContribution - kAnalogValueNeutral) *
+           kAnalogToMouseScalingFactor);
+      const double mouseAxisValueTransformed = mouseAxisValueRaw;
+
+      int mouseAxisValueToContribute = (int)mouseAxisValueTransformed;
+
+      switch (direction)
+      {
+        case EAxisDirection::Both:
+          break;
+
+        case EAxisDirection::Positive:
+          mouseAxisValueToContribute =
+              (mouseAxisValueToContribute - Mouse::kMouseMovementUnitsMin) / 2;
+          break;
+
+        case EAxisDirection::Negative:
+          mouseAxisValueToContribute =
+              (mouseAxisValueToContribute - Mouse::kMouseMovementUnitsMax) / 2;
+          break;
+      }
+
+      return mouseAxisValueToContribute;
+    }
+
+    /// Computes the contribution a mouse axis element mapper makes to its target mouse axis from
+    /// a button value.
+    /// @param [in] direction Direction of the target mouse axis to which the contribution is made.
+    /// @param [in] buttonPressed Button state from the XInput controller.
+    /// @return Mouse movement to submit for the target mouse axis.
+    static inline int MouseAxisContributionFromButtonValue(
+        EAxisDirection direction, bool buttonPressed)
+    {
+      constexpr double kMouseButtonContributionScalingFactor = 0.5;
+
+      int mouseAxisValueToContribute = Mouse::kMouseMovementUnitsNeutral;
+
+      switch (direction)
+      {
+        case EAxisDirection::Both:
+          mouseAxisValueToContribute +=
+              (int)(kMouseButtonContributionScalingFactor *
+                    (double)(buttonPressed ? (Mouse::kMouseMovementUnitsMax -
+                                              Mouse::kMouseMovementUnitsNeutral)
+                                           : (Mouse::kMouseMovementUnitsMin -
+                                              Mouse::kMouseMovementUnitsNeutral)));
+          break;
+
+        case EAxisDirection::Positive:
+          mouseAxisValueToContribute +=
+              (int)(kMouseButtonContributionScalingFactor *
+                    (double)(buttonPressed ? (Mouse::kMouseMovementUnitsMax -
+                                              Mouse::kMouseMovementUnitsNeutral)
+                                           : 0));
+          break;
+
+        case EAxisDirection::Negative:
+          mouseAxisValueToContribute +=
+              (int)(kMouseButtonContributionScalingFactor *
+                    (double)(buttonPressed ? (Mouse::kMouseMovementUnitsMin -
+                                              Mouse::kMouseMovementUnitsNeutral)
+                                           : 0));
+          break;
+      }
+
+      return mouseAxisValueToContribute;
+    }
+
+    /// Computes the contribution a mouse axis element mapper makes to its target mouse axis from
+    /// a trigger value.
+    /// @param [in] direction Direction of the target mouse axis to which the contribution is made.
+    /// @param [in] triggerValue Raw trigger value from the XInput controller.
+    /// @param [in] applyProperties Whether or not to apply the built-in deadzone and saturation.
+    /// @return Mouse movement to submit for the target mouse axis.
+    static inline int MouseAxisContributionFromTriggerValue(
+        EAxisDirection direction, uint8_t triggerValue, bool applyProperties)
+    {
+      constexpr double kBidirectionalStepSize =
+          (double)(Mouse::kMouseMovementUnitsMax - Mouse::kMouseMovementUnitsMin) /
+          (double)(kTriggerValueMax - kTriggerValueMin);
+      constexpr double kPositiveStepSize =
+          (double)Mouse::kMouseMovementUnitsMax / (double)(kTriggerValueMax - kTriggerValueMin);
+      constexpr double kNegativeStepSize =
+          (double)Mouse::kMouseMovementUnitsMin / (double)(kTriggerValueMax - kTriggerValueMin);
+
+      constexpr unsigned int kTriggerMouseDeadzonePercent = 8;
+      constexpr unsigned int kTriggerMouseSaturationPercent = 92;
+      const uint8_t triggerValueForContribution =
+          (applyProperties
+               ? Math::ApplyRawTriggerTransform(
+                     triggerValue, kTriggerMouseDeadzonePercent, kTriggerMouseSaturationPercent)
+               : triggerValue);
+
+      int mouseAxisValueToContribute = 0;
+
+      switch (direction)
+      {
+        case EAxisDirection::Both:
+          mouseAxisValueToContribute =
+              (int)((double)triggerValueForContribution * kBidirectionalStepSize) +
+              Mouse::kMouseMovementUnitsMin;
+          break;
+
+        case EAxisDirection::Positive:
+          mouseAxisValueToContribute =
+              (int)((double)triggerValueForContribution * kPositiveStepSize) +
+              Mouse::kMouseMovementUnitsNeutral;
+          break;
+
+        case EAxisDirection::Negative:
+          mouseAxisValueToContribute =
+              (int)((double)triggerValueForContribution * kNegativeStepSize) -
+              Mouse::kMouseMovementUnitsNeutral;
+          break;
+      }
+
+      return mouseAxisValueToContribute;
+    }
+
+    /// Submits the state of a virtual keyboard key.
+    /// @param [in] key Target keyboard key.
+    /// @param [in] keyPressed Whether or not the key is pressed.
+    static inline void SubmitKeyState(Keyboard::TKeyIdentifier key, bool keyPressed)
+    {
+      if (true == keyPressed)
+        Keyboard::SubmitKeyPressedState(key);
+      else
+        Keyboard::SubmitKeyReleasedState(key);
+    }
+
+    /// Submits the state of a virtual mouse button.
+    /// @param [in] mouseButton Target mouse button.
+    /// @param [in] mouseButtonPressed Whether or not the mouse button is pressed.
+    static inline void SubmitMouseButtonState(
+        Mouse::EMouseButton mouseButton, bool mouseButtonPressed)
+    {
+      if (true == mouseButtonPressed)
+        Mouse::SubmitMouseButtonPressedState(mouseButton);
+      else
+        Mouse::SubmitMouseButtonReleasedState(mouseButton);
+    }
+
+    /// Submits the state of a mouse speed modifier.
+    /// @param [in] mouseSpeedScalingFactor Mouse speed scaling factor to use while the modifier is
+    /// active.
+    /// @param [in] modifierActive Whether or not the modifier is active.
+    /// @param [in] sourceIdentifier Opaque identifier for the XInput controller element that is
+    /// the source of the modifier.
+    static inline void SubmitMouseSpeedModifierState(
+        unsigned int mouseSpeedScalingFactor, bool modifierActive, uint32_t sourceIdentifier)
+    {
+      if (true == modifierActive)
+        Mouse::SubmitMouseSpeedOverride(mouseSpeedScalingFactor, sourceIdentifier);
+      else
+        Mouse::SubmitMouseSpeedOverride(std::nullopt, sourceIdentifier);
+    }
+
+    /// Applies a transformation to an XInput controller element value.
+    /// @param [in] valueType Type of the value.
+    /// @param [in] valueTransform Transformation to apply.
+    /// @param [in] value Value to transform.
+    /// @return Transformed value.
+    static inline int32_t TransformedValue(
+        ElementMapperProgram::EValueType valueType,
+        ElementMapperProgram::EValueTransform valueTransform,
+        int32_t value)
+    {
+      switch (valueTransform)
+      {
+        case ElementMapperProgram::EValueTransform::Invert:
+          switch (valueType)
+          {
+            case ElementMapperProgram::EValueType::Analog:
+              return (int32_t)(int16_t)((kAnalogValueMax + kAnalogValueMin) - value);
+            case ElementMapperProgram::EValueType::Button:
+              return ((0 != value) ? 0 : 1);
+            case ElementMapperProgram::EValueType::Trigger:
+              return (int32_t)(uint8_t)((kTriggerValueMax + kTriggerValueMin) - value);
+          }
+          break;
+
+        case ElementMapperProgram::EValueTransform::ForcePressed:
+          return 1;
+
+        case ElementMapperProgram::EValueTransform::ForceReleased:
+          return 0;
+
+        default:
+          break;
+      }
+
+      return value;
+    }
+
+    /// Determines if an XInput controller element value should be considered pressed, using the
+    /// same definition as all element mappers that have only pressed and not pressed states.
+    /// @param [in] valueType Type of the value.
+    /// @param [in] value Value to check.
+    /// @return `true` if the value is pressed, `false` otherwise.
+    static inline bool IsValuePressed(ElementMapperProgram::EValueType valueType, int32_t value)
+    {
+      switch (valueType)
+      {
+        case ElementMapperProgram::EValueType::Analog:
+          return Math::IsAnalogPressed((int16_t)value);
+        case ElementMapperProgram::EValueType::Trigger:
+          return Math::IsTriggerPressed((uint8_t)value);
+        default:
+          return (0 != value);
+      }
+    }
+
+    /// Determines if an XInput controller element value is on the negative side, using the same
+    /// definition as split element mappers.
+    /// @param [in] valueType Type of the value.
+    /// @param [in] value Value to check.
+    /// @return `true` if the value is negative, `false` if it is positive.
+    static inline bool IsValueNegative(ElementMapperProgram::EValueType valueType, int32_t value)
+    {
+      switch (valueType)
+      {
+        case ElementMapperProgram::EValueType::Analog:
+          return (value < kAnalogValueNeutral);
+        case ElementMapperProgram::EValueType::Trigger:
+          return (value < kTriggerValueMid);
+        default:
+          return (0 == value);
+      }
+    }
+
+    /// Enumerates the types of element mappers that can appear in a structure description.
+    enum class EStructureTag : uint32_t
+    {
+      None,
+      Axis,
+      Button,
+      Compound,
+      DigitalAxis,
+      Invert,
+      Keyboard,
+      MouseAxis,
+      MouseButton,
+      MouseSpeedModifier,
+      Pov,
+      Split
+    };
+
+    /// Begins describing the structure of an element mapper by identifying its type and accounting
+    /// for the memory it occupies.
+    /// @param [in,out] structure Structure description to which to append.
+    /// @param [in] tag Type of element mapper being described.
+    /// @param [in] footprint Number of bytes occupied by the element mapper being described, not
+    /// including any underlying element mappers.
+    static inline void BeginStructureDescription(
+        IElementMapper::SStructure& structure, EStructureTag tag, size_t footprint)
+    {
+      structure.key.push_back((uint32_t)tag);
+      structure.footprint += footprint;
+    }
+
+    /// Describes the structure of an underlying element mapper, which might not be present.
+    /// @param [in,out] structure Structure description to which to append.
+    /// @param [in] elementMapper Underlying element mapper, or `nullptr` if there is none.
+    /// @return `true` if the structure was described, `false` otherwise.
+    static inline bool DescribeUnderlyingStructure(
+        IElementMapper::SStructure& structure, const IElementMapper* elementMapper)
+    {
+      if (nullptr == elementMapper)
+      {
+        structure.key.push_back((uint32_t)EStructureTag::None);
+        return true;
+      }
+
+      return elementMapper->DescribeStructure(structure);
+    }
+
+    void ElementMapperProgram::Compiler::CompileContribution(const IElementMapper* elementMapper)
+    {
+      if (nullptr != elementMapper) elementMapper->CompileContribution(*this);
+    }
+
+    void ElementMapperProgram::Compiler::CompileNeutral(const IElementMapper* elementMapper)
+    {
+      if (nullptr != elementMapper) elementMapper->CompileNeutral(*this);
+    }
+
+    void ElementMapperProgram::Compiler::CompileInvertedContribution(
+        const IElementMapper* elementMapper)
+    {
+      const EValueTransform previousValueTransform = valueTransform;
+
+      switch (valueTransform)
+      {
+        case EValueTransform::None:
+          valueTransform = EValueTransform::Invert;
+          break;
+        case EValueTransform::Invert:
+          valueTransform = EValueTransform::None;
+          break;
+        case EValueTransform::ForcePressed:
+          valueTransform = EValueTransform::ForceReleased;
+          break;
+        case EValueTransform::ForceReleased:
+          valueTransform = EValueTransform::ForcePressed;
+          break;
+      }
+
+      CompileContribution(elementMapper);
+      valueTransform = previousValueTransform;
+    }
+
+    void ElementMapperProgram::Compiler::CompileSplitContribution(
+        const IElementMapper* positiveMapper, const IElementMapper* negativeMapper)
+    {
+      // Whichever side is active receives the value, except that buttons are always received as
+      // pressed. The inactive side makes a neutral contribution afterwards.
+      const EValueTransform previousValueTransform = valueTransform;
+      const EValueTransform activeValueTransform =
+          ((EValueType::Button == valueType) ? EValueTransform::ForcePressed : valueTransform);
+
+      const uint32_t jumpToNegativeIndex = Append(EOpcode::JumpIfNegative, {.jumpTarget = 0});
+
+      valueTransform = activeValueTransform;
+      CompileContribution(positiveMapper);
+      valueTransform = previousValueTransform;
+      CompileNeutral(negativeMapper);
+
+      const uint32_t jumpToEndIndex = Append(EOpcode::Jump, {.jumpTarget = 0});
+      program.instructions[jumpToNegativeIndex].operand.jumpTarget =
+          (uint32_t)program.instructions.size();
+
+      valueTransform = activeValueTransform;
+      CompileContribution(negativeMapper);
+      valueTransform = previousValueTransform;
+      CompileNeutral(positiveMapper);
+
+      program.instructions[jumpToEndIndex].operand.jumpTarget =
+          (uint32_t)program.instructions.size();
+    }
+
+    void ElementMapperProgram::Compiler::Emit(EOpcode opcode, UOperand operand)
+    {
+      Append(opcode, operand);
+    }
+
+    uint32_t ElementMapperProgram::Compiler::Append(EOpcode opcode, UOperand operand)
+    {
+      program.instructions.push_back(
+          {.opcode = opcode,
+           .valueType = valueType,
+           .valueTransform = valueTransform,
+           .sourceIndex = sourceIndex,
+           .operand = operand});
+      return (uint32_t)(program.instructions.size() - 1);
+    }
+
+    void ElementMapperProgram::Execute(
+        SState& controllerState,
+        std::span<const int32_t> sourceValues,
+        uint32_t sourceIdentifierBase,
+        SInstructionRange range) const
+    {
+      size_t instructionIndex = range.begin;
+
+      while (instructionIndex < range.end)
+      {
+        const SInstruction& instruction = instructions[instructionIndex++];
+        const EValueType valueType = instruction.valueType;
+        const int32_t value = TransformedValue(
+            valueType, instruction.valueTransform, sourceValues[instruction.sourceIndex]);
+        const uint32_t sourceIdentifier = sourceIdentifierBase + instruction.sourceIndex;
+
+        switch (instruction.opcode)
+        {
+          case EOpcode::Axis:
+            switch (valueType)
+            {
+              case EValueType::Analog:
+                controllerState[instruction.operand.axis.axis] += AxisContributionFromAnalogValue(
+                    instruction.operand.axis.direction, (int16_t)value);
+                break;
+              case EValueType::Button:
+                controllerState[instruction.operand.axis.axis] += AxisContributionFromButtonValue(
+                    instruction.operand.axis.direction, (0 != value));
+                break;
+              case EValueType::Trigger:
+                controllerState[instruction.operand.axis.axis] += AxisContributionFromTriggerValue(
+                    instruction.operand.axis.direction, (uint8_t)value);
+                break;
+            }
+            break;
+
+          case EOpcode::DigitalAxis:
+            if (EValueType::Analog == valueType)
+              controllerState[instruction.operand.axis.axis] +=
+                  DigitalAxisContributionFromAnalogValue(
+                      instruction.operand.axis.direction, (int16_t)value);
+            else
+              controllerState[instruction.operand.axis.axis] += AxisContributionFromButtonValue(
+                  instruction.operand.axis.direction, IsValuePressed(valueType, value));
+            break;
+
+          case EOpcode::Button:
+            controllerState[instruction.operand.button] =
+                (controllerState[instruction.operand.button] || IsValuePressed(valueType, value));
+            break;
+
+          case EOpcode::Pov:
+            if (true == IsValuePressed(valueType, value))
+              controllerState.povDirection.components[(int)instruction.operand.povDirection] = true;
+            break;
+
+          case EOpcode::Keyboard:
+            SubmitKeyState(instruction.operand.key, IsValuePressed(valueType, value));
+            break;
+
+          case EOpcode::KeyboardNeutral:
+            Keyboard::SubmitKeyReleasedState(instruction.operand.key);
+            break;
+
+          case EOpcode::MouseAxis:
+            switch (valueType)
+            {
+              case EValueType::Analog:
+                Mouse::SubmitMouseMovement(
+                    instruction.operand.mouseAxis.axis,
+                    MouseAxisContributionFromAnalogValue(
+                        instruction.operand.mouseAxis.direction,
+                        (int16_t)value,
+                        instruction.operand.mouseAxis.applyProperties),
+                    sourceIdentifier);
+                break;
+              case EValueType::Button:
+                Mouse::SubmitMouseMovement(
+                    instruction.operand.mouseAxis.axis,
+                    MouseAxisContributionFromButtonValue(
+                        instruction.operand.mouseAxis.direction, (0 != value)),
+                    sourceIdentifier);
+                break;
+              case EValueType::Trigger:
+                Mouse::SubmitMouseMovement(
+                    instruction.operand.mouseAxis.axis,
+                    MouseAxisContributionFromTriggerValue(
+                        instruction.operand.mouseAxis.direction,
+                        (uint8_t)value,
+                        instruction.operand.mouseAxis.applyProperties),
+                    sourceIdentifier);
+                break;
+            }
+            break;
+
+          case EOpcode::MouseAxisNeutral:
+            Mouse::SubmitMouseMovement(
+                instruction.operand.mouseAxis.axis,
+                Mouse::kMouseMovementUnitsNeutral,
+                sourceIdentifier);
+            break;
+
+          case EOpcode::MouseButton:
+            SubmitMouseButtonState(
+                instruction.operand.mouseButton, IsValuePressed(valueType, value));
+            break;
+
+          case EOpcode::MouseButtonNeutral:
+            Mouse::SubmitMouseButtonReleasedState(instruction.operand.mouseButton);
+            break;
+
+          case EOpcode::MouseSpeedModifier:
+            SubmitMouseSpeedModifierState(
+                instruction.operand.mouseSpeedScalingFactor,
+                IsValuePressed(valueType, value),
+                sourceIdentifier);
+            break;
+
+          case EOpcode::MouseSpeedModifierNeutral:
+            Mouse::SubmitMouseSpeedOverride(std::nullopt, sourceIdentifier);
+            break;
+
+          case EOpcode::Invoke:
+            switch (valueType)
+            {
+              case EValueType::Analog:
+                instruction.operand.elementMapper->ContributeFromAnalogValue(
+                    controllerState, (int16_t)value, sourceIdentifier);
+                break;
+              case EValueType::Button:
+                instruction.operand.elementMapper->ContributeFromButtonValue(
+                    controllerState, (0 != value), sourceIdentifier);
+                break;
+              case EValueType::Trigger:
+                instruction.operand.elementMapper->ContributeFromTriggerValue(
+                    controllerState, (uint8_t)value, sourceIdentifier);
+                break;
+            }
+            break;
+
+          case EOpcode::InvokeNeutral:
+            instruction.operand.elementMapper->ContributeNeutral(controllerState, sourceIdentifier);
+            break;
+
+          case EOpcode::JumpIfNegative:
+            if (true == IsValueNegative(valueType, value))
+              instructionIndex = instruction.operand.jumpTarget;
+            break;
+
+          case EOpcode::Jump:
+            instructionIndex = instruction.operand.jumpTarget;
+            break;
+        }
+      }
+    }
+
+    /// Adds a column of contributions to a column of axis values.
+    /// @param [in,out] axisColumn Axis values to be updated in place.
+    /// @param [in] contributionColumn Contributions to add, one per axis value.
+    static void AccumulateAxisColumn(
+        std::span<int32_t> axisColumn, std::span<const int32_t> contributionColumn)
+    {
+      size_t i = 0;
+
+#ifdef XIDI_ELEMENT_MAPPER_USE_SSE2
+      for (; (i + 4) <= axisColumn.size(); i += 4)
+      {
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(&axisColumn[i]),
+            _mm_add_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&axisColumn[i])),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&contributionColumn[i]))));
+      }
+#endif
+
+      for (; i < axisColumn.size(); ++i)
+        axisColumn[i] += contributionColumn[i];
+    }
+
+    /// Sets a bit in a column of button bitmasks wherever the corresponding entry in a column of
+    /// pressed states is non-zero.
+    /// @param [in,out] buttonColumn Button bitmasks to be updated in place.
+    /// @param [in] pressedColumn Pressed states, one per button bitmask.
+    /// @param [in] buttonBit Bit to set.
+    static void AccumulateButtonColumn(
+        std::span<uint32_t> buttonColumn,
+        std::span<const int32_t> pressedColumn,
+        uint32_t buttonBit)
+    {
+      size_t i = 0;
+
+#ifdef XIDI_ELEMENT_MAPPER_USE_SSE2
+      const __m128i kButtonBit = _mm_set1_epi32((int)buttonBit);
+
+      for (; (i + 4) <= buttonColumn.size(); i += 4)
+      {
+        const __m128i isReleased = _mm_cmpeq_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pressedColumn[i])),
+            _mm_setzero_si128());
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(&buttonColumn[i]),
+            _mm_or_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&buttonColumn[i])),
+                _mm_andnot_si128(isReleased, kButtonBit)));
+      }
+#endif
+
+      for (; i < buttonColumn.size(); ++i)
+        buttonColumn[i] |= ((0 != pressedColumn[i]) ? buttonBit : 0);
+    }
+
+    /// Sets a bit in a column of POV direction bitmasks wherever the corresponding entry in a
+    /// column of pressed states is non-zero.
+    /// @param [in,out] povDirectionColumn POV direction bitmasks to be updated in place.
+    /// @param [in] pressedColumn Pressed states, one per POV direction bitmask.
+    /// @param [in] povDirectionBit Bit to set.
+    static void AccumulatePovDirectionColumn(
+        std::span<uint8_t> povDirectionColumn,
+        std::span<const int32_t> pressedColumn,
+        uint8_t povDirectionBit)
+    {
+      size_t i = 0;
+
+#ifdef XIDI_ELEMENT_MAPPER_USE_SSE2
+      const __m128i kPovDirectionBit = _mm_set1_epi8((char)povDirectionBit);
+
+      // Packing with saturation keeps non-zero values non-zero, so sixteen pressed states can be
+      // narrowed to bytes and compared at once.
+      for (; (i + 16) <= povDirectionColumn.size(); i += 16)
+      {
+        const __m128i pressedLow = _mm_packs_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pressedColumn[i])),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pressedColumn[i + 4])));
+        const __m128i pressedHigh = _mm_packs_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pressedColumn[i + 8])),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pressedColumn[i + 12])));
+        const __m128i isReleased =
+            _mm_cmpeq_epi8(_mm_packs_epi16(pressedLow, pressedHigh), _mm_setzero_si128());
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(&povDirectionColumn[i]),
+            _mm_or_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&povDirectionColumn[i])),
+                _mm_andnot_si128(isReleased, kPovDirectionBit)));
+      }
+#endif
+
+      for (; i < povDirectionColumn.size(); ++i)
+        povDirectionColumn[i] |= ((0 != pressedColumn[i]) ? povDirectionBit : 0);
+    }
+
+    void ElementMapperProgram::ExecuteColumns(
+        SColumnAccumulators& accumulators,
+        std::span<const int32_t> sourceValueColumn,
+        SInstructionRange range) const
+    {
+      const size_t columnSize =
+          std::min(sourceValueColumn.size(), SColumnAccumulators::kColumnSize);
+
+      // Each set of values can take its own path through the range because of jumps. All jumps
+      // go forward, so visiting each instruction once and applying it only to those sets of values
+      // for which it is next in line is equivalent to executing the range separately for each set.
+      // Without any jumps every instruction applies to every set of values, so there is no need to
+      // check.
+      bool hasJumps = false;
+      for (uint32_t instructionIndex = range.begin; instructionIndex < range.end;
+           ++instructionIndex)
+      {
+        if ((EOpcode::JumpIfNegative == instructions[instructionIndex].opcode) ||
+            (EOpcode::Jump == instructions[instructionIndex].opcode))
+        {
+          hasJumps = true;
+          break;
+        }
+      }
+
+      std::array<uint32_t, SColumnAccumulators::kColumnSize> nextInstructionIndex;
+      nextInstructionIndex.fill(range.begin);
+
+      // Contributions are computed one set of values at a time using the same functions as
+      // #Execute, so that both produce identical results, and are then accumulated all at once.
+      // Sets of values that do not execute an instruction contribute nothing to it.
+      alignas(16) std::array<int32_t, SColumnAccumulators::kColumnSize> contributionColumn;
+
+      for (uint32_t instructionIndex = range.begin; instructionIndex < range.end;
+           ++instructionIndex)
+      {
+        const SInstruction& instruction = instructions[instructionIndex];
+        const EValueType valueType = instruction.valueType;
+
+        auto forEachValue = [&](auto execute) -> void
+        {
+          if (false == hasJumps)
+          {
+            for (size_t i = 0; i < columnSize; ++i)
+              execute(
+                  i,
+                  TransformedValue(valueType, instruction.valueTransform, sourceValueColumn[i]));
+            return;
+          }
+
+          for (size_t i = 0; i < columnSize; ++i)
+          {
+            if (instructionIndex != nextInstructionIndex[i]) continue;
+
+            nextInstructionIndex[i] = instructionIndex + 1;
+            execute(
+                i,
+                TransformedValue(valueType, instruction.valueTransform, sourceValueColumn[i]));
+          }
+        };
+
+        auto computeContributions = [&](auto contribution) -> std::span<const int32_t>
+        {
+          if (true == hasJumps) contributionColumn.fill(0);
+
+          forEachValue([&](size_t i, int32_t value) -> void
+                       { contributionColumn[i] = contribution(value); });
+          return std::span<const int32_t>(contributionColumn.data(), columnSize);
+        };
+
+        switch (instruction.opcode)
+        {
+          case EOpcode::Axis:
+          {
+            const std::span<int32_t> axisColumn(
+                accumulators.axis[(int)instruction.operand.axis.axis].data(), columnSize);
+            const EAxisDirection direction = instruction.operand.axis.direction;
+
+            switch (valueType)
+            {
+              case EValueType::Analog:
+                AccumulateAxisColumn(
+                    axisColumn,
+                    computeContributions(
+                        [direction](int32_t value) -> int32_t
+                        { return AxisContributionFromAnalogValue(direction, (int16_t)value); }));
+                break;
+              case EValueType::Button:
+                AccumulateAxisColumn(
+                    axisColumn,
+                    computeContributions(
+                        [direction](int32_t value) -> int32_t
+                        { return AxisContributionFromButtonValue(direction, (0 != value)); }));
+                break;
+              case EValueType::Trigger:
+                AccumulateAxisColumn(
+                    axisColumn,
+                    computeContributions(
+                        [direction](int32_t value) -> int32_t
+                        { return AxisContributionFromTriggerValue(direction, (uint8_t)value); }));
+                break;
+            }
+            break;
+          }
+
+          case EOpcode::DigitalAxis:
+          {
+            const std::span<int32_t> axisColumn(
+                accumulators.axis[(int)instruction.operand.axis.axis].data(), columnSize);
+            const EAxisDirection direction = instruction.operand.axis.direction;
+
+            if (EValueType::Analog == valueType)
+              AccumulateAxisColumn(
+                  axisColumn,
+                  computeContributions(
+                      [direction](int32_t value) -> int32_t
+                      {
+                        return DigitalAxisContributionFromAnalogValue(direction, (int16_t)value);
+                      }));
+            else
+              AccumulateAxisColumn(
+                  axisColumn,
+                  computeContributions(
+                      [direction, valueType](int32_t value) -> int32_t
+                      {
+                        return AxisContributionFromButtonValue(
+                            direction, IsValuePressed(valueType, value));
+                      }));
+            break;
+          }
+
+          case EOpcode::Button:
+            AccumulateButtonColumn(
+                std::span<uint32_t>(accumulators.button.data(), columnSize),
+                computeContributions([valueType](int32_t value) -> int32_t
+                                     { return (int32_t)IsValuePressed(valueType, value); }),
+                (1u << (int)instruction.operand.button));
+            break;
+
+          case EOpcode::Pov:
+            AccumulatePovDirectionColumn(
+                std::span<uint8_t>(accumulators.povDirection.data(), columnSize),
+                computeContributions([valueType](int32_t value) -> int32_t
+                                     { return (int32_t)IsValuePressed(valueType, value); }),
+                (uint8_t)(1u << (int)instruction.operand.povDirection));
+            break;
+
+          case EOpcode::JumpIfNegative:
+            forEachValue(
+                [&](size_t i, int32_t value) -> void
+                {
+                  if (true == IsValueNegative(valueType, value))
+                    nextInstructionIndex[i] = instruction.operand.jumpTarget;
+                });
+            break;
+
+          case EOpcode::Jump:
+            forEachValue([&](size_t i, int32_t value) -> void
+                         { nextInstructionIndex[i] = instruction.operand.jumpTarget; });
+            break;
+
+          default:
+            // Contributions that cannot be undone are not supported here.
+            forEachValue([](size_t i, int32_t value) -> void {});
+            break;
+        }
+      }
+    }
+
+    ElementMapperProgram::SInstructionRange ElementMapperProgram::FindSourceInstructions(
+        uint8_t sourceIndex) const
+    {
+      uint32_t begin = 0;
+      while ((begin < instructions.size()) && (instructions[begin].sourceIndex != sourceIndex))
+        begin += 1;
+
+      uint32_t end = begin;
+      while ((end < instructions.size()) && (instructions[end].sourceIndex == sourceIndex))
+        end += 1;
+
+      return {.begin = begin, .end = end};
+    }
+
+    bool ElementMapperProgram::IsReversible(SInstructionRange range) const
+    {
+      for (uint32_t i = range.begin; i < range.end; ++i)
+      {
+        switch (instructions[i].opcode)
+        {
+          case EOpcode::Axis:
+          case EOpcode::DigitalAxis:
+          case EOpcode::Button:
+          case EOpcode::Pov:
+          case EOpcode::JumpIfNegative:
+          case EOpcode::Jump:
+            break;
+
+          default:
+            return false;
+        }
+      }
+
+      return true;
+    }
+
+    bool IElementMapper::DescribeStructure(SStructure& structure) const
+    {
+      return false;
+    }
+
+    void IElementMapper::CompileContribution(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(ElementMapperProgram::EOpcode::Invoke, {.elementMapper = this});
+    }
+
+    void IElementMapper::CompileNeutral(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(ElementMapperProgram::EOpcode::InvokeNeutral, {.elementMapper = this});
+    }
+
+    std::unique_ptr<IElementMapper> AxisMapper::Clone(void) const
+    {
+      return std::make_unique<AxisMapper>(*this);
+    }
+
+    bool AxisMapper::DescribeStructure(SStructure& structure) const
+    {
+      BeginStructureDescription(structure, EStructureTag::Axis, sizeof(*this));
+      structure.key.push_back((uint32_t)axis);
+      structure.key.push_back((uint32_t)direction);
+      return true;
+    }
+
+    void AxisMapper::ContributeFromAnalogValue(
+        SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const
+    {
+      controllerState[axis] += AxisContributionFromAnalogValue(direction, analogValue);
+    }
+
+    void AxisMapper::ContributeFromButtonValue(
+        SState& controllerState, bool buttonPressed, uint32_t sourceIdentifier) const
+    {
+      controllerState[axis] += AxisContributionFromButtonValue(direction, buttonPressed);
+    }
+
+    void AxisMapper::ContributeFromTriggerValue(
+        SState& controllerState, uint8_t triggerValue, uint32_t sourceIdentifier) const
+    {
+      controllerState[axis] += AxisContributionFromTriggerValue(direction, triggerValue);
     }
 
     int AxisMapper::GetTargetElementCount(void) const
@@ -122,11 +1065,30 @@ namespace Xidi
       return SElementIdentifier({.type = EElementType::Axis, .axis = axis});
     }
 
+    void AxisMapper::CompileContribution(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(
+          ElementMapperProgram::EOpcode::Axis, {.axis = {.axis = axis, .direction = direction}});
+    }
+
+    void AxisMapper::CompileNeutral(ElementMapperProgram::Compiler& compiler) const
+    {
+      // Contributions are made directly to the virtual controller state, so there is nothing to
+      // reset when making a neutral contribution.
+    }
+
     std::unique_ptr<IElementMapper> ButtonMapper::Clone(void) const
     {
       return std::make_unique<ButtonMapper>(*this);
     }
 
+    bool ButtonMapper::DescribeStructure(SStructure& structure) const
+    {
+      BeginStructureDescription(structure, EStructureTag::Button, sizeof(*this));
+      structure.key.push_back((uint32_t)button);
+      return true;
+    }
+
     void ButtonMapper::ContributeFromAnalogValue(
         SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const
     {
@@ -150,11 +1112,22 @@ namespace Xidi
       return 1;
     }
 
-    std::optional<SElementIdentifier> ButtonMapper::GetTargetElementAt(int index) const
+    std::optional<SElementIdentifier> ButtonMapper::GetTargetElementAt(int index) const
+    {
+      if (0 != index) return std::nullopt;
+
+      return SElementIdentifier({.type = EElementType::Button, .button = button});
+    }
+
+    void ButtonMapper::CompileContribution(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(ElementMapperProgram::EOpcode::Button, {.button = button});
+    }
+
+    void ButtonMapper::CompileNeutral(ElementMapperProgram::Compiler& compiler) const
     {
-      if (0 != index) return std::nullopt;
-
-      return SElementIdentifier({.type = EElementType::Button, .button = button});
+      // Contributions are made directly to the virtual controller state, so there is nothing to
+      // reset when making a neutral contribution.
     }
 
     std::unique_ptr<IElementMapper> CompoundMapper::Clone(void) const
@@ -162,6 +1135,16 @@ namespace Xidi
       return std::make_unique<CompoundMapper>(*this);
     }
 
+    bool CompoundMapper::DescribeStructure(SStructure& structure) const
+    {
+      BeginStructureDescription(structure, EStructureTag::Compound, sizeof(*this));
+
+      for (const auto& elementMapper : elementMappers)
+        if (false == DescribeUnderlyingStructure(structure, elementMapper.get())) return false;
+
+      return true;
+    }
+
     void CompoundMapper::ContributeFromAnalogValue(
         SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const
     {
@@ -235,35 +1218,36 @@ namespace Xidi
       return std::nullopt;
     }
 
+    void CompoundMapper::CompileContribution(ElementMapperProgram::Compiler& compiler) const
+    {
+      for (const auto& elementMapper : elementMappers)
+        compiler.CompileContribution(elementMapper.get());
+    }
+
+    void CompoundMapper::CompileNeutral(ElementMapperProgram::Compiler& compiler) const
+    {
+      for (const auto& elementMapper : elementMappers)
+        compiler.CompileNeutral(elementMapper.get());
+    }
+
     std::unique_ptr<IElementMapper> DigitalAxisMapper::Clone(void) const
     {
       return std::make_unique<DigitalAxisMapper>(*this);
     }
 
+    bool DigitalAxisMapper::DescribeStructure(SStructure& structure) const
+    {
+      BeginStructureDescription(structure, EStructureTag::DigitalAxis, sizeof(*this));
+      structure.key.push_back((uint32_t)GetAxis());
+      structure.key.push_back((uint32_t)GetAxisDirection());
+      return true;
+    }
+
     void DigitalAxisMapper::ContributeFromAnalogValue(
         SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const
     {
-      int32_t axisValueToContribute = 0;
-
-      switch (GetAxisDirection())
-      {
-        case EAxisDirection::Both:
-          if (Math::IsAnalogPressedNegative(analogValue))
-            axisValueToContribute = kAnalogValueMin;
-          else if (Math::IsAnalogPressedPositive(analogValue))
-            axisValueToContribute = kAnalogValueMax;
-          break;
-
-        case EAxisDirection::Positive:
-          if (Math::IsAnalogPressedPositive(analogValue)) axisValueToContribute = kAnalogValueMax;
-          break;
-
-        case EAxisDirection::Negative:
-          if (Math::IsAnalogPressedNegative(analogValue)) axisValueToContribute = kAnalogValueMin;
-          break;
-      }
-
-      controllerState[GetAxis()] += axisValueToContribute;
+      controllerState[GetAxis()] +=
+          DigitalAxisContributionFromAnalogValue(GetAxisDirection(), analogValue);
     }
 
     void DigitalAxisMapper::ContributeFromTriggerValue(
@@ -273,11 +1257,24 @@ namespace Xidi
           controllerState, Math::IsTriggerPressed(triggerValue), sourceIdentifier);
     }
 
+    void DigitalAxisMapper::CompileContribution(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(
+          ElementMapperProgram::EOpcode::DigitalAxis,
+          {.axis = {.axis = GetAxis(), .direction = GetAxisDirection()}});
+    }
+
     std::unique_ptr<IElementMapper> InvertMapper::Clone(void) const
     {
       return std::make_unique<InvertMapper>(*this);
     }
 
+    bool InvertMapper::DescribeStructure(SStructure& structure) const
+    {
+      BeginStructureDescription(structure, EStructureTag::Invert, sizeof(*this));
+      return DescribeUnderlyingStructure(structure, elementMapper.get());
+    }
+
     void InvertMapper::ContributeFromAnalogValue(
         SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const
     {
@@ -333,36 +1330,44 @@ namespace Xidi
       return std::nullopt;
     }
 
+    void InvertMapper::CompileContribution(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.CompileInvertedContribution(elementMapper.get());
+    }
+
+    void InvertMapper::CompileNeutral(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.CompileNeutral(elementMapper.get());
+    }
+
     std::unique_ptr<IElementMapper> KeyboardMapper::Clone(void) const
     {
       return std::make_unique<KeyboardMapper>(*this);
     }
 
+    bool KeyboardMapper::DescribeStructure(SStructure& structure) const
+    {
+      BeginStructureDescription(structure, EStructureTag::Keyboard, sizeof(*this));
+      structure.key.push_back((uint32_t)key);
+      return true;
+    }
+
     void KeyboardMapper::ContributeFromAnalogValue(
         SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const
     {
-      if (true == Math::IsAnalogPressed(analogValue))
-        Keyboard::SubmitKeyPressedState(key);
-      else
-        Keyboard::SubmitKeyReleasedState(key);
+      SubmitKeyState(key, Math::IsAnalogPressed(analogValue));
     }
 
     void KeyboardMapper::ContributeFromButtonValue(
         SState& controllerState, bool buttonPressed, uint32_t sourceIdentifier) const
     {
-      if (true == buttonPressed)
-        Keyboard::SubmitKeyPressedState(key);
-      else
-        Keyboard::SubmitKeyReleasedState(key);
+      SubmitKeyState(key, buttonPressed);
     }
 
     void KeyboardMapper::ContributeFromTriggerValue(
         SState& controllerState, uint8_t triggerValue, uint32_t sourceIdentifier) const
     {
-      if (true == Math::IsTriggerPressed(triggerValue))
-        Keyboard::SubmitKeyPressedState(key);
-      else
-        Keyboard::SubmitKeyReleasedState(key);
+      SubmitKeyState(key, Math::IsTriggerPressed(triggerValue));
     }
 
     void KeyboardMapper::ContributeNeutral(SState& controllerState, uint32_t sourceIdentifier) const
@@ -380,145 +1385,54 @@ namespace Xidi
       return std::nullopt;
     }
 
+    void KeyboardMapper::CompileContribution(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(ElementMapperProgram::EOpcode::Keyboard, {.key = key});
+    }
+
+    void KeyboardMapper::CompileNeutral(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(ElementMapperProgram::EOpcode::KeyboardNeutral, {.key = key});
+    }
+
     std::unique_ptr<IElementMapper> MouseAxisMapper::Clone(void) const
     {
       return std::make_unique<MouseAxisMapper>(*this);
     }
 
+    bool MouseAxisMapper::DescribeStructure(SStructure& structure) const
+    {
+      BeginStructureDescription(structure, EStructureTag::MouseAxis, sizeof(*this));
+      structure.key.push_back((uint32_t)axis);
+      structure.key.push_back((uint32_t)direction);
+      return true;
+    }
+
     void MouseAxisMapper::ContributeFromAnalogValue(
         SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const
     {
-      static const bool kEnableMouseAxisProperites =
-          Globals::GetConfigurationData()
-              [Strings::kStrConfigurationSectionProperties]
-              [Strings::kStrConfigurationSettingsPropertiesUseBuiltinProperties]
-                  .ValueOr(true);
-
-      constexpr double kAnalogToMouseScalingFactor =
-          (double)(Mouse::kMouseMovementUnitsMax - Mouse::kMouseMovementUnitsMin) /
-          (double)(kAnalogValueMax - kAnalogValueMin);
-
-      constexpr unsigned int kAnalogMouseDeadzonePercent = 8;
-      constexpr unsigned int kAnalogMouseSaturationPercent = 92;
-      const int16_t analogValueForContribution =
-          (kEnableMouseAxisProperites
-               ? Math::ApplyRawAnalogTransform(
-                     analogValue, kAnalogMouseDeadzonePercent, kAnalogMouseSaturationPercent)
-               : analogValue);
-
-      const double mouseAxisValueRaw =
-          ((double)(analogValueForContribution - kAnalogValueNeutral) *
-           kAnalogToMouseScalingFactor);
-      const double mouseAxisValueTransformed = mouseAxisValueRaw;
-
-      int mouseAxisValueToContribute = (int)mouseAxisValueTransformed;
-
-      switch (direction)
-      {
-        case EAxisDirection::Both:
-          break;
-
-        case EAxisDirection::Positive:
-          mouseAxisValueToContribute =
-              (mouseAxisValueToContribute - Mouse::kMouseMovementUnitsMin) / 2;
-          break;
-
-        case EAxisDirection::Negative:
-          mouseAxisValueToContribute =
-              (mouseAxisValueToContribute - Mouse::kMouseMovementUnitsMax) / 2;
-          break;
-      }
-
-      Mouse::SubmitMouseMovement(axis, mouseAxisValueToContribute, sourceIdentifier);
+      Mouse::SubmitMouseMovement(
+          axis,
+          MouseAxisContributionFromAnalogValue(
+              direction, analogValue, AreMouseAxisPropertiesEnabled()),
+          sourceIdentifier);
     }
 
     void MouseAxisMapper::ContributeFromButtonValue(
         SState& controllerState, bool buttonPressed, uint32_t sourceIdentifier) const
     {
-      constexpr double kMouseButtonContributionScalingFactor = 0.5;
-
-      int mouseAxisValueToContribute = Mouse::kMouseMovementUnitsNeutral;
-
-      switch (direction)
-      {
-        case EAxisDirection::Both:
-          mouseAxisValueToContribute +=
-              (int)(kMouseButtonContributionScalingFactor *
-                    (double)(buttonPressed ? (Mouse::kMouseMovementUnitsMax -
-                                              Mouse::kMouseMovementUnitsNeutral)
-                                           : (Mouse::kMouseMovementUnitsMin -
-                                              Mouse::kMouseMovementUnitsNeutral)));
-          break;
-
-        case EAxisDirection::Positive:
-          mouseAxisValueToContribute +=
-              (int)(kMouseButtonContributionScalingFactor *
-                    (double)(buttonPressed ? (Mouse::kMouseMovementUnitsMax -
-                                              Mouse::kMouseMovementUnitsNeutral)
-                                           : 0));
-          break;
-
-        case EAxisDirection::Negative:
-          mouseAxisValueToContribute +=
-              (int)(kMouseButtonContributionScalingFactor *
-                    (double)(buttonPressed ? (Mouse::kMouseMovementUnitsMin -
-                                              Mouse::kMouseMovementUnitsNeutral)
-                                           : 0));
-          break;
-      }
-
-      Mouse::SubmitMouseMovement(axis, mouseAxisValueToContribute, sourceIdentifier);
+      Mouse::SubmitMouseMovement(
+          axis, MouseAxisContributionFromButtonValue(direction, buttonPressed), sourceIdentifier);
     }
 
     void MouseAxisMapper::ContributeFromTriggerValue(
         SState& controllerState, uint8_t triggerValue, uint32_t sourceIdentifier) const
     {
-      static const bool kEnableMouseAxisProperites =
-          Globals::GetConfigurationData()
-              [Strings::kStrConfigurationSectionProperties]
-              [Strings::kStrConfigurationSettingsPropertiesUseBuiltinProperties]
-                  .ValueOr(true);
-
-      constexpr double kBidirectionalStepSize =
-          (double)(Mouse::kMouseMovementUnitsMax - Mouse::kMouseMovementUnitsMin) /
-          (double)(kTriggerValueMax - kTriggerValueMin);
-      constexpr double kPositiveStepSize =
-          (double)Mouse::kMouseMovementUnitsMax / (double)(kTriggerValueMax - kTriggerValueMin);
-      constexpr double kNegativeStepSize =
-          (double)Mouse::kMouseMovementUnitsMin / (double)(kTriggerValueMax - kTriggerValueMin);
-
-      constexpr unsigned int kTriggerMouseDeadzonePercent = 8;
-      constexpr unsigned int kTriggerMouseSaturationPercent = 92;
-      const uint8_t triggerValueForContribution =
-          (kEnableMouseAxisProperites
-               ? Math::ApplyRawTriggerTransform(
-                     triggerValue, kTriggerMouseDeadzonePercent, kTriggerMouseSaturationPercent)
-               : triggerValue);
-
-      int mouseAxisValueToContribute = 0;
-
-      switch (direction)
-      {
-        case EAxisDirection::Both:
-          mouseAxisValueToContribute =
-              (int)((double)triggerValueForContribution * kBidirectionalStepSize) +
-              Mouse::kMouseMovementUnitsMin;
-          break;
-
-        case EAxisDirection::Positive:
-          mouseAxisValueToContribute =
-              (int)((double)triggerValueForContribution * kPositiveStepSize) +
-              Mouse::kMouseMovementUnitsNeutral;
-          break;
-
-        case EAxisDirection::Negative:
-          mouseAxisValueToContribute =
-              (int)((double)triggerValueForContribution * kNegativeStepSize) -
-              Mouse::kMouseMovementUnitsNeutral;
-          break;
-      }
-
-      Mouse::SubmitMouseMovement(axis, mouseAxisValueToContribute, sourceIdentifier);
+      Mouse::SubmitMouseMovement(
+          axis,
+          MouseAxisContributionFromTriggerValue(
+              direction, triggerValue, AreMouseAxisPropertiesEnabled()),
+          sourceIdentifier);
     }
 
     void MouseAxisMapper::ContributeNeutral(
@@ -537,36 +1451,51 @@ namespace Xidi
       return std::nullopt;
     }
 
+    void MouseAxisMapper::CompileContribution(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(
+          ElementMapperProgram::EOpcode::MouseAxis,
+          {.mouseAxis = {
+               .axis = axis,
+               .direction = direction,
+               .applyProperties = AreMouseAxisPropertiesEnabled()}});
+    }
+
+    void MouseAxisMapper::CompileNeutral(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(
+          ElementMapperProgram::EOpcode::MouseAxisNeutral,
+          {.mouseAxis = {.axis = axis, .direction = direction, .applyProperties = false}});
+    }
+
     std::unique_ptr<IElementMapper> MouseButtonMapper::Clone(void) const
     {
       return std::make_unique<MouseButtonMapper>(*this);
     }
 
+    bool MouseButtonMapper::DescribeStructure(SStructure& structure) const
+    {
+      BeginStructureDescription(structure, EStructureTag::MouseButton, sizeof(*this));
+      structure.key.push_back((uint32_t)mouseButton);
+      return true;
+    }
+
     void MouseButtonMapper::ContributeFromAnalogValue(
         SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const
     {
-      if (true == Math::IsAnalogPressed(analogValue))
-        Mouse::SubmitMouseButtonPressedState(mouseButton);
-      else
-        Mouse::SubmitMouseButtonReleasedState(mouseButton);
+      SubmitMouseButtonState(mouseButton, Math::IsAnalogPressed(analogValue));
     }
 
     void MouseButtonMapper::ContributeFromButtonValue(
         SState& controllerState, bool buttonPressed, uint32_t sourceIdentifier) const
     {
-      if (true == buttonPressed)
-        Mouse::SubmitMouseButtonPressedState(mouseButton);
-      else
-        Mouse::SubmitMouseButtonReleasedState(mouseButton);
+      SubmitMouseButtonState(mouseButton, buttonPressed);
     }
 
     void MouseButtonMapper::ContributeFromTriggerValue(
         SState& controllerState, uint8_t triggerValue, uint32_t sourceIdentifier) const
     {
-      if (true == Math::IsTriggerPressed(triggerValue))
-        Mouse::SubmitMouseButtonPressedState(mouseButton);
-      else
-        Mouse::SubmitMouseButtonReleasedState(mouseButton);
+      SubmitMouseButtonState(mouseButton, Math::IsTriggerPressed(triggerValue));
     }
 
     void MouseButtonMapper::ContributeNeutral(
@@ -585,36 +1514,48 @@ namespace Xidi
       return std::nullopt;
     }
 
+    void MouseButtonMapper::CompileContribution(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(ElementMapperProgram::EOpcode::MouseButton, {.mouseButton = mouseButton});
+    }
+
+    void MouseButtonMapper::CompileNeutral(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(
+          ElementMapperProgram::EOpcode::MouseButtonNeutral, {.mouseButton = mouseButton});
+    }
+
     std::unique_ptr<IElementMapper> MouseSpeedModifierMapper::Clone(void) const
     {
       return std::make_unique<MouseSpeedModifierMapper>(*this);
     }
 
+    bool MouseSpeedModifierMapper::DescribeStructure(SStructure& structure) const
+    {
+      BeginStructureDescription(structure, EStructureTag::MouseSpeedModifier, sizeof(*this));
+      structure.key.push_back((uint32_t)mouseSpeedScalingFactor);
+      return true;
+    }
+
     void MouseSpeedModifierMapper::ContributeFromAnalogValue(
         SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const
     {
-      if (true == Math::IsAnalogPressed(analogValue))
-        Mouse::SubmitMouseSpeedOverride(mouseSpeedScalingFactor, sourceIdentifier);
-      else
-        Mouse::SubmitMouseSpeedOverride(std::nullopt, sourceIdentifier);
+      SubmitMouseSpeedModifierState(
+          mouseSpeedScalingFactor, Math::IsAnalogPressed(analogValue), sourceIdentifier);
     }
 
     void MouseSpeedModifierMapper::ContributeFromButtonValue(
         SState& controllerState, bool buttonPressed, uint32_t sourceIdentifier) const
     {
-      if (true == buttonPressed)
-        Mouse::SubmitMouseSpeedOverride(mouseSpeedScalingFactor, sourceIdentifier);
-      else
-        Mouse::SubmitMouseSpeedOverride(std::nullopt, sourceIdentifier);
+      SubmitMouseSpeedModifierState(
+          mouseSpeedScalingFactor, buttonPressed, sourceIdentifier);
     }
 
     void MouseSpeedModifierMapper::ContributeFromTriggerValue(
         SState& controllerState, uint8_t triggerValue, uint32_t sourceIdentifier) const
     {
-      if (true == Math::IsTriggerPressed(triggerValue))
-        Mouse::SubmitMouseSpeedOverride(mouseSpeedScalingFactor, sourceIdentifier);
-      else
-        Mouse::SubmitMouseSpeedOverride(std::nullopt, sourceIdentifier);
+      SubmitMouseSpeedModifierState(
+          mouseSpeedScalingFactor, Math::IsTriggerPressed(triggerValue), sourceIdentifier);
     }
 
     void MouseSpeedModifierMapper::ContributeNeutral(
@@ -633,11 +1574,34 @@ namespace Xidi
       return std::nullopt;
     }
 
+    void MouseSpeedModifierMapper::CompileContribution(
+        ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(
+          ElementMapperProgram::EOpcode::MouseSpeedModifier,
+          {.mouseSpeedScalingFactor = mouseSpeedScalingFactor});
+    }
+
+    void MouseSpeedModifierMapper::CompileNeutral(
+        ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(
+          ElementMapperProgram::EOpcode::MouseSpeedModifierNeutral,
+          {.mouseSpeedScalingFactor = mouseSpeedScalingFactor});
+    }
+
     std::unique_ptr<IElementMapper> PovMapper::Clone(void) const
     {
       return std::make_unique<PovMapper>(*this);
     }
 
+    bool PovMapper::DescribeStructure(SStructure& structure) const
+    {
+      BeginStructureDescription(structure, EStructureTag::Pov, sizeof(*this));
+      structure.key.push_back((uint32_t)povDirection);
+      return true;
+    }
+
     void PovMapper::ContributeFromAnalogValue(
         SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const
     {
@@ -670,11 +1634,29 @@ namespace Xidi
       return SElementIdentifier({.type = EElementType::Pov});
     }
 
+    void PovMapper::CompileContribution(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.Emit(ElementMapperProgram::EOpcode::Pov, {.povDirection = povDirection});
+    }
+
+    void PovMapper::CompileNeutral(ElementMapperProgram::Compiler& compiler) const
+    {
+      // Contributions are made directly to the virtual controller state, so there is nothing to
+      // reset when making a neutral contribution.
+    }
+
     std::unique_ptr<IElementMapper> SplitMapper::Clone(void) const
     {
       return std::make_unique<SplitMapper>(*this);
     }
 
+    bool SplitMapper::DescribeStructure(SStructure& structure) const
+    {
+      BeginStructureDescription(structure, EStructureTag::Split, sizeof(*this));
+      if (false == DescribeUnderlyingStructure(structure, positiveMapper.get())) return false;
+      return DescribeUnderlyingStructure(structure, negativeMapper.get());
+    }
+
     void SplitMapper::ContributeFromAnalogValue(
         SState& controllerState, int16_t analogValue, uint32_t sourceIdentifier) const
     {
@@ -776,5 +1758,16 @@ namespace Xidi
 
       return std::nullopt;
     }
+
+    void SplitMapper::CompileContribution(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.CompileSplitContribution(positiveMapper.get(), negativeMapper.get());
+    }
+
+    void SplitMapper::CompileNeutral(ElementMapperProgram::Compiler& compiler) const
+    {
+      compiler.CompileNeutral(positiveMapper.get());
+      compiler.CompileNeutral(negativeMapper.get());
+    }
   } // namespace Controller
 } // namespace Xidi
@@ -0,0 +1,155 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file ElementMapperArena.cpp
+ *   Implementation of arenas from which element mappers that are created together are allocated
+ *   together.
+ **************************************************************************************************/
+
+#include "ElementMapperArena.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    /// Precedes each allocation and identifies where it came from.
+    struct alignas(std::max_align_t) SAllocationHeader
+    {
+      /// Arena from which the allocation came, or `nullptr` if it came from the heap.
+      ElementMapperArena::SArenaState* arenaState;
+    };
+
+    struct ElementMapperArena::SArenaState
+    {
+      /// Number of bytes in each block of memory an arena obtains from the heap. Allocations
+      /// larger than this are given a block of their own.
+      static constexpr size_t kBlockSize = 4096;
+
+      /// Blocks of memory obtained from the heap, in the order they were obtained.
+      std::vector<uint8_t*> blocks;
+
+      /// Next free byte in the most recently obtained block.
+      uint8_t* nextFree = nullptr;
+
+      /// Number of bytes remaining in the most recently obtained block.
+      size_t bytesRemaining = 0;
+
+      /// Number of bytes used by allocations so far.
+      size_t bytesUsed = 0;
+
+      /// Number of outstanding allocations, plus one for as long as the arena object exists. All
+      /// memory is released once this reaches zero.
+      std::atomic<size_t> referenceCount = 1;
+
+      ~SArenaState(void)
+      {
+        for (uint8_t* block : blocks)
+          ::operator delete(block);
+      }
+
+      /// Allocates memory from this arena. May only be invoked on the thread on which this arena
+      /// is active.
+      /// @param [in] size Number of bytes to allocate, which must be a multiple of the
+      /// fundamental alignment.
+      /// @return Pointer to the allocated memory.
+      void* Allocate(size_t size)
+      {
+        referenceCount.fetch_add(1, std::memory_order_relaxed);
+        bytesUsed += size;
+
+        if (size > kBlockSize)
+        {
+          uint8_t* const dedicatedBlock = static_cast<uint8_t*>(::operator new(size));
+          blocks.push_back(dedicatedBlock);
+          return dedicatedBlock;
+        }
+
+        if (size > bytesRemaining)
+        {
+          nextFree = static_cast<uint8_t*>(::operator new(kBlockSize));
+          bytesRemaining = kBlockSize;
+          blocks.push_back(nextFree);
+        }
+
+        void* const allocatedMemory = nextFree;
+        nextFree += size;
+        bytesRemaining -= size;
+        return allocatedMemory;
+      }
+
+      /// Releases one reference to this arena, destroying it if that was the last reference.
+      void Release(void)
+      {
+        if (1 == referenceCount.fetch_sub(1, std::memory_order_acq_rel)) delete this;
+      }
+    };
+
+    /// Arena that is active on each thread, if any.
+    static thread_local ElementMapperArena::SArenaState* activeArenaState = nullptr;
+
+    /// Retrieves the header that precedes an allocation.
+    /// @param [in] ptr Pointer previously returned from #ElementMapperArena::Allocate.
+    /// @return Pointer to the allocation header.
+    static inline SAllocationHeader* AllocationHeaderFor(const void* ptr)
+    {
+      return const_cast<SAllocationHeader*>(static_cast<const SAllocationHeader*>(ptr)) - 1;
+    }
+
+    ElementMapperArena::ElementMapperArena(void)
+        : arenaState(new SArenaState()), previousArenaState(activeArenaState)
+    {
+      activeArenaState = arenaState;
+    }
+
+    ElementMapperArena::~ElementMapperArena(void)
+    {
+      activeArenaState = previousArenaState;
+      arenaState->Release();
+    }
+
+    void* ElementMapperArena::Allocate(size_t size)
+    {
+      constexpr size_t kAlignment = alignof(std::max_align_t);
+      const size_t totalSize =
+          sizeof(SAllocationHeader) + (((size + kAlignment - 1) / kAlignment) * kAlignment);
+
+      SAllocationHeader* const allocationHeader = static_cast<SAllocationHeader*>(
+          (nullptr == activeArenaState) ? ::operator new(totalSize)
+                                        : activeArenaState->Allocate(totalSize));
+      allocationHeader->arenaState = activeArenaState;
+
+      return allocationHeader + 1;
+    }
+
+    void ElementMapperArena::Deallocate(void* ptr)
+    {
+      if (nullptr == ptr) return;
+
+      SAllocationHeader* const allocationHeader = AllocationHeaderFor(ptr);
+      if (nullptr == allocationHeader->arenaState)
+        ::operator delete(allocationHeader);
+      else
+        allocationHeader->arenaState->Release();
+    }
+
+    bool ElementMapperArena::Contains(const void* ptr) const
+    {
+      return (arenaState == AllocationHeaderFor(ptr)->arenaState);
+    }
+
+    size_t ElementMapperArena::GetUsedBytes(void) const
+    {
+      return arenaState->bytesUsed;
+    }
+  } // namespace Controller
+} // namespace Xidi
@@ -0,0 +1,170 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file ElementMapperPool.cpp
+ *   Implementation of the pool through which structurally identical element mappers are shared
+ *   instead of being duplicated.
+ **************************************************************************************************/
+
+#include "ElementMapperPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ElementMapper.h"
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    /// Holds an interned element mapper along with the information needed to compute statistics.
+    struct SInternedElementMapper
+    {
+      /// Interned element mapper, which is not kept alive by the pool.
+      std::weak_ptr<const IElementMapper> elementMapper;
+
+      /// Interned permanent element mapper, which is preferred if present. Does not own the
+      /// element mapper to which it points.
+      std::shared_ptr<const IElementMapper> permanentElementMapper;
+
+      /// Number of bytes occupied by the interned element mapper, including underlying element
+      /// mappers.
+      size_t footprint;
+    };
+
+    /// Holds all of the state of the element mapper pool. Implemented as a singleton object so
+    /// that it is available to mappers that are created during static initialization.
+    class ElementMapperPoolState
+    {
+    public:
+
+      /// Returns a reference to the singleton instance of this class.
+      /// @return Reference to the singleton instance.
+      static ElementMapperPoolState& GetInstance(void)
+      {
+        static ElementMapperPoolState elementMapperPoolState;
+        return elementMapperPoolState;
+      }
+
+      /// Removes all interned element mappers that are no longer in use. Requires that the mutex
+      /// be held.
+      void PurgeExpiredLocked(void)
+      {
+        std::erase_if(
+            internedElementMappers,
+            [](const auto& internedElementMapper) -> bool
+            {
+              return (nullptr == internedElementMapper.second.permanentElementMapper) &&
+                  (true == internedElementMapper.second.elementMapper.expired());
+            });
+      }
+
+      /// Serializes all access to the interned element mappers.
+      std::mutex mutex;
+
+      /// Interned element mappers, keyed by their structure.
+      std::map<std::vector<uint32_t>, SInternedElementMapper> internedElementMappers;
+    };
+
+    ElementMapperPool::SStatistics ElementMapperPool::GetStatistics(void)
+    {
+      ElementMapperPoolState& poolState = ElementMapperPoolState::GetInstance();
+      std::unique_lock lock(poolState.mutex);
+
+      poolState.PurgeExpiredLocked();
+
+      SStatistics statistics = {
+          .internedCount = 0, .permanentCount = 0, .referenceCount = 0, .bytesSaved = 0};
+      for (const auto& internedElementMapper : poolState.internedElementMappers)
+      {
+        if (nullptr != internedElementMapper.second.permanentElementMapper)
+        {
+          statistics.permanentCount += 1;
+          continue;
+        }
+
+        const long useCount = internedElementMapper.second.elementMapper.use_count();
+        if (useCount <= 0) continue;
+
+        statistics.internedCount += 1;
+        statistics.referenceCount += (size_t)useCount;
+        statistics.bytesSaved += ((size_t)useCount - 1) * internedElementMapper.second.footprint;
+      }
+
+      return statistics;
+    }
+
+    bool ElementMapperPool::IsShareable(const IElementMapper& elementMapper)
+    {
+      IElementMapper::SStructure structure;
+      return elementMapper.DescribeStructure(structure);
+    }
+
+    std::shared_ptr<const IElementMapper> ElementMapperPool::Intern(
+        std::shared_ptr<const IElementMapper> elementMapper)
+    {
+      IElementMapper::SStructure structure;
+      if (false == elementMapper->DescribeStructure(structure)) return elementMapper;
+
+      ElementMapperPoolState& poolState = ElementMapperPoolState::GetInstance();
+      std::unique_lock lock(poolState.mutex);
+
+      auto internedElementMapperIter = poolState.internedElementMappers.find(structure.key);
+      if (poolState.internedElementMappers.end() != internedElementMapperIter)
+      {
+        if (nullptr != internedElementMapperIter->second.permanentElementMapper)
+          return internedElementMapperIter->second.permanentElementMapper;
+
+        std::shared_ptr<const IElementMapper> internedElementMapper =
+            internedElementMapperIter->second.elementMapper.lock();
+        if (nullptr != internedElementMapper) return internedElementMapper;
+      }
+
+      // Interning a new element mapper is rare, since it only happens when a mapper is created
+      // that uses an element mapper unlike any already in use, so this is a good time to get rid
+      // of anything that is no longer needed.
+      poolState.PurgeExpiredLocked();
+      poolState.internedElementMappers.insert_or_assign(
+          std::move(structure.key),
+          SInternedElementMapper{
+              .elementMapper = elementMapper,
+              .permanentElementMapper = nullptr,
+              .footprint = structure.footprint});
+
+      return elementMapper;
+    }
+
+    std::shared_ptr<const IElementMapper> ElementMapperPool::InternPermanent(
+        const IElementMapper& elementMapper)
+    {
+      IElementMapper::SStructure structure;
+      elementMapper.DescribeStructure(structure);
+
+      ElementMapperPoolState& poolState = ElementMapperPoolState::GetInstance();
+      std::unique_lock lock(poolState.mutex);
+
+      SInternedElementMapper& internedElementMapper =
+          poolState.internedElementMappers[std::move(structure.key)];
+      if (nullptr == internedElementMapper.permanentElementMapper)
+      {
+        // An aliased pointer without an owner points to the element mapper without ever
+        // attempting to destroy it, and creating one does not require any memory allocation.
+        internedElementMapper = {
+            .elementMapper = std::weak_ptr<const IElementMapper>(),
+            .permanentElementMapper = std::shared_ptr<const IElementMapper>(
+                std::shared_ptr<const IElementMapper>(), &elementMapper),
+            .footprint = structure.footprint};
+      }
+
+      return internedElementMapper.permanentElementMapper;
+    }
+  } // namespace Controller
+} // namespace Xidi
@@ -30,6 +30,7 @@
 #ifndef XIDI_SKIP_CONFIG
 #include "XidiConfigReader.h"
 #ifndef XIDI_SKIP_MAPPERS
+#include "ElementMapperArena.h"
 #include "Mapper.h"
 #include "MapperBuilder.h"
 #endif
@@ -163,6 +164,9 @@ namespace Xidi
             XidiConfigReader configReader;
 
 #ifndef XIDI_SKIP_MAPPERS
+            // All element mappers that belong to custom mappers are created while reading the
+            // configuration file and building the custom mappers, so they can be stored together.
+            Controller::ElementMapperArena customMapperArena;
             configReader.SetMapperBuilder(&customMapperBuilder);
 #endif
 
@@ -206,6 +210,51 @@ namespace Xidi
 #ifndef XIDI_SKIP_MAPPERS
       Controller::Mapper::DumpRegisteredMappers();
 #endif
+#endif
+    }
+
+    bool ReloadMappers(void)
+    {
+#if !defined(XIDI_SKIP_CONFIG) && !defined(XIDI_SKIP_MAPPERS)
+      static std::mutex reloadMutex;
+      std::unique_lock lock(reloadMutex);
+
+      // Custom mappers built when the configuration file is first read are the ones that can be
+      // replaced, so that needs to happen first.
+      GetConfigurationData();
+
+      Controller::ElementMapperArena replacementMapperArena;
+      Controller::MapperBuilder replacementMapperBuilder;
+      replacementMapperBuilder.EnableReplacement();
+
+      XidiConfigReader configReader;
+      configReader.SetMapperBuilder(&replacementMapperBuilder);
+
+      const Infra::Configuration::ConfigurationData reloadedConfigData =
+          configReader.ReadConfigurationFile();
+
+      if (true == configReader.HasErrorMessages())
+      {
+        Infra::Message::Output(
+            Infra::Message::ESeverity::Error,
+            L"Errors were encountered during configuration file reading. Mappers were not reloaded.");
+        configReader.LogAllErrorMessages();
+        return false;
+      }
+
+      if (false == replacementMapperBuilder.Build())
+      {
+        Infra::Message::Output(
+            Infra::Message::ESeverity::Error,
+            L"Errors were encountered during custom mapper construction. Mappers were not reloaded.");
+        return false;
+      }
+
+      Controller::Mapper::PublishConfigured(
+          reloadedConfigData, replacementMapperBuilder.ReleaseReplacementMappers());
+      return true;
+#else
+      return false;
 #endif
     }
   } // namespace Globals
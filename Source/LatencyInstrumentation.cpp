@@ -0,0 +1,302 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file LatencyInstrumentation.cpp
+ *   Implementation of instrumentation for measuring input latency at each stage of the path from
+ *   physical controller to application.
+ **************************************************************************************************/
+
+#include "LatencyInstrumentation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+#include <Infra/Core/Message.h>
+
+#include "ConcurrencyWrapper.h"
+#include "ControllerTypes.h"
+#include "Globals.h"
+#include "PeriodicJobScheduler.h"
+#include "Strings.h"
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    namespace Latency
+    {
+      /// Human-readable names for each stage, used for log output.
+      static constexpr const wchar_t* kStageNames[] = {
+          L"PhysicalRead",
+          L"Mapping",
+          L"Publication",
+          L"VirtualRefresh",
+          L"ApplicationDelivery",
+          L"Total",
+      };
+
+      static_assert(
+          _countof(kStageNames) == static_cast<size_t>(EStage::Count),
+          "Stage name array is out of sync with stage enumeration.");
+
+      /// Whether or not latency instrumentation is enabled.
+      static std::atomic<bool> isEnabled = false;
+
+      /// Latency histograms, one per physical controller per stage.
+      static Histogram latencyHistograms[kPhysicalControllerCount][static_cast<int>(EStage::Count)];
+
+      /// Timestamps of the most recently published sample for each physical controller.
+      static ConcurrencyWrapper<SSampleTimestamps>
+          publishedSampleTimestamps[kPhysicalControllerCount];
+
+      /// Records a single latency measurement, computed as the difference between two timestamps.
+      /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+      /// @param [in] stage Stage to which the measurement belongs.
+      /// @param [in] stageStart Point in time at which the stage started.
+      /// @param [in] stageEnd Point in time at which the stage ended.
+      static inline void RecordStage(
+          TControllerIdentifier controllerIdentifier,
+          EStage stage,
+          TTimestamp stageStart,
+          TTimestamp stageEnd)
+      {
+        latencyHistograms[controllerIdentifier][static_cast<int>(stage)].Record(
+            stageEnd - stageStart);
+      }
+
+      unsigned int Histogram::BucketIndexForValue(uint64_t value)
+      {
+        value = std::min(value, kMaxValue);
+        if (value < kSubBucketCount) return (unsigned int)value;
+
+        const unsigned int shift = (unsigned int)std::bit_width(value) - 1 - kSubBucketBits;
+        return ((shift + 1) * kSubBucketCount) +
+            (unsigned int)((value >> shift) - kSubBucketCount);
+      }
+
+      uint64_t Histogram::BucketUpperBound(unsigned int bucketIndex)
+      {
+        if (bucketIndex < kSubBucketCount) return bucketIndex;
+
+        const unsigned int shift = (bucketIndex / kSubBucketCount) - 1;
+        const uint64_t subBucket = (uint64_t)(bucketIndex % kSubBucketCount);
+        return ((kSubBucketCount + subBucket + 1) << shift) - 1;
+      }
+
+      SStatistics Histogram::GetStatistics(void) const
+      {
+        std::array<uint32_t, kBucketCount> bucketCounts;
+        uint64_t totalCount = 0;
+
+        for (unsigned int i = 0; i < kBucketCount; ++i)
+        {
+          bucketCounts[i] = buckets[i].load(std::memory_order_relaxed);
+          totalCount += bucketCounts[i];
+        }
+
+        const uint64_t maxValueSeen = maxValue.load(std::memory_order_relaxed);
+        SStatistics statistics = {.count = totalCount, .p50 = 0, .p99 = 0, .max = maxValueSeen};
+        if (0 == totalCount) return statistics;
+
+        // Percentile targets are computed as ranks, rounding up, so that for example the median of
+        // a single measurement is that measurement.
+        const uint64_t p50Rank = ((totalCount * 50) + 99) / 100;
+        const uint64_t p99Rank = ((totalCount * 99) + 99) / 100;
+
+        uint64_t cumulativeCount = 0;
+        bool p50Found = false;
+
+        for (unsigned int i = 0; i < kBucketCount; ++i)
+        {
+          cumulativeCount += bucketCounts[i];
+
+          if ((false == p50Found) && (cumulativeCount >= p50Rank))
+          {
+            statistics.p50 = std::min(BucketUpperBound(i), maxValueSeen);
+            p50Found = true;
+          }
+
+          if (cumulativeCount >= p99Rank)
+          {
+            statistics.p99 = std::min(BucketUpperBound(i), maxValueSeen);
+            break;
+          }
+        }
+
+        return statistics;
+      }
+
+      void Histogram::Record(TClock::duration latency)
+      {
+        const int64_t latencyNanoseconds =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+        const uint64_t value = (uint64_t)std::max<int64_t>(latencyNanoseconds, 0);
+
+        buckets[BucketIndexForValue(value)].fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t previousMaxValue = maxValue.load(std::memory_order_relaxed);
+        while ((value > previousMaxValue) &&
+               (false ==
+                maxValue.compare_exchange_weak(
+                    previousMaxValue, value, std::memory_order_relaxed)))
+          ;
+      }
+
+      void Histogram::Reset(void)
+      {
+        for (auto& bucket : buckets)
+          bucket.store(0, std::memory_order_relaxed);
+
+        maxValue.store(0, std::memory_order_relaxed);
+      }
+
+      void Initialize(PeriodicJobScheduler& scheduler)
+      {
+        const int64_t reportIntervalSeconds =
+            Globals::GetConfigurationData()
+                [Strings::kStrConfigurationSectionLog]
+                [Strings::kStrConfigurationSettingLogLatencyReportIntervalSeconds]
+                    .ValueOr(0);
+
+        if (reportIntervalSeconds <= 0) return;
+
+        SetEnabled(true);
+
+        const std::chrono::milliseconds reportPeriod =
+            std::chrono::seconds(reportIntervalSeconds);
+        scheduler.AddJob(
+            {.period = reportPeriod, .errorBackoffPeriod = reportPeriod},
+            []() -> PeriodicJobScheduler::EJobResult
+            {
+              OutputStatistics();
+              return PeriodicJobScheduler::EJobResult::Success;
+            });
+
+        Infra::Message::OutputFormatted(
+            Infra::Message::ESeverity::Info,
+            L"Enabled input latency instrumentation. Statistics will be output every %u seconds.",
+            (unsigned int)reportIntervalSeconds);
+      }
+
+      bool IsEnabled(void)
+      {
+        return isEnabled.load(std::memory_order_relaxed);
+      }
+
+      void SetEnabled(bool enabled)
+      {
+        isEnabled.store(enabled, std::memory_order_relaxed);
+      }
+
+      SSampleTimestamps GetPublishedSampleTimestamps(TControllerIdentifier controllerIdentifier)
+      {
+        if (controllerIdentifier >= kPhysicalControllerCount) return {};
+        return publishedSampleTimestamps[controllerIdentifier].Get();
+      }
+
+      SStatistics GetStatistics(TControllerIdentifier controllerIdentifier, EStage stage)
+      {
+        if ((controllerIdentifier >= kPhysicalControllerCount) || (stage >= EStage::Count))
+          return {};
+
+        return latencyHistograms[controllerIdentifier][static_cast<int>(stage)].GetStatistics();
+      }
+
+      void OutputStatistics(void)
+      {
+        constexpr double kNanosecondsPerMicrosecond = 1000.0;
+
+        for (TControllerIdentifier controllerIdentifier = 0;
+             controllerIdentifier < kPhysicalControllerCount;
+             ++controllerIdentifier)
+        {
+          for (int stage = 0; stage < static_cast<int>(EStage::Count); ++stage)
+          {
+            const SStatistics statistics =
+                GetStatistics(controllerIdentifier, static_cast<EStage>(stage));
+            if (0 == statistics.count) continue;
+
+            Infra::Message::OutputFormatted(
+                Infra::Message::ESeverity::Info,
+                L"Physical controller %u: Latency of stage %s over %llu measurements: p50 = %.1lf us, p99 = %.1lf us, max = %.1lf us.",
+                (unsigned int)(1 + controllerIdentifier),
+                kStageNames[stage],
+                (unsigned long long)statistics.count,
+                (double)statistics.p50 / kNanosecondsPerMicrosecond,
+                (double)statistics.p99 / kNanosecondsPerMicrosecond,
+                (double)statistics.max / kNanosecondsPerMicrosecond);
+          }
+        }
+      }
+
+      void RecordApplicationDelivery(
+          TControllerIdentifier controllerIdentifier,
+          const SSampleTimestamps& timestamps,
+          TTimestamp delivered)
+      {
+        if ((false == IsEnabled()) || (controllerIdentifier >= kPhysicalControllerCount)) return;
+
+        // Virtual controllers that have not yet refreshed from an instrumented sample have nothing
+        // meaningful to report.
+        if (TTimestamp() == timestamps.refreshed) return;
+
+        RecordStage(
+            controllerIdentifier, EStage::ApplicationDelivery, timestamps.refreshed, delivered);
+        RecordStage(controllerIdentifier, EStage::Total, timestamps.physicalReadEnd, delivered);
+      }
+
+      void RecordPhysicalSampleMapped(
+          TControllerIdentifier controllerIdentifier, const SSampleTimestamps& timestamps)
+      {
+        if ((false == IsEnabled()) || (controllerIdentifier >= kPhysicalControllerCount)) return;
+
+        RecordStage(
+            controllerIdentifier,
+            EStage::PhysicalRead,
+            timestamps.physicalReadStart,
+            timestamps.physicalReadEnd);
+        RecordStage(
+            controllerIdentifier, EStage::Mapping, timestamps.physicalReadEnd, timestamps.mapped);
+      }
+
+      void RecordPhysicalSamplePublicationStart(
+          TControllerIdentifier controllerIdentifier, const SSampleTimestamps& timestamps)
+      {
+        if ((false == IsEnabled()) || (controllerIdentifier >= kPhysicalControllerCount)) return;
+
+        publishedSampleTimestamps[controllerIdentifier].Set(timestamps);
+      }
+
+      void RecordPhysicalSamplePublished(
+          TControllerIdentifier controllerIdentifier,
+          const SSampleTimestamps& timestamps,
+          TTimestamp publicationEnd)
+      {
+        if ((false == IsEnabled()) || (controllerIdentifier >= kPhysicalControllerCount)) return;
+
+        RecordStage(
+            controllerIdentifier, EStage::Publication, timestamps.publicationStart, publicationEnd);
+      }
+
+      void RecordVirtualRefresh(
+          TControllerIdentifier controllerIdentifier, const SSampleTimestamps& timestamps)
+      {
+        if ((false == IsEnabled()) || (controllerIdentifier >= kPhysicalControllerCount)) return;
+        if (TTimestamp() == timestamps.publicationStart) return;
+
+        RecordStage(
+            controllerIdentifier,
+            EStage::VirtualRefresh,
+            timestamps.publicationStart,
+            timestamps.refreshed);
+      }
+    } // namespace Latency
+  } // namespace Controller
+} // namespace Xidi
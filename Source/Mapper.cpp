@@ -12,10 +12,15 @@
 
 #include "Mapper.h"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <limits>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <set>
+#include <span>
 #include <string_view>
 
 #include <Infra/Core/Configuration.h>
@@ -26,16 +31,24 @@
 #include "ControllerMath.h"
 #include "ControllerTypes.h"
 #include "ElementMapper.h"
+#include "ElementMapperPool.h"
 #include "ForceFeedbackTypes.h"
 #include "Globals.h"
+#include "MapperSet.h"
 #include "Strings.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define XIDI_MAPPER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Xidi
 {
   namespace Controller
   {
     /// Holds a mapping from strings to instances of mapper objects.
-    /// Implemented as a singleton object and intended for internal use.
+    /// Implemented as a singleton object and intended for internal use. Concurrency-safe, since
+    /// mappers can be built and registered at runtime.
     class MapperRegistry
     {
     public:
@@ -55,6 +68,8 @@ namespace Xidi
 
         if (Infra::Message::WillOutputMessageOfSeverity(kDumpSeverity))
         {
+          std::unique_lock lock(registryMutex);
+
           Infra::Message::Output(kDumpSeverity, L"Begin dump of all known mappers.");
 
           for (const auto& knownMapper : knownMappers)
@@ -87,10 +102,21 @@ namespace Xidi
           }
 
           Infra::Message::Output(kDumpSeverity, L"End dump of all known mappers.");
+
+          const ElementMapperPool::SStatistics elementMapperPoolStatistics =
+              ElementMapperPool::GetStatistics();
+          Infra::Message::OutputFormatted(
+              kDumpSeverity,
+              L"Mappers share %zu distinct element mappers across %zu uses, saving %zu bytes, in addition to %zu permanent element mappers.",
+              elementMapperPoolStatistics.internedCount,
+              elementMapperPoolStatistics.referenceCount,
+              elementMapperPoolStatistics.bytesSaved,
+              elementMapperPoolStatistics.permanentCount);
         }
       }
 
-      /// Registers a mapper object with this registry.
+      /// Registers a mapper object with this registry, replacing any mapper object previously
+      /// registered with the same name.
       /// @param [in] name Name to associate with the mapper.
       /// @param [in] object Corresponding mapper object.
       void RegisterMapper(std::wstring_view name, const Mapper* object)
@@ -103,13 +129,15 @@ namespace Xidi
           return;
         }
 
-        knownMappers[name] = object;
+        std::unique_lock lock(registryMutex);
 
-        if (true == defaultMapper.empty()) defaultMapper = name;
+        knownMappers[name] = object;
       }
 
       /// Unregisters a mapper object from this registry, if the registration details provided match
-      /// the contents of the registry.
+      /// the contents of the registry. Mismatches are expected and silently skipped, since mappers
+      /// can be replaced by other mappers of the same name, and mappers built as replacements are
+      /// never registered unless they are published.
       /// @param [in] name Name associated with the mapper.
       /// @param [in] object Corresponding mapper object.
       void UnregisterMapper(std::wstring_view name, const Mapper* object)
@@ -122,27 +150,12 @@ namespace Xidi
           return;
         }
 
-        if (false == knownMappers.contains(name))
-        {
-          Infra::Message::OutputFormatted(
-              Infra::Message::ESeverity::Error,
-              L"Internal error: Attempting to unregister unknown mapper %s.",
-              name.data());
-          return;
-        }
+        std::unique_lock lock(registryMutex);
 
-        if (object != knownMappers.at(name))
-        {
-          Infra::Message::OutputFormatted(
-              Infra::Message::ESeverity::Error,
-              L"Internal error: Object mismatch while attempting to unregister mapper %s.",
-              name.data());
-          return;
-        }
-
-        knownMappers.erase(name);
+        const auto mapperRecord = knownMappers.find(name);
+        if ((knownMappers.cend() == mapperRecord) || (object != mapperRecord->second)) return;
 
-        if (defaultMapper == name) defaultMapper = std::wstring_view();
+        knownMappers.erase(mapperRecord);
       }
 
       /// Retrieves a pointer to the mapper object that corresponds to the specified name, if it
@@ -152,7 +165,7 @@ namespace Xidi
       /// the registry.
       const Mapper* GetMapper(std::wstring_view mapperName)
       {
-        if (true == mapperName.empty()) mapperName = defaultMapper;
+        std::unique_lock lock(registryMutex);
 
         const auto mapperRecord = knownMappers.find(mapperName);
         if (knownMappers.cend() != mapperRecord) return mapperRecord->second;
@@ -167,9 +180,8 @@ namespace Xidi
       /// Implements the registry of known mappers.
       std::map<std::wstring_view, const Mapper*> knownMappers;
 
-      /// Holds the map key that corresponds to the default mapper.
-      /// The first type of mapper that is registered becomes the default.
-      std::wstring_view defaultMapper;
+      /// Protects the registry against concurrent access.
+      std::mutex registryMutex;
     };
 
     /// Derives the capabilities of the controller that is described by the specified element
@@ -265,6 +277,116 @@ namespace Xidi
       return capabilities;
     }
 
+    /// Determines the type of value produced by the XInput controller element that corresponds to
+    /// the specified position within an element map.
+    /// @param [in] elementMapIndex Positional index of the element mapper within the overall
+    /// element map.
+    /// @return Type of value produced by the corresponding XInput controller element.
+    static ElementMapperProgram::EValueType ElementMapValueType(unsigned int elementMapIndex)
+    {
+      switch (elementMapIndex)
+      {
+        case ELEMENT_MAP_INDEX_OF(stickLeftX):
+        case ELEMENT_MAP_INDEX_OF(stickLeftY):
+        case ELEMENT_MAP_INDEX_OF(stickRightX):
+        case ELEMENT_MAP_INDEX_OF(stickRightY):
+          return ElementMapperProgram::EValueType::Analog;
+
+        case ELEMENT_MAP_INDEX_OF(triggerLT):
+        case ELEMENT_MAP_INDEX_OF(triggerRT):
+          return ElementMapperProgram::EValueType::Trigger;
+
+        default:
+          return ElementMapperProgram::EValueType::Button;
+      }
+    }
+
+    /// Copies an element mapper for use in a copy of an element map. Element mappers that can be
+    /// shared are shared, and any others are cloned.
+    /// @param [in] elementMapper Element mapper to copy, which may be `nullptr`.
+    /// @return Element mapper to use in the copy.
+    static std::shared_ptr<const IElementMapper> CopyElementMapper(
+        const std::shared_ptr<const IElementMapper>& elementMapper)
+    {
+      if ((nullptr == elementMapper) || (true == ElementMapperPool::IsShareable(*elementMapper)))
+        return elementMapper;
+
+      return elementMapper->Clone();
+    }
+
+    /// Replaces each of the specified element mappers with a structurally identical element mapper
+    /// that is already in use, if one exists, so that identical element mappers are stored once
+    /// and shared across all mappers that use them.
+    /// @param [in] elements Per-element controller map, which is consumed.
+    /// @return Per-element controller map that refers to interned element mappers.
+    static Mapper::UElementMap InternElementMap(Mapper::SElementMap&& elements)
+    {
+      Mapper::UElementMap internedElements(std::move(elements));
+
+      for (auto& elementMapper : internedElements.all)
+        if (nullptr != elementMapper) elementMapper = ElementMapperPool::Intern(elementMapper);
+
+      return internedElements;
+    }
+
+    /// Compiles the contributions of all of the specified element mappers into a single program.
+    /// Contributions are made in element map order, which is the same order in which the XInput
+    /// controller elements are read.
+    /// @param [in] elements Per-element controller map.
+    /// @return Compiled program.
+    static ElementMapperProgram CompileElementMapContributions(const Mapper::UElementMap& elements)
+    {
+      ElementMapperProgram program;
+
+      for (unsigned int elementMapIdx = 0; elementMapIdx < _countof(elements.all); ++elementMapIdx)
+      {
+        ElementMapperProgram::Compiler compiler(
+            program, (uint8_t)elementMapIdx, ElementMapValueType(elementMapIdx));
+        compiler.CompileContribution(elements.all[elementMapIdx].get());
+      }
+
+      return program;
+    }
+
+    /// Compiles the neutral contributions of all of the specified element mappers into a single
+    /// program.
+    /// @param [in] elements Per-element controller map.
+    /// @return Compiled program.
+    static ElementMapperProgram CompileElementMapNeutralContributions(
+        const Mapper::UElementMap& elements)
+    {
+      ElementMapperProgram program;
+
+      for (unsigned int elementMapIdx = 0; elementMapIdx < _countof(elements.all); ++elementMapIdx)
+      {
+        ElementMapperProgram::Compiler compiler(
+            program, (uint8_t)elementMapIdx, ElementMapValueType(elementMapIdx));
+        compiler.CompileNeutral(elements.all[elementMapIdx].get());
+      }
+
+      return program;
+    }
+
+    /// Locates each controller element's instructions within a compiled contribution program and
+    /// determines whether or not their contributions can be undone.
+    /// @param [in] program Program compiled from an element map, one controller element at a time.
+    /// @return Location of each controller element's instructions, in element map order.
+    static std::array<Mapper::SElementProgramSegment, Mapper::kElementMapSize>
+        SegmentElementMapContributions(const ElementMapperProgram& program)
+    {
+      std::array<Mapper::SElementProgramSegment, Mapper::kElementMapSize> segments;
+
+      for (unsigned int elementMapIdx = 0; elementMapIdx < segments.size(); ++elementMapIdx)
+      {
+        const ElementMapperProgram::SInstructionRange instructions =
+            program.FindSourceInstructions((uint8_t)elementMapIdx);
+        segments[elementMapIdx] = {
+            .instructions = instructions, .isReversible = program.IsReversible(instructions)};
+      }
+
+      return segments;
+    }
+
     /// Filters (by saturation) analog stick values that might be slightly out of range due to
     /// differences between the implemented range and the physical controller's actual range.
     /// @param [in] analogValue Raw analog value.
@@ -289,6 +411,369 @@ namespace Xidi
       return -FilterAnalogStickValue(analogValue);
     }
 
+    /// Computes the values of all controller elements that are supplied to element mappers,
+    /// applying all of the transformations configured for the physical controller.
+    /// @param [in] physicalState Physical controller state from which to read.
+    /// @param [in] transforms Transformations to apply to raw analog values.
+    /// @param [in,out] sourceValues Filled with the value of each controller element.
+    /// @param [in] previousPhysicalState Physical controller state from which the existing
+    /// contents of the source values were computed, or `nullptr` if there is none. Analog sticks
+    /// and triggers whose readings are unchanged from this state are not transformed again.
+    static void ComputeSourceValues(
+        const SPhysicalState& physicalState,
+        const Mapper::SPhysicalControllerTransforms& transforms,
+        Mapper::TSourceValues& sourceValues,
+        const SPhysicalState* previousPhysicalState = nullptr)
+    {
+      // If requested by the user, left and right stick values need to be transformed so that a
+      // circular field of physical motion is transformed into a square field of virtual motion.
+      // Both axes of a stick participate in this transformation, so a stick is only skipped if
+      // neither axis changed. Afterwards, left and right stick values need to be saturated at the
+      // virtual controller range due to a very slight difference between XInput range and virtual
+      // controller range. This difference (-32768 extreme negative for XInput vs -32767 extreme
+      // negative for Xidi) does not affect functionality when filtered by saturation. Vertical
+      // analog axes additionally need to be inverted because XInput presents up as positive and
+      // down as negative whereas Xidi needs to do the opposite.
+      if ((nullptr == previousPhysicalState) ||
+          (physicalState[EPhysicalStick::LeftX] !=
+           (*previousPhysicalState)[EPhysicalStick::LeftX]) ||
+          (physicalState[EPhysicalStick::LeftY] !=
+           (*previousPhysicalState)[EPhysicalStick::LeftY]))
+      {
+        const Math::SAnalogStickCoordinates stickLeftCoordinates =
+            transforms.circleToSquareStickLeft.Apply(
+                {.x = physicalState[EPhysicalStick::LeftX],
+                 .y = physicalState[EPhysicalStick::LeftY]});
+        sourceValues[ELEMENT_MAP_INDEX_OF(stickLeftX)] =
+            transforms.rawStickLeft.Apply(FilterAnalogStickValue(stickLeftCoordinates.x));
+        sourceValues[ELEMENT_MAP_INDEX_OF(stickLeftY)] =
+            transforms.rawStickLeft.Apply(FilterAndInvertAnalogStickValue(stickLeftCoordinates.y));
+      }
+
+      if ((nullptr == previousPhysicalState) ||
+          (physicalState[EPhysicalStick::RightX] !=
+           (*previousPhysicalState)[EPhysicalStick::RightX]) ||
+          (physicalState[EPhysicalStick::RightY] !=
+           (*previousPhysicalState)[EPhysicalStick::RightY]))
+      {
+        const Math::SAnalogStickCoordinates stickRightCoordinates =
+            transforms.circleToSquareStickRight.Apply(
+                {.x = physicalState[EPhysicalStick::RightX],
+                 .y = physicalState[EPhysicalStick::RightY]});
+        sourceValues[ELEMENT_MAP_INDEX_OF(stickRightX)] =
+            transforms.rawStickRight.Apply(FilterAnalogStickValue(stickRightCoordinates.x));
+        sourceValues[ELEMENT_MAP_INDEX_OF(stickRightY)] = transforms.rawStickRight.Apply(
+            FilterAndInvertAnalogStickValue(stickRightCoordinates.y));
+      }
+
+      sourceValues[ELEMENT_MAP_INDEX_OF(dpadUp)] = physicalState[EPhysicalButton::DpadUp];
+      sourceValues[ELEMENT_MAP_INDEX_OF(dpadDown)] = physicalState[EPhysicalButton::DpadDown];
+      sourceValues[ELEMENT_MAP_INDEX_OF(dpadLeft)] = physicalState[EPhysicalButton::DpadLeft];
+      sourceValues[ELEMENT_MAP_INDEX_OF(dpadRight)] = physicalState[EPhysicalButton::DpadRight];
+
+      if ((nullptr == previousPhysicalState) ||
+          (physicalState[EPhysicalTrigger::LT] != (*previousPhysicalState)[EPhysicalTrigger::LT]))
+        sourceValues[ELEMENT_MAP_INDEX_OF(triggerLT)] =
+            transforms.rawTriggerLT.Apply(physicalState[EPhysicalTrigger::LT]);
+      if ((nullptr == previousPhysicalState) ||
+          (physicalState[EPhysicalTrigger::RT] != (*previousPhysicalState)[EPhysicalTrigger::RT]))
+        sourceValues[ELEMENT_MAP_INDEX_OF(triggerRT)] =
+            transforms.rawTriggerRT.Apply(physicalState[EPhysicalTrigger::RT]);
+
+      sourceValues[ELEMENT_MAP_INDEX_OF(buttonA)] = physicalState[EPhysicalButton::A];
+      sourceValues[ELEMENT_MAP_INDEX_OF(buttonB)] = physicalState[EPhysicalButton::B];
+      sourceValues[ELEMENT_MAP_INDEX_OF(buttonX)] = physicalState[EPhysicalButton::X];
+      sourceValues[ELEMENT_MAP_INDEX_OF(buttonY)] = physicalState[EPhysicalButton::Y];
+
+      sourceValues[ELEMENT_MAP_INDEX_OF(buttonLB)] = physicalState[EPhysicalButton::LB];
+      sourceValues[ELEMENT_MAP_INDEX_OF(buttonRB)] = physicalState[EPhysicalButton::RB];
+
+      sourceValues[ELEMENT_MAP_INDEX_OF(buttonBack)] = physicalState[EPhysicalButton::Back];
+      sourceValues[ELEMENT_MAP_INDEX_OF(buttonStart)] = physicalState[EPhysicalButton::Start];
+
+      sourceValues[ELEMENT_MAP_INDEX_OF(buttonLS)] = physicalState[EPhysicalButton::LS];
+      sourceValues[ELEMENT_MAP_INDEX_OF(buttonRS)] = physicalState[EPhysicalButton::RS];
+    }
+
+    /// Saturates all axis values in the specified virtual controller state at the extreme ends of
+    /// the allowed range. Doing this only after all contributions have been committed means that
+    /// intermediate contributions are computed with much more range than the controller is allowed
+    /// to report, which can increase accuracy when there are multiple interfering mappers
+    /// contributing to axes.
+    /// @param [in,out] controllerState Controller state data structure to be updated.
+    static inline void SaturateAxisValues(SState& controllerState)
+    {
+      for (auto& axisValue : controllerState.axis)
+      {
+        if (axisValue > kAnalogValueMax)
+          axisValue = kAnalogValueMax;
+        else if (axisValue < kAnalogValueMin)
+          axisValue = kAnalogValueMin;
+      }
+    }
+
+    /// Adds or removes the contributions that a single controller element makes for a particular
+    /// value to or from the running totals held in an incremental mapping state object. All of the
+    /// contributions must be reversible.
+    /// @param [in] program Compiled program that holds the controller element's instructions.
+    /// @param [in] instructions Range of instructions that belong to the controller element.
+    /// @param [in] sourceValues Values of all controller elements.
+    /// @param [in] shouldRemove Whether the contributions should be removed rather than added.
+    /// @param [in,out] incrementalState Incremental mapping state object to be updated.
+    static void AccumulateReversibleContributions(
+        const ElementMapperProgram& program,
+        ElementMapperProgram::SInstructionRange instructions,
+        const Mapper::TSourceValues& sourceValues,
+        bool shouldRemove,
+        Mapper::SIncrementalMappingState& incrementalState)
+    {
+      // Reversible contributions never depend on the source identifier, nor on anything already in
+      // the virtual controller state, so they can be evaluated in isolation.
+      SState elementState = {};
+      program.Execute(elementState, sourceValues, 0, instructions);
+
+      const int32_t axisMultiplier = ((true == shouldRemove) ? -1 : 1);
+      for (size_t i = 0; i < elementState.axis.size(); ++i)
+        incrementalState.axisContributions[i] += (axisMultiplier * elementState.axis[i]);
+
+      const uint8_t countDelta = ((true == shouldRemove) ? (uint8_t)-1 : (uint8_t)1);
+      for (size_t i = 0; i < elementState.button.size(); ++i)
+      {
+        if (true == elementState.button[i]) incrementalState.buttonContributions[i] += countDelta;
+      }
+      for (size_t i = 0; i < elementState.povDirection.components.size(); ++i)
+      {
+        if (true == elementState.povDirection.components[i])
+          incrementalState.povDirectionContributions[i] += countDelta;
+      }
+    }
+
+    /// Values of all controller elements for a block of physical controller states, laid out as one
+    /// column per controller element with one entry per physical controller state.
+    using TSourceValueColumns = std::array<
+        std::array<int32_t, ElementMapperProgram::SColumnAccumulators::kColumnSize>,
+        Mapper::kElementMapSize>;
+
+    /// Filters, and optionally inverts, a column of analog stick values. Equivalent to invoking
+    /// either #FilterAnalogStickValue or #FilterAndInvertAnalogStickValue on each value.
+    /// @param [in,out] column Analog stick values to be filtered in place.
+    /// @param [in] shouldInvert Whether or not the values should also be inverted.
+    static void FilterAnalogStickColumn(std::span<int16_t> column, bool shouldInvert)
+    {
+      size_t i = 0;
+
+#ifdef XIDI_MAPPER_USE_SSE2
+      const __m128i kValueMin = _mm_set1_epi16((int16_t)kAnalogValueMin);
+      const __m128i kValueMax = _mm_set1_epi16((int16_t)kAnalogValueMax);
+
+      for (; (i + 8) <= column.size(); i += 8)
+      {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&column[i]));
+        values = _mm_min_epi16(_mm_max_epi16(values, kValueMin), kValueMax);
+        if (true == shouldInvert) values = _mm_sub_epi16(_mm_setzero_si128(), values);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&column[i]), values);
+      }
+#endif
+
+      for (; i < column.size(); ++i)
+        column[i] =
+            ((true == shouldInvert) ? FilterAndInvertAnalogStickValue(column[i])
+                                    : FilterAnalogStickValue(column[i]));
+    }
+
+    /// Extracts the state of a single physical controller button from a column of button bitmasks.
+    /// @param [in] buttonMasks Physical controller button bitmasks, one per physical controller
+    /// state.
+    /// @param [in] button Physical controller button of interest.
+    /// @param [out] column Filled with 1 for each physical controller state in which the button is
+    /// pressed and 0 otherwise. Must be the same size as the column of button bitmasks.
+    static void ExtractPhysicalButtonColumn(
+        std::span<const uint16_t> buttonMasks, EPhysicalButton button, std::span<int32_t> column)
+    {
+      const unsigned int buttonBitIndex = static_cast<unsigned int>(button);
+      size_t i = 0;
+
+#ifdef XIDI_MAPPER_USE_SSE2
+      const __m128i kBitIndex = _mm_cvtsi32_si128((int)buttonBitIndex);
+      const __m128i kOne = _mm_set1_epi16(1);
+
+      for (; (i + 8) <= buttonMasks.size(); i += 8)
+      {
+        const __m128i values = _mm_and_si128(
+            _mm_srl_epi16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&buttonMasks[i])), kBitIndex),
+            kOne);
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(&column[i]),
+            _mm_unpacklo_epi16(values, _mm_setzero_si128()));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(&column[i + 4]),
+            _mm_unpackhi_epi16(values, _mm_setzero_si128()));
+      }
+#endif
+
+      for (; i < buttonMasks.size(); ++i)
+        column[i] = (int32_t)((buttonMasks[i] >> buttonBitIndex) & 1);
+    }
+
+    /// Saturates a column of axis values at the extreme ends of the allowed range. Equivalent to
+    /// what #SaturateAxisValues does for a single virtual controller state.
+    /// @param [in,out] column Axis values to be saturated in place.
+    static void SaturateAxisColumn(std::span<int32_t> column)
+    {
+      size_t i = 0;
+
+#ifdef XIDI_MAPPER_USE_SSE2
+      static_assert(
+          (kAnalogValueMin >= std::numeric_limits<int16_t>::min()) &&
+              (kAnalogValueMax <= std::numeric_limits<int16_t>::max()),
+          "Axis value range must fit into 16 bits.");
+
+      const __m128i kValueMin = _mm_set1_epi16((int16_t)kAnalogValueMin);
+      const __m128i kValueMax = _mm_set1_epi16((int16_t)kAnalogValueMax);
+
+      // Packing to 16 bits saturates at the 16-bit range, which contains the entire allowed range,
+      // so the rest of the saturation can be done using 16-bit comparisons. Unpacking each value
+      // into both halves of a 32-bit value and shifting back down sign-extends it.
+      for (; (i + 8) <= column.size(); i += 8)
+      {
+        __m128i values = _mm_packs_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(&column[i])),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(&column[i + 4])));
+        values = _mm_min_epi16(_mm_max_epi16(values, kValueMin), kValueMax);
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(&column[i]),
+            _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(&column[i + 4]),
+            _mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16));
+      }
+#endif
+
+      for (; i < column.size(); ++i)
+        column[i] = std::clamp(column[i], kAnalogValueMin, kAnalogValueMax);
+    }
+
+    /// Computes the values of all controller elements for a block of physical controller states at
+    /// once, applying the same transformations as #ComputeSourceValues.
+    /// @param [in] physicalStates Physical controller states from which to read. Only up to one
+    /// column's worth of physical controller states is used.
+    /// @param [in] transforms Transformations to apply to raw analog values.
+    /// @param [out] sourceValueColumns Filled with the value of each controller element for each
+    /// physical controller state.
+    static void ComputeSourceValueColumns(
+        std::span<const SPhysicalState> physicalStates,
+        const Mapper::SPhysicalControllerTransforms& transforms,
+        TSourceValueColumns& sourceValueColumns)
+    {
+      constexpr size_t kColumnSize = ElementMapperProgram::SColumnAccumulators::kColumnSize;
+
+      const size_t columnSize = std::min(physicalStates.size(), kColumnSize);
+
+      std::array<std::array<int16_t, kColumnSize>, static_cast<int>(EPhysicalStick::Count)>
+          stickColumns;
+      std::array<uint16_t, kColumnSize> buttonMasks;
+
+      // Circle-to-square transformation needs both axes of a stick together, so it is applied one
+      // physical controller state at a time while the columns are being filled. Everything else is
+      // applied one column at a time.
+      for (size_t i = 0; i < columnSize; ++i)
+      {
+        const SPhysicalState& physicalState = physicalStates[i];
+
+        const Math::SAnalogStickCoordinates stickLeftCoordinates =
+            transforms.circleToSquareStickLeft.Apply(
+                {.x = physicalState[EPhysicalStick::LeftX],
+                 .y = physicalState[EPhysicalStick::LeftY]});
+        const Math::SAnalogStickCoordinates stickRightCoordinates =
+            transforms.circleToSquareStickRight.Apply(
+                {.x = physicalState[EPhysicalStick::RightX],
+                 .y = physicalState[EPhysicalStick::RightY]});
+
+        stickColumns[static_cast<int>(EPhysicalStick::LeftX)][i] = stickLeftCoordinates.x;
+        stickColumns[static_cast<int>(EPhysicalStick::LeftY)][i] = stickLeftCoordinates.y;
+        stickColumns[static_cast<int>(EPhysicalStick::RightX)][i] = stickRightCoordinates.x;
+        stickColumns[static_cast<int>(EPhysicalStick::RightY)][i] = stickRightCoordinates.y;
+        buttonMasks[i] = static_cast<uint16_t>(physicalState.button.to_ulong());
+      }
+
+      auto stickColumn = [&stickColumns, columnSize](EPhysicalStick stick) -> std::span<int16_t>
+      { return std::span<int16_t>(stickColumns[static_cast<int>(stick)].data(), columnSize); };
+      auto sourceValueColumn = [&sourceValueColumns,
+                                columnSize](unsigned int elementMapIdx) -> std::span<int32_t>
+      { return std::span<int32_t>(sourceValueColumns[elementMapIdx].data(), columnSize); };
+
+      FilterAnalogStickColumn(stickColumn(EPhysicalStick::LeftX), false);
+      FilterAnalogStickColumn(stickColumn(EPhysicalStick::LeftY), true);
+      FilterAnalogStickColumn(stickColumn(EPhysicalStick::RightX), false);
+      FilterAnalogStickColumn(stickColumn(EPhysicalStick::RightY), true);
+
+      // Deadzone and saturation tables are indexed by value, so they cannot be applied to more
+      // than one value at a time.
+      for (size_t i = 0; i < columnSize; ++i)
+      {
+        sourceValueColumns[ELEMENT_MAP_INDEX_OF(stickLeftX)][i] = transforms.rawStickLeft.Apply(
+            stickColumns[static_cast<int>(EPhysicalStick::LeftX)][i]);
+        sourceValueColumns[ELEMENT_MAP_INDEX_OF(stickLeftY)][i] = transforms.rawStickLeft.Apply(
+            stickColumns[static_cast<int>(EPhysicalStick::LeftY)][i]);
+        sourceValueColumns[ELEMENT_MAP_INDEX_OF(stickRightX)][i] = transforms.rawStickRight.Apply(
+            stickColumns[static_cast<int>(EPhysicalStick::RightX)][i]);
+        sourceValueColumns[ELEMENT_MAP_INDEX_OF(stickRightY)][i] = transforms.rawStickRight.Apply(
+            stickColumns[static_cast<int>(EPhysicalStick::RightY)][i]);
+        sourceValueColumns[ELEMENT_MAP_INDEX_OF(triggerLT)][i] =
+            transforms.rawTriggerLT.Apply(physicalStates[i][EPhysicalTrigger::LT]);
+        sourceValueColumns[ELEMENT_MAP_INDEX_OF(triggerRT)][i] =
+            transforms.rawTriggerRT.Apply(physicalStates[i][EPhysicalTrigger::RT]);
+      }
+
+      const std::span<const uint16_t> buttonMaskColumn(buttonMasks.data(), columnSize);
+
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn,
+          EPhysicalButton::DpadUp,
+          sourceValueColumn(ELEMENT_MAP_INDEX_OF(dpadUp)));
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn,
+          EPhysicalButton::DpadDown,
+          sourceValueColumn(ELEMENT_MAP_INDEX_OF(dpadDown)));
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn,
+          EPhysicalButton::DpadLeft,
+          sourceValueColumn(ELEMENT_MAP_INDEX_OF(dpadLeft)));
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn,
+          EPhysicalButton::DpadRight,
+          sourceValueColumn(ELEMENT_MAP_INDEX_OF(dpadRight)));
+
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn, EPhysicalButton::A, sourceValueColumn(ELEMENT_MAP_INDEX_OF(buttonA)));
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn, EPhysicalButton::B, sourceValueColumn(ELEMENT_MAP_INDEX_OF(buttonB)));
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn, EPhysicalButton::X, sourceValueColumn(ELEMENT_MAP_INDEX_OF(buttonX)));
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn, EPhysicalButton::Y, sourceValueColumn(ELEMENT_MAP_INDEX_OF(buttonY)));
+
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn, EPhysicalButton::LB, sourceValueColumn(ELEMENT_MAP_INDEX_OF(buttonLB)));
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn, EPhysicalButton::RB, sourceValueColumn(ELEMENT_MAP_INDEX_OF(buttonRB)));
+
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn,
+          EPhysicalButton::Back,
+          sourceValueColumn(ELEMENT_MAP_INDEX_OF(buttonBack)));
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn,
+          EPhysicalButton::Start,
+          sourceValueColumn(ELEMENT_MAP_INDEX_OF(buttonStart)));
+
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn, EPhysicalButton::LS, sourceValueColumn(ELEMENT_MAP_INDEX_OF(buttonLS)));
+      ExtractPhysicalButtonColumn(
+          buttonMaskColumn, EPhysicalButton::RS, sourceValueColumn(ELEMENT_MAP_INDEX_OF(buttonRS)));
+    }
+
     /// Computes the physical force feedback actuator value for the specified actuator given a
     /// vector of magnitude components.
     /// @param [in] virtualEffectComponents Virtual force feedback vector expressed as a magnitude
@@ -380,27 +865,47 @@ namespace Xidi
     Mapper::UElementMap::UElementMap(const UElementMap& other) : named()
     {
       for (int i = 0; i < _countof(all); ++i)
-      {
-        if (nullptr != other.all[i]) all[i] = other.all[i]->Clone();
-      }
+        all[i] = CopyElementMapper(other.all[i]);
     }
 
     Mapper::Mapper(
         const std::wstring_view name,
         SElementMap&& elements,
         SForceFeedbackActuatorMap forceFeedbackActuators)
-        : elements(std::move(elements)),
+        : Mapper(name, std::move(elements), forceFeedbackActuators, true)
+    {}
+
+    Mapper::Mapper(
+        const std::wstring_view name,
+        SElementMap&& elements,
+        SForceFeedbackActuatorMap forceFeedbackActuators,
+        bool registerName)
+        : elements(InternElementMap(std::move(elements))),
+          contributionProgram(CompileElementMapContributions(this->elements)),
+          contributionProgramSegments(SegmentElementMapContributions(contributionProgram)),
+          neutralProgram(CompileElementMapNeutralContributions(this->elements)),
           forceFeedbackActuators(forceFeedbackActuators),
           capabilities(DeriveCapabilitiesFromElementMap(this->elements, forceFeedbackActuators)),
           name(name)
     {
-      if (false == name.empty()) MapperRegistry::GetInstance().RegisterMapper(name, this);
+      if ((true == registerName) && (false == name.empty()))
+        MapperRegistry::GetInstance().RegisterMapper(name, this);
     }
 
     Mapper::Mapper(SElementMap&& elements, SForceFeedbackActuatorMap forceFeedbackActuators)
         : Mapper(L"", std::move(elements), forceFeedbackActuators)
     {}
 
+    Mapper::Mapper(const Mapper& other)
+        : elements(other.elements),
+          contributionProgram(CompileElementMapContributions(this->elements)),
+          contributionProgramSegments(SegmentElementMapContributions(contributionProgram)),
+          neutralProgram(CompileElementMapNeutralContributions(this->elements)),
+          forceFeedbackActuators(other.forceFeedbackActuators),
+          capabilities(other.capabilities),
+          name(other.name)
+    {}
+
     Mapper::~Mapper(void)
     {
       if (false == name.empty()) MapperRegistry::GetInstance().UnregisterMapper(name, this);
@@ -409,12 +914,7 @@ namespace Xidi
     Mapper::UElementMap& Mapper::UElementMap::operator=(const UElementMap& other)
     {
       for (int i = 0; i < _countof(all); ++i)
-      {
-        if (nullptr == other.all[i])
-          all[i] = nullptr;
-        else
-          all[i] = other.all[i]->Clone();
-      }
+        all[i] = CopyElementMapper(other.all[i]);
 
       return *this;
     }
@@ -429,112 +929,169 @@ namespace Xidi
 
     void Mapper::DumpRegisteredMappers(void)
     {
+      GetBuiltIn();
       MapperRegistry::GetInstance().DumpRegisteredMappers();
     }
 
     const Mapper* Mapper::GetByName(std::wstring_view mapperName)
     {
+      // Built-in mappers register themselves when they are first created, which happens on first
+      // use rather than during static initialization.
+      const std::span<const Mapper> builtInMappers = GetBuiltIn();
+      if (true == mapperName.empty()) return &builtInMappers.front();
+
       return MapperRegistry::GetInstance().GetMapper(mapperName);
     }
 
-    const Mapper* Mapper::GetConfigured(TControllerIdentifier controllerIdentifier)
+    /// Determines which mapper the configuration data specifies for each physical controller.
+    /// @param [in] configData Configuration data from which to read the mapper assignments.
+    /// @param [in] replacementMappers Mappers built to replace registered mappers of the same name,
+    /// which take precedence over them.
+    /// @return Configured mapper for each physical controller.
+    static MapperSet::TMapperArray ResolveConfiguredMappers(
+        const Infra::Configuration::ConfigurationData& configData,
+        const MapperSet::TOwnedMappers& replacementMappers)
     {
-      static const Mapper* configuredMapper[kPhysicalControllerCount];
-      static std::once_flag configuredMapperFlag;
+      const auto findMapper = [&replacementMappers](std::wstring_view mapperName) -> const Mapper*
+      {
+        for (const auto& replacementMapper : replacementMappers)
+          if (replacementMapper->GetName() == mapperName) return replacementMapper.get();
 
-      std::call_once(
-          configuredMapperFlag,
-          []() -> void
+        return Mapper::GetByName(mapperName);
+      };
+
+      MapperSet::TMapperArray configuredMapper = {};
+
+      if (true == configData.Contains(Strings::kStrConfigurationSectionMapper))
+      {
+        // Mapper section exists in the configuration file.
+        // If the controller-independent type setting exists, it will be used as the fallback
+        // default, otherwise the default mapper will be used for this purpose. If any
+        // per-controller type settings exist, they take precedence.
+        const auto& mapperConfigData = configData[Strings::kStrConfigurationSectionMapper];
+
+        const Mapper* fallbackMapper = nullptr;
+        if (true == mapperConfigData.Contains(Strings::kStrConfigurationSettingMapperType))
+        {
+          std::wstring_view fallbackMapperName =
+              mapperConfigData[Strings::kStrConfigurationSettingMapperType]->GetString();
+          fallbackMapper = findMapper(fallbackMapperName);
+
+          if (nullptr == fallbackMapper)
+            Infra::Message::OutputFormatted(
+                Infra::Message::ESeverity::Warning,
+                L"Could not locate mapper \"%s\" specified in the configuration file as the default.",
+                fallbackMapperName.data());
+        }
+
+        if (nullptr == fallbackMapper)
+        {
+          fallbackMapper = Mapper::GetDefault();
+
+          if (nullptr == fallbackMapper)
           {
-            const auto& configData = Globals::GetConfigurationData();
+            Infra::Message::Output(
+                Infra::Message::ESeverity::Error,
+                L"Internal error: Unable to locate the default mapper.");
+            fallbackMapper = Mapper::GetNull();
+          }
+        }
 
-            if (true == configData.Contains(Strings::kStrConfigurationSectionMapper))
-            {
-              // Mapper section exists in the configuration file.
-              // If the controller-independent type setting exists, it will be used as the fallback
-              // default, otherwise the default mapper will be used for this purpose. If any
-              // per-controller type settings exist, they take precedence.
-              const auto& mapperConfigData = configData[Strings::kStrConfigurationSectionMapper];
-
-              const Mapper* fallbackMapper = nullptr;
-              if (true == mapperConfigData.Contains(Strings::kStrConfigurationSettingMapperType))
-              {
-                std::wstring_view fallbackMapperName =
-                    mapperConfigData[Strings::kStrConfigurationSettingMapperType]->GetString();
-                fallbackMapper = GetByName(fallbackMapperName);
-
-                if (nullptr == fallbackMapper)
-                  Infra::Message::OutputFormatted(
-                      Infra::Message::ESeverity::Warning,
-                      L"Could not locate mapper \"%s\" specified in the configuration file as the default.",
-                      fallbackMapperName.data());
-              }
-
-              if (nullptr == fallbackMapper)
-              {
-                fallbackMapper = GetDefault();
-
-                if (nullptr == fallbackMapper)
-                {
-                  Infra::Message::Output(
-                      Infra::Message::ESeverity::Error,
-                      L"Internal error: Unable to locate the default mapper.");
-                  fallbackMapper = GetNull();
-                }
-              }
+        for (TControllerIdentifier i = 0; i < kPhysicalControllerCount; ++i)
+        {
+          if (true == mapperConfigData.Contains(Strings::MapperTypeConfigurationNameString(i)))
+          {
+            std::wstring_view configuredMapperName =
+                mapperConfigData[Strings::MapperTypeConfigurationNameString(i)]->GetString();
+            configuredMapper[i] = findMapper(configuredMapperName);
 
-              for (TControllerIdentifier i = 0; i < _countof(configuredMapper); ++i)
-              {
-                if (true ==
-                    mapperConfigData.Contains(Strings::MapperTypeConfigurationNameString(i)))
-                {
-                  std::wstring_view configuredMapperName =
-                      mapperConfigData[Strings::MapperTypeConfigurationNameString(i)]->GetString();
-                  configuredMapper[i] = GetByName(configuredMapperName.data());
-
-                  if (nullptr == configuredMapper[i])
-                  {
-                    Infra::Message::OutputFormatted(
-                        Infra::Message::ESeverity::Warning,
-                        L"Could not locate mapper \"%s\" specified in the configuration file for controller %u.",
-                        configuredMapperName.data(),
-                        (unsigned int)(1 + i));
-                    configuredMapper[i] = fallbackMapper;
-                  }
-                }
-                else
-                {
-                  configuredMapper[i] = fallbackMapper;
-                }
-              }
-            }
-            else
+            if (nullptr == configuredMapper[i])
             {
-              // Mapper section does not exist in the configuration file.
-              const Mapper* defaultMapper = GetDefault();
-              if (nullptr == defaultMapper)
-              {
-                Infra::Message::Output(
-                    Infra::Message::ESeverity::Error,
-                    L"Internal error: Unable to locate the default mapper. Virtual controllers will not function.");
-                defaultMapper = GetNull();
-              }
-
-              for (TControllerIdentifier i = 0; i < _countof(configuredMapper); ++i)
-                configuredMapper[i] = defaultMapper;
+              Infra::Message::OutputFormatted(
+                  Infra::Message::ESeverity::Warning,
+                  L"Could not locate mapper \"%s\" specified in the configuration file for controller %u.",
+                  configuredMapperName.data(),
+                  (unsigned int)(1 + i));
+              configuredMapper[i] = fallbackMapper;
             }
+          }
+          else
+          {
+            configuredMapper[i] = fallbackMapper;
+          }
+        }
+      }
+      else
+      {
+        // Mapper section does not exist in the configuration file.
+        const Mapper* defaultMapper = Mapper::GetDefault();
+        if (nullptr == defaultMapper)
+        {
+          Infra::Message::Output(
+              Infra::Message::ESeverity::Error,
+              L"Internal error: Unable to locate the default mapper. Virtual controllers will not function.");
+          defaultMapper = Mapper::GetNull();
+        }
 
-            Infra::Message::Output(
-                Infra::Message::ESeverity::Info, L"Mappers assigned to controllers...");
-            for (TControllerIdentifier i = 0; i < _countof(configuredMapper); ++i)
-              Infra::Message::OutputFormatted(
-                  Infra::Message::ESeverity::Info,
-                  L"    [%u]: %s",
-                  (unsigned int)(1 + i),
-                  configuredMapper[i]->GetName().data());
+        for (TControllerIdentifier i = 0; i < kPhysicalControllerCount; ++i)
+          configuredMapper[i] = defaultMapper;
+      }
+
+      return configuredMapper;
+    }
+
+    /// Determines which mapper is configured for each physical controller, registers any
+    /// replacement mappers by name, and publishes the result.
+    /// @param [in] configData Configuration data from which to read the mapper assignments.
+    /// @param [in] replacementMappers Mappers built to replace registered mappers of the same name.
+    /// @return Generation number of the published mapper set.
+    static uint64_t ResolveAndPublishConfiguredMappers(
+        const Infra::Configuration::ConfigurationData& configData,
+        MapperSet::TOwnedMappers&& replacementMappers)
+    {
+      const MapperSet::TMapperArray configuredMapper =
+          ResolveConfiguredMappers(configData, replacementMappers);
+
+      for (const auto& replacementMapper : replacementMappers)
+        MapperRegistry::GetInstance().RegisterMapper(
+            replacementMapper->GetName(), replacementMapper.get());
+
+      const uint64_t generation = MapperSet::Publish(
+          std::make_unique<MapperSet>(configuredMapper, std::move(replacementMappers)));
+
+      Infra::Message::OutputFormatted(
+          Infra::Message::ESeverity::Info,
+          L"Mappers assigned to controllers (generation %llu)...",
+          (unsigned long long)generation);
+      for (TControllerIdentifier i = 0; i < kPhysicalControllerCount; ++i)
+        Infra::Message::OutputFormatted(
+            Infra::Message::ESeverity::Info,
+            L"    [%u]: %s",
+            (unsigned int)(1 + i),
+            configuredMapper[i]->GetName().data());
+
+      return generation;
+    }
+
+    /// Publishes the mappers that are configured when the configuration file is first read, if
+    /// this has not already happened.
+    static void PublishInitialConfiguredMappers(void)
+    {
+      static std::once_flag initialPublicationFlag;
+      std::call_once(
+          initialPublicationFlag,
+          []() -> void
+          {
+            ResolveAndPublishConfiguredMappers(
+                Globals::GetConfigurationData(), MapperSet::TOwnedMappers());
           });
+    }
 
-      if (controllerIdentifier >= _countof(configuredMapper))
+    const Mapper* Mapper::GetConfigured(TControllerIdentifier controllerIdentifier)
+    {
+      PublishInitialConfiguredMappers();
+
+      if (controllerIdentifier >= kPhysicalControllerCount)
       {
         Infra::Message::OutputFormatted(
             Infra::Message::ESeverity::Error,
@@ -543,7 +1100,97 @@ namespace Xidi
         return GetNull();
       }
 
-      return configuredMapper[controllerIdentifier];
+      return MapperSetReader()->GetMapper(controllerIdentifier);
+    }
+
+    MapperSetReader Mapper::ReadConfigured(void)
+    {
+      PublishInitialConfiguredMappers();
+      return MapperSetReader();
+    }
+
+    uint64_t Mapper::PublishConfigured(
+        const Infra::Configuration::ConfigurationData& configData,
+        MapperSet::TOwnedMappers&& replacementMappers)
+    {
+      PublishInitialConfiguredMappers();
+      return ResolveAndPublishConfiguredMappers(configData, std::move(replacementMappers));
+    }
+
+    const Mapper::SPhysicalControllerTransforms& Mapper::GetConfiguredPhysicalControllerTransforms(
+        void)
+    {
+      // These properties are read from the configuration file and can be used to apply extra
+      // transformations to raw analog values read from physical controllers. By default, deadzone
+      // percentage is set to 0 and saturation percentage is set to 100 to avoid any reduction in
+      // full analog range of motion, since most often applications will themselves apply a deadzone
+      // and saturation via virtual controller properties. However not all applications do this, and
+      // some interfaces like WinMM do not even support application-supplied properties.
+      // Furthermore, some games require an extra correction to map from a circular field of
+      // physical motion to a square field of virtual motion. Deadzone and saturation
+      // transformations are fixed once the configuration file is read, so they are precomputed for
+      // every possible raw value and applied by table lookup.
+      static const SPhysicalControllerTransforms kPhysicalControllerTransforms = {
+          .circleToSquareStickLeft = Math::CircleToSquareTransform(
+              static_cast<double>(
+                  Globals::GetConfigurationData()
+                      [Strings::kStrConfigurationSectionProperties]
+                      [Strings::kStrConfigurationSettingsPropertiesCircleToSquarePercentStickLeft]
+                          .ValueOr(0)) /
+              100.0),
+          .circleToSquareStickRight = Math::CircleToSquareTransform(
+              static_cast<double>(
+                  Globals::GetConfigurationData()
+                      [Strings::kStrConfigurationSectionProperties]
+                      [Strings::kStrConfigurationSettingsPropertiesCircleToSquarePercentStickRight]
+                          .ValueOr(0)) /
+              100.0),
+          .rawStickLeft = Math::RawAnalogTransformTable(
+              static_cast<unsigned int>(
+                  Globals::GetConfigurationData()
+                      [Strings::kStrConfigurationSectionProperties]
+                      [Strings::kStrConfigurationSettingsPropertiesDeadzonePercentStickLeft]
+                          .ValueOr(0)),
+              static_cast<unsigned int>(
+                  Globals::GetConfigurationData()
+                      [Strings::kStrConfigurationSectionProperties]
+                      [Strings::kStrConfigurationSettingsPropertiesSaturationPercentStickLeft]
+                          .ValueOr(100))),
+          .rawStickRight = Math::RawAnalogTransformTable(
+              static_cast<unsigned int>(
+                  Globals::GetConfigurationData()
+                      [Strings::kStrConfigurationSectionProperties]
+                      [Strings::kStrConfigurationSettingsPropertiesDeadzonePercentStickRight]
+                          .ValueOr(0)),
+              static_cast<unsigned int>(
+                  Globals::GetConfigurationData()
+                      [Strings::kStrConfigurationSectionProperties]
+                      [Strings::kStrConfigurationSettingsPropertiesSaturationPercentStickRight]
+                          .ValueOr(100))),
+          .rawTriggerLT = Math::RawTriggerTransformTable(
+              static_cast<unsigned int>(
+                  Globals::GetConfigurationData()
+                      [Strings::kStrConfigurationSectionProperties]
+                      [Strings::kStrConfigurationSettingsPropertiesDeadzonePercentTriggerLT]
+                          .ValueOr(0)),
+              static_cast<unsigned int>(
+                  Globals::GetConfigurationData()
+                      [Strings::kStrConfigurationSectionProperties]
+                      [Strings::kStrConfigurationSettingsPropertiesSaturationPercentTriggerLT]
+                          .ValueOr(100))),
+          .rawTriggerRT = Math::RawTriggerTransformTable(
+              static_cast<unsigned int>(
+                  Globals::GetConfigurationData()
+                      [Strings::kStrConfigurationSectionProperties]
+                      [Strings::kStrConfigurationSettingsPropertiesDeadzonePercentTriggerRT]
+                          .ValueOr(0)),
+              static_cast<unsigned int>(
+                  Globals::GetConfigurationData()
+                      [Strings::kStrConfigurationSectionProperties]
+                      [Strings::kStrConfigurationSettingsPropertiesSaturationPercentTriggerRT]
+                          .ValueOr(100)))};
+
+      return kPhysicalControllerTransforms;
     }
 
     const Mapper* Mapper::GetNull(void)
@@ -570,263 +1217,190 @@ namespace Xidi
     SState Mapper::MapStatePhysicalToVirtual(
         SPhysicalState physicalState, uint32_t sourceControllerIdentifier) const
     {
-      // These properties are read from the configuration file and can be used to apply extra
-      // transformations to raw analog values read from physical controllers. By default, deadzone
-      // percentage is set to 0 and saturation percentage is set to 100 to avoid any reduction in
-      // full analog range of motion, since most often applications will themselves apply a deadzone
-      // and saturation via virtual controller properties. However not all applications do this, and
-      // some interfaces like WinMM do not even support application-supplied properties.
-      // Furthermore, some games require an extra correction to map from a circular field of
-      // physical motion to a square field of virtual motion.
-      static const double kCircleToSquareFractionStickLeft =
-          static_cast<double>(
-              Globals::GetConfigurationData()
-                  [Strings::kStrConfigurationSectionProperties]
-                  [Strings::kStrConfigurationSettingsPropertiesCircleToSquarePercentStickLeft]
-                      .ValueOr(0)) /
-          100.0;
-      static const double kCircleToSquareFractionStickRight =
-          static_cast<double>(
-              Globals::GetConfigurationData()
-                  [Strings::kStrConfigurationSectionProperties]
-                  [Strings::kStrConfigurationSettingsPropertiesCircleToSquarePercentStickRight]
-                      .ValueOr(0)) /
-          100.0;
-      static const unsigned int kDeadzonePercentStickLeft = static_cast<unsigned int>(
-          Globals::GetConfigurationData()
-              [Strings::kStrConfigurationSectionProperties]
-              [Strings::kStrConfigurationSettingsPropertiesDeadzonePercentStickLeft]
-                  .ValueOr(0));
-      static const unsigned int kDeadzonePercentStickRight = static_cast<unsigned int>(
-          Globals::GetConfigurationData()
-              [Strings::kStrConfigurationSectionProperties]
-              [Strings::kStrConfigurationSettingsPropertiesDeadzonePercentStickRight]
-                  .ValueOr(0));
-      static const unsigned int kDeadzonePercentTriggerLT = static_cast<unsigned int>(
-          Globals::GetConfigurationData()
-              [Strings::kStrConfigurationSectionProperties]
-              [Strings::kStrConfigurationSettingsPropertiesDeadzonePercentTriggerLT]
-                  .ValueOr(0));
-      static const unsigned int kDeadzonePercentTriggerRT = static_cast<unsigned int>(
-          Globals::GetConfigurationData()
-              [Strings::kStrConfigurationSectionProperties]
-              [Strings::kStrConfigurationSettingsPropertiesDeadzonePercentTriggerRT]
-                  .ValueOr(0));
-      static const unsigned int kSaturationPercentStickLeft = static_cast<unsigned int>(
-          Globals::GetConfigurationData()
-              [Strings::kStrConfigurationSectionProperties]
-              [Strings::kStrConfigurationSettingsPropertiesSaturationPercentStickLeft]
-                  .ValueOr(100));
-      static const unsigned int kSaturationPercentStickRight = static_cast<unsigned int>(
-          Globals::GetConfigurationData()
-              [Strings::kStrConfigurationSectionProperties]
-              [Strings::kStrConfigurationSettingsPropertiesSaturationPercentStickRight]
-                  .ValueOr(100));
-      static const unsigned int kSaturationPercentTriggerLT = static_cast<unsigned int>(
-          Globals::GetConfigurationData()
-              [Strings::kStrConfigurationSectionProperties]
-              [Strings::kStrConfigurationSettingsPropertiesSaturationPercentTriggerLT]
-                  .ValueOr(100));
-      static const unsigned int kSaturationPercentTriggerRT = static_cast<unsigned int>(
-          Globals::GetConfigurationData()
-              [Strings::kStrConfigurationSectionProperties]
-              [Strings::kStrConfigurationSettingsPropertiesSaturationPercentTriggerRT]
-                  .ValueOr(100));
-
-      // If requested by the user, left and right stick values need to be transformed so that a
-      // circular field of physical motion is transformed into a square field of virtual motion.
-      const Math::SAnalogStickCoordinates stickLeftCoordinates =
-          Math::TransformCoordinatesCircleToSquare(
-              {.x = physicalState[EPhysicalStick::LeftX],
-               .y = physicalState[EPhysicalStick::LeftY]},
-              kCircleToSquareFractionStickLeft);
-      const Math::SAnalogStickCoordinates stickRightCoordinates =
-          Math::TransformCoordinatesCircleToSquare(
-              {.x = physicalState[EPhysicalStick::RightX],
-               .y = physicalState[EPhysicalStick::RightY]},
-              kCircleToSquareFractionStickRight);
+      TSourceValues sourceValues;
+      ComputeSourceValues(physicalState, GetConfiguredPhysicalControllerTransforms(), sourceValues);
 
       SState controllerState = {};
+      contributionProgram.Execute(
+          controllerState,
+          sourceValues,
+          SourceIdentifierForElementMapper(sourceControllerIdentifier, 0));
 
-      // Left and right stick values need to be saturated at the virtual controller range due to a
-      // very slight difference between XInput range and virtual controller range. This difference
-      // (-32768 extreme negative for XInput vs -32767 extreme negative for Xidi) does not affect
-      // functionality when filtered by saturation. Vertical analog axes additionally need to be
-      // inverted because XInput presents up as positive and down as negative whereas Xidi needs to
-      // do the opposite.
+      SaturateAxisValues(controllerState);
+      return controllerState;
+    }
 
-      if (nullptr != elements.named.stickLeftX)
-        elements.named.stickLeftX->ContributeFromAnalogValue(
-            controllerState,
-            Math::ApplyRawAnalogTransform(
-                FilterAnalogStickValue(stickLeftCoordinates.x),
-                kDeadzonePercentStickLeft,
-                kSaturationPercentStickLeft),
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(stickLeftX)));
-      if (nullptr != elements.named.stickLeftY)
-        elements.named.stickLeftY->ContributeFromAnalogValue(
-            controllerState,
-            Math::ApplyRawAnalogTransform(
-                FilterAndInvertAnalogStickValue(stickLeftCoordinates.y),
-                kDeadzonePercentStickLeft,
-                kSaturationPercentStickLeft),
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(stickLeftY)));
-
-      if (nullptr != elements.named.stickRightX)
-        elements.named.stickRightX->ContributeFromAnalogValue(
-            controllerState,
-            Math::ApplyRawAnalogTransform(
-                FilterAnalogStickValue(stickRightCoordinates.x),
-                kDeadzonePercentStickRight,
-                kSaturationPercentStickRight),
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(stickRightX)));
-      if (nullptr != elements.named.stickRightY)
-        elements.named.stickRightY->ContributeFromAnalogValue(
-            controllerState,
-            Math::ApplyRawAnalogTransform(
-                FilterAndInvertAnalogStickValue(stickRightCoordinates.y),
-                kDeadzonePercentStickRight,
-                kSaturationPercentStickRight),
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(stickRightY)));
-
-      if (nullptr != elements.named.dpadUp)
-        elements.named.dpadUp->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::DpadUp],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(dpadUp)));
-      if (nullptr != elements.named.dpadDown)
-        elements.named.dpadDown->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::DpadDown],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(dpadDown)));
-      if (nullptr != elements.named.dpadLeft)
-        elements.named.dpadLeft->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::DpadLeft],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(dpadLeft)));
-      if (nullptr != elements.named.dpadRight)
-        elements.named.dpadRight->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::DpadRight],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(dpadRight)));
+    SState Mapper::MapStatePhysicalToVirtual(
+        SPhysicalState physicalState,
+        uint32_t sourceControllerIdentifier,
+        SIncrementalMappingState& incrementalState,
+        const SPhysicalControllerTransforms& transforms) const
+    {
+      // Running totals are only meaningful for the mapper and transformations that produced them.
+      // Anything else means starting over from a neutral virtual controller with no contributions
+      // at all.
+      const bool isFromScratch =
+          ((this != incrementalState.mapper) || (&transforms != incrementalState.transforms));
+      if (true == isFromScratch)
+      {
+        incrementalState = {};
+        incrementalState.mapper = this;
+        incrementalState.transforms = &transforms;
+      }
 
-      if (nullptr != elements.named.triggerLT)
-        elements.named.triggerLT->ContributeFromTriggerValue(
-            controllerState,
-            Math::ApplyRawTriggerTransform(
-                physicalState[EPhysicalTrigger::LT],
-                kDeadzonePercentTriggerLT,
-                kSaturationPercentTriggerLT),
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(triggerLT)));
-      if (nullptr != elements.named.triggerRT)
-        elements.named.triggerRT->ContributeFromTriggerValue(
-            controllerState,
-            Math::ApplyRawTriggerTransform(
-                physicalState[EPhysicalTrigger::RT],
-                kDeadzonePercentTriggerRT,
-                kSaturationPercentTriggerRT),
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(triggerRT)));
-
-      if (nullptr != elements.named.buttonA)
-        elements.named.buttonA->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::A],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(buttonA)));
-      if (nullptr != elements.named.buttonB)
-        elements.named.buttonB->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::B],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(buttonB)));
-      if (nullptr != elements.named.buttonX)
-        elements.named.buttonX->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::X],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(buttonX)));
-      if (nullptr != elements.named.buttonY)
-        elements.named.buttonY->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::Y],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(buttonY)));
+      TSourceValues sourceValues = incrementalState.sourceValues;
+      ComputeSourceValues(
+          physicalState,
+          transforms,
+          sourceValues,
+          ((true == isFromScratch) ? nullptr : &incrementalState.physicalState));
 
-      if (nullptr != elements.named.buttonLB)
-        elements.named.buttonLB->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::LB],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(buttonLB)));
-      if (nullptr != elements.named.buttonRB)
-        elements.named.buttonRB->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::RB],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(buttonRB)));
+      // Each controller element whose value changed has its old contributions replaced with new
+      // ones. Everything else is left alone.
+      for (unsigned int elementMapIdx = 0; elementMapIdx < kElementMapSize; ++elementMapIdx)
+      {
+        const SElementProgramSegment& segment = contributionProgramSegments[elementMapIdx];
+        if ((false == segment.isReversible) || (true == segment.instructions.IsEmpty())) continue;
 
-      if (nullptr != elements.named.buttonBack)
-        elements.named.buttonBack->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::Back],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(buttonBack)));
-      if (nullptr != elements.named.buttonStart)
-        elements.named.buttonStart->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::Start],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(buttonStart)));
+        if (false == isFromScratch)
+        {
+          if (sourceValues[elementMapIdx] == incrementalState.sourceValues[elementMapIdx]) continue;
+
+          AccumulateReversibleContributions(
+              contributionProgram,
+              segment.instructions,
+              incrementalState.sourceValues,
+              true,
+              incrementalState);
+        }
 
-      if (nullptr != elements.named.buttonLS)
-        elements.named.buttonLS->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::LS],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(buttonLS)));
-      if (nullptr != elements.named.buttonRS)
-        elements.named.buttonRS->ContributeFromButtonValue(
-            controllerState,
-            physicalState[EPhysicalButton::RS],
-            SourceIdentifierForElementMapper(
-                sourceControllerIdentifier, ELEMENT_MAP_INDEX_OF(buttonRS)));
-
-      // Once all contributions have been committed, saturate all axis values at the extreme ends of
-      // the allowed range. Doing this at the end means that intermediate contributions are computed
-      // with much more range than the controller is allowed to report, which can increase accuracy
-      // when there are multiple interfering mappers contributing to axes.
-      for (auto& axisValue : controllerState.axis)
+        AccumulateReversibleContributions(
+            contributionProgram, segment.instructions, sourceValues, false, incrementalState);
+      }
+
+      incrementalState.physicalState = physicalState;
+      incrementalState.sourceValues = sourceValues;
+
+      SState controllerState = {.axis = incrementalState.axisContributions};
+      for (size_t i = 0; i < incrementalState.buttonContributions.size(); ++i)
+        controllerState.button[i] = (0 != incrementalState.buttonContributions[i]);
+      for (size_t i = 0; i < incrementalState.povDirectionContributions.size(); ++i)
+        controllerState.povDirection.components[i] =
+            (0 != incrementalState.povDirectionContributions[i]);
+
+      // Contributions that cannot be undone are made every time, in the same order as they would
+      // be made by a non-incremental mapping.
+      for (const auto& segment : contributionProgramSegments)
       {
-        if (axisValue > kAnalogValueMax)
-          axisValue = kAnalogValueMax;
-        else if (axisValue < kAnalogValueMin)
-          axisValue = kAnalogValueMin;
+        if ((true == segment.isReversible) || (true == segment.instructions.IsEmpty())) continue;
+
+        contributionProgram.Execute(
+            controllerState,
+            sourceValues,
+            SourceIdentifierForElementMapper(sourceControllerIdentifier, 0),
+            segment.instructions);
       }
 
+      SaturateAxisValues(controllerState);
       return controllerState;
     }
 
-    SState Mapper::MapNeutralPhysicalToVirtual(uint32_t sourceControllerIdentifier) const
+    void Mapper::MapStatesPhysicalToVirtual(
+        std::span<const SPhysicalState> physicalStates,
+        std::span<SState> controllerStates,
+        uint32_t sourceControllerIdentifier) const
     {
-      SState controllerState = {};
+      constexpr size_t kBlockSize = ElementMapperProgram::SColumnAccumulators::kColumnSize;
+
+      const SPhysicalControllerTransforms& transforms = GetConfiguredPhysicalControllerTransforms();
+      const size_t stateCount = std::min(physicalStates.size(), controllerStates.size());
+      const bool hasIrreversibleContributions = std::any_of(
+          contributionProgramSegments.cbegin(),
+          contributionProgramSegments.cend(),
+          [](const SElementProgramSegment& segment) -> bool
+          {
+            return ((false == segment.isReversible) && (false == segment.instructions.IsEmpty()));
+          });
 
-      for (uint32_t elementMapIdx = 0; elementMapIdx < _countof(elements.all); ++elementMapIdx)
+      TSourceValueColumns sourceValueColumns;
+      ElementMapperProgram::SColumnAccumulators accumulators;
+
+      for (size_t blockBegin = 0; blockBegin < stateCount; blockBegin += kBlockSize)
       {
-        if (nullptr != elements.all[elementMapIdx])
-          elements.all[elementMapIdx]->ContributeNeutral(
-              controllerState,
-              SourceIdentifierForElementMapper(sourceControllerIdentifier, elementMapIdx));
+        const size_t blockSize = std::min(kBlockSize, stateCount - blockBegin);
+
+        ComputeSourceValueColumns(
+            physicalStates.subspan(blockBegin, blockSize), transforms, sourceValueColumns);
+
+        // Reversible contributions neither depend on nor interfere with one another, so they are
+        // made one controller element at a time across the whole block.
+        accumulators = {};
+        for (unsigned int elementMapIdx = 0; elementMapIdx < kElementMapSize; ++elementMapIdx)
+        {
+          const SElementProgramSegment& segment = contributionProgramSegments[elementMapIdx];
+          if ((false == segment.isReversible) || (true == segment.instructions.IsEmpty())) continue;
+
+          contributionProgram.ExecuteColumns(
+              accumulators,
+              std::span<const int32_t>(sourceValueColumns[elementMapIdx].data(), blockSize),
+              segment.instructions);
+        }
+
+        if (false == hasIrreversibleContributions)
+        {
+          for (auto& axisColumn : accumulators.axis)
+            SaturateAxisColumn(std::span<int32_t>(axisColumn.data(), blockSize));
+        }
+
+        for (size_t i = 0; i < blockSize; ++i)
+        {
+          SState& controllerState = controllerStates[blockBegin + i];
+
+          controllerState = {};
+          for (size_t axisIdx = 0; axisIdx < controllerState.axis.size(); ++axisIdx)
+            controllerState.axis[axisIdx] = accumulators.axis[axisIdx][i];
+          controllerState.button = decltype(controllerState.button)(accumulators.button[i]);
+          for (size_t povIdx = 0; povIdx < controllerState.povDirection.components.size(); ++povIdx)
+            controllerState.povDirection.components[povIdx] =
+                (0 != (accumulators.povDirection[i] & (1u << povIdx)));
+
+          // Contributions that cannot be undone have side effects, so they are made one physical
+          // controller state at a time and in order, after all of the others, and saturation must
+          // wait until they are done.
+          if (true == hasIrreversibleContributions)
+          {
+            TSourceValues sourceValues;
+            for (unsigned int elementMapIdx = 0; elementMapIdx < kElementMapSize; ++elementMapIdx)
+              sourceValues[elementMapIdx] = sourceValueColumns[elementMapIdx][i];
+
+            for (const auto& segment : contributionProgramSegments)
+            {
+              if ((true == segment.isReversible) || (true == segment.instructions.IsEmpty()))
+                continue;
+
+              contributionProgram.Execute(
+                  controllerState,
+                  sourceValues,
+                  SourceIdentifierForElementMapper(sourceControllerIdentifier, 0),
+                  segment.instructions);
+            }
+
+            SaturateAxisValues(controllerState);
+          }
+        }
       }
+    }
+
+    SState Mapper::MapNeutralPhysicalToVirtual(uint32_t sourceControllerIdentifier) const
+    {
+      // Neutral contributions do not depend on the values of any XInput controller elements.
+      constexpr TSourceValues kSourceValues = {};
+
+      SState controllerState = {};
+      neutralProgram.Execute(
+          controllerState,
+          kSourceValues,
+          SourceIdentifierForElementMapper(sourceControllerIdentifier, 0));
 
       return controllerState;
     }
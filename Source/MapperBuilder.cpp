@@ -14,6 +14,8 @@
 #include <deque>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 
 #include <Infra/Core/Message.h>
 
@@ -38,6 +40,23 @@ namespace Xidi
       return mapperNames->emplace_back(mapperName);
     }
 
+    /// Holds the names of all custom mappers successfully built by any mapper builder object, all
+    /// of which are safe string views. Custom mappers can be replaced by building them again,
+    /// unlike the built-in mappers.
+    static std::set<std::wstring_view> customMapperNames;
+
+    /// Protects the set of custom mapper names against concurrent access.
+    static std::mutex customMapperNamesMutex;
+
+    /// Determines if the specified name is the name of a custom mapper built previously.
+    /// @param [in] mapperName Name of the mapper to check.
+    /// @return `true` if so, `false` otherwise.
+    static bool IsCustomMapperName(std::wstring_view mapperName)
+    {
+      std::unique_lock lock(customMapperNamesMutex);
+      return customMapperNames.contains(mapperName);
+    }
+
     bool MapperBuilder::Build(void)
     {
       for (const auto& blueprintItem : blueprints)
@@ -63,7 +82,7 @@ namespace Xidi
         return nullptr;
       }
 
-      if (true == Mapper::IsMapperNameKnown(mapperName))
+      if (false == IsMapperNameAvailable(mapperName))
       {
         Infra::Message::OutputFormatted(
             Infra::Message::ESeverity::Error,
@@ -103,16 +122,29 @@ namespace Xidi
       if (false == blueprint.templateName.empty())
       {
         // If a template is specified, then the mapper element starting point comes from an existing
-        // mapper object. If the mapper object named in the template does not exist, try to build
-        // it. It is an error if that dependent build operation fails.
-        if (false == Mapper::IsMapperNameKnown(blueprint.templateName))
+        // mapper object. If the template is described by a blueprint that this object holds, then
+        // the mapper object built from that blueprint is used, which matters when building
+        // replacements because any registered mapper of the same name is the one being replaced.
+        // If the mapper object named in the template does not exist, try to build it. It is an
+        // error if that dependent build operation fails.
+        const Mapper* templateMapper = nullptr;
+        const bool templateIsBlueprint = DoesBlueprintNameExist(blueprint.templateName);
+
+        if ((true == templateIsBlueprint) &&
+            (nullptr != blueprints.at(blueprint.templateName).builtMapper))
+        {
+          templateMapper = blueprints.at(blueprint.templateName).builtMapper;
+        }
+        else if (
+            (false == Mapper::IsMapperNameKnown(blueprint.templateName)) ||
+            ((true == buildsReplacements) && (true == templateIsBlueprint)))
         {
           // The purpose of this check is to make error messages easier to understand by making it
           // immediately obvious why a template build operation failed. Without it, the user would
           // see an attempt to build the template take place, fail, and then this mapper would fail
           // to build due to a template dependency build failure, so either 2 or 3 messages total
           // when 1 would suffice and be more concise.
-          if (false == DoesBlueprintNameExist(blueprint.templateName))
+          if (false == templateIsBlueprint)
           {
             Infra::Message::OutputFormatted(
                 Infra::Message::ESeverity::Error,
@@ -128,7 +160,8 @@ namespace Xidi
               mapperName.data(),
               blueprint.templateName.data());
 
-          if (nullptr == Build(blueprint.templateName))
+          templateMapper = Build(blueprint.templateName);
+          if (nullptr == templateMapper)
           {
             Infra::Message::OutputFormatted(
                 Infra::Message::ESeverity::Error,
@@ -137,34 +170,25 @@ namespace Xidi
                 blueprint.templateName.data());
             return nullptr;
           }
-
-          if (false == Mapper::IsMapperNameKnown(blueprint.templateName))
+        }
+        else
+        {
+          // Since the template name is known, the registered mapper object should be obtainable.
+          // It is an internal error if this fails.
+          templateMapper = Mapper::GetByName(blueprint.templateName);
+          if (nullptr == templateMapper)
           {
             Infra::Message::OutputFormatted(
                 Infra::Message::ESeverity::Error,
-                L"Error while building mapper %s: Internal error: Successfully built template dependency %s but failed to register the resulting mapper object.",
+                L"Error while building mapper %s: Internal error: Failed to locate the mapper object for template dependency %s.",
                 mapperName.data(),
                 blueprint.templateName.data());
             return nullptr;
           }
         }
 
-        // Since the template name is known, the registered mapper object should be obtainable.
-        // It is an internal error if this fails.
-        const Mapper* const kTemplateMapper = Mapper::GetByName(blueprint.templateName);
-        if (nullptr == kTemplateMapper)
-        {
-          Infra::Message::OutputFormatted(
-              Infra::Message::ESeverity::Error,
-              L"Error while building mapper %s: Internal error: Failed to locate the mapper object for template dependency %s.",
-              mapperName.data(),
-              blueprint.templateName.data());
-          return nullptr;
-        }
-
-        mapperElements = Mapper::GetByName(blueprint.templateName)->CloneElementMap();
-        mapperForceFeedbackActuators =
-            Mapper::GetByName(blueprint.templateName)->GetForceFeedbackActuatorMap();
+        mapperElements = templateMapper->CloneElementMap();
+        mapperForceFeedbackActuators = templateMapper->GetForceFeedbackActuatorMap();
       }
 
       // Loop through all the changes that the blueprint describes and apply them to the starting
@@ -190,8 +214,30 @@ namespace Xidi
 
       Infra::Message::OutputFormatted(
           Infra::Message::ESeverity::Info, L"Successfully built mapper %s.", mapperName.data());
-      return new Mapper(
-          mapperName, std::move(mapperElements.named), mapperForceFeedbackActuators.named);
+
+      {
+        std::unique_lock lock(customMapperNamesMutex);
+        customMapperNames.insert(mapperName);
+      }
+
+      if (true == buildsReplacements)
+      {
+        blueprint.builtMapper =
+            builtReplacementMappers
+                .emplace_back(std::make_unique<Mapper>(
+                    mapperName,
+                    std::move(mapperElements.named),
+                    mapperForceFeedbackActuators.named,
+                    false))
+                .get();
+      }
+      else
+      {
+        blueprint.builtMapper = new Mapper(
+            mapperName, std::move(mapperElements.named), mapperForceFeedbackActuators.named);
+      }
+
+      return blueprint.builtMapper;
     }
 
     bool MapperBuilder::ClearBlueprintElementMapper(
@@ -247,7 +293,7 @@ namespace Xidi
 
     bool MapperBuilder::CreateBlueprint(std::wstring_view mapperName)
     {
-      if (true == Mapper::IsMapperNameKnown(mapperName)) return false;
+      if (false == IsMapperNameAvailable(mapperName)) return false;
 
       return blueprints.emplace(std::make_pair(SafeMapperNameString(mapperName), SBlueprint()))
           .second;
@@ -294,6 +340,12 @@ namespace Xidi
       return true;
     }
 
+    bool MapperBuilder::IsMapperNameAvailable(std::wstring_view mapperName) const
+    {
+      if (false == Mapper::IsMapperNameKnown(mapperName)) return true;
+      return ((true == buildsReplacements) && (true == IsCustomMapperName(mapperName)));
+    }
+
     bool MapperBuilder::SetBlueprintElementMapper(
         std::wstring_view mapperName,
         unsigned int elementIndex,
@@ -9,129 +9,189 @@
  *   Definitions of all known mapper types.
  **************************************************************************************************/
 
+#include <memory>
+#include <span>
+
 #include "ControllerTypes.h"
 #include "ElementMapper.h"
+#include "ElementMapperPool.h"
 #include "Mapper.h"
 
 namespace Xidi
 {
   namespace Controller
   {
-    /// Defines all known mapper types, one element per type. The first element is the default
-    /// mapper. Any field that corresponds to an XInput controller element can be omitted or
-    /// assigned `nullptr` and the mapper will simply ignore input from that XInput controller
-    /// element.
-    static const Mapper kMappers[] = {
-        Mapper(
-            L"StandardGamepad",
-            {.stickLeftX = std::make_unique<AxisMapper>(EAxis::X),
-             .stickLeftY = std::make_unique<AxisMapper>(EAxis::Y),
-             .stickRightX = std::make_unique<AxisMapper>(EAxis::Z),
-             .stickRightY = std::make_unique<AxisMapper>(EAxis::RotZ),
-             .dpadUp = std::make_unique<PovMapper>(EPovDirection::Up),
-             .dpadDown = std::make_unique<PovMapper>(EPovDirection::Down),
-             .dpadLeft = std::make_unique<PovMapper>(EPovDirection::Left),
-             .dpadRight = std::make_unique<PovMapper>(EPovDirection::Right),
-             .triggerLT = std::make_unique<ButtonMapper>(EButton::B7),
-             .triggerRT = std::make_unique<ButtonMapper>(EButton::B8),
-             .buttonA = std::make_unique<ButtonMapper>(EButton::B1),
-             .buttonB = std::make_unique<ButtonMapper>(EButton::B2),
-             .buttonX = std::make_unique<ButtonMapper>(EButton::B3),
-             .buttonY = std::make_unique<ButtonMapper>(EButton::B4),
-             .buttonLB = std::make_unique<ButtonMapper>(EButton::B5),
-             .buttonRB = std::make_unique<ButtonMapper>(EButton::B6),
-             .buttonBack = std::make_unique<ButtonMapper>(EButton::B9),
-             .buttonStart = std::make_unique<ButtonMapper>(EButton::B10),
-             .buttonLS = std::make_unique<ButtonMapper>(EButton::B11),
-             .buttonRS = std::make_unique<ButtonMapper>(EButton::B12)}),
-        Mapper(
-            L"DigitalGamepad",
-            {.stickLeftX = std::make_unique<DigitalAxisMapper>(EAxis::X),
-             .stickLeftY = std::make_unique<DigitalAxisMapper>(EAxis::Y),
-             .stickRightX = std::make_unique<DigitalAxisMapper>(EAxis::Z),
-             .stickRightY = std::make_unique<DigitalAxisMapper>(EAxis::RotZ),
-             .dpadUp = std::make_unique<DigitalAxisMapper>(EAxis::Y, EAxisDirection::Negative),
-             .dpadDown = std::make_unique<DigitalAxisMapper>(EAxis::Y, EAxisDirection::Positive),
-             .dpadLeft = std::make_unique<DigitalAxisMapper>(EAxis::X, EAxisDirection::Negative),
-             .dpadRight = std::make_unique<DigitalAxisMapper>(EAxis::X, EAxisDirection::Positive),
-             .triggerLT = std::make_unique<ButtonMapper>(EButton::B7),
-             .triggerRT = std::make_unique<ButtonMapper>(EButton::B8),
-             .buttonA = std::make_unique<ButtonMapper>(EButton::B1),
-             .buttonB = std::make_unique<ButtonMapper>(EButton::B2),
-             .buttonX = std::make_unique<ButtonMapper>(EButton::B3),
-             .buttonY = std::make_unique<ButtonMapper>(EButton::B4),
-             .buttonLB = std::make_unique<ButtonMapper>(EButton::B5),
-             .buttonRB = std::make_unique<ButtonMapper>(EButton::B6),
-             .buttonBack = std::make_unique<ButtonMapper>(EButton::B9),
-             .buttonStart = std::make_unique<ButtonMapper>(EButton::B10),
-             .buttonLS = std::make_unique<ButtonMapper>(EButton::B11),
-             .buttonRS = std::make_unique<ButtonMapper>(EButton::B12)}),
-        Mapper(
-            L"ExtendedGamepad",
-            {.stickLeftX = std::make_unique<AxisMapper>(EAxis::X),
-             .stickLeftY = std::make_unique<AxisMapper>(EAxis::Y),
-             .stickRightX = std::make_unique<AxisMapper>(EAxis::Z),
-             .stickRightY = std::make_unique<AxisMapper>(EAxis::RotZ),
-             .dpadUp = std::make_unique<PovMapper>(EPovDirection::Up),
-             .dpadDown = std::make_unique<PovMapper>(EPovDirection::Down),
-             .dpadLeft = std::make_unique<PovMapper>(EPovDirection::Left),
-             .dpadRight = std::make_unique<PovMapper>(EPovDirection::Right),
-             .triggerLT = std::make_unique<AxisMapper>(EAxis::RotX),
-             .triggerRT = std::make_unique<AxisMapper>(EAxis::RotY),
-             .buttonA = std::make_unique<ButtonMapper>(EButton::B1),
-             .buttonB = std::make_unique<ButtonMapper>(EButton::B2),
-             .buttonX = std::make_unique<ButtonMapper>(EButton::B3),
-             .buttonY = std::make_unique<ButtonMapper>(EButton::B4),
-             .buttonLB = std::make_unique<ButtonMapper>(EButton::B5),
-             .buttonRB = std::make_unique<ButtonMapper>(EButton::B6),
-             .buttonBack = std::make_unique<ButtonMapper>(EButton::B7),
-             .buttonStart = std::make_unique<ButtonMapper>(EButton::B8),
-             .buttonLS = std::make_unique<ButtonMapper>(EButton::B9),
-             .buttonRS = std::make_unique<ButtonMapper>(EButton::B10)}),
+    // Element mappers used by built-in mappers are compile-time constants. They are shared by all
+    // built-in mappers that use them, and they require neither dynamic initialization nor heap
+    // allocation.
+
+    static constexpr AxisMapper kAxisX(EAxis::X);
+    static constexpr AxisMapper kAxisY(EAxis::Y);
+    static constexpr AxisMapper kAxisZ(EAxis::Z);
+    static constexpr AxisMapper kAxisRotX(EAxis::RotX);
+    static constexpr AxisMapper kAxisRotY(EAxis::RotY);
+    static constexpr AxisMapper kAxisRotZ(EAxis::RotZ);
+    static constexpr AxisMapper kAxisZPositive(EAxis::Z, EAxisDirection::Positive);
+    static constexpr AxisMapper kAxisZNegative(EAxis::Z, EAxisDirection::Negative);
+
+    static constexpr DigitalAxisMapper kDigitalAxisX(EAxis::X);
+    static constexpr DigitalAxisMapper kDigitalAxisY(EAxis::Y);
+    static constexpr DigitalAxisMapper kDigitalAxisZ(EAxis::Z);
+    static constexpr DigitalAxisMapper kDigitalAxisRotZ(EAxis::RotZ);
+    static constexpr DigitalAxisMapper kDigitalAxisXNegative(EAxis::X, EAxisDirection::Negative);
+    static constexpr DigitalAxisMapper kDigitalAxisXPositive(EAxis::X, EAxisDirection::Positive);
+    static constexpr DigitalAxisMapper kDigitalAxisYNegative(EAxis::Y, EAxisDirection::Negative);
+    static constexpr DigitalAxisMapper kDigitalAxisYPositive(EAxis::Y, EAxisDirection::Positive);
+
+    static constexpr PovMapper kPovUp(EPovDirection::Up);
+    static constexpr PovMapper kPovDown(EPovDirection::Down);
+    static constexpr PovMapper kPovLeft(EPovDirection::Left);
+    static constexpr PovMapper kPovRight(EPovDirection::Right);
+
+    static constexpr ButtonMapper kButton1(EButton::B1);
+    static constexpr ButtonMapper kButton2(EButton::B2);
+    static constexpr ButtonMapper kButton3(EButton::B3);
+    static constexpr ButtonMapper kButton4(EButton::B4);
+    static constexpr ButtonMapper kButton5(EButton::B5);
+    static constexpr ButtonMapper kButton6(EButton::B6);
+    static constexpr ButtonMapper kButton7(EButton::B7);
+    static constexpr ButtonMapper kButton8(EButton::B8);
+    static constexpr ButtonMapper kButton9(EButton::B9);
+    static constexpr ButtonMapper kButton10(EButton::B10);
+    static constexpr ButtonMapper kButton11(EButton::B11);
+    static constexpr ButtonMapper kButton12(EButton::B12);
+
+    /// Obtains a pointer through which a compile-time constant element mapper can be placed into
+    /// an element map of a built-in mapper, without copying it.
+    /// @param [in] elementMapper Compile-time constant element mapper.
+    /// @return Non-owning pointer to the element mapper.
+    static inline std::shared_ptr<const IElementMapper> BuiltIn(const IElementMapper& elementMapper)
+    {
+      return ElementMapperPool::InternPermanent(elementMapper);
+    }
+
+    std::span<const Mapper> Mapper::GetBuiltIn(void)
+    {
+      /// Defines all built-in mapper types, one element per type. The first element is the default
+      /// mapper. Any field that corresponds to an XInput controller element can be omitted or
+      /// assigned `nullptr` and the mapper will simply ignore input from that XInput controller
+      /// element. These are created the first time they are needed instead of during static
+      /// initialization. Each one registers itself when created, which guarantees that the mapper
+      /// registry outlives them.
+      static const Mapper kBuiltInMappers[] = {
+          Mapper(
+              L"StandardGamepad",
+              {.stickLeftX = BuiltIn(kAxisX),
+               .stickLeftY = BuiltIn(kAxisY),
+               .stickRightX = BuiltIn(kAxisZ),
+               .stickRightY = BuiltIn(kAxisRotZ),
+               .dpadUp = BuiltIn(kPovUp),
+               .dpadDown = BuiltIn(kPovDown),
+               .dpadLeft = BuiltIn(kPovLeft),
+               .dpadRight = BuiltIn(kPovRight),
+               .triggerLT = BuiltIn(kButton7),
+               .triggerRT = BuiltIn(kButton8),
+               .buttonA = BuiltIn(kButton1),
+               .buttonB = BuiltIn(kButton2),
+               .buttonX = BuiltIn(kButton3),
+               .buttonY = BuiltIn(kButton4),
+               .buttonLB = BuiltIn(kButton5),
+               .buttonRB = BuiltIn(kButton6),
+               .buttonBack = BuiltIn(kButton9),
+               .buttonStart = BuiltIn(kButton10),
+               .buttonLS = BuiltIn(kButton11),
+               .buttonRS = BuiltIn(kButton12)}),
+          Mapper(
+              L"DigitalGamepad",
+              {.stickLeftX = BuiltIn(kDigitalAxisX),
+               .stickLeftY = BuiltIn(kDigitalAxisY),
+               .stickRightX = BuiltIn(kDigitalAxisZ),
+               .stickRightY = BuiltIn(kDigitalAxisRotZ),
+               .dpadUp = BuiltIn(kDigitalAxisYNegative),
+               .dpadDown = BuiltIn(kDigitalAxisYPositive),
+               .dpadLeft = BuiltIn(kDigitalAxisXNegative),
+               .dpadRight = BuiltIn(kDigitalAxisXPositive),
+               .triggerLT = BuiltIn(kButton7),
+               .triggerRT = BuiltIn(kButton8),
+               .buttonA = BuiltIn(kButton1),
+               .buttonB = BuiltIn(kButton2),
+               .buttonX = BuiltIn(kButton3),
+               .buttonY = BuiltIn(kButton4),
+               .buttonLB = BuiltIn(kButton5),
+               .buttonRB = BuiltIn(kButton6),
+               .buttonBack = BuiltIn(kButton9),
+               .buttonStart = BuiltIn(kButton10),
+               .buttonLS = BuiltIn(kButton11),
+               .buttonRS = BuiltIn(kButton12)}),
+          Mapper(
+              L"ExtendedGamepad",
+              {.stickLeftX = BuiltIn(kAxisX),
+               .stickLeftY = BuiltIn(kAxisY),
+               .stickRightX = BuiltIn(kAxisZ),
+               .stickRightY = BuiltIn(kAxisRotZ),
+               .dpadUp = BuiltIn(kPovUp),
+               .dpadDown = BuiltIn(kPovDown),
+               .dpadLeft = BuiltIn(kPovLeft),
+               .dpadRight = BuiltIn(kPovRight),
+               .triggerLT = BuiltIn(kAxisRotX),
+               .triggerRT = BuiltIn(kAxisRotY),
+               .buttonA = BuiltIn(kButton1),
+               .buttonB = BuiltIn(kButton2),
+               .buttonX = BuiltIn(kButton3),
+               .buttonY = BuiltIn(kButton4),
+               .buttonLB = BuiltIn(kButton5),
+               .buttonRB = BuiltIn(kButton6),
+               .buttonBack = BuiltIn(kButton7),
+               .buttonStart = BuiltIn(kButton8),
+               .buttonLS = BuiltIn(kButton9),
+               .buttonRS = BuiltIn(kButton10)}),
+
+          Mapper(
+              L"XInputNative",
+              {.stickLeftX = BuiltIn(kAxisX),
+               .stickLeftY = BuiltIn(kAxisY),
+               .stickRightX = BuiltIn(kAxisRotX),
+               .stickRightY = BuiltIn(kAxisRotY),
+               .dpadUp = BuiltIn(kPovUp),
+               .dpadDown = BuiltIn(kPovDown),
+               .dpadLeft = BuiltIn(kPovLeft),
+               .dpadRight = BuiltIn(kPovRight),
+               .triggerLT = BuiltIn(kAxisZ),
+               .triggerRT = BuiltIn(kAxisRotZ),
+               .buttonA = BuiltIn(kButton1),
+               .buttonB = BuiltIn(kButton2),
+               .buttonX = BuiltIn(kButton3),
+               .buttonY = BuiltIn(kButton4),
+               .buttonLB = BuiltIn(kButton5),
+               .buttonRB = BuiltIn(kButton6),
+               .buttonBack = BuiltIn(kButton7),
+               .buttonStart = BuiltIn(kButton8),
+               .buttonLS = BuiltIn(kButton9),
+               .buttonRS = BuiltIn(kButton10)}),
+          Mapper(
+              L"XInputSharedTriggers",
+              {.stickLeftX = BuiltIn(kAxisX),
+               .stickLeftY = BuiltIn(kAxisY),
+               .stickRightX = BuiltIn(kAxisRotX),
+               .stickRightY = BuiltIn(kAxisRotY),
+               .dpadUp = BuiltIn(kPovUp),
+               .dpadDown = BuiltIn(kPovDown),
+               .dpadLeft = BuiltIn(kPovLeft),
+               .dpadRight = BuiltIn(kPovRight),
+               .triggerLT = BuiltIn(kAxisZPositive),
+               .triggerRT = BuiltIn(kAxisZNegative),
+               .buttonA = BuiltIn(kButton1),
+               .buttonB = BuiltIn(kButton2),
+               .buttonX = BuiltIn(kButton3),
+               .buttonY = BuiltIn(kButton4),
+               .buttonLB = BuiltIn(kButton5),
+               .buttonRB = BuiltIn(kButton6),
+               .buttonBack = BuiltIn(kButton7),
+               .buttonStart = BuiltIn(kButton8),
+               .buttonLS = BuiltIn(kButton9),
+               .buttonRS = BuiltIn(kButton10)})};
 
-        Mapper(
-            L"XInputNative",
-            {.stickLeftX = std::make_unique<AxisMapper>(EAxis::X),
-             .stickLeftY = std::make_unique<AxisMapper>(EAxis::Y),
-             .stickRightX = std::make_unique<AxisMapper>(EAxis::RotX),
-             .stickRightY = std::make_unique<AxisMapper>(EAxis::RotY),
-             .dpadUp = std::make_unique<PovMapper>(EPovDirection::Up),
-             .dpadDown = std::make_unique<PovMapper>(EPovDirection::Down),
-             .dpadLeft = std::make_unique<PovMapper>(EPovDirection::Left),
-             .dpadRight = std::make_unique<PovMapper>(EPovDirection::Right),
-             .triggerLT = std::make_unique<AxisMapper>(EAxis::Z),
-             .triggerRT = std::make_unique<AxisMapper>(EAxis::RotZ),
-             .buttonA = std::make_unique<ButtonMapper>(EButton::B1),
-             .buttonB = std::make_unique<ButtonMapper>(EButton::B2),
-             .buttonX = std::make_unique<ButtonMapper>(EButton::B3),
-             .buttonY = std::make_unique<ButtonMapper>(EButton::B4),
-             .buttonLB = std::make_unique<ButtonMapper>(EButton::B5),
-             .buttonRB = std::make_unique<ButtonMapper>(EButton::B6),
-             .buttonBack = std::make_unique<ButtonMapper>(EButton::B7),
-             .buttonStart = std::make_unique<ButtonMapper>(EButton::B8),
-             .buttonLS = std::make_unique<ButtonMapper>(EButton::B9),
-             .buttonRS = std::make_unique<ButtonMapper>(EButton::B10)}),
-        Mapper(
-            L"XInputSharedTriggers",
-            {.stickLeftX = std::make_unique<AxisMapper>(EAxis::X),
-             .stickLeftY = std::make_unique<AxisMapper>(EAxis::Y),
-             .stickRightX = std::make_unique<AxisMapper>(EAxis::RotX),
-             .stickRightY = std::make_unique<AxisMapper>(EAxis::RotY),
-             .dpadUp = std::make_unique<PovMapper>(EPovDirection::Up),
-             .dpadDown = std::make_unique<PovMapper>(EPovDirection::Down),
-             .dpadLeft = std::make_unique<PovMapper>(EPovDirection::Left),
-             .dpadRight = std::make_unique<PovMapper>(EPovDirection::Right),
-             .triggerLT = std::make_unique<AxisMapper>(EAxis::Z, EAxisDirection::Positive),
-             .triggerRT = std::make_unique<AxisMapper>(EAxis::Z, EAxisDirection::Negative),
-             .buttonA = std::make_unique<ButtonMapper>(EButton::B1),
-             .buttonB = std::make_unique<ButtonMapper>(EButton::B2),
-             .buttonX = std::make_unique<ButtonMapper>(EButton::B3),
-             .buttonY = std::make_unique<ButtonMapper>(EButton::B4),
-             .buttonLB = std::make_unique<ButtonMapper>(EButton::B5),
-             .buttonRB = std::make_unique<ButtonMapper>(EButton::B6),
-             .buttonBack = std::make_unique<ButtonMapper>(EButton::B7),
-             .buttonStart = std::make_unique<ButtonMapper>(EButton::B8),
-             .buttonLS = std::make_unique<ButtonMapper>(EButton::B9),
-             .buttonRS = std::make_unique<ButtonMapper>(EButton::B10)})};
+      return kBuiltInMappers;
+    }
   } // namespace Controller
 } // namespace Xidi
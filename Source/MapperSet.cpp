@@ -0,0 +1,204 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file MapperSet.cpp
+ *   Implementation of immutable sets of mappers assigned to physical controllers, which can be
+ *   replaced at runtime without blocking the threads that use them.
+ **************************************************************************************************/
+
+#include "MapperSet.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <Infra/Core/Message.h>
+
+#include "ControllerTypes.h"
+#include "Mapper.h"
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    // Readers publish the mapper set they are reading from in a hazard record before using it,
+    // and the mapper set is not destroyed while any hazard record refers to it. This is the
+    // hazard pointer technique, which keeps readers lock-free. Readers only ever publish and
+    // validate their hazard. Retired mapper sets are reclaimed exclusively on the publication
+    // side, which is rare and is the only place that takes a lock.
+    struct MapperSetReader::SHazardRecord
+    {
+      /// Mapper set protected by this record, or `nullptr` if none.
+      std::atomic<const MapperSet*> protectedMapperSet;
+
+      /// Whether or not this record is claimed by a reader.
+      std::atomic<bool> isClaimed;
+
+      /// Next record in the list of all records. Never changes once the record is in the list.
+      SHazardRecord* next;
+    };
+
+    /// Holds the head of the list of all hazard records. Records are only ever added.
+    static std::atomic<MapperSetReader::SHazardRecord*> hazardRecordList = nullptr;
+
+    /// Serializes publication and reclamation.
+    static std::mutex publicationMutex;
+
+    /// Holds mapper sets that have been replaced but might still have readers.
+    /// Only accessed while holding the publication mutex.
+    static std::vector<const MapperSet*> retiredMapperSets;
+
+    /// Claims an unused hazard record, allocating a new one if all existing records are claimed.
+    /// @return Claimed hazard record.
+    static MapperSetReader::SHazardRecord* ClaimHazardRecord(void)
+    {
+      for (MapperSetReader::SHazardRecord* hazardRecord =
+               hazardRecordList.load(std::memory_order_acquire);
+           nullptr != hazardRecord;
+           hazardRecord = hazardRecord->next)
+      {
+        bool expectedIsClaimed = false;
+        if (true ==
+            hazardRecord->isClaimed.compare_exchange_strong(
+                expectedIsClaimed, true, std::memory_order_acquire))
+          return hazardRecord;
+      }
+
+      MapperSetReader::SHazardRecord* newHazardRecord = new MapperSetReader::SHazardRecord();
+      newHazardRecord->isClaimed.store(true, std::memory_order_relaxed);
+      newHazardRecord->next = hazardRecordList.load(std::memory_order_relaxed);
+      while (false ==
+             hazardRecordList.compare_exchange_weak(
+                 newHazardRecord->next, newHazardRecord, std::memory_order_release))
+        ;
+
+      return newHazardRecord;
+    }
+
+    /// Releases a previously-claimed hazard record so that another reader can claim it.
+    /// @param [in] hazardRecord Hazard record to release.
+    static void ReleaseHazardRecord(MapperSetReader::SHazardRecord* hazardRecord)
+    {
+      hazardRecord->protectedMapperSet.store(nullptr, std::memory_order_release);
+      hazardRecord->isClaimed.store(false, std::memory_order_release);
+    }
+
+    /// Destroys all retired mapper sets that no hazard record protects. Requires that the
+    /// publication mutex be held.
+    /// @return Number of retired mapper sets that remain because they are still protected.
+    static size_t ReclaimRetiredMapperSetsLocked(void)
+    {
+      if (true == retiredMapperSets.empty()) return 0;
+
+      std::vector<const MapperSet*> protectedMapperSets;
+      for (MapperSetReader::SHazardRecord* hazardRecord =
+               hazardRecordList.load(std::memory_order_acquire);
+           nullptr != hazardRecord;
+           hazardRecord = hazardRecord->next)
+      {
+        const MapperSet* const protectedMapperSet =
+            hazardRecord->protectedMapperSet.load(std::memory_order_seq_cst);
+        if (nullptr != protectedMapperSet) protectedMapperSets.push_back(protectedMapperSet);
+      }
+
+      std::erase_if(
+          retiredMapperSets,
+          [&protectedMapperSets](const MapperSet* retiredMapperSet) -> bool
+          {
+            if (protectedMapperSets.cend() !=
+                std::find(protectedMapperSets.cbegin(), protectedMapperSets.cend(), retiredMapperSet))
+              return false;
+
+            Infra::Message::OutputFormatted(
+                Infra::Message::ESeverity::Debug,
+                L"Reclaiming mapper set generation %llu.",
+                (unsigned long long)retiredMapperSet->GetGeneration());
+            delete retiredMapperSet;
+            return true;
+          });
+
+      return retiredMapperSets.size();
+    }
+
+    MapperSet::MapperSet(const TMapperArray& mappers, TOwnedMappers&& ownedMappers)
+        : mappers(mappers), ownedMappers(std::move(ownedMappers)), generation(0)
+    {}
+
+    MapperSet::~MapperSet(void) = default;
+
+    uint64_t MapperSet::Publish(std::unique_ptr<MapperSet> mapperSet)
+    {
+      std::unique_lock lock(publicationMutex);
+
+      const uint64_t newGeneration = 1 + publishedGeneration.load(std::memory_order_relaxed);
+      mapperSet->generation = newGeneration;
+
+      const MapperSet* const replacedMapperSet =
+          published.exchange(mapperSet.release(), std::memory_order_seq_cst);
+      publishedGeneration.store(newGeneration, std::memory_order_release);
+      if (nullptr != replacedMapperSet) retiredMapperSets.push_back(replacedMapperSet);
+
+      ReclaimRetiredMapperSetsLocked();
+      return newGeneration;
+    }
+
+    size_t MapperSet::ReclaimRetired(void)
+    {
+      std::unique_lock lock(publicationMutex);
+      return ReclaimRetiredMapperSetsLocked();
+    }
+
+    MapperSetReader::MapperSetReader(void) : hazardRecord(ClaimHazardRecord()), mapperSet(nullptr)
+    {
+      Protect();
+    }
+
+    MapperSetReader::MapperSetReader(const MapperSetReader& other)
+        : hazardRecord(ClaimHazardRecord()), mapperSet(other.mapperSet)
+    {
+      // The other reader keeps its mapper set from being reclaimed, so it is safe to protect it
+      // directly without checking whether it is still published.
+      hazardRecord->protectedMapperSet.store(mapperSet, std::memory_order_seq_cst);
+    }
+
+    MapperSetReader::MapperSetReader(MapperSetReader&& other) noexcept
+        : hazardRecord(other.hazardRecord), mapperSet(other.mapperSet)
+    {
+      other.hazardRecord = nullptr;
+      other.mapperSet = nullptr;
+    }
+
+    MapperSetReader::~MapperSetReader(void)
+    {
+      if (nullptr != hazardRecord) ReleaseHazardRecord(hazardRecord);
+    }
+
+    void MapperSetReader::Protect(void)
+    {
+      // The published mapper set can change between reading it and protecting it, in which case
+      // it might already have been reclaimed. Checking that it is still published after protecting
+      // it guarantees that it has not been, and that it will not be until it is no longer
+      // protected.
+      const MapperSet* mapperSetToProtect = MapperSet::published.load(std::memory_order_acquire);
+      while (true)
+      {
+        hazardRecord->protectedMapperSet.store(mapperSetToProtect, std::memory_order_seq_cst);
+
+        const MapperSet* const publishedMapperSet =
+            MapperSet::published.load(std::memory_order_seq_cst);
+        if (publishedMapperSet == mapperSetToProtect) break;
+
+        mapperSetToProtect = publishedMapperSet;
+      }
+
+      mapperSet = mapperSetToProtect;
+    }
+  } // namespace Controller
+} // namespace Xidi
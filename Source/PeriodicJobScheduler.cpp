@@ -0,0 +1,236 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file PeriodicJobScheduler.cpp
+ *   Implementation of a deadline-based scheduler that runs periodic jobs on a single worker
+ *   thread.
+ **************************************************************************************************/
+
+#include "PeriodicJobScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+namespace Xidi
+{
+  PeriodicJobScheduler::PeriodicJobScheduler(void)
+      : jobs(), deadlineQueue(), mutex(), deadlineQueueChanged(), workerThread()
+  {}
+
+  PeriodicJobScheduler::~PeriodicJobScheduler(void)
+  {
+    Stop();
+  }
+
+  PeriodicJobScheduler::TJobIdentifier PeriodicJobScheduler::AddJob(
+      const SJobPolicy& policy, TJobFunction&& jobFunction)
+  {
+    std::unique_lock lock(mutex);
+
+    const TJobIdentifier jobIdentifier = (TJobIdentifier)jobs.size();
+    const TClock::time_point now = TClock::now();
+
+    jobs.emplace_back(std::make_unique<SJob>(SJob{
+        .policy = policy,
+        .function = std::move(jobFunction),
+        .invocationCount = 0,
+        .lastActiveTime = now,
+        .scheduledDeadline = now + policy.period,
+        .isBeingInvoked = false,
+        .isIdle = false,
+        .isParked = false,
+        .resumeRequested = false}));
+    deadlineQueue.push({.deadline = now + policy.period, .jobIdentifier = jobIdentifier});
+
+    lock.unlock();
+    deadlineQueueChanged.notify_one();
+
+    return jobIdentifier;
+  }
+
+  void PeriodicJobScheduler::ResumeJob(TJobIdentifier jobIdentifier)
+  {
+    std::unique_lock lock(mutex);
+
+    if (jobIdentifier >= jobs.size()) return;
+    SJob& job = *jobs[jobIdentifier];
+
+    if (true == job.isBeingInvoked)
+    {
+      job.resumeRequested = true;
+      return;
+    }
+
+    if ((false == job.isParked) && (false == job.isIdle)) return;
+
+    const TClock::time_point now = TClock::now();
+
+    job.isIdle = false;
+    job.lastActiveTime = now;
+
+    // An idle job whose deadline has already arrived is about to be invoked anyway.
+    if ((false == job.isParked) && (job.scheduledDeadline <= now)) return;
+
+    job.isParked = false;
+    job.scheduledDeadline = now;
+    deadlineQueue.push({.deadline = now, .jobIdentifier = jobIdentifier});
+
+    lock.unlock();
+    deadlineQueueChanged.notify_one();
+  }
+
+  unsigned int PeriodicJobScheduler::GetJobInvocationCount(TJobIdentifier jobIdentifier)
+  {
+    std::scoped_lock lock(mutex);
+
+    if (jobIdentifier >= jobs.size()) return 0;
+    return jobs[jobIdentifier]->invocationCount;
+  }
+
+  PeriodicJobScheduler::TClock::duration PeriodicJobScheduler::IdleJobPeriod(
+      const SJobPolicy& policy, TClock::duration idleTime)
+  {
+    const TClock::duration period = policy.period;
+    const TClock::duration idlePeriod = std::max(policy.idlePeriod, policy.period);
+
+    if (idleTime >= policy.idleDecayPeriod) return idlePeriod;
+    if (idleTime <= TClock::duration::zero()) return period;
+
+    return period +
+        (((idlePeriod - period) * idleTime.count()) /
+         std::chrono::duration_cast<TClock::duration>(policy.idleDecayPeriod).count());
+  }
+
+  void PeriodicJobScheduler::Start(void)
+  {
+    if (true == IsRunning()) return;
+
+    workerThread = std::jthread(
+        [this](std::stop_token stopToken) -> void
+        {
+          WorkerThread(stopToken);
+        });
+  }
+
+  void PeriodicJobScheduler::Stop(void)
+  {
+    if (false == IsRunning()) return;
+
+    workerThread.request_stop();
+    workerThread.join();
+    workerThread = std::jthread();
+  }
+
+  void PeriodicJobScheduler::WorkerThread(std::stop_token stopToken)
+  {
+    std::unique_lock lock(mutex);
+
+    while (false == stopToken.stop_requested())
+    {
+      if (true == deadlineQueue.empty())
+      {
+        deadlineQueueChanged.wait(
+            lock,
+            stopToken,
+            [this]() -> bool
+            {
+              return (false == deadlineQueue.empty());
+            });
+        continue;
+      }
+
+      // Sleep until the earliest deadline arrives. The wait ends early if a job with an even
+      // earlier deadline is added to the queue or if a stop is requested, in which case the loop
+      // starts over.
+      const TClock::time_point nextDeadline = deadlineQueue.top().deadline;
+      if (TClock::now() < nextDeadline)
+      {
+        deadlineQueueChanged.wait_until(
+            lock,
+            stopToken,
+            nextDeadline,
+            [this, nextDeadline]() -> bool
+            {
+              return (deadlineQueue.top().deadline < nextDeadline);
+            });
+        continue;
+      }
+
+      const SQueueEntry dueEntry = deadlineQueue.top();
+      deadlineQueue.pop();
+
+      SJob& dueJob = *jobs[dueEntry.jobIdentifier];
+      if (dueEntry.deadline != dueJob.scheduledDeadline) continue;
+
+      dueJob.isBeingInvoked = true;
+
+      lock.unlock();
+      const EJobResult jobResult = dueJob.function();
+      const TClock::time_point jobCompletionTime = TClock::now();
+      lock.lock();
+
+      dueJob.isBeingInvoked = false;
+      dueJob.isIdle = false;
+      dueJob.invocationCount += 1;
+
+      // Successful jobs are scheduled at a fixed rate relative to their previous deadline, which
+      // keeps wakeups from drifting due to the time it takes to run each job. If a job has fallen
+      // behind by more than a full period it is simply scheduled to run again immediately rather
+      // than being allowed to run back-to-back to catch up. Idle jobs are treated the same way,
+      // except that their period stretches the longer they stay idle. Failed jobs are delayed
+      // relative to the time at which they failed. Parked jobs are not scheduled at all unless
+      // they were asked to resume while being invoked, in which case they run again immediately.
+      // The same goes for idle jobs that were asked to resume while being invoked.
+      TClock::time_point followingDeadline;
+      switch (jobResult)
+      {
+        case EJobResult::Park:
+          if (false == dueJob.resumeRequested)
+          {
+            dueJob.isParked = true;
+            continue;
+          }
+          dueJob.lastActiveTime = jobCompletionTime;
+          followingDeadline = jobCompletionTime;
+          break;
+
+        case EJobResult::Success:
+          dueJob.lastActiveTime = jobCompletionTime;
+          followingDeadline =
+              std::max(dueEntry.deadline + dueJob.policy.period, jobCompletionTime);
+          break;
+
+        case EJobResult::Idle:
+          if (true == dueJob.resumeRequested)
+          {
+            dueJob.lastActiveTime = jobCompletionTime;
+            followingDeadline = jobCompletionTime;
+            break;
+          }
+          dueJob.isIdle = true;
+          followingDeadline = std::max(
+              dueEntry.deadline +
+                  IdleJobPeriod(dueJob.policy, jobCompletionTime - dueJob.lastActiveTime),
+              jobCompletionTime);
+          break;
+
+        default:
+          dueJob.lastActiveTime = jobCompletionTime;
+          followingDeadline = jobCompletionTime + dueJob.policy.errorBackoffPeriod;
+          break;
+      }
+
+      dueJob.resumeRequested = false;
+      dueJob.scheduledDeadline = followingDeadline;
+      deadlineQueue.push({.deadline = followingDeadline, .jobIdentifier = dueEntry.jobIdentifier});
+    }
+  }
+} // namespace Xidi
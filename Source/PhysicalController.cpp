@@ -11,11 +11,18 @@
 
 #include "PhysicalController.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <mutex>
+#include <optional>
 #include <set>
 #include <stop_token>
+#include <string_view>
+#include <utility>
 #include <thread>
+#include <type_traits>
 
 #include <Infra/Core/Message.h>
 
@@ -25,8 +32,13 @@
 #include "ForceFeedbackDevice.h"
 #include "Globals.h"
 #include "ImportApiWinMM.h"
-#include "ImportApiXInput.h"
+#include "LatencyInstrumentation.h"
 #include "Mapper.h"
+#include "PeriodicJobScheduler.h"
+#include "PhysicalControllerRecording.h"
+#include "PhysicalControllerSource.h"
+#include "PhysicalPacketFilter.h"
+#include "SampleHistoryRing.h"
 #include "Strings.h"
 #include "VirtualController.h"
 
@@ -34,6 +46,10 @@ namespace Xidi
 {
   namespace Controller
   {
+    static_assert(
+        std::is_same_v<TControllerStateGeneration, ConcurrencyWrapper<SState>::TGeneration>,
+        "Controller state generations must match those of the underlying wrapper.");
+
     /// Raw physical state data for each of the possible physical controllers.
     static ConcurrencyWrapper<SPhysicalState> physicalControllerState[kPhysicalControllerCount];
 
@@ -41,6 +57,11 @@ namespace Xidi
     /// but without any further processing.
     static ConcurrencyWrapper<SState> rawVirtualControllerState[kPhysicalControllerCount];
 
+    /// History of recent physical controller state samples for each of the possible physical
+    /// controllers, along with the raw virtual controller states to which they were mapped.
+    static SampleHistoryRing<SPhysicalSample, kPhysicalSampleHistoryCapacity>
+        physicalControllerSampleHistory[kPhysicalControllerCount];
+
     /// Per-controller force feedback device buffer objects.
     /// These objects are not safe for dynamic initialization, so they are initialized later by
     /// pointer.
@@ -55,6 +76,20 @@ namespace Xidi
     /// feedback registration data.
     static std::mutex physicalControllerForceFeedbackMutex[kPhysicalControllerCount];
 
+    /// Scheduler that runs all of the periodic jobs, such as polling and force feedback actuation,
+    /// for all physical controllers on a single thread. Initialized later by pointer and never
+    /// destroyed, because destroying it requires joining the worker thread, which is unsafe during
+    /// process or library teardown.
+    static PeriodicJobScheduler* physicalControllerScheduler;
+
+    /// Source through which all physical controllers are accessed. Selected by configuration,
+    /// initialized later by pointer, and never destroyed.
+    static IPhysicalControllerSource* physicalControllerSource;
+
+    /// Records physical controller states to a file, if enabled by configuration. Initialized
+    /// later by pointer and never destroyed.
+    static Recording::Recorder* physicalControllerRecorder;
+
     /// Computes an opaque source identifier from a given controller identifier.
     /// @param [in] controllerIdentifier Identifier of the physical controller for which an
     /// identifier is needed.
@@ -67,56 +102,16 @@ namespace Xidi
 
     /// Reads physical controller state.
     /// @param [in] controllerIdentifier Identifier of the controller on which to operate.
+    /// @param [out] packetNumber Packet number that accompanies the physical state. Only filled in
+    /// if the physical state indicates the controller was read successfully.
     /// @return Physical state of the identified controller.
-    static SPhysicalState ReadPhysicalControllerState(TControllerIdentifier controllerIdentifier)
+    static SPhysicalState ReadPhysicalControllerState(
+        TControllerIdentifier controllerIdentifier,
+        PhysicalPacketFilter::TPacketNumber& packetNumber)
     {
-      constexpr uint16_t kUnusedButtonMask =
-          ~((uint16_t)((1u << (unsigned int)EPhysicalButton::UnusedGuide) |
-                       (1u << (unsigned int)EPhysicalButton::UnusedShare)));
-
-      XINPUT_STATE xinputState;
-      DWORD xinputGetStateResult =
-          ImportApiXInput::XInputGetState(controllerIdentifier, &xinputState);
-
-      switch (xinputGetStateResult)
-      {
-        case ERROR_SUCCESS:
-          // Directly using wButtons assumes that the bit layout is the same between the internal
-          // bitset and the XInput data structure. The static assertions below this function verify
-          // this assumption and will cause a compiler error if it is wrong.
-          return {
-              .deviceStatus = EPhysicalDeviceStatus::Ok,
-              .stick =
-                  {xinputState.Gamepad.sThumbLX,
-                   xinputState.Gamepad.sThumbLY,
-                   xinputState.Gamepad.sThumbRX,
-                   xinputState.Gamepad.sThumbRY},
-              .trigger = {xinputState.Gamepad.bLeftTrigger, xinputState.Gamepad.bRightTrigger},
-              .button = (uint16_t)(xinputState.Gamepad.wButtons & kUnusedButtonMask)};
-
-        case ERROR_DEVICE_NOT_CONNECTED:
-          return {.deviceStatus = EPhysicalDeviceStatus::NotConnected};
-
-        default:
-          return {.deviceStatus = EPhysicalDeviceStatus::Error};
-      }
+      return physicalControllerSource->ReadState(controllerIdentifier, packetNumber);
     }
 
-    static_assert(1u << (unsigned int)EPhysicalButton::DpadUp == XINPUT_GAMEPAD_DPAD_UP);
-    static_assert(1u << (unsigned int)EPhysicalButton::DpadDown == XINPUT_GAMEPAD_DPAD_DOWN);
-    static_assert(1u << (unsigned int)EPhysicalButton::DpadLeft == XINPUT_GAMEPAD_DPAD_LEFT);
-    static_assert(1u << (unsigned int)EPhysicalButton::DpadRight == XINPUT_GAMEPAD_DPAD_RIGHT);
-    static_assert(1u << (unsigned int)EPhysicalButton::Start == XINPUT_GAMEPAD_START);
-    static_assert(1u << (unsigned int)EPhysicalButton::Back == XINPUT_GAMEPAD_BACK);
-    static_assert(1u << (unsigned int)EPhysicalButton::LS == XINPUT_GAMEPAD_LEFT_THUMB);
-    static_assert(1u << (unsigned int)EPhysicalButton::RS == XINPUT_GAMEPAD_RIGHT_THUMB);
-    static_assert(1u << (unsigned int)EPhysicalButton::LB == XINPUT_GAMEPAD_LEFT_SHOULDER);
-    static_assert(1u << (unsigned int)EPhysicalButton::RB == XINPUT_GAMEPAD_RIGHT_SHOULDER);
-    static_assert(1u << (unsigned int)EPhysicalButton::A == XINPUT_GAMEPAD_A);
-    static_assert(1u << (unsigned int)EPhysicalButton::B == XINPUT_GAMEPAD_B);
-    static_assert(1u << (unsigned int)EPhysicalButton::X == XINPUT_GAMEPAD_X);
-    static_assert(1u << (unsigned int)EPhysicalButton::Y == XINPUT_GAMEPAD_Y);
-
     /// Scales a vibration strength value by the specified scaling factor. If the resulting strength
     /// exceeds the maximum possible strength it is saturated at the maximum possible strength.
     /// @param [in] vibrationStrength Physical motor vibration strength value.
@@ -156,187 +151,587 @@ namespace Xidi
                       .ValueOr(100)) /
           100.0;
 
-      // Impulse triggers are ignored because the XInput API does not support them.
-      XINPUT_VIBRATION xinputVibration = {
-          .wLeftMotorSpeed = ScaledVibrationStrength(
-              vibration.leftMotor, kForceFeedbackEffectStrengthScalingFactor),
-          .wRightMotorSpeed = ScaledVibrationStrength(
-              vibration.rightMotor, kForceFeedbackEffectStrengthScalingFactor)};
-      return (
-          ERROR_SUCCESS ==
-          ImportApiXInput::XInputSetState((DWORD)controllerIdentifier, &xinputVibration));
+      return physicalControllerSource->WriteVibration(
+          controllerIdentifier,
+          {.leftMotor = ScaledVibrationStrength(
+               vibration.leftMotor, kForceFeedbackEffectStrengthScalingFactor),
+           .rightMotor = ScaledVibrationStrength(
+               vibration.rightMotor, kForceFeedbackEffectStrengthScalingFactor),
+           .leftImpulseTrigger = ScaledVibrationStrength(
+               vibration.leftImpulseTrigger, kForceFeedbackEffectStrengthScalingFactor),
+           .rightImpulseTrigger = ScaledVibrationStrength(
+               vibration.rightImpulseTrigger, kForceFeedbackEffectStrengthScalingFactor)});
     }
 
-    /// Periodically plays force feedback effects on the physical controller actuators.
+    /// Outputs a log message describing a change in the hardware status of a physical controller,
+    /// such as connection, disconnection, or an error condition.
+    /// @param [in] controllerIdentifier Identifier of the controller whose status changed.
+    /// @param [in] oldDeviceStatus Previous hardware status of the controller.
+    /// @param [in] newDeviceStatus Updated hardware status of the controller.
+    static void OutputPhysicalControllerStatusChange(
+        TControllerIdentifier controllerIdentifier,
+        EPhysicalDeviceStatus oldDeviceStatus,
+        EPhysicalDeviceStatus newDeviceStatus)
+    {
+      switch (newDeviceStatus)
+      {
+        case EPhysicalDeviceStatus::Ok:
+          switch (oldDeviceStatus)
+          {
+            case EPhysicalDeviceStatus::Ok:
+              break;
+
+            case EPhysicalDeviceStatus::NotConnected:
+              Infra::Message::OutputFormatted(
+                  Infra::Message::ESeverity::Info,
+                  L"Physical controller %u: Hardware connected.",
+                  (1 + controllerIdentifier));
+              break;
+
+            default:
+              Infra::Message::OutputFormatted(
+                  Infra::Message::ESeverity::Warning,
+                  L"Physical controller %u: Cleared previous error condition.",
+                  (1 + controllerIdentifier));
+              break;
+          }
+          break;
+
+        case EPhysicalDeviceStatus::NotConnected:
+          if (newDeviceStatus != oldDeviceStatus)
+            Infra::Message::OutputFormatted(
+                Infra::Message::ESeverity::Info,
+                L"Physical controller %u: Hardware disconnected.",
+                (1 + controllerIdentifier));
+          break;
+
+        default:
+          if (newDeviceStatus != oldDeviceStatus)
+            Infra::Message::OutputFormatted(
+                Infra::Message::ESeverity::Warning,
+                L"Physical controller %u: Encountered an error condition.",
+                (1 + controllerIdentifier));
+          break;
+      }
+    }
+
+    /// Plays force feedback effects on the physical controller actuators. Invoked periodically as
+    /// a scheduled job, one job per physical controller.
     /// @param [in] controllerIdentifier Identifier of the controller on which to operate.
-    static void ForceFeedbackActuateEffects(TControllerIdentifier controllerIdentifier)
+    /// @param [in] mapper Mapper associated with the controller on which to operate.
+    /// @param [in,out] previousPhysicalActuatorValues Physical actuator values most recently
+    /// written to the controller. Updated whenever a new set of values is written.
+    /// @return Result of the job, which indicates whether or not the physical actuators were
+    /// successfully updated and is idle if they did not need to be updated and no effects are
+    /// playing.
+    static PeriodicJobScheduler::EJobResult ForceFeedbackActuateEffects(
+        TControllerIdentifier controllerIdentifier,
+        const Mapper& mapper,
+        ForceFeedback::SPhysicalActuatorComponents& previousPhysicalActuatorValues)
     {
       constexpr ForceFeedback::TOrderedMagnitudeComponents kVirtualMagnitudeVectorZero = {};
 
-      ForceFeedback::SPhysicalActuatorComponents previousPhysicalActuatorValues;
       ForceFeedback::SPhysicalActuatorComponents currentPhysicalActuatorValues;
 
-      const Mapper* mapper = Mapper::GetConfigured(controllerIdentifier);
-      bool lastActuationResult = true;
-
-      while (true)
+      if (true == Globals::DoesCurrentProcessHaveInputFocus())
       {
-        if (true == lastActuationResult)
-          Sleep(kPhysicalForceFeedbackPeriodMilliseconds);
-        else
-          Sleep(kPhysicalErrorBackoffPeriodMilliseconds);
+        ForceFeedback::TEffectValue overallEffectGain = 10000;
+        ForceFeedback::SPhysicalActuatorComponents physicalActuatorVector = {};
+        ForceFeedback::TOrderedMagnitudeComponents virtualMagnitudeVector =
+            physicalControllerForceFeedbackBuffer[controllerIdentifier].PlayEffects();
 
-        if (true == Globals::DoesCurrentProcessHaveInputFocus())
+        if (kVirtualMagnitudeVectorZero != virtualMagnitudeVector)
         {
-          ForceFeedback::TEffectValue overallEffectGain = 10000;
-          ForceFeedback::SPhysicalActuatorComponents physicalActuatorVector = {};
-          ForceFeedback::TOrderedMagnitudeComponents virtualMagnitudeVector =
-              physicalControllerForceFeedbackBuffer[controllerIdentifier].PlayEffects();
+          std::unique_lock lock(physicalControllerForceFeedbackMutex[controllerIdentifier]);
+
+          // Gain is modified downwards by each virtual controller object.
+          // Typically there would only be one, in which case the properties of that object would
+          // be effective. Otherwise this loop is essentially modeled as multiple volume knobs
+          // connected in sequence, each lowering the volume of the effects by the value of its own
+          // device-wide gain property.
+          for (auto virtualController :
+               physicalControllerForceFeedbackRegistration[controllerIdentifier])
+            overallEffectGain *=
+                ((ForceFeedback::TEffectValue)virtualController->GetForceFeedbackGain() /
+                 ForceFeedback::kEffectModifierMaximum);
+
+          physicalActuatorVector =
+              mapper.MapForceFeedbackVirtualToPhysical(virtualMagnitudeVector, overallEffectGain);
+        }
 
-          if (kVirtualMagnitudeVectorZero != virtualMagnitudeVector)
-          {
-            std::unique_lock lock(physicalControllerForceFeedbackMutex[controllerIdentifier]);
-
-            // Gain is modified downwards by each virtual controller object.
-            // Typically there would only be one, in which case the properties of that object would
-            // be effective. Otherwise this loop is essentially modeled as multiple volume knobs
-            // connected in sequence, each lowering the volume of the effects by the value of its
-            // own device-wide gain property.
-            for (auto virtualController :
-                 physicalControllerForceFeedbackRegistration[controllerIdentifier])
-              overallEffectGain *=
-                  ((ForceFeedback::TEffectValue)virtualController->GetForceFeedbackGain() /
-                   ForceFeedback::kEffectModifierMaximum);
-
-            physicalActuatorVector = mapper->MapForceFeedbackVirtualToPhysical(
-                virtualMagnitudeVector, overallEffectGain);
-          }
+        currentPhysicalActuatorValues = physicalActuatorVector;
+      }
+      else
+      {
+        currentPhysicalActuatorValues = {};
+      }
 
-          currentPhysicalActuatorValues = physicalActuatorVector;
-        }
-        else
+      // With no effects playing there is nothing further to actuate until an effect is started,
+      // at which point this job is resumed.
+      if (previousPhysicalActuatorValues == currentPhysicalActuatorValues)
+      {
+        const bool anyEffectsPlaying =
+            physicalControllerForceFeedbackBuffer[controllerIdentifier].IsDevicePlayingAnyEffects();
+        return (
+            (true == anyEffectsPlaying) ? PeriodicJobScheduler::EJobResult::Success
+                                        : PeriodicJobScheduler::EJobResult::Idle);
+      }
+
+      previousPhysicalActuatorValues = currentPhysicalActuatorValues;
+
+      if (false ==
+          WritePhysicalControllerVibration(controllerIdentifier, currentPhysicalActuatorValues))
+        return PeriodicJobScheduler::EJobResult::Error;
+
+      return PeriodicJobScheduler::EJobResult::Success;
+    }
+
+    /// Polls for physical controller state. Invoked periodically as a scheduled job, one job per
+    /// physical controller. On detected state change, updates the internal data structure and
+    /// notifies all waiting threads. Hardware status changes are additionally written to the log.
+    /// @param [in] controllerIdentifier Identifier of the controller on which to operate.
+    /// @param [in,out] packetFilter Filter that remembers the packet number of the previous poll.
+    /// @param [in,out] lastDeviceStatus Hardware status of the controller as of the previous poll.
+    /// Updated with the hardware status of the controller as of this poll.
+    /// @param [in,out] mappingContext Context through which physical controller states are mapped,
+    /// resolved once when polling begins and carried between polls so that mapping can be
+    /// incremental. Follows the configured mapper, so a replacement mapper takes effect at the
+    /// next poll.
+    /// @return Result of the job, which indicates an error whenever the controller is not in a
+    /// state from which it can be successfully read and otherwise indicates whether or not the
+    /// controller's state changed since the previous poll.
+    static PeriodicJobScheduler::EJobResult PollForPhysicalControllerStateChanges(
+        TControllerIdentifier controllerIdentifier,
+        PhysicalPacketFilter& packetFilter,
+        EPhysicalDeviceStatus& lastDeviceStatus,
+        MappingContext& mappingContext)
+    {
+      const bool latencyInstrumentationEnabled = Latency::IsEnabled();
+      Latency::SSampleTimestamps latencyTimestamps = {};
+
+      if (true == latencyInstrumentationEnabled)
+        latencyTimestamps.physicalReadStart = Latency::Now();
+
+      PhysicalPacketFilter::TPacketNumber newPacketNumber = 0;
+      const SPhysicalState newPhysicalState =
+          ReadPhysicalControllerState(controllerIdentifier, newPacketNumber);
+
+      // An unchanged packet number means the physical controller's state is also unchanged. The
+      // filter resets itself on any unsuccessful read, so this also implies that the device status
+      // has not changed since the previous poll. The state still needs to be mapped again if the
+      // mapper was replaced, since the virtual controller state could be different.
+      const bool mapperChanged = mappingContext.Refresh();
+      if ((false == packetFilter.IsNewPacket(newPhysicalState.deviceStatus, newPacketNumber)) &&
+          (false == mapperChanged))
+        return PeriodicJobScheduler::EJobResult::Idle;
+
+      if (true == latencyInstrumentationEnabled) latencyTimestamps.physicalReadEnd = Latency::Now();
+
+      const bool physicalStateChanged =
+          physicalControllerState[controllerIdentifier].Update(newPhysicalState);
+
+      if ((true == physicalStateChanged) && (nullptr != physicalControllerRecorder))
+        physicalControllerRecorder->Record(controllerIdentifier, newPhysicalState);
+
+      if ((true == physicalStateChanged) || (true == mapperChanged))
+      {
+        const SState newRawVirtualState =
+            ((EPhysicalDeviceStatus::Ok == newPhysicalState.deviceStatus)
+                 ? mappingContext.MapStatePhysicalToVirtual(newPhysicalState)
+                 : mappingContext.MapNeutralPhysicalToVirtual());
+
+        if (true == latencyInstrumentationEnabled)
         {
-          currentPhysicalActuatorValues = {};
+          latencyTimestamps.mapped = Latency::Now();
+          Latency::RecordPhysicalSampleMapped(controllerIdentifier, latencyTimestamps);
         }
 
-        if (previousPhysicalActuatorValues != currentPhysicalActuatorValues)
+        // Samples are recorded in the history before the raw virtual controller state is published
+        // so that anyone woken up by the publication is guaranteed to find the sample there.
+        physicalControllerSampleHistory[controllerIdentifier].Append(
+            {.timestamp = ImportApiWinMM::timeGetTime(),
+             .physicalState = newPhysicalState,
+             .rawVirtualState = newRawVirtualState});
+
+        // Timestamps are made available before the raw virtual controller state is published so
+        // that virtual controllers woken up by the publication always see them. They are skipped
+        // if publication would not change anything, since no virtual controller would refresh.
+        if ((true == latencyInstrumentationEnabled) &&
+            (newRawVirtualState != rawVirtualControllerState[controllerIdentifier].Get()))
         {
-          lastActuationResult =
-              WritePhysicalControllerVibration(controllerIdentifier, currentPhysicalActuatorValues);
-          previousPhysicalActuatorValues = currentPhysicalActuatorValues;
+          latencyTimestamps.publicationStart = Latency::Now();
+          Latency::RecordPhysicalSamplePublicationStart(controllerIdentifier, latencyTimestamps);
+
+          rawVirtualControllerState[controllerIdentifier].Update(newRawVirtualState);
+          Latency::RecordPhysicalSamplePublished(
+              controllerIdentifier, latencyTimestamps, Latency::Now());
         }
         else
         {
-          lastActuationResult = true;
+          rawVirtualControllerState[controllerIdentifier].Update(newRawVirtualState);
         }
       }
+
+      if (newPhysicalState.deviceStatus != lastDeviceStatus)
+      {
+        OutputPhysicalControllerStatusChange(
+            controllerIdentifier, lastDeviceStatus, newPhysicalState.deviceStatus);
+        lastDeviceStatus = newPhysicalState.deviceStatus;
+      }
+
+      if (EPhysicalDeviceStatus::Ok != newPhysicalState.deviceStatus)
+        return PeriodicJobScheduler::EJobResult::Error;
+
+      return (
+          (true == physicalStateChanged) ? PeriodicJobScheduler::EJobResult::Success
+                                         : PeriodicJobScheduler::EJobResult::Idle);
     }
 
-    /// Periodically polls for physical controller state.
-    /// On detected state change, updates the internal data structure and notifies all waiting
-    /// threads.
-    /// @param [in] controllerIdentifier Identifier of the controller on which to operate.
-    static void PollForPhysicalControllerStateChanges(TControllerIdentifier controllerIdentifier)
+    /// Determines the scheduling policy to use for physical controller polling jobs. Polling is
+    /// adaptive, in that it occurs at a fast rate while the physical controller's state is changing
+    /// and gradually slows down once the state stops changing. All of the relevant periods can be
+    /// customized by configuration.
+    /// @return Scheduling policy for physical controller polling jobs.
+    static PeriodicJobScheduler::SJobPolicy PhysicalControllerPollingPolicy(void)
     {
-      SPhysicalState newPhysicalState = physicalControllerState[controllerIdentifier].Get();
+      const auto& propertiesSection =
+          Globals::GetConfigurationData()[Strings::kStrConfigurationSectionProperties];
+
+      const int64_t pollingPeriodFastMilliseconds = std::clamp<int64_t>(
+          propertiesSection
+              [Strings::kStrConfigurationSettingPropertiesPollingPeriodFastMilliseconds]
+                  .ValueOr(kPhysicalPollingPeriodFastDefaultMilliseconds),
+          1,
+          kPhysicalErrorBackoffPeriodMilliseconds);
+      const int64_t pollingPeriodSlowMilliseconds = std::clamp<int64_t>(
+          propertiesSection
+              [Strings::kStrConfigurationSettingPropertiesPollingPeriodSlowMilliseconds]
+                  .ValueOr(kPhysicalPollingPeriodSlowDefaultMilliseconds),
+          pollingPeriodFastMilliseconds,
+          kPhysicalErrorBackoffPeriodMilliseconds);
+      const int64_t pollingPeriodDecayMilliseconds = std::max<int64_t>(
+          propertiesSection
+              [Strings::kStrConfigurationSettingPropertiesPollingPeriodDecayMilliseconds]
+                  .ValueOr(kPhysicalPollingPeriodDecayDefaultMilliseconds),
+          0);
+
+      return {
+          .period = std::chrono::milliseconds(pollingPeriodFastMilliseconds),
+          .errorBackoffPeriod = std::chrono::milliseconds(kPhysicalErrorBackoffPeriodMilliseconds),
+          .idlePeriod = std::chrono::milliseconds(pollingPeriodSlowMilliseconds),
+          .idleDecayPeriod = std::chrono::milliseconds(pollingPeriodDecayMilliseconds)};
+    }
 
-      while (true)
-      {
-        if (EPhysicalDeviceStatus::Ok == newPhysicalState.deviceStatus)
-          Sleep(kPhysicalPollingPeriodMilliseconds);
-        else
-          Sleep(kPhysicalErrorBackoffPeriodMilliseconds);
+    /// Creates the source through which all physical controllers are accessed, as selected by
+    /// configuration. Real hardware accessed using XInput is the default.
+    /// @return Newly-allocated physical controller source.
+    static IPhysicalControllerSource* CreatePhysicalControllerSource(void)
+    {
+      const auto& propertiesSection =
+          Globals::GetConfigurationData()[Strings::kStrConfigurationSectionProperties];
 
-        newPhysicalState = ReadPhysicalControllerState(controllerIdentifier);
+      if (true ==
+          propertiesSection.Contains(
+              Strings::kStrConfigurationSettingPropertiesPhysicalControllerSource))
+      {
+        const std::wstring_view sourceName =
+            propertiesSection[Strings::kStrConfigurationSettingPropertiesPhysicalControllerSource]
+                ->GetString();
 
-        if (true == physicalControllerState[controllerIdentifier].Update(newPhysicalState))
+        if (Strings::kStrPhysicalControllerSourceSynthetic == sourceName)
+        {
+          const unsigned int sampleRateHz = (unsigned int)std::clamp<int64_t>(
+              propertiesSection[Strings::kStrConfigurationSettingPropertiesSyntheticSampleRateHz]
+                  .ValueOr((int64_t)SyntheticPhysicalControllerSource::kSampleRateDefaultHz),
+              SyntheticPhysicalControllerSource::kSampleRateMinHz,
+              SyntheticPhysicalControllerSource::kSampleRateMaxHz);
+
+          Infra::Message::OutputFormatted(
+              Infra::Message::ESeverity::Warning,
+              L"Physical controllers are being replaced with synthetic data generated at %u samples per second. Real hardware will not be used.",
+              sampleRateHz);
+          return new SyntheticPhysicalControllerSource({.sampleRateHz = sampleRateHz});
+        }
+        else if (Strings::kStrPhysicalControllerSourceReplay == sourceName)
         {
-          const SState newRawVirtualState =
-              ((EPhysicalDeviceStatus::Ok == newPhysicalState.deviceStatus)
-                   ? Mapper::GetConfigured(controllerIdentifier)
-                         ->MapStatePhysicalToVirtual(
-                             newPhysicalState,
-                             OpaqueControllerSourceIdentifier(controllerIdentifier))
-                   : Mapper::GetConfigured(controllerIdentifier)
-                         ->MapNeutralPhysicalToVirtual(
-                             OpaqueControllerSourceIdentifier(controllerIdentifier)));
+          if (true ==
+              propertiesSection.Contains(Strings::kStrConfigurationSettingPropertiesReplayFile))
+          {
+            const std::wstring_view replayFilename =
+                propertiesSection[Strings::kStrConfigurationSettingPropertiesReplayFile]
+                    ->GetString();
 
-          rawVirtualControllerState[controllerIdentifier].Update(newRawVirtualState);
+            ReplayPhysicalControllerSource::TRecording recording;
+            if (true == Recording::LoadFromFile(replayFilename, recording))
+            {
+              Infra::Message::OutputFormatted(
+                  Infra::Message::ESeverity::Warning,
+                  L"Physical controllers are being replaced with playback of recording file \"%s\". Real hardware will not be used.",
+                  replayFilename.data());
+              return new ReplayPhysicalControllerSource(
+                  std::move(recording), ReplayPhysicalControllerSource::ESpeed::Original);
+            }
+          }
+          else
+          {
+            Infra::Message::OutputFormatted(
+                Infra::Message::ESeverity::Warning,
+                L"Physical controller source is replay, but no recording file is specified in the configuration file.");
+          }
+
+          Infra::Message::OutputFormatted(
+              Infra::Message::ESeverity::Warning,
+              L"Unable to play back a recording of physical controller states. Using XInput instead.");
+        }
+        else if (Strings::kStrPhysicalControllerSourceXInput != sourceName)
+        {
+          Infra::Message::OutputFormatted(
+              Infra::Message::ESeverity::Warning,
+              L"Unrecognized physical controller source \"%s\" specified in the configuration file. Using XInput instead.",
+              sourceName.data());
         }
       }
+
+      return new XInputPhysicalControllerSource();
     }
 
-    /// Monitors physical controller status for events like hardware connection or disconnection and
-    /// error conditions. Used exclusively for logging. Intended to be a thread entry point, one
-    /// thread per monitored physical controller.
-    /// @param [in] controllerIdentifier Identifier of the controller to monitor.
-    static void MonitorPhysicalControllerStatus(TControllerIdentifier controllerIdentifier)
+    /// Tracks whether or not a physical controller is in use, so that the jobs and threads that
+    /// service it only run while something is consuming its data. Physical controllers are
+    /// activated the first time they are referenced and parked whenever they go unreferenced for
+    /// long enough.
+    struct SPhysicalControllerActivity
     {
-      if (controllerIdentifier >= kPhysicalControllerCount)
+      /// Ensures the physical controller is activated exactly once.
+      std::once_flag activationFlag;
+
+      /// Whether or not the physical controller has been activated. Never cleared once set.
+      std::atomic<bool> isActivated;
+
+      /// Whether or not the physical controller is parked, meaning that its state is not being
+      /// sampled and its force feedback effects are not being actuated.
+      std::atomic<bool> isParked;
+
+      /// Set whenever the physical controller is referenced and cleared whenever its inactivity
+      /// monitoring job checks for inactivity.
+      std::atomic<bool> wasReferenced;
+
+      /// Set by the inactivity monitoring job once the physical controller has gone unreferenced
+      /// for a full parking period. Checked by the polling job or sampling thread before each
+      /// sample, which is where the physical controller is actually parked.
+      std::atomic<bool> parkRequested;
+
+      /// Number of threads currently waiting for the physical controller's state to change, plus
+      /// the number of consumers registered to be notified of its state changes.
+      std::atomic<unsigned int> waiterCount;
+
+      /// Identifier of the scheduler job that polls the physical controller, if it is polled
+      /// rather than sampled by a dedicated thread. Written once during activation.
+      std::optional<PeriodicJobScheduler::TJobIdentifier> pollingJob;
+
+      /// Identifier of the scheduler job that actuates the physical controller's force feedback
+      /// effects. Written once during activation.
+      PeriodicJobScheduler::TJobIdentifier forceFeedbackJob;
+
+      /// Identifier of the scheduler job that monitors the physical controller for inactivity, if
+      /// parking is enabled. Written once during activation.
+      std::optional<PeriodicJobScheduler::TJobIdentifier> inactivityJob;
+
+      /// Inactivity period after which the physical controller is parked, or 0 if it is never
+      /// parked. Resolved from configuration and written once during activation.
+      std::chrono::milliseconds parkingPeriod;
+    };
+
+    /// Activity tracking data for each of the possible physical controllers.
+    static SPhysicalControllerActivity physicalControllerActivity[kPhysicalControllerCount];
+
+    /// Number of physical controllers that are activated and not parked. The system timer
+    /// resolution is only raised while this is non-zero.
+    static unsigned int physicalControllerRunningCount = 0;
+
+    /// Mutex for protecting against concurrent parking and unparking of physical controllers, and
+    /// by extension against concurrent changes to the number of running physical controllers.
+    static std::mutex physicalControllerActivityMutex;
+
+    /// Determines how long a physical controller must go without being referenced before it is
+    /// parked. Customizable by configuration, where a value of 0 disables parking.
+    /// @return Inactivity period after which physical controllers are parked, or 0 if they are
+    /// never parked.
+    static std::chrono::milliseconds PhysicalControllerParkingPeriod(void)
+    {
+      static const std::chrono::milliseconds kParkingPeriod =
+          std::chrono::milliseconds(std::max<int64_t>(
+              Globals::GetConfigurationData()
+                  [Strings::kStrConfigurationSectionProperties]
+                  [Strings::kStrConfigurationSettingPropertiesParkAfterInactivityMilliseconds]
+                      .ValueOr(kPhysicalParkAfterInactivityDefaultMilliseconds),
+              0));
+
+      return kParkingPeriod;
+    }
+
+    /// Retrieves the finest system timer resolution available.
+    /// @return Finest available system timer resolution in milliseconds, or 0 if the information
+    /// is unavailable.
+    static UINT FinestSystemTimerResolution(void)
+    {
+      static const UINT kFinestSystemTimerResolution = []() -> UINT
       {
+        TIMECAPS timeCaps;
+        const MMRESULT timeResult = ImportApiWinMM::timeGetDevCaps(&timeCaps, sizeof(timeCaps));
+        if (MMSYSERR_NOERROR == timeResult) return timeCaps.wPeriodMin;
+
         Infra::Message::OutputFormatted(
-            Infra::Message::ESeverity::Error,
-            L"Attempted to monitor physical controller with invalid identifier %u.",
-            controllerIdentifier);
-        return;
-      }
+            Infra::Message::ESeverity::Warning,
+            L"Failed with code %u to obtain system timer resolution information.",
+            timeResult);
+        return 0;
+      }();
+
+      return kFinestSystemTimerResolution;
+    }
+
+    /// Records that a physical controller has started running, either because it was activated or
+    /// because it was unparked. The first running physical controller raises the system timer
+    /// resolution to suit the desired polling frequency. Must be invoked with the physical
+    /// controller activity mutex held.
+    static void PhysicalControllerStartedRunning(void)
+    {
+      physicalControllerRunningCount += 1;
+      if (1 != physicalControllerRunningCount) return;
+
+      const UINT timerResolution = FinestSystemTimerResolution();
+      if (0 == timerResolution) return;
+
+      const MMRESULT timeResult = ImportApiWinMM::timeBeginPeriod(timerResolution);
+      if (MMSYSERR_NOERROR == timeResult)
+        Infra::Message::OutputFormatted(
+            Infra::Message::ESeverity::Info,
+            L"Set the system timer resolution to %u ms.",
+            timerResolution);
+      else
+        Infra::Message::OutputFormatted(
+            Infra::Message::ESeverity::Warning,
+            L"Failed with code %u to set the system timer resolution.",
+            timeResult);
+    }
+
+    /// Records that a physical controller has stopped running because it was parked. The last
+    /// running physical controller restores the system timer resolution. Must be invoked with the
+    /// physical controller activity mutex held.
+    static void PhysicalControllerStoppedRunning(void)
+    {
+      physicalControllerRunningCount -= 1;
+      if (0 != physicalControllerRunningCount) return;
+
+      const UINT timerResolution = FinestSystemTimerResolution();
+      if (0 == timerResolution) return;
+
+      if (MMSYSERR_NOERROR == ImportApiWinMM::timeEndPeriod(timerResolution))
+        Infra::Message::OutputFormatted(
+            Infra::Message::ESeverity::Info,
+            L"Restored the system timer resolution because no physical controllers are in use.");
+    }
+
+    /// Checks a physical controller for inactivity and, if it has gone unreferenced for a full
+    /// parking period with nothing waiting for its state to change and no virtual controller
+    /// registered with it for force feedback, requests that it be parked. Invoked periodically as
+    /// a scheduled job, once per parking period, so that sampling never needs to consult a clock.
+    /// Physical controllers are therefore parked after between one and two parking periods of
+    /// inactivity.
+    /// @param [in] controllerIdentifier Identifier of the controller on which to operate.
+    /// @return Result of the job, which parks it along with the physical controller.
+    static PeriodicJobScheduler::EJobResult MonitorPhysicalControllerInactivity(
+        TControllerIdentifier controllerIdentifier)
+    {
+      SPhysicalControllerActivity& activity = physicalControllerActivity[controllerIdentifier];
 
-      SPhysicalState oldPhysicalState = GetCurrentPhysicalControllerState(controllerIdentifier);
-      SPhysicalState newPhysicalState = oldPhysicalState;
+      if (true == activity.isParked.load()) return PeriodicJobScheduler::EJobResult::Park;
+
+      if ((true == activity.wasReferenced.exchange(false)) || (0 != activity.waiterCount.load()))
+        return PeriodicJobScheduler::EJobResult::Success;
 
-      while (true)
       {
-        WaitForPhysicalControllerStateChange(
-            controllerIdentifier, newPhysicalState, std::stop_token());
+        std::unique_lock lock(physicalControllerForceFeedbackMutex[controllerIdentifier]);
+        if (false == physicalControllerForceFeedbackRegistration[controllerIdentifier].empty())
+          return PeriodicJobScheduler::EJobResult::Success;
+      }
 
-        // Look for status changes and output to the log, as appropriate.
-        switch (newPhysicalState.deviceStatus)
-        {
-          case EPhysicalDeviceStatus::Ok:
-            switch (oldPhysicalState.deviceStatus)
-            {
-              case EPhysicalDeviceStatus::Ok:
-                break;
-
-              case EPhysicalDeviceStatus::NotConnected:
-                Infra::Message::OutputFormatted(
-                    Infra::Message::ESeverity::Info,
-                    L"Physical controller %u: Hardware connected.",
-                    (1 + controllerIdentifier));
-                break;
-
-              default:
-                Infra::Message::OutputFormatted(
-                    Infra::Message::ESeverity::Warning,
-                    L"Physical controller %u: Cleared previous error condition.",
-                    (1 + controllerIdentifier));
-                break;
-            }
-            break;
+      activity.parkRequested.store(true);
+      return PeriodicJobScheduler::EJobResult::Success;
+    }
 
-          case EPhysicalDeviceStatus::NotConnected:
-            if (newPhysicalState.deviceStatus != oldPhysicalState.deviceStatus)
-              Infra::Message::OutputFormatted(
-                  Infra::Message::ESeverity::Info,
-                  L"Physical controller %u: Hardware disconnected.",
-                  (1 + controllerIdentifier));
-            break;
+    /// Parks a physical controller if its inactivity monitoring job requested it and nothing has
+    /// referenced it since. Invoked by whatever samples the physical controller's state,
+    /// immediately before each sample, so it does as little as possible unless parking was
+    /// requested.
+    /// @param [in] controllerIdentifier Identifier of the controller on which to operate.
+    /// @return `true` if the physical controller was parked, `false` otherwise.
+    static inline bool TryParkPhysicalController(TControllerIdentifier controllerIdentifier)
+    {
+      SPhysicalControllerActivity& activity = physicalControllerActivity[controllerIdentifier];
 
-          default:
-            if (newPhysicalState.deviceStatus != oldPhysicalState.deviceStatus)
-              Infra::Message::OutputFormatted(
-                  Infra::Message::ESeverity::Warning,
-                  L"Physical controller %u: Encountered an error condition.",
-                  (1 + controllerIdentifier));
-            break;
-        }
+      if (false == activity.parkRequested.load(std::memory_order_acquire)) return false;
+      activity.parkRequested.store(false);
+
+      if ((true == activity.wasReferenced.load()) || (0 != activity.waiterCount.load()))
+        return false;
 
-        oldPhysicalState = newPhysicalState;
+      std::unique_lock lock(physicalControllerActivityMutex);
+
+      // References do not take the mutex unless they see the parked flag, so a reference that
+      // arrives concurrently with parking is only guaranteed to be visible after the flag is set.
+      activity.isParked.store(true);
+      if ((true == activity.wasReferenced.load()) || (0 != activity.waiterCount.load()))
+      {
+        // Force feedback actuation and inactivity monitoring might have observed the parked flag
+        // in the meantime and parked themselves, in which case they need to be resumed.
+        activity.isParked.store(false);
+        physicalControllerScheduler->ResumeJob(activity.forceFeedbackJob);
+        physicalControllerScheduler->ResumeJob(*activity.inactivityJob);
+        return false;
       }
+
+      PhysicalControllerStoppedRunning();
+      Infra::Message::OutputFormatted(
+          Infra::Message::ESeverity::Debug,
+          L"Physical controller %u: Parked after at least %u ms of inactivity.",
+          (1 + controllerIdentifier),
+          (unsigned int)activity.parkingPeriod.count());
+      return true;
+    }
+
+    /// Unparks a physical controller so that its state is once again sampled and its force
+    /// feedback effects are once again actuated. Does nothing if the physical controller is not
+    /// parked.
+    /// @param [in] controllerIdentifier Identifier of the controller on which to operate.
+    static void UnparkPhysicalController(TControllerIdentifier controllerIdentifier)
+    {
+      SPhysicalControllerActivity& activity = physicalControllerActivity[controllerIdentifier];
+
+      std::unique_lock lock(physicalControllerActivityMutex);
+      if (false == activity.isParked.load()) return;
+
+      activity.isParked.store(false);
+      PhysicalControllerStartedRunning();
+
+      if (true == activity.pollingJob.has_value())
+        physicalControllerScheduler->ResumeJob(*activity.pollingJob);
+      else
+        activity.isParked.notify_all();
+
+      physicalControllerScheduler->ResumeJob(activity.forceFeedbackJob);
+      if (true == activity.inactivityJob.has_value())
+        physicalControllerScheduler->ResumeJob(*activity.inactivityJob);
+
+      Infra::Message::OutputFormatted(
+          Infra::Message::ESeverity::Debug,
+          L"Physical controller %u: Unparked.",
+          (1 + controllerIdentifier));
     }
 
-    /// Initializes internal data structures and creates worker threads.
-    /// Idempotent and concurrency-safe.
+    /// Initializes internal data structures that are shared by all physical controllers and
+    /// starts the scheduler that runs all periodic jobs. Individual physical controllers are
+    /// activated separately. Idempotent and concurrency-safe.
     static void Initialize(void)
     {
       // There is overhead to using call_once, even after the operation is completed, and physical
@@ -350,118 +745,272 @@ namespace Xidi
           initFlag,
           []() -> void
           {
-            // Initialize controller state data structures.
-            for (auto controllerIdentifier = 0;
-                 controllerIdentifier < _countof(physicalControllerState);
-                 ++controllerIdentifier)
-            {
-              const SPhysicalState initialPhysicalState =
-                  ReadPhysicalControllerState(controllerIdentifier);
-              const SState initialRawVirtualState =
-                  Mapper::GetConfigured(controllerIdentifier)
-                      ->MapStatePhysicalToVirtual(
-                          initialPhysicalState,
-                          OpaqueControllerSourceIdentifier(controllerIdentifier));
-
-              physicalControllerState[controllerIdentifier].Set(initialPhysicalState);
-              rawVirtualControllerState[controllerIdentifier].Set(initialRawVirtualState);
-            }
+            physicalControllerSource = CreatePhysicalControllerSource();
 
-            // Ensure the system timer resolution is suitable for the desired polling frequency.
-            TIMECAPS timeCaps;
-            MMRESULT timeResult = ImportApiWinMM::timeGetDevCaps(&timeCaps, sizeof(timeCaps));
-            if (MMSYSERR_NOERROR == timeResult)
-            {
-              timeResult = ImportApiWinMM::timeBeginPeriod(timeCaps.wPeriodMin);
-
-              if (MMSYSERR_NOERROR == timeResult)
-                Infra::Message::OutputFormatted(
-                    Infra::Message::ESeverity::Info,
-                    L"Set the system timer resolution to %u ms.",
-                    timeCaps.wPeriodMin);
-              else
-                Infra::Message::OutputFormatted(
-                    Infra::Message::ESeverity::Warning,
-                    L"Failed with code %u to set the system timer resolution.",
-                    timeResult);
-            }
+            const auto& propertiesSection =
+                Globals::GetConfigurationData()[Strings::kStrConfigurationSectionProperties];
+            if (true ==
+                propertiesSection.Contains(Strings::kStrConfigurationSettingPropertiesRecordFile))
+              physicalControllerRecorder = new Recording::Recorder(
+                  propertiesSection[Strings::kStrConfigurationSettingPropertiesRecordFile]
+                      ->GetString());
+
+            // Allocate the force feedback device buffers.
+            physicalControllerForceFeedbackBuffer =
+                new ForceFeedback::Device[kPhysicalControllerCount];
+
+            if (std::chrono::milliseconds(0) != PhysicalControllerParkingPeriod())
+              Infra::Message::OutputFormatted(
+                  Infra::Message::ESeverity::Info,
+                  L"Physical controllers will be parked after %u ms of inactivity.",
+                  (unsigned int)PhysicalControllerParkingPeriod().count());
             else
-            {
               Infra::Message::OutputFormatted(
-                  Infra::Message::ESeverity::Warning,
-                  L"Failed with code %u to obtain system timer resolution information.",
-                  timeResult);
+                  Infra::Message::ESeverity::Info,
+                  L"Physical controllers will not be parked when inactive.");
+
+            // Start the scheduler with no physical controller jobs. Jobs are added as each
+            // physical controller is activated.
+            physicalControllerScheduler = new PeriodicJobScheduler();
+            Latency::Initialize(*physicalControllerScheduler);
+            physicalControllerScheduler->Start();
+
+            isInitialized = true;
+          });
+    }
+
+    /// Activates a physical controller by reading its initial state and then creating the jobs,
+    /// or thread, that service it. Idempotent and concurrency-safe.
+    /// @param [in] controllerIdentifier Identifier of the controller on which to operate.
+    static void ActivatePhysicalController(TControllerIdentifier controllerIdentifier)
+    {
+      SPhysicalControllerActivity& activity = physicalControllerActivity[controllerIdentifier];
+      if (true == activity.isActivated.load(std::memory_order_acquire)) return;
+
+      Initialize();
+
+      std::call_once(
+          activity.activationFlag,
+          [controllerIdentifier, &activity]() -> void
+          {
+            // Parking is governed by configuration, which is resolved here, once, so that neither
+            // sampling nor inactivity monitoring needs to look it up.
+            activity.parkingPeriod = PhysicalControllerParkingPeriod();
+
+            // Initialize controller state data structures. The packet filter is seeded with the
+            // initial packet number so that the first poll can skip mapping if nothing changed.
+            // Everything needed for mapping is resolved here, once, so that polling does not need
+            // to look anything up. The mapping context follows the configured mapper so that it can
+            // be replaced at runtime.
+            MappingContext initialMappingContext(
+                controllerIdentifier, OpaqueControllerSourceIdentifier(controllerIdentifier));
+            PhysicalPacketFilter initialPacketFilter;
+            PhysicalPacketFilter::TPacketNumber initialPacketNumber = 0;
+            const SPhysicalState initialPhysicalState =
+                ReadPhysicalControllerState(controllerIdentifier, initialPacketNumber);
+            initialPacketFilter.IsNewPacket(initialPhysicalState.deviceStatus, initialPacketNumber);
+            const SState initialRawVirtualState =
+                initialMappingContext.MapStatePhysicalToVirtual(initialPhysicalState);
+
+            physicalControllerState[controllerIdentifier].Set(initialPhysicalState);
+            if (nullptr != physicalControllerRecorder)
+              physicalControllerRecorder->Record(controllerIdentifier, initialPhysicalState);
+            rawVirtualControllerState[controllerIdentifier].Set(initialRawVirtualState);
+
+            {
+              std::unique_lock lock(physicalControllerActivityMutex);
+              PhysicalControllerStartedRunning();
             }
 
-            // Create and start the polling threads.
-            for (auto controllerIdentifier = 0; controllerIdentifier < kPhysicalControllerCount;
-                 ++controllerIdentifier)
+            // Create the polling and force feedback actuation jobs. Each job carries along
+            // whatever state it needs to remember between invocations.
+            if (true == physicalControllerSource->SupportsWaitForNextSample())
             {
-              std::thread(PollForPhysicalControllerStateChanges, controllerIdentifier).detach();
+              // Sources that can signal when a new sample is available do not need to be polled.
+              // Each physical controller gets its own dedicated thread that waits for samples and
+              // processes them as soon as they arrive. These threads are never joined for the
+              // same reason the scheduler is never destroyed.
+              new std::jthread(
+                  [controllerIdentifier,
+                   packetFilter = initialPacketFilter,
+                   lastDeviceStatus = initialPhysicalState.deviceStatus,
+                   mappingContext = initialMappingContext](
+                      std::stop_token stopToken) mutable -> void
+                  {
+                    SPhysicalControllerActivity& activity =
+                        physicalControllerActivity[controllerIdentifier];
+
+                    while (true)
+                    {
+                      if (true == TryParkPhysicalController(controllerIdentifier))
+                      {
+                        activity.isParked.wait(true);
+                        continue;
+                      }
+
+                      if (false ==
+                          physicalControllerSource->WaitForNextSample(
+                              controllerIdentifier, stopToken))
+                        break;
+
+                      PollForPhysicalControllerStateChanges(
+                          controllerIdentifier, packetFilter, lastDeviceStatus, mappingContext);
+                    }
+                  });
               Infra::Message::OutputFormatted(
                   Infra::Message::ESeverity::Info,
-                  L"Initialized the physical controller state polling thread for controller %u. Desired polling period is %u ms.",
-                  (unsigned int)(1 + controllerIdentifier),
-                  kPhysicalPollingPeriodMilliseconds);
+                  L"Initialized the physical controller state sampling thread for controller %u.",
+                  (1 + controllerIdentifier));
             }
-
-            // Allocate the force feedback device buffers, then create and start the force feedback
-            // threads.
-            physicalControllerForceFeedbackBuffer =
-                new ForceFeedback::Device[kPhysicalControllerCount];
-            for (auto controllerIdentifier = 0; controllerIdentifier < kPhysicalControllerCount;
-                 ++controllerIdentifier)
+            else
             {
-              std::thread(ForceFeedbackActuateEffects, controllerIdentifier).detach();
+              static const PeriodicJobScheduler::SJobPolicy kPollingPolicy =
+                  PhysicalControllerPollingPolicy();
+
+              activity.pollingJob = physicalControllerScheduler->AddJob(
+                  kPollingPolicy,
+                  [controllerIdentifier,
+                   packetFilter = initialPacketFilter,
+                   lastDeviceStatus = initialPhysicalState.deviceStatus,
+                   mappingContext = initialMappingContext]() mutable
+                      -> PeriodicJobScheduler::EJobResult
+                  {
+                    if (true == TryParkPhysicalController(controllerIdentifier))
+                      return PeriodicJobScheduler::EJobResult::Park;
+
+                    return PollForPhysicalControllerStateChanges(
+                        controllerIdentifier, packetFilter, lastDeviceStatus, mappingContext);
+                  });
               Infra::Message::OutputFormatted(
                   Infra::Message::ESeverity::Info,
-                  L"Initialized the physical controller force feedback actuation thread for controller %u. Desired actuation period is %u ms.",
-                  (unsigned int)(1 + controllerIdentifier),
-                  kPhysicalForceFeedbackPeriodMilliseconds);
+                  L"Initialized the physical controller state polling job for controller %u. Desired polling period is %u ms while active and %u ms after %u ms of inactivity.",
+                  (1 + controllerIdentifier),
+                  (unsigned int)kPollingPolicy.period.count(),
+                  (unsigned int)kPollingPolicy.idlePeriod.count(),
+                  (unsigned int)kPollingPolicy.idleDecayPeriod.count());
             }
 
-            // Create and start the physical controller hardware status monitoring threads, but only
-            // if the messages generated by those threads will actually be delivered as output.
-            if (Infra::Message::WillOutputMessageOfSeverity(Infra::Message::ESeverity::Warning))
+            activity.forceFeedbackJob = physicalControllerScheduler->AddJob(
+                {.period = std::chrono::milliseconds(kPhysicalForceFeedbackPeriodMilliseconds),
+                 .errorBackoffPeriod =
+                     std::chrono::milliseconds(kPhysicalErrorBackoffPeriodMilliseconds),
+                 .idlePeriod =
+                     std::chrono::milliseconds(kPhysicalForceFeedbackIdlePeriodMilliseconds),
+                 .idleDecayPeriod =
+                     std::chrono::milliseconds(kPhysicalForceFeedbackIdleDecayPeriodMilliseconds)},
+                [controllerIdentifier,
+                 configuredMappers = Mapper::ReadConfigured(),
+                 previousPhysicalActuatorValues =
+                     ForceFeedback::SPhysicalActuatorComponents()]() mutable
+                    -> PeriodicJobScheduler::EJobResult
+                {
+                  // Parked physical controllers have no registered virtual controllers, so there
+                  // is nothing to play, but any vibration still in progress needs to be stopped.
+                  if (true == physicalControllerActivity[controllerIdentifier].isParked.load())
+                  {
+                    constexpr ForceFeedback::SPhysicalActuatorComponents kPhysicalActuatorsOff = {};
+                    if (kPhysicalActuatorsOff != previousPhysicalActuatorValues)
+                    {
+                      previousPhysicalActuatorValues = kPhysicalActuatorsOff;
+                      WritePhysicalControllerVibration(controllerIdentifier, kPhysicalActuatorsOff);
+                    }
+
+                    return PeriodicJobScheduler::EJobResult::Park;
+                  }
+
+                  configuredMappers.Refresh();
+                  return ForceFeedbackActuateEffects(
+                      controllerIdentifier,
+                      *configuredMappers->GetMapper(controllerIdentifier),
+                      previousPhysicalActuatorValues);
+                });
+            Infra::Message::OutputFormatted(
+                Infra::Message::ESeverity::Info,
+                L"Initialized the physical controller force feedback actuation job for controller %u. Desired actuation period is %u ms while effects are playing and %u ms after %u ms without any.",
+                (1 + controllerIdentifier),
+                kPhysicalForceFeedbackPeriodMilliseconds,
+                kPhysicalForceFeedbackIdlePeriodMilliseconds,
+                kPhysicalForceFeedbackIdleDecayPeriodMilliseconds);
+
+            // Parking is requested by the inactivity monitoring job but performed while holding
+            // the activity mutex, so the job identifier is published under that same mutex.
+            if (std::chrono::milliseconds(0) != activity.parkingPeriod)
             {
-              for (auto controllerIdentifier = 0; controllerIdentifier < kPhysicalControllerCount;
-                   ++controllerIdentifier)
-              {
-                std::thread(MonitorPhysicalControllerStatus, controllerIdentifier).detach();
-                Infra::Message::OutputFormatted(
-                    Infra::Message::ESeverity::Info,
-                    L"Initialized the physical controller hardware status monitoring thread for controller %u.",
-                    (unsigned int)(1 + controllerIdentifier));
-              }
+              std::unique_lock lock(physicalControllerActivityMutex);
+              activity.inactivityJob = physicalControllerScheduler->AddJob(
+                  {.period = activity.parkingPeriod, .errorBackoffPeriod = activity.parkingPeriod},
+                  [controllerIdentifier]() -> PeriodicJobScheduler::EJobResult
+                  {
+                    return MonitorPhysicalControllerInactivity(controllerIdentifier);
+                  });
             }
 
-            isInitialized = true;
+            activity.isActivated.store(true, std::memory_order_release);
           });
     }
 
+    /// Records that a physical controller is in use. Activates the physical controller if this is
+    /// the first time it is referenced and unparks it if it is parked. Intended to be invoked by
+    /// every function that accesses the physical controller on behalf of a consumer.
+    /// @param [in] controllerIdentifier Identifier of the controller on which to operate.
+    static inline void ReferencePhysicalController(TControllerIdentifier controllerIdentifier)
+    {
+      SPhysicalControllerActivity& activity = physicalControllerActivity[controllerIdentifier];
+
+      ActivatePhysicalController(controllerIdentifier);
+
+      activity.wasReferenced.store(true);
+      if (true == activity.isParked.load()) UnparkPhysicalController(controllerIdentifier);
+    }
+
     SCapabilities GetControllerCapabilities(TControllerIdentifier controllerIdentifier)
     {
-      Initialize();
-      return Mapper::GetConfigured(controllerIdentifier)->GetCapabilities();
+      ReferencePhysicalController(controllerIdentifier);
+      return Mapper::ReadConfigured()->GetMapper(controllerIdentifier)->GetCapabilities();
     }
 
     SPhysicalState GetCurrentPhysicalControllerState(TControllerIdentifier controllerIdentifier)
     {
-      Initialize();
+      ReferencePhysicalController(controllerIdentifier);
       return physicalControllerState[controllerIdentifier].Get();
     }
 
     SState GetCurrentRawVirtualControllerState(TControllerIdentifier controllerIdentifier)
     {
-      Initialize();
+      ReferencePhysicalController(controllerIdentifier);
       return rawVirtualControllerState[controllerIdentifier].Get();
     }
 
+    TControllerStateGeneration GetPhysicalControllerStateGeneration(
+        TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return 0;
+
+      ReferencePhysicalController(controllerIdentifier);
+      return physicalControllerState[controllerIdentifier].GetGeneration();
+    }
+
+    TControllerStateGeneration GetRawVirtualControllerStateGeneration(
+        TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return 0;
+
+      ReferencePhysicalController(controllerIdentifier);
+      return rawVirtualControllerState[controllerIdentifier].GetGeneration();
+    }
+
+    TPhysicalSampleHistoryCursor GetPhysicalControllerSampleHistoryCursor(
+        TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return 0;
+
+      ReferencePhysicalController(controllerIdentifier);
+      return physicalControllerSampleHistory[controllerIdentifier].GetWriteCursor();
+    }
+
     ForceFeedback::Device* PhysicalControllerForceFeedbackRegister(
         TControllerIdentifier controllerIdentifier, const VirtualController* virtualController)
     {
-      Initialize();
-
       if (controllerIdentifier >= kPhysicalControllerCount)
       {
         Infra::Message::OutputFormatted(
@@ -471,17 +1020,27 @@ namespace Xidi
         return nullptr;
       }
 
+      ReferencePhysicalController(controllerIdentifier);
+
       std::unique_lock lock(physicalControllerForceFeedbackMutex[controllerIdentifier]);
       physicalControllerForceFeedbackRegistration[controllerIdentifier].insert(virtualController);
 
       return &physicalControllerForceFeedbackBuffer[controllerIdentifier];
     }
 
+    void PhysicalControllerForceFeedbackNotifyEffectStarted(
+        TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return;
+
+      ReferencePhysicalController(controllerIdentifier);
+      physicalControllerScheduler->ResumeJob(
+          physicalControllerActivity[controllerIdentifier].forceFeedbackJob);
+    }
+
     void PhysicalControllerForceFeedbackUnregister(
         TControllerIdentifier controllerIdentifier, const VirtualController* virtualController)
     {
-      Initialize();
-
       if (controllerIdentifier >= kPhysicalControllerCount)
       {
         Infra::Message::OutputFormatted(
@@ -491,30 +1050,86 @@ namespace Xidi
         return;
       }
 
+      // Registering activates the physical controller, so if it was never activated then there is
+      // nothing to unregister and no reason to bring up the subsystem just to find that out.
+      if (false ==
+          physicalControllerActivity[controllerIdentifier].isActivated.load(
+              std::memory_order_acquire))
+        return;
+
       std::unique_lock lock(physicalControllerForceFeedbackMutex[controllerIdentifier]);
       physicalControllerForceFeedbackRegistration[controllerIdentifier].erase(virtualController);
     }
 
+    void PhysicalControllerNotifyInUse(TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return;
+
+      ReferencePhysicalController(controllerIdentifier);
+    }
+
+    void PhysicalControllerStateChangeNotificationRegister(
+        TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return;
+
+      physicalControllerActivity[controllerIdentifier].waiterCount += 1;
+      ReferencePhysicalController(controllerIdentifier);
+    }
+
+    void PhysicalControllerStateChangeNotificationUnregister(
+        TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return;
+
+      physicalControllerActivity[controllerIdentifier].waiterCount -= 1;
+    }
+
+    bool ReadPhysicalControllerSampleHistory(
+        TControllerIdentifier controllerIdentifier,
+        TPhysicalSampleHistoryCursor& cursor,
+        SPhysicalSample& sample)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return false;
+
+      return physicalControllerSampleHistory[controllerIdentifier].Read(cursor, sample);
+    }
+
     bool WaitForPhysicalControllerStateChange(
         TControllerIdentifier controllerIdentifier,
+        TControllerStateGeneration& lastKnownGeneration,
         SPhysicalState& state,
         std::stop_token stopToken)
     {
-      Initialize();
-
       if (controllerIdentifier >= kPhysicalControllerCount) return false;
 
-      return physicalControllerState[controllerIdentifier].WaitForUpdate(state, stopToken);
+      // Waiting threads keep the physical controller from being parked, otherwise they might wait
+      // forever for a change that is never detected.
+      SPhysicalControllerActivity& activity = physicalControllerActivity[controllerIdentifier];
+      activity.waiterCount += 1;
+      ReferencePhysicalController(controllerIdentifier);
+
+      const bool result = physicalControllerState[controllerIdentifier].WaitForUpdate(
+          lastKnownGeneration, state, stopToken);
+
+      activity.waiterCount -= 1;
+      return result;
     }
 
     bool WaitForRawVirtualControllerStateChange(
-        TControllerIdentifier controllerIdentifier, SState& state, std::stop_token stopToken)
+        TControllerIdentifier controllerIdentifier,
+        TControllerStateGeneration& lastKnownGeneration,
+        SState& state,
+        std::stop_token stopToken)
     {
-      Initialize();
-
       if (controllerIdentifier >= kPhysicalControllerCount) return false;
 
-      return rawVirtualControllerState[controllerIdentifier].WaitForUpdate(state, stopToken);
+      // The thread that waits here dispatches state changes to virtual controllers for as long as
+      // any of them exist, so counting it as a waiter would keep the physical controller from ever
+      // being parked. Virtual controllers instead mark the physical controller as being in use
+      // whenever they are read and whenever they are asked to notify of state changes.
+      return rawVirtualControllerState[controllerIdentifier].WaitForUpdate(
+          lastKnownGeneration, state, stopToken);
     }
   } // namespace Controller
 } // namespace Xidi
@@ -0,0 +1,601 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file PhysicalControllerRecording.cpp
+ *   Implementation of functionality for recording physical controller sessions to a compact binary
+ *   format and replaying them through a mapper.
+ **************************************************************************************************/
+
+#include "PhysicalControllerRecording.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <Infra/Core/Message.h>
+
+#include "ApiWindows.h"
+#include "ControllerTypes.h"
+#include "Mapper.h"
+#include "PhysicalControllerSource.h"
+#include "PhysicalPacketFilter.h"
+#include "SampleHistoryRing.h"
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    namespace Recording
+    {
+      /// Computes the bit within a record's field mask that corresponds to the specified field.
+      /// @param [in] field Field of interest.
+      /// @return Corresponding bit within the field mask.
+      static constexpr uint8_t FieldMaskBit(EField field)
+      {
+        return (uint8_t)(1u << static_cast<unsigned int>(field));
+      }
+
+      /// Appends an unsigned integer to a buffer in little-endian byte order.
+      /// @tparam IntegerType Type of integer to append, which determines the number of bytes.
+      /// @param [in] value Value to append.
+      /// @param [in,out] buffer Buffer to which to append the value.
+      template <typename IntegerType> static void AppendInteger(
+          IntegerType value, std::vector<uint8_t>& buffer)
+      {
+        for (size_t i = 0; i < sizeof(IntegerType); ++i)
+          buffer.push_back((uint8_t)((uint64_t)value >> (8 * i)));
+      }
+
+      /// Appends an unsigned integer to a buffer using a variable-length encoding in which each
+      /// byte holds seven bits of the value and the top bit indicates whether more bytes follow.
+      /// Small values therefore take up very little space.
+      /// @param [in] value Value to append.
+      /// @param [in,out] buffer Buffer to which to append the value.
+      static void AppendVariableLengthInteger(uint64_t value, std::vector<uint8_t>& buffer)
+      {
+        do
+        {
+          const uint8_t lowBits = (uint8_t)(value & 0x7f);
+          value >>= 7;
+          buffer.push_back((0 == value) ? lowBits : (uint8_t)(lowBits | 0x80));
+        }
+        while (0 != value);
+      }
+
+      /// Sequentially reads values out of an encoded recording, checking bounds along the way.
+      class DecodeCursor
+      {
+      public:
+
+        inline DecodeCursor(const uint8_t* data, size_t size)
+            : kData(data), kSize(size), position(0)
+        {}
+
+        /// Determines whether or not all of the encoded bytes have been read.
+        /// @return `true` if so, `false` otherwise.
+        inline bool IsAtEnd(void) const
+        {
+          return (position >= kSize);
+        }
+
+        /// Reads an unsigned integer stored in little-endian byte order.
+        /// @tparam IntegerType Type of integer to read, which determines the number of bytes.
+        /// @param [out] value Filled in with the value that was read.
+        /// @return `true` if successful, `false` if not enough bytes remain.
+        template <typename IntegerType> inline bool ReadInteger(IntegerType& value)
+        {
+          if ((kSize - position) < sizeof(IntegerType)) return false;
+
+          uint64_t valueRead = 0;
+          for (size_t i = 0; i < sizeof(IntegerType); ++i)
+            valueRead |= ((uint64_t)kData[position + i] << (8 * i));
+
+          value = (IntegerType)valueRead;
+          position += sizeof(IntegerType);
+          return true;
+        }
+
+        /// Reads an unsigned integer stored using the variable-length encoding.
+        /// @param [out] value Filled in with the value that was read.
+        /// @return `true` if successful, `false` if not enough bytes remain or the value is too
+        /// large to be represented.
+        inline bool ReadVariableLengthInteger(uint64_t& value)
+        {
+          uint64_t valueRead = 0;
+
+          for (unsigned int shift = 0; shift < 64; shift += 7)
+          {
+            if (true == IsAtEnd()) return false;
+
+            const uint8_t nextByte = kData[position++];
+            valueRead |= ((uint64_t)(nextByte & 0x7f) << shift);
+
+            if (0 == (nextByte & 0x80))
+            {
+              value = valueRead;
+              return true;
+            }
+          }
+
+          return false;
+        }
+
+      private:
+
+        /// Start of the encoded bytes.
+        const uint8_t* const kData;
+
+        /// Total number of encoded bytes.
+        const size_t kSize;
+
+        /// Position of the next byte to be read.
+        size_t position;
+      };
+
+      Encoder::Encoder(void) : previousPhysicalState(), previousTimestampMicroseconds(0)
+      {
+        for (auto& physicalState : previousPhysicalState)
+          physicalState = {.deviceStatus = EPhysicalDeviceStatus::NotConnected};
+      }
+
+      void Encoder::EncodeHeader(std::vector<uint8_t>& buffer)
+      {
+        AppendInteger<uint32_t>(kRecordingMagic, buffer);
+        AppendInteger<uint16_t>(kRecordingVersion, buffer);
+        AppendInteger<uint16_t>(kPhysicalControllerCount, buffer);
+      }
+
+      bool Encoder::EncodeRecord(
+          TControllerIdentifier controllerIdentifier,
+          uint64_t timestampMicroseconds,
+          const SPhysicalState& physicalState,
+          std::vector<uint8_t>& buffer)
+      {
+        if (controllerIdentifier >= kPhysicalControllerCount) return false;
+
+        const SPhysicalState& previousState = previousPhysicalState[controllerIdentifier];
+        const uint16_t buttons = (uint16_t)physicalState.button.to_ulong();
+
+        uint8_t fieldMask = 0;
+        if (physicalState.deviceStatus != previousState.deviceStatus)
+          fieldMask |= FieldMaskBit(EField::DeviceStatus);
+        for (int i = 0; i < static_cast<int>(EPhysicalStick::Count); ++i)
+        {
+          if (physicalState.stick[i] != previousState.stick[i])
+            fieldMask |= FieldMaskBit(
+                static_cast<EField>(static_cast<int>(EField::StickLeftX) + i));
+        }
+        for (int i = 0; i < static_cast<int>(EPhysicalTrigger::Count); ++i)
+        {
+          if (physicalState.trigger[i] != previousState.trigger[i])
+            fieldMask |= FieldMaskBit(
+                static_cast<EField>(static_cast<int>(EField::TriggerLT) + i));
+        }
+        if (physicalState.button != previousState.button)
+          fieldMask |= FieldMaskBit(EField::Buttons);
+
+        if (0 == fieldMask) return false;
+
+        AppendVariableLengthInteger(
+            timestampMicroseconds -
+                std::min(timestampMicroseconds, previousTimestampMicroseconds),
+            buffer);
+        AppendInteger<uint8_t>((uint8_t)controllerIdentifier, buffer);
+        AppendInteger<uint8_t>(fieldMask, buffer);
+
+        if (0 != (fieldMask & FieldMaskBit(EField::DeviceStatus)))
+          AppendInteger<uint8_t>((uint8_t)physicalState.deviceStatus, buffer);
+        for (int i = 0; i < static_cast<int>(EPhysicalStick::Count); ++i)
+        {
+          if (0 !=
+              (fieldMask &
+               FieldMaskBit(static_cast<EField>(static_cast<int>(EField::StickLeftX) + i))))
+            AppendInteger<uint16_t>((uint16_t)physicalState.stick[i], buffer);
+        }
+        for (int i = 0; i < static_cast<int>(EPhysicalTrigger::Count); ++i)
+        {
+          if (0 !=
+              (fieldMask &
+               FieldMaskBit(static_cast<EField>(static_cast<int>(EField::TriggerLT) + i))))
+            AppendInteger<uint8_t>(physicalState.trigger[i], buffer);
+        }
+        if (0 != (fieldMask & FieldMaskBit(EField::Buttons)))
+          AppendInteger<uint16_t>(buttons, buffer);
+
+        previousPhysicalState[controllerIdentifier] = physicalState;
+        previousTimestampMicroseconds =
+            std::max(timestampMicroseconds, previousTimestampMicroseconds);
+        return true;
+      }
+
+      bool Decode(
+          const uint8_t* data, size_t size, ReplayPhysicalControllerSource::TRecording& recording)
+      {
+        DecodeCursor cursor(data, size);
+
+        SRecordingHeader header = {};
+        if ((false == cursor.ReadInteger(header.magic)) ||
+            (false == cursor.ReadInteger(header.version)) ||
+            (false == cursor.ReadInteger(header.controllerCount)))
+          return false;
+        if ((kRecordingMagic != header.magic) || (kRecordingVersion != header.version))
+          return false;
+
+        ReplayPhysicalControllerSource::TRecording decodedRecording;
+        std::array<SPhysicalState, kPhysicalControllerCount> currentPhysicalState;
+        for (auto& physicalState : currentPhysicalState)
+          physicalState = {.deviceStatus = EPhysicalDeviceStatus::NotConnected};
+
+        uint64_t timestampMicroseconds = 0;
+        while (false == cursor.IsAtEnd())
+        {
+          uint64_t timestampDeltaMicroseconds = 0;
+          uint8_t controllerIdentifier = 0;
+          uint8_t fieldMask = 0;
+
+          if ((false == cursor.ReadVariableLengthInteger(timestampDeltaMicroseconds)) ||
+              (false == cursor.ReadInteger(controllerIdentifier)) ||
+              (false == cursor.ReadInteger(fieldMask)))
+            return false;
+          if ((controllerIdentifier >= header.controllerCount) ||
+              (controllerIdentifier >= kPhysicalControllerCount))
+            return false;
+
+          SPhysicalState& physicalState = currentPhysicalState[controllerIdentifier];
+
+          if (0 != (fieldMask & FieldMaskBit(EField::DeviceStatus)))
+          {
+            uint8_t deviceStatus = 0;
+            if (false == cursor.ReadInteger(deviceStatus)) return false;
+            if (deviceStatus >= static_cast<uint8_t>(EPhysicalDeviceStatus::Count)) return false;
+
+            physicalState.deviceStatus = static_cast<EPhysicalDeviceStatus>(deviceStatus);
+          }
+          for (int i = 0; i < static_cast<int>(EPhysicalStick::Count); ++i)
+          {
+            if (0 !=
+                (fieldMask &
+                 FieldMaskBit(static_cast<EField>(static_cast<int>(EField::StickLeftX) + i))))
+            {
+              uint16_t stickValue = 0;
+              if (false == cursor.ReadInteger(stickValue)) return false;
+
+              physicalState.stick[i] = (int16_t)stickValue;
+            }
+          }
+          for (int i = 0; i < static_cast<int>(EPhysicalTrigger::Count); ++i)
+          {
+            if (0 !=
+                (fieldMask &
+                 FieldMaskBit(static_cast<EField>(static_cast<int>(EField::TriggerLT) + i))))
+            {
+              if (false == cursor.ReadInteger(physicalState.trigger[i])) return false;
+            }
+          }
+          if (0 != (fieldMask & FieldMaskBit(EField::Buttons)))
+          {
+            uint16_t buttons = 0;
+            if (false == cursor.ReadInteger(buttons)) return false;
+
+            physicalState.button = buttons;
+          }
+
+          timestampMicroseconds += timestampDeltaMicroseconds;
+          decodedRecording[controllerIdentifier].push_back(
+              {.timestampMicroseconds = timestampMicroseconds, .physicalState = physicalState});
+        }
+
+        recording = std::move(decodedRecording);
+        return true;
+      }
+
+      bool LoadFromFile(
+          std::wstring_view filename, ReplayPhysicalControllerSource::TRecording& recording)
+      {
+        HANDLE fileHandle = CreateFileW(
+            filename.data(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+        if (INVALID_HANDLE_VALUE == fileHandle)
+        {
+          Infra::Message::OutputFormatted(
+              Infra::Message::ESeverity::Error,
+              L"Failed with code %u to open physical controller recording file \"%s\".",
+              (unsigned int)GetLastError(),
+              filename.data());
+          return false;
+        }
+
+        LARGE_INTEGER fileSize = {};
+        if ((FALSE == GetFileSizeEx(fileHandle, &fileSize)) || (0 == fileSize.QuadPart) ||
+            ((uint64_t)fileSize.QuadPart > (uint64_t)SIZE_MAX))
+        {
+          Infra::Message::OutputFormatted(
+              Infra::Message::ESeverity::Error,
+              L"Physical controller recording file \"%s\" is empty or its size could not be determined.",
+              filename.data());
+          CloseHandle(fileHandle);
+          return false;
+        }
+
+        HANDLE fileMappingHandle =
+            CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(fileHandle);
+        if (nullptr == fileMappingHandle)
+        {
+          Infra::Message::OutputFormatted(
+              Infra::Message::ESeverity::Error,
+              L"Failed with code %u to map physical controller recording file \"%s\".",
+              (unsigned int)GetLastError(),
+              filename.data());
+          return false;
+        }
+
+        // The view keeps the underlying file mapping alive, so its handle can be closed as soon as
+        // the view is created, whether or not that succeeds.
+        const void* const fileView = MapViewOfFile(fileMappingHandle, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(fileMappingHandle);
+        if (nullptr == fileView)
+        {
+          Infra::Message::OutputFormatted(
+              Infra::Message::ESeverity::Error,
+              L"Failed with code %u to map a view of physical controller recording file \"%s\".",
+              (unsigned int)GetLastError(),
+              filename.data());
+          return false;
+        }
+
+        const bool decodeResult = Decode(
+            static_cast<const uint8_t*>(fileView), (size_t)fileSize.QuadPart, recording);
+        UnmapViewOfFile(fileView);
+
+        if (true == decodeResult)
+          Infra::Message::OutputFormatted(
+              Infra::Message::ESeverity::Info,
+              L"Loaded physical controller recording file \"%s\".",
+              filename.data());
+        else
+          Infra::Message::OutputFormatted(
+              Infra::Message::ESeverity::Error,
+              L"Physical controller recording file \"%s\" is malformed.",
+              filename.data());
+
+        return decodeResult;
+      }
+
+      Recorder::Recorder(std::wstring_view filename)
+          : kStartTime(TClock::now()),
+            fileHandle(CreateFileW(
+                filename.data(),
+                GENERIC_WRITE,
+                FILE_SHARE_READ,
+                nullptr,
+                CREATE_ALWAYS,
+                FILE_ATTRIBUTE_NORMAL,
+                nullptr)),
+            pendingRecords(),
+            encoder(),
+            buffer(),
+            writerMutex(),
+            writerWakeup(),
+            writerThread()
+      {
+        if (INVALID_HANDLE_VALUE == fileHandle)
+        {
+          Infra::Message::OutputFormatted(
+              Infra::Message::ESeverity::Error,
+              L"Failed with code %u to create physical controller recording file \"%s\".",
+              (unsigned int)GetLastError(),
+              filename.data());
+          return;
+        }
+
+        Encoder::EncodeHeader(buffer);
+
+        DWORD numBytesWritten = 0;
+        WriteFile(fileHandle, buffer.data(), (DWORD)buffer.size(), &numBytesWritten, nullptr);
+        buffer.clear();
+
+        writerThread = std::jthread(
+            [this](std::stop_token stopToken) -> void
+            {
+              WriteQueuedRecords(stopToken);
+            });
+
+        Infra::Message::OutputFormatted(
+            Infra::Message::ESeverity::Info,
+            L"Recording physical controller states to file \"%s\".",
+            filename.data());
+      }
+
+      Recorder::~Recorder(void)
+      {
+        // The background thread writes whatever remains queued before it exits, so it must be
+        // finished before the file is closed.
+        if (true == writerThread.joinable())
+        {
+          writerThread.request_stop();
+          writerThread.join();
+        }
+
+        if (INVALID_HANDLE_VALUE != fileHandle) CloseHandle(fileHandle);
+      }
+
+      void Recorder::Record(
+          TControllerIdentifier controllerIdentifier, const SPhysicalState& physicalState)
+      {
+        if (false == IsReady()) return;
+        if (controllerIdentifier >= kPhysicalControllerCount) return;
+
+        const uint64_t timestampMicroseconds =
+            (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                TClock::now() - kStartTime)
+                .count();
+        pendingRecords[controllerIdentifier].Append(
+            {.timestampMicroseconds = timestampMicroseconds, .physicalState = physicalState});
+      }
+
+      void Recorder::WriteQueuedRecords(std::stop_token stopToken)
+      {
+        std::array<SampleHistoryRing<SPendingRecord, kRecorderQueueCapacity>::TCursor,
+                   kPhysicalControllerCount>
+            readCursors = {};
+        std::vector<std::pair<TControllerIdentifier, SPendingRecord>> queuedRecords;
+        uint64_t lostRecordCount = 0;
+
+        while (true)
+        {
+          const bool stopRequested = stopToken.stop_requested();
+
+          // Each queue is already in timestamp order, but the queues are independent of one
+          // another. Everything queued so far is gathered and sorted so that records for all of
+          // the physical controllers are encoded in the order in which they were recorded.
+          queuedRecords.clear();
+          for (TControllerIdentifier controllerIdentifier = 0;
+               controllerIdentifier < kPhysicalControllerCount;
+               ++controllerIdentifier)
+          {
+            auto& readCursor = readCursors[controllerIdentifier];
+            SPendingRecord pendingRecord;
+
+            while (true)
+            {
+              const auto expectedReadCursor = readCursor;
+              if (false == pendingRecords[controllerIdentifier].Read(readCursor, pendingRecord))
+                break;
+
+              lostRecordCount += (readCursor - 1 - expectedReadCursor);
+              queuedRecords.emplace_back(controllerIdentifier, pendingRecord);
+            }
+          }
+
+          std::stable_sort(
+              queuedRecords.begin(),
+              queuedRecords.end(),
+              [](const auto& recordA, const auto& recordB) -> bool
+              {
+                return (recordA.second.timestampMicroseconds <
+                        recordB.second.timestampMicroseconds);
+              });
+
+          for (const auto& queuedRecord : queuedRecords)
+            encoder.EncodeRecord(
+                queuedRecord.first,
+                queuedRecord.second.timestampMicroseconds,
+                queuedRecord.second.physicalState,
+                buffer);
+
+          if (false == buffer.empty())
+          {
+            DWORD numBytesWritten = 0;
+            WriteFile(fileHandle, buffer.data(), (DWORD)buffer.size(), &numBytesWritten, nullptr);
+            buffer.clear();
+          }
+
+          if (0 != lostRecordCount)
+          {
+            Infra::Message::OutputFormatted(
+                Infra::Message::ESeverity::Warning,
+                L"Physical controller recording lost %llu states because they were recorded faster than they could be written.",
+                (unsigned long long)lostRecordCount);
+            lostRecordCount = 0;
+          }
+
+          if (true == stopRequested) break;
+
+          std::unique_lock lock(writerMutex);
+          writerWakeup.wait_for(
+              lock,
+              stopToken,
+              std::chrono::milliseconds(kRecorderFlushPeriodMilliseconds),
+              []() -> bool
+              {
+                return false;
+              });
+        }
+      }
+
+      double SReplayResult::SamplesPerSecond(void) const
+      {
+        if (elapsedTime <= std::chrono::nanoseconds::zero()) return 0.0;
+        return (double)sampleCount / std::chrono::duration<double>(elapsedTime).count();
+      }
+
+      SReplayResult Replay(
+          const ReplayPhysicalControllerSource::TRecording& recording,
+          const Mapper& mapper,
+          ReplayPhysicalControllerSource::ESpeed speed)
+      {
+        ReplayPhysicalControllerSource replaySource(
+            ReplayPhysicalControllerSource::TRecording(recording), speed);
+        SReplayResult result = {};
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        std::array<std::thread, kPhysicalControllerCount> replayThreads;
+
+        for (TControllerIdentifier controllerIdentifier = 0;
+             controllerIdentifier < kPhysicalControllerCount;
+             ++controllerIdentifier)
+        {
+          if (true == recording[controllerIdentifier].empty()) continue;
+
+          result.virtualStates[controllerIdentifier].reserve(
+              recording[controllerIdentifier].size());
+          replayThreads[controllerIdentifier] = std::thread(
+              [controllerIdentifier,
+               &replaySource,
+               &mapper,
+               &virtualStates = result.virtualStates[controllerIdentifier]]() -> void
+              {
+                MappingContext mappingContext(&mapper, (uint32_t)controllerIdentifier);
+
+                do
+                {
+                  PhysicalPacketFilter::TPacketNumber unusedPacketNumber = 0;
+                  const SPhysicalState physicalState =
+                      replaySource.ReadState(controllerIdentifier, unusedPacketNumber);
+
+                  virtualStates.push_back(
+                      (EPhysicalDeviceStatus::Ok == physicalState.deviceStatus)
+                          ? mappingContext.MapStatePhysicalToVirtual(physicalState)
+                          : mappingContext.MapNeutralPhysicalToVirtual());
+                }
+                while (true ==
+                       replaySource.WaitForNextSample(controllerIdentifier, std::stop_token()));
+              });
+        }
+
+        // Every thread runs until its physical controller's recording is finished.
+        for (auto& replayThread : replayThreads)
+        {
+          if (true == replayThread.joinable()) replayThread.join();
+        }
+
+        result.elapsedTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - startTime);
+        for (const auto& virtualStates : result.virtualStates)
+          result.sampleCount += virtualStates.size();
+
+        return result;
+      }
+    } // namespace Recording
+  } // namespace Controller
+} // namespace Xidi
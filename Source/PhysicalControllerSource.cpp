@@ -0,0 +1,397 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file PhysicalControllerSource.cpp
+ *   Implementation of all sources of physical controller data.
+ **************************************************************************************************/
+
+#include "PhysicalControllerSource.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "ApiWindows.h"
+#include "ControllerTypes.h"
+#include "ForceFeedbackTypes.h"
+#include "ImportApiXInput.h"
+#include "PhysicalPacketFilter.h"
+
+namespace Xidi
+{
+  namespace Controller
+  {
+    /// Sleeps until the specified point in time. Coarse sleeping is used for most of the wait and
+    /// the remainder is spent yielding, which allows deadlines to be met with much finer precision
+    /// than the system timer resolution allows.
+    /// @tparam ClockType Clock type of the deadline.
+    /// @param [in] deadline Point in time until which to sleep.
+    /// @param [in] stopToken Token that allows the sleep to be interrupted.
+    /// @return `true` if the deadline was reached, `false` if the sleep was interrupted.
+    template <typename ClockType> static bool SleepUntil(
+        typename ClockType::time_point deadline, std::stop_token stopToken)
+    {
+      constexpr auto kCoarseSleepMargin = std::chrono::milliseconds(2);
+      constexpr auto kCoarseSleepMaxDuration = std::chrono::milliseconds(10);
+
+      while (false == stopToken.stop_requested())
+      {
+        const auto remainingTime = deadline - ClockType::now();
+        if (remainingTime <= ClockType::duration::zero()) return true;
+
+        if (remainingTime > kCoarseSleepMargin)
+          std::this_thread::sleep_for(
+              std::min<typename ClockType::duration>(
+                  remainingTime - kCoarseSleepMargin, kCoarseSleepMaxDuration));
+        else
+          std::this_thread::yield();
+      }
+
+      return false;
+    }
+
+    /// Packs a physical actuator vibration vector into a single word.
+    /// @param [in] vibration Physical actuator vibration vector.
+    /// @return Packed representation.
+    static constexpr uint64_t PackVibration(ForceFeedback::SPhysicalActuatorComponents vibration)
+    {
+      return ((uint64_t)vibration.leftMotor) | ((uint64_t)vibration.rightMotor << 16) |
+          ((uint64_t)vibration.leftImpulseTrigger << 32) |
+          ((uint64_t)vibration.rightImpulseTrigger << 48);
+    }
+
+    /// Unpacks a physical actuator vibration vector from a single word.
+    /// @param [in] packedVibration Packed representation.
+    /// @return Physical actuator vibration vector.
+    static constexpr ForceFeedback::SPhysicalActuatorComponents UnpackVibration(
+        uint64_t packedVibration)
+    {
+      return {
+          .leftMotor = (ForceFeedback::TPhysicalActuatorValue)(packedVibration),
+          .rightMotor = (ForceFeedback::TPhysicalActuatorValue)(packedVibration >> 16),
+          .leftImpulseTrigger = (ForceFeedback::TPhysicalActuatorValue)(packedVibration >> 32),
+          .rightImpulseTrigger = (ForceFeedback::TPhysicalActuatorValue)(packedVibration >> 48)};
+    }
+
+    SPhysicalState XInputPhysicalControllerSource::ReadState(
+        TControllerIdentifier controllerIdentifier,
+        PhysicalPacketFilter::TPacketNumber& packetNumber)
+    {
+      constexpr uint16_t kUnusedButtonMask =
+          ~((uint16_t)((1u << (unsigned int)EPhysicalButton::UnusedGuide) |
+                       (1u << (unsigned int)EPhysicalButton::UnusedShare)));
+
+      XINPUT_STATE xinputState;
+      DWORD xinputGetStateResult =
+          ImportApiXInput::XInputGetState(controllerIdentifier, &xinputState);
+
+      switch (xinputGetStateResult)
+      {
+        case ERROR_SUCCESS:
+          packetNumber = (PhysicalPacketFilter::TPacketNumber)xinputState.dwPacketNumber;
+
+          // Directly using wButtons assumes that the bit layout is the same between the internal
+          // bitset and the XInput data structure. The static assertions below this function verify
+          // this assumption and will cause a compiler error if it is wrong.
+          return {
+              .deviceStatus = EPhysicalDeviceStatus::Ok,
+              .stick =
+                  {xinputState.Gamepad.sThumbLX,
+                   xinputState.Gamepad.sThumbLY,
+                   xinputState.Gamepad.sThumbRX,
+                   xinputState.Gamepad.sThumbRY},
+              .trigger = {xinputState.Gamepad.bLeftTrigger, xinputState.Gamepad.bRightTrigger},
+              .button = (uint16_t)(xinputState.Gamepad.wButtons & kUnusedButtonMask)};
+
+        case ERROR_DEVICE_NOT_CONNECTED:
+          return {.deviceStatus = EPhysicalDeviceStatus::NotConnected};
+
+        default:
+          return {.deviceStatus = EPhysicalDeviceStatus::Error};
+      }
+    }
+
+    static_assert(1u << (unsigned int)EPhysicalButton::DpadUp == XINPUT_GAMEPAD_DPAD_UP);
+    static_assert(1u << (unsigned int)EPhysicalButton::DpadDown == XINPUT_GAMEPAD_DPAD_DOWN);
+    static_assert(1u << (unsigned int)EPhysicalButton::DpadLeft == XINPUT_GAMEPAD_DPAD_LEFT);
+    static_assert(1u << (unsigned int)EPhysicalButton::DpadRight == XINPUT_GAMEPAD_DPAD_RIGHT);
+    static_assert(1u << (unsigned int)EPhysicalButton::Start == XINPUT_GAMEPAD_START);
+    static_assert(1u << (unsigned int)EPhysicalButton::Back == XINPUT_GAMEPAD_BACK);
+    static_assert(1u << (unsigned int)EPhysicalButton::LS == XINPUT_GAMEPAD_LEFT_THUMB);
+    static_assert(1u << (unsigned int)EPhysicalButton::RS == XINPUT_GAMEPAD_RIGHT_THUMB);
+    static_assert(1u << (unsigned int)EPhysicalButton::LB == XINPUT_GAMEPAD_LEFT_SHOULDER);
+    static_assert(1u << (unsigned int)EPhysicalButton::RB == XINPUT_GAMEPAD_RIGHT_SHOULDER);
+    static_assert(1u << (unsigned int)EPhysicalButton::A == XINPUT_GAMEPAD_A);
+    static_assert(1u << (unsigned int)EPhysicalButton::B == XINPUT_GAMEPAD_B);
+    static_assert(1u << (unsigned int)EPhysicalButton::X == XINPUT_GAMEPAD_X);
+    static_assert(1u << (unsigned int)EPhysicalButton::Y == XINPUT_GAMEPAD_Y);
+
+    bool XInputPhysicalControllerSource::WriteVibration(
+        TControllerIdentifier controllerIdentifier,
+        ForceFeedback::SPhysicalActuatorComponents vibration)
+    {
+      // Impulse triggers are ignored because the XInput API does not support them.
+      XINPUT_VIBRATION xinputVibration = {
+          .wLeftMotorSpeed = vibration.leftMotor, .wRightMotorSpeed = vibration.rightMotor};
+      return (
+          ERROR_SUCCESS ==
+          ImportApiXInput::XInputSetState((DWORD)controllerIdentifier, &xinputVibration));
+    }
+
+    SyntheticPhysicalControllerSource::SyntheticPhysicalControllerSource(void)
+        : SyntheticPhysicalControllerSource(SWaveformScript())
+    {}
+
+    SyntheticPhysicalControllerSource::SyntheticPhysicalControllerSource(
+        const SWaveformScript& script)
+        : kScript({.sampleRateHz =
+                       std::clamp(script.sampleRateHz, kSampleRateMinHz, kSampleRateMaxHz),
+                   .stickPeriod = std::max(script.stickPeriod, std::chrono::milliseconds(1)),
+                   .triggerPeriod = std::max(script.triggerPeriod, std::chrono::milliseconds(1)),
+                   .buttonPeriod = std::max(script.buttonPeriod, std::chrono::milliseconds(1))}),
+          kStartTime(TClock::now()),
+          sampleIndex(),
+          lastVibration()
+    {}
+
+    SPhysicalState SyntheticPhysicalControllerSource::StateAtSample(
+        const SWaveformScript& script,
+        TControllerIdentifier controllerIdentifier,
+        uint64_t sampleIndex)
+    {
+      const uint64_t sampleRateHz = std::max(script.sampleRateHz, kSampleRateMinHz);
+      const uint64_t stickPeriodMicroseconds =
+          std::max<uint64_t>(1, std::chrono::microseconds(script.stickPeriod).count());
+      const uint64_t triggerPeriodMicroseconds =
+          std::max<uint64_t>(2, std::chrono::microseconds(script.triggerPeriod).count());
+      const uint64_t buttonPeriodMicroseconds =
+          std::max<uint64_t>(1, std::chrono::microseconds(script.buttonPeriod).count());
+
+      // Each physical controller is offset by an equal fraction of each period so that no two
+      // physical controllers produce the same state at the same time.
+      const uint64_t elapsedMicroseconds = (sampleIndex * 1000000ull) / sampleRateHz;
+      const uint64_t stickTime = elapsedMicroseconds +
+          ((stickPeriodMicroseconds * controllerIdentifier) / kPhysicalControllerCount);
+      const uint64_t triggerTime = elapsedMicroseconds +
+          ((triggerPeriodMicroseconds * controllerIdentifier) / kPhysicalControllerCount);
+      const uint64_t buttonTime = elapsedMicroseconds +
+          ((buttonPeriodMicroseconds * controllerIdentifier) / kPhysicalControllerCount);
+
+      SPhysicalState state = {.deviceStatus = EPhysicalDeviceStatus::Ok};
+
+      // Left stick traces a circle counter-clockwise and right stick traces a circle clockwise.
+      const double stickAngle = (2.0 * std::numbers::pi) *
+          ((double)(stickTime % stickPeriodMicroseconds) / (double)stickPeriodMicroseconds);
+      const int16_t stickCosine = (int16_t)std::lround(kAnalogValueMax * std::cos(stickAngle));
+      const int16_t stickSine = (int16_t)std::lround(kAnalogValueMax * std::sin(stickAngle));
+      state[EPhysicalStick::LeftX] = stickCosine;
+      state[EPhysicalStick::LeftY] = stickSine;
+      state[EPhysicalStick::RightX] = stickCosine;
+      state[EPhysicalStick::RightY] = -stickSine;
+
+      // Left trigger ramps up and then down and right trigger does the opposite.
+      const uint64_t triggerHalfPeriodMicroseconds = triggerPeriodMicroseconds / 2;
+      const uint64_t triggerPosition = triggerTime % triggerPeriodMicroseconds;
+      const uint64_t triggerRampPosition = std::min(
+          ((triggerPosition < triggerHalfPeriodMicroseconds)
+               ? triggerPosition
+               : (triggerPeriodMicroseconds - triggerPosition)),
+          triggerHalfPeriodMicroseconds);
+      const uint8_t triggerValue =
+          (uint8_t)((triggerRampPosition * kTriggerValueMax) / triggerHalfPeriodMicroseconds);
+      state[EPhysicalTrigger::LT] = triggerValue;
+      state[EPhysicalTrigger::RT] = (uint8_t)(kTriggerValueMax - triggerValue);
+
+      // Each button toggles at a different period, so over time every combination of buttons is
+      // eventually produced. Unused buttons are never pressed.
+      uint64_t buttonToggleMultiplier = 1;
+      for (int i = 0; i < static_cast<int>(EPhysicalButton::Count); ++i)
+      {
+        const EPhysicalButton button = static_cast<EPhysicalButton>(i);
+        if ((EPhysicalButton::UnusedGuide == button) || (EPhysicalButton::UnusedShare == button))
+          continue;
+
+        const uint64_t buttonTogglePeriodMicroseconds =
+            buttonPeriodMicroseconds * buttonToggleMultiplier;
+        state.button[i] = (0 != ((buttonTime / buttonTogglePeriodMicroseconds) % 2));
+        buttonToggleMultiplier += 1;
+      }
+
+      return state;
+    }
+
+    ForceFeedback::SPhysicalActuatorComponents SyntheticPhysicalControllerSource::
+        GetLastVibration(TControllerIdentifier controllerIdentifier) const
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return {};
+      return UnpackVibration(lastVibration[controllerIdentifier].load(std::memory_order_relaxed));
+    }
+
+    uint64_t SyntheticPhysicalControllerSource::GetSampleIndex(
+        TControllerIdentifier controllerIdentifier) const
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return 0;
+      return sampleIndex[controllerIdentifier].load(std::memory_order_relaxed);
+    }
+
+    SPhysicalState SyntheticPhysicalControllerSource::ReadState(
+        TControllerIdentifier controllerIdentifier,
+        PhysicalPacketFilter::TPacketNumber& packetNumber)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount)
+        return {.deviceStatus = EPhysicalDeviceStatus::NotConnected};
+
+      const uint64_t currentSampleIndex =
+          sampleIndex[controllerIdentifier].load(std::memory_order_relaxed);
+
+      packetNumber = (PhysicalPacketFilter::TPacketNumber)currentSampleIndex;
+      return StateAtSample(kScript, controllerIdentifier, currentSampleIndex);
+    }
+
+    bool SyntheticPhysicalControllerSource::SupportsWaitForNextSample(void) const
+    {
+      return true;
+    }
+
+    bool SyntheticPhysicalControllerSource::WaitForNextSample(
+        TControllerIdentifier controllerIdentifier, std::stop_token stopToken)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return false;
+
+      // Samples are paced relative to the start time rather than to each other, so a consumer
+      // that falls behind catches up without sleeping rather than drifting further behind.
+      const uint64_t nextSampleIndex =
+          sampleIndex[controllerIdentifier].load(std::memory_order_relaxed) + 1;
+      const TClock::time_point nextSampleTime = kStartTime +
+          std::chrono::duration_cast<TClock::duration>(
+              std::chrono::duration<double>((double)nextSampleIndex / kScript.sampleRateHz));
+
+      if (false == SleepUntil<TClock>(nextSampleTime, stopToken)) return false;
+
+      sampleIndex[controllerIdentifier].store(nextSampleIndex, std::memory_order_relaxed);
+      return true;
+    }
+
+    bool SyntheticPhysicalControllerSource::WriteVibration(
+        TControllerIdentifier controllerIdentifier,
+        ForceFeedback::SPhysicalActuatorComponents vibration)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return false;
+
+      lastVibration[controllerIdentifier].store(
+          PackVibration(vibration), std::memory_order_relaxed);
+      return true;
+    }
+
+    /// Determines the earliest timestamp across all physical controllers in a recording.
+    /// @param [in] recording Recording to check.
+    /// @return Earliest timestamp, in microseconds, or 0 if the recording is empty.
+    static uint64_t EarliestRecordedTimestamp(
+        const ReplayPhysicalControllerSource::TRecording& recording)
+    {
+      bool foundAnySample = false;
+      uint64_t earliestTimestamp = 0;
+
+      for (const auto& controllerSamples : recording)
+      {
+        if (true == controllerSamples.empty()) continue;
+
+        if ((false == foundAnySample) ||
+            (controllerSamples.front().timestampMicroseconds < earliestTimestamp))
+          earliestTimestamp = controllerSamples.front().timestampMicroseconds;
+
+        foundAnySample = true;
+      }
+
+      return earliestTimestamp;
+    }
+
+    ReplayPhysicalControllerSource::ReplayPhysicalControllerSource(
+        TRecording&& recording, ESpeed speed)
+        : kRecording(std::move(recording)),
+          kSpeed(speed),
+          kStartTime(TClock::now()),
+          kStartTimestampMicroseconds(EarliestRecordedTimestamp(kRecording)),
+          sampleIndex(),
+          finished()
+    {
+      for (TControllerIdentifier i = 0; i < kPhysicalControllerCount; ++i)
+        finished[i].store(kRecording[i].empty(), std::memory_order_relaxed);
+    }
+
+    bool ReplayPhysicalControllerSource::IsFinished(
+        TControllerIdentifier controllerIdentifier) const
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return true;
+      return finished[controllerIdentifier].load(std::memory_order_acquire);
+    }
+
+    SPhysicalState ReplayPhysicalControllerSource::ReadState(
+        TControllerIdentifier controllerIdentifier,
+        PhysicalPacketFilter::TPacketNumber& packetNumber)
+    {
+      if ((controllerIdentifier >= kPhysicalControllerCount) ||
+          (true == kRecording[controllerIdentifier].empty()))
+        return {.deviceStatus = EPhysicalDeviceStatus::NotConnected};
+
+      const size_t currentSampleIndex =
+          sampleIndex[controllerIdentifier].load(std::memory_order_relaxed);
+
+      packetNumber = (PhysicalPacketFilter::TPacketNumber)currentSampleIndex;
+      return kRecording[controllerIdentifier][currentSampleIndex].physicalState;
+    }
+
+    bool ReplayPhysicalControllerSource::SupportsWaitForNextSample(void) const
+    {
+      return true;
+    }
+
+    bool ReplayPhysicalControllerSource::WaitForNextSample(
+        TControllerIdentifier controllerIdentifier, std::stop_token stopToken)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount) return false;
+      if (true == stopToken.stop_requested()) return false;
+
+      const size_t nextSampleIndex =
+          sampleIndex[controllerIdentifier].load(std::memory_order_relaxed) + 1;
+      if (nextSampleIndex >= kRecording[controllerIdentifier].size())
+      {
+        finished[controllerIdentifier].store(true, std::memory_order_release);
+        return false;
+      }
+
+      if (ESpeed::Original == kSpeed)
+      {
+        const uint64_t nextSampleOffsetMicroseconds =
+            kRecording[controllerIdentifier][nextSampleIndex].timestampMicroseconds -
+            std::min(
+                kStartTimestampMicroseconds,
+                kRecording[controllerIdentifier][nextSampleIndex].timestampMicroseconds);
+        const TClock::time_point nextSampleTime = kStartTime +
+            std::chrono::duration_cast<TClock::duration>(
+                std::chrono::microseconds(nextSampleOffsetMicroseconds));
+
+        if (false == SleepUntil<TClock>(nextSampleTime, stopToken)) return false;
+      }
+
+      sampleIndex[controllerIdentifier].store(nextSampleIndex, std::memory_order_relaxed);
+      return true;
+    }
+
+    bool ReplayPhysicalControllerSource::WriteVibration(
+        TControllerIdentifier controllerIdentifier,
+        ForceFeedback::SPhysicalActuatorComponents vibration)
+    {
+      return (controllerIdentifier < kPhysicalControllerCount);
+    }
+  } // namespace Controller
+} // namespace Xidi
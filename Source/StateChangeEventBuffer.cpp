@@ -11,56 +11,105 @@
 
 #include "StateChangeEventBuffer.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <memory>
+#include <span>
 
-#include <boost/circular_buffer.hpp>
-
-#include "ApiWindows.h"
 #include "ControllerTypes.h"
 
 namespace Xidi
 {
   namespace Controller
   {
-    /// Handles a possible buffer overflow condition.
-    /// @param [in] eventBuffer Event buffer object for which to check for overflow.
-    /// @return `true` if the event buffer overflowed, `false` otherwise.
-    static inline bool HandlePossibleOverflow(
-        boost::circular_buffer<StateChangeEventBuffer::SEvent>& eventBuffer)
+    /// Sequence number to assign to the next event appended to any event buffer. Sequence numbers
+    /// are globally ordered with respect to all controller events, even those from other event
+    /// buffers.
+    static std::atomic<uint32_t> nextSequence = 0;
+
+    void StateChangeEventBuffer::AppendEvent(SEventData eventData, uint32_t timestamp)
     {
-      // Per DirectInput documentation, we always need one free space in the buffer.
-      // This is how we ensure the number of events stored is always one less than capacity.
+      AppendEvents(std::span(&eventData, 1), timestamp);
+    }
 
-      const bool eventBufferWasFull = ((0 != eventBuffer.size()) && (true == eventBuffer.full()));
+    void StateChangeEventBuffer::AppendEvents(
+        std::span<const SEventData> eventData, uint32_t timestamp)
+    {
+      if ((true == eventData.empty()) || (false == IsEnabled())) return;
 
-      if (true == eventBufferWasFull) eventBuffer.pop_front();
+      // Reserving all of the sequence numbers at once keeps the events in this batch contiguous in
+      // the global sequence and avoids one atomic operation per event.
+      uint32_t sequence = nextSequence.fetch_add((uint32_t)eventData.size());
 
-      return eventBufferWasFull;
-    }
+      const uint32_t maxCount = GetMaxCount();
+      uint64_t next = nextPosition.load(std::memory_order_relaxed);
 
-    void StateChangeEventBuffer::AppendEvent(SEventData eventData, uint32_t timestamp)
-    {
-      // Sequence number is globally ordered with respect to all controller events, even those from
-      // other event buffers.
-      static std::atomic<uint32_t> nextSequence = 0;
+      for (const auto& eventDataItem : eventData)
+      {
+        // Per DirectInput documentation, we always need one free space in the buffer. A capacity
+        // of 1 therefore means no events can be stored at all, so every event is discarded.
+        if (0 == maxCount)
+        {
+          oldestPosition.fetch_or(kOverflowFlag, std::memory_order_acq_rel);
+          sequence += 1;
+          continue;
+        }
 
-      eventBuffer.push_back(
-          {.data = eventData, .timestamp = timestamp, .sequence = nextSequence++});
+        // If there is no room for another event, the oldest event is discarded before its slot can
+        // be reused. The consumer might be removing events at the same time, in which case there
+        // might turn out to be room after all. Events already appended from this batch are
+        // published first, since otherwise the oldest position could move past the published next
+        // position whenever a batch holds more events than fit.
+        uint64_t oldestWord = oldestPosition.load(std::memory_order_acquire);
+        if ((next - PositionFromWord(oldestWord)) >= maxCount)
+        {
+          nextPosition.store(next, std::memory_order_release);
 
-      eventBufferOverflowed = HandlePossibleOverflow(eventBuffer);
+          while ((next - PositionFromWord(oldestWord)) >= maxCount)
+          {
+            if (true ==
+                oldestPosition.compare_exchange_weak(
+                    oldestWord,
+                    ((PositionFromWord(oldestWord) + 1) | kOverflowFlag),
+                    std::memory_order_acq_rel,
+                    std::memory_order_acquire))
+              break;
+          }
+        }
+
+        StoreSlot(
+            slots[next % eventBufferCapacity],
+            {.data = eventDataItem, .timestamp = timestamp, .sequence = sequence++});
+        next += 1;
+      }
+
+      nextPosition.store(next, std::memory_order_release);
     }
 
-    void StateChangeEventBuffer::PopOldestEvents(uint32_t numEventsToPop)
+    bool StateChangeEventBuffer::PopOldestEvents(uint32_t numEventsToPop)
     {
       // Popping 0 events is a no-op.
-      if (numEventsToPop > 0)
+      if (0 == numEventsToPop) return false;
+
+      // The producer might be discarding the oldest events at the same time, in which case the
+      // number of events available to be removed needs to be determined again. Storing the new
+      // oldest position without the overflow flag clears any overflow condition present when
+      // the events were removed, but not one triggered afterwards.
+      uint64_t oldestWord = oldestPosition.load(std::memory_order_acquire);
+      while (true)
       {
-        for (uint32_t i = 0; (i < numEventsToPop) && (false == eventBuffer.empty()); ++i)
-          eventBuffer.pop_front();
+        const uint64_t oldest = PositionFromWord(oldestWord);
+        const uint64_t next = nextPosition.load(std::memory_order_acquire);
+        const uint64_t newOldest = oldest + std::min<uint64_t>(numEventsToPop, next - oldest);
 
-        eventBufferOverflowed = false;
+        if (true ==
+            oldestPosition.compare_exchange_weak(
+                oldestWord, newOldest, std::memory_order_acq_rel, std::memory_order_acquire))
+          break;
       }
+
+      return (0 != (oldestWord & kOverflowFlag));
     }
 
     void StateChangeEventBuffer::SetCapacity(uint32_t capacity)
@@ -70,8 +119,24 @@ namespace Xidi
       {
         const uint32_t newCapacity =
             ((capacity > kEventBufferCapacityMax) ? kEventBufferCapacityMax : capacity);
-        eventBuffer.rset_capacity(newCapacity);
-        eventBufferOverflowed = HandlePossibleOverflow(eventBuffer);
+        const uint32_t newMaxCount = ((0 == newCapacity) ? 0 : (newCapacity - 1));
+
+        // The most recent events are retained. If not all of them fit, then the oldest excess
+        // events are discarded and an overflow condition is triggered.
+        const uint32_t oldCount = GetCount();
+        const uint32_t newCount = std::min(oldCount, newMaxCount);
+
+        std::unique_ptr<SSlot[]> newSlots =
+            ((0 == newCapacity) ? nullptr : std::make_unique<SSlot[]>(newCapacity));
+        for (uint32_t i = 0; i < newCount; ++i)
+          StoreSlot(newSlots[i], (*this)[(oldCount - newCount) + i]);
+
+        slots = std::move(newSlots);
+        eventBufferCapacity = newCapacity;
+        oldestPosition.store(
+            (((0 != newCapacity) && (oldCount > newCount)) ? kOverflowFlag : 0),
+            std::memory_order_release);
+        nextPosition.store(newCount, std::memory_order_release);
       }
     }
   } // namespace Controller
@@ -0,0 +1,293 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file ConcurrencyWrapperTest.cpp
+ *   Unit tests for the concurrency-safe data wrapper.
+ **************************************************************************************************/
+
+#include "ConcurrencyWrapper.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include <Infra/Test/TestCase.h>
+
+namespace XidiTest
+{
+  using namespace ::Xidi;
+
+  /// Wrapped data type used for tests. Sized to match the largest type that is wrapped in practice.
+  /// Every write fills all of the values with the same number, so a read that observes anything
+  /// other than identical values indicates that it saw a partially-completed write.
+  struct STestData
+  {
+    std::array<uint32_t, 8> values;
+
+    constexpr bool operator==(const STestData& other) const = default;
+  };
+
+  /// Number of reader threads to use for stress tests.
+  static constexpr unsigned int kStressTestReaderCount = 8;
+
+  /// Number of writes the writer thread performs in stress tests.
+  static constexpr uint32_t kStressTestWriteCount = 200000;
+
+  /// Creates a test data object with all values set to the specified number.
+  /// @param [in] value Number to use for all values.
+  /// @return Test data object.
+  static constexpr STestData MakeTestData(uint32_t value)
+  {
+    STestData testData = {};
+    for (auto& testDataValue : testData.values)
+      testDataValue = value;
+    return testData;
+  }
+
+  // Verifies that newly-constructed wrappers hold value-initialized data and that data written can
+  // be read back.
+  TEST_CASE(ConcurrencyWrapper_GetAndSet)
+  {
+    ConcurrencyWrapper<STestData> wrapper;
+    TEST_ASSERT(MakeTestData(0) == wrapper.Get());
+
+    wrapper.Set(MakeTestData(1234));
+    TEST_ASSERT(MakeTestData(1234) == wrapper.Get());
+  }
+
+  // Verifies that updates are only performed if the new data actually differ from the old, and
+  // that the generation advances only when an update is performed.
+  TEST_CASE(ConcurrencyWrapper_UpdateOnlyIfDifferent)
+  {
+    ConcurrencyWrapper<STestData> wrapper;
+    const auto initialGeneration = wrapper.GetGeneration();
+
+    TEST_ASSERT(false == wrapper.Update(MakeTestData(0)));
+    TEST_ASSERT(initialGeneration == wrapper.GetGeneration());
+    TEST_ASSERT(true == wrapper.Update(MakeTestData(5)));
+    TEST_ASSERT(initialGeneration + 1 == wrapper.GetGeneration());
+    TEST_ASSERT(false == wrapper.Update(MakeTestData(5)));
+    TEST_ASSERT(initialGeneration + 1 == wrapper.GetGeneration());
+
+    ConcurrencyWrapper<STestData>::TGeneration readGeneration = 0;
+    TEST_ASSERT(MakeTestData(5) == wrapper.Get(readGeneration));
+    TEST_ASSERT(initialGeneration + 1 == readGeneration);
+  }
+
+  // Verifies that updates compare data by value, such that data that are equal but differ in the
+  // contents of their padding bytes are not considered different.
+  TEST_CASE(ConcurrencyWrapper_UpdateIgnoresPadding)
+  {
+    struct SPaddedTestData
+    {
+      uint8_t smallValue;
+      uint32_t largeValue;
+
+      constexpr bool operator==(const SPaddedTestData& other) const = default;
+    };
+
+    static_assert(
+        sizeof(SPaddedTestData) > (sizeof(uint8_t) + sizeof(uint32_t)),
+        "Test data type must contain padding.");
+
+    SPaddedTestData testData;
+    std::memset(&testData, 0xff, sizeof(testData));
+    testData.smallValue = 1;
+    testData.largeValue = 2;
+
+    ConcurrencyWrapper<SPaddedTestData> wrapper;
+    TEST_ASSERT(true == wrapper.Update(testData));
+
+    const ConcurrencyWrapper<SPaddedTestData>::TGeneration generationBeforeUpdate =
+        wrapper.GetGeneration();
+    std::memset(&testData, 0x00, sizeof(testData));
+    testData.smallValue = 1;
+    testData.largeValue = 2;
+
+    TEST_ASSERT(false == wrapper.Update(testData));
+    TEST_ASSERT(generationBeforeUpdate == wrapper.GetGeneration());
+    TEST_ASSERT(testData == wrapper.Get());
+  }
+
+  // Verifies that waiting for an update returns immediately if the caller's last-known generation
+  // is already stale.
+  TEST_CASE(ConcurrencyWrapper_WaitForUpdateAlreadyStale)
+  {
+    ConcurrencyWrapper<STestData> wrapper;
+    auto lastKnownGeneration = wrapper.GetGeneration();
+    wrapper.Update(MakeTestData(10));
+
+    STestData updatedData = MakeTestData(0);
+    TEST_ASSERT(true == wrapper.WaitForUpdate(lastKnownGeneration, updatedData, std::stop_token()));
+    TEST_ASSERT(MakeTestData(10) == updatedData);
+    TEST_ASSERT(wrapper.GetGeneration() == lastKnownGeneration);
+  }
+
+  // Verifies that updates which restore previously-seen data still wake waiting threads. Staleness
+  // is identified by generation, so a waiter does not miss a change just because the data happen
+  // to match what it saw last.
+  TEST_CASE(ConcurrencyWrapper_WaitForUpdateRestoredData)
+  {
+    ConcurrencyWrapper<STestData> wrapper;
+    auto lastKnownGeneration = wrapper.GetGeneration();
+    wrapper.Update(MakeTestData(20));
+    wrapper.Update(MakeTestData(0));
+
+    STestData updatedData = MakeTestData(99);
+    TEST_ASSERT(true == wrapper.WaitForUpdate(lastKnownGeneration, updatedData, std::stop_token()));
+    TEST_ASSERT(MakeTestData(0) == updatedData);
+  }
+
+  // Verifies that a stop request interrupts a wait that would otherwise block forever.
+  TEST_CASE(ConcurrencyWrapper_WaitForUpdateInterrupted)
+  {
+    ConcurrencyWrapper<STestData> wrapper;
+    std::stop_source stopSource;
+
+    std::atomic<bool> waitResult = true;
+    std::thread waiterThread(
+        [&wrapper, &waitResult, stopToken = stopSource.get_token()]() -> void
+        {
+          auto lastKnownGeneration = wrapper.GetGeneration();
+          STestData updatedData = MakeTestData(0);
+          waitResult = wrapper.WaitForUpdate(lastKnownGeneration, updatedData, stopToken);
+        });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    stopSource.request_stop();
+    waiterThread.join();
+
+    TEST_ASSERT(false == waitResult);
+  }
+
+  // Verifies that interrupting one waiting thread does not cause any other waiting thread to return
+  // early. Other waiting threads may be woken up internally, but they should keep waiting until the
+  // data are actually updated.
+  TEST_CASE(ConcurrencyWrapper_WaitForUpdateInterruptOneOfMany)
+  {
+    ConcurrencyWrapper<STestData> wrapper;
+    std::stop_source stopSource;
+
+    std::atomic<bool> interruptedWaitResult = true;
+    std::thread interruptedWaiterThread(
+        [&wrapper, &interruptedWaitResult, stopToken = stopSource.get_token()]() -> void
+        {
+          auto lastKnownGeneration = wrapper.GetGeneration();
+          STestData updatedData = MakeTestData(0);
+          interruptedWaitResult =
+              wrapper.WaitForUpdate(lastKnownGeneration, updatedData, stopToken);
+        });
+
+    std::atomic<bool> uninterruptedWaitFinished = false;
+    STestData uninterruptedUpdatedData = MakeTestData(0);
+    std::thread uninterruptedWaiterThread(
+        [&wrapper, &uninterruptedWaitFinished, &uninterruptedUpdatedData]() -> void
+        {
+          auto lastKnownGeneration = wrapper.GetGeneration();
+          wrapper.WaitForUpdate(lastKnownGeneration, uninterruptedUpdatedData, std::stop_token());
+          uninterruptedWaitFinished = true;
+        });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    stopSource.request_stop();
+    interruptedWaiterThread.join();
+    TEST_ASSERT(false == interruptedWaitResult);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    TEST_ASSERT(false == uninterruptedWaitFinished);
+
+    wrapper.Update(MakeTestData(77));
+    uninterruptedWaiterThread.join();
+    TEST_ASSERT(MakeTestData(77) == uninterruptedUpdatedData);
+  }
+
+  // Verifies that many concurrent readers never observe a partially-completed write while a single
+  // writer continuously updates the wrapped data. Also verifies that readers never observe data
+  // going backwards, since each write uses a larger value than the one before it.
+  TEST_CASE(ConcurrencyWrapper_StressGet)
+  {
+    ConcurrencyWrapper<STestData> wrapper;
+    std::atomic<bool> writerFinished = false;
+    std::atomic<unsigned int> inconsistentReadCount = 0;
+    std::atomic<unsigned int> backwardsReadCount = 0;
+
+    std::vector<std::thread> readerThreads;
+    for (unsigned int i = 0; i < kStressTestReaderCount; ++i)
+    {
+      readerThreads.emplace_back(
+          [&wrapper, &writerFinished, &inconsistentReadCount, &backwardsReadCount]() -> void
+          {
+            uint32_t lastValueSeen = 0;
+
+            while (false == writerFinished)
+            {
+              const STestData readData = wrapper.Get();
+              if (MakeTestData(readData.values[0]) != readData) inconsistentReadCount += 1;
+              if (readData.values[0] < lastValueSeen) backwardsReadCount += 1;
+
+              lastValueSeen = readData.values[0];
+            }
+          });
+    }
+
+    for (uint32_t i = 1; i <= kStressTestWriteCount; ++i)
+      wrapper.Update(MakeTestData(i));
+
+    writerFinished = true;
+    for (auto& readerThread : readerThreads)
+      readerThread.join();
+
+    TEST_ASSERT(0 == inconsistentReadCount);
+    TEST_ASSERT(0 == backwardsReadCount);
+    TEST_ASSERT(MakeTestData(kStressTestWriteCount) == wrapper.Get());
+  }
+
+  // Verifies that many concurrent waiters are all woken up by updates, always receive consistent
+  // data, and eventually all observe the final value written. Waiters may skip intermediate values
+  // if multiple updates happen between successive waits, but they must never miss the last one.
+  TEST_CASE(ConcurrencyWrapper_StressWaitForUpdate)
+  {
+    ConcurrencyWrapper<STestData> wrapper;
+    std::atomic<unsigned int> inconsistentReadCount = 0;
+    std::atomic<unsigned int> waitFailureCount = 0;
+
+    std::vector<std::thread> waiterThreads;
+    for (unsigned int i = 0; i < kStressTestReaderCount; ++i)
+    {
+      waiterThreads.emplace_back(
+          [&wrapper, &inconsistentReadCount, &waitFailureCount]() -> void
+          {
+            ConcurrencyWrapper<STestData>::TGeneration lastKnownGeneration = 0;
+            STestData lastKnownData = MakeTestData(0);
+
+            while (MakeTestData(kStressTestWriteCount) != lastKnownData)
+            {
+              if (false ==
+                  wrapper.WaitForUpdate(lastKnownGeneration, lastKnownData, std::stop_token()))
+                waitFailureCount += 1;
+
+              if (MakeTestData(lastKnownData.values[0]) != lastKnownData)
+                inconsistentReadCount += 1;
+            }
+          });
+    }
+
+    for (uint32_t i = 1; i <= kStressTestWriteCount; ++i)
+      wrapper.Update(MakeTestData(i));
+
+    for (auto& waiterThread : waiterThreads)
+      waiterThread.join();
+
+    TEST_ASSERT(0 == inconsistentReadCount);
+    TEST_ASSERT(0 == waitFailureCount);
+  }
+} // namespace XidiTest
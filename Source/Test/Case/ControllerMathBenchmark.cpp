@@ -0,0 +1,125 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file ControllerMathBenchmark.cpp
+ *   Benchmarks comparing precomputed internal math against the equivalent arithmetic. These
+ *   report timing rather than checking it, so they are only built when XIDI_TEST_BENCHMARK is
+ *   defined and are otherwise excluded from the test suite.
+ **************************************************************************************************/
+
+#ifdef XIDI_TEST_BENCHMARK
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+#include <Infra/Test/TestCase.h>
+
+#include "ControllerMath.h"
+
+namespace XidiTest
+{
+  using namespace ::Xidi::Controller::Math;
+
+  // Compares the time taken to transform raw analog values using a lookup table against the time
+  // taken using the arithmetic transformation. Both are given every possible raw analog value
+  // several times over.
+  TEST_CASE(ControllerMathBenchmark_AnalogTransformTable)
+  {
+    constexpr unsigned int kDeadzonePercent = 25;
+    constexpr unsigned int kSaturationPercent = 75;
+    constexpr int kPassCount = 64;
+    constexpr double kTransformCount = (double)kPassCount * (double)(1 + UINT16_MAX);
+
+    const auto table =
+        std::make_unique<RawAnalogTransformTable>(kDeadzonePercent, kSaturationPercent);
+
+    int64_t arithmeticChecksum = 0;
+    const auto arithmeticStartTime = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < kPassCount; ++pass)
+    {
+      for (int32_t rawInput = INT16_MIN; rawInput <= INT16_MAX; ++rawInput)
+        arithmeticChecksum +=
+            ApplyRawAnalogTransform((int16_t)rawInput, kDeadzonePercent, kSaturationPercent);
+    }
+    const std::chrono::duration<double, std::nano> arithmeticElapsedTime =
+        std::chrono::steady_clock::now() - arithmeticStartTime;
+
+    int64_t tableChecksum = 0;
+    const auto tableStartTime = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < kPassCount; ++pass)
+    {
+      for (int32_t rawInput = INT16_MIN; rawInput <= INT16_MAX; ++rawInput)
+        tableChecksum += table->Apply((int16_t)rawInput);
+    }
+    const std::chrono::duration<double, std::nano> tableElapsedTime =
+        std::chrono::steady_clock::now() - tableStartTime;
+
+    Infra::Test::PrintFormatted(
+        L"Analog transform: %.2f ns per value using arithmetic, %.2f ns per value using a lookup "
+        L"table.",
+        arithmeticElapsedTime.count() / kTransformCount,
+        tableElapsedTime.count() / kTransformCount);
+
+    TEST_ASSERT(arithmeticChecksum == tableChecksum);
+  }
+
+  // Compares the time taken to apply the circle-to-square correction using the precomputed
+  // transformation against the time taken using the arithmetic transformation.
+  TEST_CASE(ControllerMathBenchmark_CircleToSquareTransform)
+  {
+    constexpr double kAmountFraction = 0.5;
+    constexpr int32_t kStep = 17;
+
+    const CircleToSquareTransform transform(kAmountFraction);
+
+    double transformCount = 0.0;
+    int64_t arithmeticChecksum = 0;
+    const auto arithmeticStartTime = std::chrono::steady_clock::now();
+    for (int32_t x = INT16_MIN; x <= INT16_MAX; x += kStep)
+    {
+      for (int32_t y = INT16_MIN; y <= INT16_MAX; y += kStep)
+      {
+        const SAnalogStickCoordinates outputCoords =
+            TransformCoordinatesCircleToSquare({.x = (int16_t)x, .y = (int16_t)y}, kAmountFraction);
+        arithmeticChecksum += outputCoords.x + outputCoords.y;
+        transformCount += 1.0;
+      }
+    }
+    const std::chrono::duration<double, std::nano> arithmeticElapsedTime =
+        std::chrono::steady_clock::now() - arithmeticStartTime;
+
+    int64_t precomputedChecksum = 0;
+    const auto precomputedStartTime = std::chrono::steady_clock::now();
+    for (int32_t x = INT16_MIN; x <= INT16_MAX; x += kStep)
+    {
+      for (int32_t y = INT16_MIN; y <= INT16_MAX; y += kStep)
+      {
+        const SAnalogStickCoordinates outputCoords =
+            transform.Apply({.x = (int16_t)x, .y = (int16_t)y});
+        precomputedChecksum += outputCoords.x + outputCoords.y;
+      }
+    }
+    const std::chrono::duration<double, std::nano> precomputedElapsedTime =
+        std::chrono::steady_clock::now() - precomputedStartTime;
+
+    Infra::Test::PrintFormatted(
+        L"Circle-to-square transform: %.2f ns per pair using arithmetic, %.2f ns per pair "
+        L"precomputed.",
+        arithmeticElapsedTime.count() / transformCount,
+        precomputedElapsedTime.count() / transformCount);
+
+    // Each output coordinate can differ by at most one unit, so the checksums can differ by at
+    // most two units per pair of coordinates. Checking them also keeps the work from being
+    // optimized away.
+    TEST_ASSERT(
+        std::abs(arithmeticChecksum - precomputedChecksum) <= (int64_t)(2.0 * transformCount));
+  }
+} // namespace XidiTest
+
+#endif
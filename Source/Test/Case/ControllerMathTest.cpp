@@ -12,6 +12,12 @@
 #include "ControllerMath.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include <Infra/Test/TestCase.h>
 
@@ -246,6 +252,55 @@ namespace XidiTest
     }
   }
 
+  // Verifies that analog lookup tables produce exactly the same results as the arithmetic
+  // transformation for every possible raw analog value and a variety of transformation parameters.
+  TEST_CASE(ControllerMath_AnalogTransformTableMatchesArithmetic)
+  {
+    constexpr struct
+    {
+      unsigned int deadzonePercent;
+      unsigned int saturationPercent;
+    } kTestParameters[] = {{0, 100}, {50, 100}, {0, 50}, {25, 75}, {8, 92}};
+
+    for (const auto& testParameters : kTestParameters)
+    {
+      const auto table = std::make_unique<RawAnalogTransformTable>(
+          testParameters.deadzonePercent, testParameters.saturationPercent);
+
+      for (int32_t rawInput = INT16_MIN; rawInput <= INT16_MAX; ++rawInput)
+        TEST_ASSERT(
+            ApplyRawAnalogTransform(
+                (int16_t)rawInput,
+                testParameters.deadzonePercent,
+                testParameters.saturationPercent) == table->Apply((int16_t)rawInput));
+    }
+  }
+
+  // Verifies that trigger lookup tables produce exactly the same results as the arithmetic
+  // transformation for every possible raw trigger value and a variety of transformation
+  // parameters.
+  TEST_CASE(ControllerMath_TriggerTransformTableMatchesArithmetic)
+  {
+    constexpr struct
+    {
+      unsigned int deadzonePercent;
+      unsigned int saturationPercent;
+    } kTestParameters[] = {{0, 100}, {50, 100}, {0, 50}, {25, 75}, {8, 92}};
+
+    for (const auto& testParameters : kTestParameters)
+    {
+      const RawTriggerTransformTable table(
+          testParameters.deadzonePercent, testParameters.saturationPercent);
+
+      for (int32_t rawInput = 0; rawInput <= UINT8_MAX; ++rawInput)
+        TEST_ASSERT(
+            ApplyRawTriggerTransform(
+                (uint8_t)rawInput,
+                testParameters.deadzonePercent,
+                testParameters.saturationPercent) == table.Apply((uint8_t)rawInput));
+    }
+  }
+
   // Verifies that analog sticks are correctly identified as "pressed" as a digital button if
   // sufficiently pressed in the positive direction. Only checks extreme values to avoid enforcing a
   // specific threshold value requirement.
@@ -451,4 +506,131 @@ namespace XidiTest
     }
   }
 
+  // Computes the same result as the arithmetic circle-to-square transformation for non-positive
+  // coordinates in which the vertical magnitude does not exceed the horizontal one, using a square
+  // root instead of a general power for an amount of one half. This is much faster, which makes it
+  // practical to compare against every such pair of coordinates.
+  static SAnalogStickCoordinates ReferenceCircleToSquareOctant(
+      int32_t x, int32_t y, double amountFraction)
+  {
+    if (0 == x) return {.x = 0, .y = 0};
+
+    const double xCoord = (double)x;
+    const double yCoord = (double)y;
+    const double radius =
+        std::min((double)INT16_MAX, std::sqrt((xCoord * xCoord) + (yCoord * yCoord)));
+    const double multiplier = radius / -xCoord;
+    const double weightedMultiplier =
+        ((1.0 == amountFraction) ? multiplier : std::sqrt(multiplier));
+
+    return {
+        .x = (int16_t)(xCoord * weightedMultiplier), .y = (int16_t)(yCoord * weightedMultiplier)};
+  }
+
+  // Verifies that the precomputed circle-to-square transformation stays within one unit of the
+  // arithmetic transformation for every possible pair of analog stick coordinates. Both depend only
+  // on coordinate magnitudes, with signs restored afterwards, and both treat the two axes the same
+  // way. Checking every pair of non-positive coordinates in which the vertical magnitude does not
+  // exceed the horizontal one therefore covers the entire domain, including the extreme negative
+  // value that has no positive counterpart. The work is divided among all available processors.
+  TEST_CASE(ControllerMath_CircleToSquareTransform_MatchesArithmetic)
+  {
+    constexpr double kTestAmountFractions[] = {1.0, 0.5};
+
+    for (const auto amountFraction : kTestAmountFractions)
+    {
+      TEST_ASSERT(
+          ReferenceCircleToSquareOctant(-12345, -6789, amountFraction) ==
+          TransformCoordinatesCircleToSquare({.x = -12345, .y = -6789}, amountFraction));
+
+      const CircleToSquareTransform transform(amountFraction);
+
+      const int32_t workerCount = (int32_t)std::max(1u, std::thread::hardware_concurrency());
+      std::vector<int32_t> firstMismatchX(workerCount, 1);
+      std::vector<int32_t> firstMismatchY(workerCount, 1);
+      std::vector<std::thread> workers;
+
+      for (int32_t workerIndex = 0; workerIndex < workerCount; ++workerIndex)
+      {
+        workers.emplace_back(
+            [&, amountFraction, workerIndex]() -> void
+            {
+              for (int32_t x = INT16_MIN + workerIndex; x <= 0; x += workerCount)
+              {
+                for (int32_t y = x; y <= 0; ++y)
+                {
+                  const SAnalogStickCoordinates expectedOutputCoords =
+                      ReferenceCircleToSquareOctant(x, y, amountFraction);
+                  const SAnalogStickCoordinates actualOutputCoords =
+                      transform.Apply({.x = (int16_t)x, .y = (int16_t)y});
+
+                  if ((false == SufficientlyEqual(actualOutputCoords.x, expectedOutputCoords.x)) ||
+                      (false == SufficientlyEqual(actualOutputCoords.y, expectedOutputCoords.y)))
+                  {
+                    firstMismatchX[workerIndex] = x;
+                    firstMismatchY[workerIndex] = y;
+                    return;
+                  }
+                }
+              }
+            });
+      }
+
+      for (auto& worker : workers)
+        worker.join();
+
+      for (int32_t workerIndex = 0; workerIndex < workerCount; ++workerIndex)
+      {
+        if (firstMismatchX[workerIndex] > 0) continue;
+
+        const SAnalogStickCoordinates testCoords = {
+            .x = (int16_t)firstMismatchX[workerIndex], .y = (int16_t)firstMismatchY[workerIndex]};
+        const SAnalogStickCoordinates expectedOutputCoords =
+            ReferenceCircleToSquareOctant(testCoords.x, testCoords.y, amountFraction);
+        const SAnalogStickCoordinates actualOutputCoords = transform.Apply(testCoords);
+
+        TEST_FAILED_BECAUSE(
+            L"Amount %.2f, input (%d, %d): expected (%d, %d), got (%d, %d).",
+            amountFraction,
+            (int)testCoords.x,
+            (int)testCoords.y,
+            (int)expectedOutputCoords.x,
+            (int)expectedOutputCoords.y,
+            (int)actualOutputCoords.x,
+            (int)actualOutputCoords.y);
+      }
+    }
+  }
+
+  // Verifies that the precomputed circle-to-square transformation is symmetric with respect to the
+  // signs of the coordinates and to swapping the two axes. Together with the previous test, this
+  // shows agreement with the arithmetic transformation across the entire domain.
+  TEST_CASE(ControllerMath_CircleToSquareTransform_Symmetry)
+  {
+    constexpr double kAmountFraction = 0.5;
+    constexpr int32_t kStep = 61;
+
+    const CircleToSquareTransform transform(kAmountFraction);
+
+    for (int32_t x = INT16_MIN + 1; x <= INT16_MAX; x += kStep)
+    {
+      for (int32_t y = INT16_MIN + 1; y <= INT16_MAX; y += kStep)
+      {
+        const SAnalogStickCoordinates referenceOutputCoords =
+            transform.Apply({.x = (int16_t)-std::abs(x), .y = (int16_t)-std::abs(y)});
+        const int16_t expectedOutputX = (int16_t)((x < 0) ? referenceOutputCoords.x
+                                                          : -referenceOutputCoords.x);
+        const int16_t expectedOutputY = (int16_t)((y < 0) ? referenceOutputCoords.y
+                                                          : -referenceOutputCoords.y);
+
+        TEST_ASSERT(
+            (SAnalogStickCoordinates{.x = expectedOutputX, .y = expectedOutputY}) ==
+            transform.Apply({.x = (int16_t)x, .y = (int16_t)y}));
+        TEST_ASSERT(
+            (SAnalogStickCoordinates{.x = expectedOutputY, .y = expectedOutputX}) ==
+            transform.Apply({.x = (int16_t)y, .y = (int16_t)x}));
+      }
+    }
+  }
+
 } // namespace XidiTest
@@ -0,0 +1,146 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file ElementMapperArenaTest.cpp
+ *   Unit tests for allocating element mappers from arenas.
+ **************************************************************************************************/
+
+#include "ElementMapperArena.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <Infra/Test/TestCase.h>
+
+#include "ControllerTypes.h"
+#include "ElementMapper.h"
+#include "Mapper.h"
+
+namespace XidiTest
+{
+  using namespace ::Xidi::Controller;
+
+  // Verifies that element mappers created while an arena is active are allocated contiguously
+  // from that arena, and that element mappers created otherwise are not.
+  TEST_CASE(ElementMapperArena_Allocate_Nominal)
+  {
+    std::unique_ptr<IElementMapper> heapMapper = std::make_unique<ButtonMapper>(EButton::B1);
+
+    ElementMapperArena arena;
+    TEST_ASSERT(0 == arena.GetUsedBytes());
+
+    std::unique_ptr<IElementMapper> arenaMappers[] = {
+        std::make_unique<ButtonMapper>(EButton::B2),
+        std::make_unique<ButtonMapper>(EButton::B3),
+        std::make_unique<ButtonMapper>(EButton::B4)};
+
+    TEST_ASSERT(false == arena.Contains(heapMapper.get()));
+    for (const auto& arenaMapper : arenaMappers)
+      TEST_ASSERT(true == arena.Contains(arenaMapper.get()));
+
+    const size_t allocationSize = arena.GetUsedBytes() / _countof(arenaMappers);
+    TEST_ASSERT(allocationSize >= sizeof(ButtonMapper));
+
+    for (size_t i = 1; i < _countof(arenaMappers); ++i)
+    {
+      const uintptr_t previousAddress = reinterpret_cast<uintptr_t>(arenaMappers[i - 1].get());
+      const uintptr_t currentAddress = reinterpret_cast<uintptr_t>(arenaMappers[i].get());
+      TEST_ASSERT((currentAddress - previousAddress) == allocationSize);
+    }
+  }
+
+  // Verifies that element mappers created by cloning and by building mappers while an arena is
+  // active are allocated from that arena.
+  TEST_CASE(ElementMapperArena_Allocate_CloneAndMapper)
+  {
+    const SplitMapper heapMapper(
+        std::make_unique<ButtonMapper>(EButton::B5),
+        std::make_unique<InvertMapper>(std::make_unique<AxisMapper>(EAxis::Z)));
+
+    ElementMapperArena arena;
+
+    std::unique_ptr<IElementMapper> clonedMapper = heapMapper.Clone();
+    const SplitMapper* const clonedSplitMapper = dynamic_cast<SplitMapper*>(clonedMapper.get());
+    TEST_ASSERT(nullptr != clonedSplitMapper);
+    TEST_ASSERT(true == arena.Contains(clonedSplitMapper));
+    TEST_ASSERT(true == arena.Contains(clonedSplitMapper->GetPositiveMapper()));
+    TEST_ASSERT(true == arena.Contains(clonedSplitMapper->GetNegativeMapper()));
+
+    const Mapper mapper({.buttonA = std::make_unique<MouseSpeedModifierMapper>(54321)});
+    TEST_ASSERT(true == arena.Contains(mapper.ElementMap().named.buttonA.get()));
+  }
+
+  // Verifies that only the most recently created arena on a thread is active, that the previous
+  // arena becomes active again once it is destroyed, and that element mappers remain usable after
+  // the arena from which they were allocated is destroyed.
+  TEST_CASE(ElementMapperArena_Nested)
+  {
+    std::unique_ptr<IElementMapper> outerMapper;
+    std::unique_ptr<IElementMapper> innerMapper;
+    std::unique_ptr<IElementMapper> outerMapperAfterInner;
+
+    {
+      ElementMapperArena outerArena;
+      outerMapper = std::make_unique<ButtonMapper>(EButton::B6);
+
+      {
+        ElementMapperArena innerArena;
+        innerMapper = std::make_unique<ButtonMapper>(EButton::B7);
+        TEST_ASSERT(true == innerArena.Contains(innerMapper.get()));
+        TEST_ASSERT(false == outerArena.Contains(innerMapper.get()));
+      }
+
+      outerMapperAfterInner = std::make_unique<ButtonMapper>(EButton::B8);
+      TEST_ASSERT(true == outerArena.Contains(outerMapper.get()));
+      TEST_ASSERT(true == outerArena.Contains(outerMapperAfterInner.get()));
+    }
+
+    const std::optional<SElementIdentifier> kExpectedTargets[] = {
+        SElementIdentifier{.type = EElementType::Button, .button = EButton::B6},
+        SElementIdentifier{.type = EElementType::Button, .button = EButton::B7},
+        SElementIdentifier{.type = EElementType::Button, .button = EButton::B8}};
+
+    TEST_ASSERT(kExpectedTargets[0] == outerMapper->GetTargetElementAt(0));
+    TEST_ASSERT(kExpectedTargets[1] == innerMapper->GetTargetElementAt(0));
+    TEST_ASSERT(kExpectedTargets[2] == outerMapperAfterInner->GetTargetElementAt(0));
+  }
+
+  // Verifies that element mappers allocated from an arena can be destroyed on other threads, in
+  // any order, both before and after the arena object is destroyed.
+  TEST_CASE(ElementMapperArena_ConcurrentDeallocation)
+  {
+    constexpr unsigned int kThreadCount = 4;
+    constexpr unsigned int kMappersPerThread = 1000;
+
+    std::vector<std::vector<std::unique_ptr<IElementMapper>>> mappersPerThread(kThreadCount);
+
+    {
+      ElementMapperArena arena;
+
+      for (auto& mappers : mappersPerThread)
+      {
+        for (unsigned int i = 0; i < kMappersPerThread; ++i)
+          mappers.push_back(std::make_unique<AxisMapper>(EAxis::X));
+      }
+
+      TEST_ASSERT(
+          arena.GetUsedBytes() >= (kThreadCount * kMappersPerThread * sizeof(AxisMapper)));
+
+      mappersPerThread[0].clear();
+    }
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < kThreadCount; ++i)
+      threads.emplace_back([&mappers = mappersPerThread[i]]() -> void { mappers.clear(); });
+
+    for (auto& thread : threads)
+      thread.join();
+  }
+} // namespace XidiTest
@@ -0,0 +1,173 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file ElementMapperPoolTest.cpp
+ *   Unit tests for sharing structurally identical element mappers.
+ **************************************************************************************************/
+
+#include "ElementMapperPool.h"
+
+#include <memory>
+
+#include <Infra/Test/TestCase.h>
+
+#include "ControllerTypes.h"
+#include "ElementMapper.h"
+#include "Mapper.h"
+#include "MockElementMapper.h"
+
+namespace XidiTest
+{
+  using namespace ::Xidi::Controller;
+
+  // Verifies that structurally identical element mappers are shared and that element mappers
+  // that differ in any way, including in type alone, are not.
+  TEST_CASE(ElementMapperPool_Intern_Nominal)
+  {
+    const std::shared_ptr<const IElementMapper> internedMapper = ElementMapperPool::Intern(
+        std::make_shared<AxisMapper>(EAxis::RotX, EAxisDirection::Positive));
+
+    TEST_ASSERT(
+        internedMapper ==
+        ElementMapperPool::Intern(
+            std::make_shared<AxisMapper>(EAxis::RotX, EAxisDirection::Positive)));
+    TEST_ASSERT(
+        internedMapper !=
+        ElementMapperPool::Intern(
+            std::make_shared<AxisMapper>(EAxis::RotX, EAxisDirection::Negative)));
+    TEST_ASSERT(
+        internedMapper !=
+        ElementMapperPool::Intern(
+            std::make_shared<AxisMapper>(EAxis::RotY, EAxisDirection::Positive)));
+    TEST_ASSERT(
+        internedMapper !=
+        ElementMapperPool::Intern(
+            std::make_shared<DigitalAxisMapper>(EAxis::RotX, EAxisDirection::Positive)));
+  }
+
+  // Verifies that element mappers that contain underlying element mappers are shared if and only
+  // if all of their underlying element mappers are structurally identical.
+  TEST_CASE(ElementMapperPool_Intern_Underlying)
+  {
+    const std::shared_ptr<const IElementMapper> internedMapper = ElementMapperPool::Intern(
+        std::make_shared<SplitMapper>(
+            std::make_unique<ButtonMapper>(EButton::B5),
+            std::make_unique<InvertMapper>(std::make_unique<AxisMapper>(EAxis::Z))));
+
+    TEST_ASSERT(
+        internedMapper ==
+        ElementMapperPool::Intern(
+            std::make_shared<SplitMapper>(
+                std::make_unique<ButtonMapper>(EButton::B5),
+                std::make_unique<InvertMapper>(std::make_unique<AxisMapper>(EAxis::Z)))));
+    TEST_ASSERT(
+        internedMapper !=
+        ElementMapperPool::Intern(
+            std::make_shared<SplitMapper>(
+                std::make_unique<ButtonMapper>(EButton::B5),
+                std::make_unique<InvertMapper>(std::make_unique<AxisMapper>(EAxis::RotZ)))));
+    TEST_ASSERT(
+        internedMapper !=
+        ElementMapperPool::Intern(
+            std::make_shared<SplitMapper>(std::make_unique<ButtonMapper>(EButton::B5), nullptr)));
+  }
+
+  // Verifies that element mappers whose structures cannot be described are never shared.
+  TEST_CASE(ElementMapperPool_Intern_Undescribable)
+  {
+    const std::shared_ptr<const IElementMapper> mockMapper = std::make_shared<MockElementMapper>();
+    TEST_ASSERT(mockMapper == ElementMapperPool::Intern(mockMapper));
+    TEST_ASSERT(mockMapper != ElementMapperPool::Intern(std::make_shared<MockElementMapper>()));
+
+    const std::shared_ptr<const IElementMapper> invertMockMapper =
+        std::make_shared<InvertMapper>(std::make_unique<MockElementMapper>());
+    TEST_ASSERT(invertMockMapper == ElementMapperPool::Intern(invertMockMapper));
+    TEST_ASSERT(
+        invertMockMapper !=
+        ElementMapperPool::Intern(
+            std::make_shared<InvertMapper>(std::make_unique<MockElementMapper>())));
+  }
+
+  // Verifies that an interned element mapper is not kept alive by the pool and that a newly
+  // interned element mapper takes its place once it is destroyed.
+  TEST_CASE(ElementMapperPool_Intern_Expired)
+  {
+    std::weak_ptr<const IElementMapper> originalMapper =
+        ElementMapperPool::Intern(std::make_shared<KeyboardMapper>(0xfe));
+    TEST_ASSERT(true == originalMapper.expired());
+
+    const std::shared_ptr<const IElementMapper> replacementMapper =
+        std::make_shared<KeyboardMapper>(0xfe);
+    TEST_ASSERT(replacementMapper == ElementMapperPool::Intern(replacementMapper));
+  }
+
+  // Verifies that permanent element mappers are referenced without being owned and that they
+  // replace any structurally identical element mappers, whether interned before or afterwards.
+  TEST_CASE(ElementMapperPool_InternPermanent)
+  {
+    static const KeyboardMapper kPermanentMapper(0xfd);
+
+    const std::shared_ptr<const IElementMapper> internedBeforeMapper =
+        ElementMapperPool::Intern(std::make_shared<KeyboardMapper>(0xfd));
+
+    const std::shared_ptr<const IElementMapper> permanentMapper =
+        ElementMapperPool::InternPermanent(kPermanentMapper);
+    TEST_ASSERT(&kPermanentMapper == permanentMapper.get());
+    TEST_ASSERT(0 == permanentMapper.use_count());
+
+    TEST_ASSERT(
+        permanentMapper == ElementMapperPool::Intern(std::make_shared<KeyboardMapper>(0xfd)));
+    TEST_ASSERT(permanentMapper != internedBeforeMapper);
+  }
+
+  // Verifies that statistics account for each additional reference to an interned element mapper
+  // as memory saved.
+  TEST_CASE(ElementMapperPool_GetStatistics)
+  {
+    constexpr unsigned int kTestMouseSpeedScalingFactor = 12345;
+    const ElementMapperPool::SStatistics statisticsBefore = ElementMapperPool::GetStatistics();
+
+    const std::shared_ptr<const IElementMapper> internedMappers[] = {
+        ElementMapperPool::Intern(
+            std::make_shared<MouseSpeedModifierMapper>(kTestMouseSpeedScalingFactor)),
+        ElementMapperPool::Intern(
+            std::make_shared<MouseSpeedModifierMapper>(kTestMouseSpeedScalingFactor)),
+        ElementMapperPool::Intern(
+            std::make_shared<MouseSpeedModifierMapper>(kTestMouseSpeedScalingFactor))};
+
+    const ElementMapperPool::SStatistics statisticsAfter = ElementMapperPool::GetStatistics();
+    TEST_ASSERT(1 == (statisticsAfter.internedCount - statisticsBefore.internedCount));
+    TEST_ASSERT(3 == (statisticsAfter.referenceCount - statisticsBefore.referenceCount));
+    TEST_ASSERT(
+        (2 * sizeof(MouseSpeedModifierMapper)) ==
+        (statisticsAfter.bytesSaved - statisticsBefore.bytesSaved));
+  }
+
+  // Verifies that mappers share structurally identical element mappers, both with each other and
+  // with mappers created using them as templates.
+  TEST_CASE(ElementMapperPool_SharedAcrossMappers)
+  {
+    const Mapper mapperA(
+        {.stickLeftX = std::make_unique<AxisMapper>(EAxis::X),
+         .buttonA = std::make_unique<ButtonMapper>(EButton::B1)});
+    const Mapper mapperB(
+        {.stickLeftX = std::make_unique<AxisMapper>(EAxis::X),
+         .buttonA = std::make_unique<ButtonMapper>(EButton::B2)});
+
+    TEST_ASSERT(mapperA.ElementMap().named.stickLeftX == mapperB.ElementMap().named.stickLeftX);
+    TEST_ASSERT(mapperA.ElementMap().named.buttonA != mapperB.ElementMap().named.buttonA);
+
+    Mapper::UElementMap derivedElements = mapperA.CloneElementMap();
+    derivedElements.named.buttonB = std::make_unique<ButtonMapper>(EButton::B2);
+    const Mapper derivedMapper(std::move(derivedElements.named));
+
+    TEST_ASSERT(
+        mapperA.ElementMap().named.stickLeftX == derivedMapper.ElementMap().named.stickLeftX);
+    TEST_ASSERT(mapperA.ElementMap().named.buttonA == derivedMapper.ElementMap().named.buttonA);
+    TEST_ASSERT(mapperB.ElementMap().named.buttonA == derivedMapper.ElementMap().named.buttonB);
+  }
+} // namespace XidiTest
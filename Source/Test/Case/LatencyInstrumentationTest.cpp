@@ -0,0 +1,196 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file LatencyInstrumentationTest.cpp
+ *   Unit tests for input latency instrumentation.
+ **************************************************************************************************/
+
+#include "LatencyInstrumentation.h"
+
+#include <chrono>
+#include <cstdint>
+
+#include <Infra/Test/TestCase.h>
+
+namespace XidiTest
+{
+  using namespace ::Xidi::Controller;
+  using ::Xidi::Controller::Latency::EStage;
+  using ::Xidi::Controller::Latency::Histogram;
+
+  // Verifies that small values each get their own bucket and that every bucket's upper bound maps
+  // back to that same bucket, while the value just past the upper bound maps to the next bucket.
+  TEST_CASE(LatencyInstrumentation_Histogram_BucketBoundaries)
+  {
+    for (uint64_t value = 0; value < Histogram::kSubBucketCount; ++value)
+      TEST_ASSERT(value == Histogram::BucketIndexForValue(value));
+
+    for (unsigned int bucketIndex = 0; bucketIndex < Histogram::kBucketCount; ++bucketIndex)
+    {
+      const uint64_t upperBound = Histogram::BucketUpperBound(bucketIndex);
+      TEST_ASSERT(bucketIndex == Histogram::BucketIndexForValue(upperBound));
+
+      if ((bucketIndex + 1) < Histogram::kBucketCount)
+        TEST_ASSERT((bucketIndex + 1) == Histogram::BucketIndexForValue(upperBound + 1));
+    }
+
+    TEST_ASSERT(Histogram::kMaxValue == Histogram::BucketUpperBound(Histogram::kBucketCount - 1));
+  }
+
+  // Verifies that values beyond the representable range are clamped into the last bucket.
+  TEST_CASE(LatencyInstrumentation_Histogram_ClampLargeValues)
+  {
+    TEST_ASSERT(
+        (Histogram::kBucketCount - 1) == Histogram::BucketIndexForValue(Histogram::kMaxValue + 1));
+    TEST_ASSERT((Histogram::kBucketCount - 1) == Histogram::BucketIndexForValue(UINT64_MAX));
+  }
+
+  // Verifies that summary statistics computed from a known set of measurements are accurate to
+  // within the resolution of the histogram buckets.
+  TEST_CASE(LatencyInstrumentation_Histogram_Statistics)
+  {
+    Histogram histogram;
+
+    const Latency::SStatistics emptyStatistics = histogram.GetStatistics();
+    TEST_ASSERT(0 == emptyStatistics.count);
+    TEST_ASSERT(0 == emptyStatistics.max);
+
+    // 1 through 100 microseconds, one measurement each.
+    for (int64_t i = 1; i <= 100; ++i)
+      histogram.Record(std::chrono::microseconds(i));
+
+    const Latency::SStatistics statistics = histogram.GetStatistics();
+    TEST_ASSERT(100 == statistics.count);
+    TEST_ASSERT(100000 == statistics.max);
+
+    // Log-linear buckets with 8 sub-buckets have a relative error of at most 1/8.
+    TEST_ASSERT(statistics.p50 >= 50000);
+    TEST_ASSERT(statistics.p50 <= 50000 + (50000 / 8));
+    TEST_ASSERT(statistics.p99 >= 99000);
+    TEST_ASSERT(statistics.p99 <= statistics.max);
+
+    histogram.Reset();
+    TEST_ASSERT(0 == histogram.GetStatistics().count);
+  }
+
+  // Verifies that negative durations, which can only arise from clock anomalies, are recorded as
+  // zero rather than wrapping around to huge values.
+  TEST_CASE(LatencyInstrumentation_Histogram_NegativeDuration)
+  {
+    Histogram histogram;
+    histogram.Record(std::chrono::microseconds(-5));
+
+    const Latency::SStatistics statistics = histogram.GetStatistics();
+    TEST_ASSERT(1 == statistics.count);
+    TEST_ASSERT(0 == statistics.max);
+  }
+
+  // Verifies that the timestamps of a mapped sample are made available to virtual controllers and
+  // that each stage is recorded against the correct histogram.
+  TEST_CASE(LatencyInstrumentation_RecordStages)
+  {
+    constexpr TControllerIdentifier kTestControllerIdentifier = 2;
+
+    const Latency::TTimestamp baseTime = Latency::Now();
+    Latency::SSampleTimestamps timestamps = {
+        .physicalReadStart = baseTime,
+        .physicalReadEnd = baseTime + std::chrono::microseconds(100),
+        .mapped = baseTime + std::chrono::microseconds(110),
+        .publicationStart = baseTime + std::chrono::microseconds(110)};
+
+    Latency::SetEnabled(true);
+
+    const uint64_t physicalReadCountBefore =
+        Latency::GetStatistics(kTestControllerIdentifier, EStage::PhysicalRead).count;
+    const uint64_t totalCountBefore =
+        Latency::GetStatistics(kTestControllerIdentifier, EStage::Total).count;
+
+    Latency::RecordPhysicalSampleMapped(kTestControllerIdentifier, timestamps);
+    Latency::RecordPhysicalSamplePublicationStart(kTestControllerIdentifier, timestamps);
+    Latency::RecordPhysicalSamplePublished(
+        kTestControllerIdentifier, timestamps, baseTime + std::chrono::microseconds(120));
+
+    Latency::SSampleTimestamps publishedTimestamps =
+        Latency::GetPublishedSampleTimestamps(kTestControllerIdentifier);
+    TEST_ASSERT(publishedTimestamps.physicalReadEnd == timestamps.physicalReadEnd);
+    TEST_ASSERT(publishedTimestamps.publicationStart == timestamps.publicationStart);
+
+    publishedTimestamps.refreshed = baseTime + std::chrono::microseconds(200);
+    Latency::RecordVirtualRefresh(kTestControllerIdentifier, publishedTimestamps);
+    Latency::RecordApplicationDelivery(
+        kTestControllerIdentifier, publishedTimestamps, baseTime + std::chrono::microseconds(300));
+
+    Latency::SetEnabled(false);
+
+    TEST_ASSERT(
+        (physicalReadCountBefore + 1) ==
+        Latency::GetStatistics(kTestControllerIdentifier, EStage::PhysicalRead).count);
+    TEST_ASSERT(
+        (totalCountBefore + 1) ==
+        Latency::GetStatistics(kTestControllerIdentifier, EStage::Total).count);
+    TEST_ASSERT(
+        Latency::GetStatistics(kTestControllerIdentifier, EStage::Total).max >= 200000);
+  }
+
+  // Verifies that a mapped sample that is never published has its read and mapping stages
+  // recorded but does not replace the timestamps made available to virtual controllers.
+  TEST_CASE(LatencyInstrumentation_RecordMappedWithoutPublication)
+  {
+    constexpr TControllerIdentifier kTestControllerIdentifier = 1;
+
+    const Latency::TTimestamp baseTime = Latency::Now();
+    const Latency::SSampleTimestamps publishedTimestamps = {
+        .physicalReadStart = baseTime,
+        .physicalReadEnd = baseTime + std::chrono::microseconds(100),
+        .mapped = baseTime + std::chrono::microseconds(110),
+        .publicationStart = baseTime + std::chrono::microseconds(120)};
+    const Latency::SSampleTimestamps unpublishedTimestamps = {
+        .physicalReadStart = baseTime + std::chrono::microseconds(1000),
+        .physicalReadEnd = baseTime + std::chrono::microseconds(1100),
+        .mapped = baseTime + std::chrono::microseconds(1110)};
+
+    Latency::SetEnabled(true);
+
+    Latency::RecordPhysicalSampleMapped(kTestControllerIdentifier, publishedTimestamps);
+    Latency::RecordPhysicalSamplePublicationStart(kTestControllerIdentifier, publishedTimestamps);
+
+    const uint64_t mappingCountBefore =
+        Latency::GetStatistics(kTestControllerIdentifier, EStage::Mapping).count;
+    Latency::RecordPhysicalSampleMapped(kTestControllerIdentifier, unpublishedTimestamps);
+
+    Latency::SetEnabled(false);
+
+    TEST_ASSERT(
+        (mappingCountBefore + 1) ==
+        Latency::GetStatistics(kTestControllerIdentifier, EStage::Mapping).count);
+    TEST_ASSERT(
+        publishedTimestamps.physicalReadEnd ==
+        Latency::GetPublishedSampleTimestamps(kTestControllerIdentifier).physicalReadEnd);
+  }
+
+  // Verifies that nothing is recorded while latency instrumentation is disabled.
+  TEST_CASE(LatencyInstrumentation_DisabledRecordsNothing)
+  {
+    constexpr TControllerIdentifier kTestControllerIdentifier = 3;
+
+    const uint64_t mappingCountBefore =
+        Latency::GetStatistics(kTestControllerIdentifier, EStage::Mapping).count;
+
+    const Latency::TTimestamp baseTime = Latency::Now();
+    Latency::SetEnabled(false);
+    Latency::RecordPhysicalSampleMapped(
+        kTestControllerIdentifier,
+        {.physicalReadStart = baseTime,
+         .physicalReadEnd = baseTime,
+         .mapped = baseTime,
+         .publicationStart = baseTime});
+
+    TEST_ASSERT(
+        mappingCountBefore ==
+        Latency::GetStatistics(kTestControllerIdentifier, EStage::Mapping).count);
+  }
+} // namespace XidiTest
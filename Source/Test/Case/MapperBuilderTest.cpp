@@ -22,6 +22,7 @@
 #include "ElementMapper.h"
 #include "ForceFeedbackTypes.h"
 #include "Mapper.h"
+#include "MapperSet.h"
 
 namespace XidiTest
 {
@@ -814,4 +815,79 @@ namespace XidiTest
         mapper->GetForceFeedbackActuatorMap();
     VerifyForceFeedbackActuatorMapsAreEquivalent(actualActuatorMap, expectedActuatorMap);
   }
+
+  // Verifies that a builder that builds replacements accepts the names of custom mappers built
+  // previously but still rejects the names of built-in mappers, and that the replacement mappers
+  // it builds are owned by the builder rather than registered.
+  TEST_CASE(MapperBuilder_Replacement_Nominal)
+  {
+    constexpr std::wstring_view kMapperName = L"TestMapperReplacement";
+
+    MapperBuilder builder;
+    TEST_ASSERT(true == builder.CreateBlueprint(kMapperName));
+    std::unique_ptr<const Mapper> originalMapper(builder.Build(kMapperName));
+    TEST_ASSERT(nullptr != originalMapper);
+
+    MapperBuilder otherBuilder;
+    TEST_ASSERT(false == otherBuilder.CreateBlueprint(kMapperName));
+
+    MapperBuilder replacementBuilder;
+    replacementBuilder.EnableReplacement();
+    TEST_ASSERT(false == replacementBuilder.CreateBlueprint(L"StandardGamepad"));
+    TEST_ASSERT(true == replacementBuilder.CreateBlueprint(kMapperName));
+    TEST_ASSERT(true == replacementBuilder.Build());
+
+    MapperSet::TOwnedMappers replacementMappers = replacementBuilder.ReleaseReplacementMappers();
+    TEST_ASSERT(1 == replacementMappers.size());
+    TEST_ASSERT(kMapperName == replacementMappers[0]->GetName());
+    TEST_ASSERT(originalMapper.get() != replacementMappers[0].get());
+    TEST_ASSERT(originalMapper.get() == Mapper::GetByName(kMapperName));
+
+    replacementMappers.clear();
+    TEST_ASSERT(originalMapper.get() == Mapper::GetByName(kMapperName));
+  }
+
+  // Verifies that a replacement mapper whose template is another custom mapper being replaced
+  // uses the replacement as its template rather than the registered mapper being replaced.
+  TEST_CASE(MapperBuilder_Replacement_TemplateIsReplacement)
+  {
+    constexpr std::wstring_view kMapperName = L"TestMapperReplacementA";
+    constexpr std::wstring_view kTemplateMapperName = L"TestMapperReplacementB";
+    constexpr ButtonMapper kOriginalElementMapper(EButton::B1);
+    constexpr ButtonMapper kReplacementElementMapper(EButton::B2);
+
+    MapperBuilder builder;
+    TEST_ASSERT(true == builder.CreateBlueprint(kTemplateMapperName));
+    TEST_ASSERT(
+        true ==
+        builder.SetBlueprintElementMapper(
+            kTemplateMapperName, ELEMENT_MAP_INDEX_OF(buttonA), kOriginalElementMapper.Clone()));
+    std::unique_ptr<const Mapper> originalTemplateMapper(builder.Build(kTemplateMapperName));
+    TEST_ASSERT(nullptr != originalTemplateMapper);
+
+    MapperBuilder replacementBuilder;
+    replacementBuilder.EnableReplacement();
+    TEST_ASSERT(true == replacementBuilder.CreateBlueprint(kMapperName));
+    TEST_ASSERT(true == replacementBuilder.SetBlueprintTemplate(kMapperName, kTemplateMapperName));
+    TEST_ASSERT(true == replacementBuilder.CreateBlueprint(kTemplateMapperName));
+    TEST_ASSERT(
+        true ==
+        replacementBuilder.SetBlueprintElementMapper(
+            kTemplateMapperName,
+            ELEMENT_MAP_INDEX_OF(buttonA),
+            kReplacementElementMapper.Clone()));
+    TEST_ASSERT(true == replacementBuilder.Build());
+
+    const MapperSet::TOwnedMappers replacementMappers =
+        replacementBuilder.ReleaseReplacementMappers();
+    TEST_ASSERT(2 == replacementMappers.size());
+
+    for (const auto& replacementMapper : replacementMappers)
+    {
+      const IElementMapper* const kElementMapper =
+          replacementMapper->ElementMap().named.buttonA.get();
+      TEST_ASSERT(nullptr != kElementMapper);
+      VerifyElementMappersAreEquivalent(*kElementMapper, kReplacementElementMapper);
+    }
+  }
 } // namespace XidiTest
@@ -0,0 +1,235 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file MapperSetTest.cpp
+ *   Unit tests for publishing and reading sets of mappers assigned to physical controllers.
+ **************************************************************************************************/
+
+#include "MapperSet.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <Infra/Test/TestCase.h>
+
+#include "ControllerTypes.h"
+#include "ElementMapper.h"
+#include "Mapper.h"
+
+namespace XidiTest
+{
+  using namespace ::Xidi::Controller;
+
+  /// Number of reader threads to use for stress-testing mapper set publication.
+  static constexpr unsigned int kStressTestReaderCount = 4;
+
+  /// Number of mapper sets to publish while stress-testing mapper set publication.
+  static constexpr uint64_t kStressTestPublishCount = 2000;
+
+  /// Captures the configured mappers when created and publishes them again when destroyed, so
+  /// that tests which publish their own mapper sets do not affect any other tests.
+  class ConfiguredMapperRestorer
+  {
+  public:
+
+    inline ConfiguredMapperRestorer(void) : originalMappers()
+    {
+      const MapperSetReader configuredMappers = Mapper::ReadConfigured();
+      for (TControllerIdentifier i = 0; i < kPhysicalControllerCount; ++i)
+        originalMappers[i] = configuredMappers->GetMapper(i);
+    }
+
+    inline ~ConfiguredMapperRestorer(void)
+    {
+      MapperSet::Publish(std::make_unique<MapperSet>(originalMappers));
+    }
+
+  private:
+
+    /// Configured mappers at the time this object was created.
+    MapperSet::TMapperArray originalMappers;
+  };
+
+  /// Creates a mapper whose only element mapper maps the A button to the specified button.
+  /// @param [in] button Virtual controller button to which the A button should be mapped.
+  /// @return Newly-created mapper.
+  static std::unique_ptr<const Mapper> MakeTestMapper(EButton button)
+  {
+    return std::make_unique<Mapper>(
+        Mapper::SElementMap{.buttonA = std::make_unique<ButtonMapper>(button)});
+  }
+
+  /// Creates a mapper set that assigns the same newly-created mapper to all physical controllers
+  /// and owns that mapper.
+  /// @param [in] button Virtual controller button to which the mapper maps the A button.
+  /// @return Newly-created mapper set.
+  static std::unique_ptr<MapperSet> MakeTestMapperSet(EButton button)
+  {
+    MapperSet::TOwnedMappers ownedMappers;
+    const Mapper* const mapper = ownedMappers.emplace_back(MakeTestMapper(button)).get();
+
+    MapperSet::TMapperArray mappers;
+    mappers.fill(mapper);
+
+    return std::make_unique<MapperSet>(mappers, std::move(ownedMappers));
+  }
+
+  /// Determines the virtual controller button that the stress test maps for a given generation,
+  /// so that readers can detect if they ever see a mapper that does not belong to the mapper set
+  /// from which they are reading.
+  /// @param [in] generation Generation number of a mapper set.
+  /// @return Virtual controller button to which the A button is mapped in that generation.
+  static EButton StressTestButtonForGeneration(uint64_t generation)
+  {
+    return (EButton)(2 + (generation % 8));
+  }
+
+  // Verifies that readers keep reading from the same mapper set until they refresh, and that
+  // generation numbers increase with each publication and are reported as published.
+  TEST_CASE(MapperSet_ReaderSwitchesOnRefresh)
+  {
+    const ConfiguredMapperRestorer configuredMapperRestorer;
+
+    std::unique_ptr<MapperSet> firstMapperSet = MakeTestMapperSet(EButton::B1);
+    const MapperSet* const kFirstMapperSet = firstMapperSet.get();
+    const uint64_t firstGeneration = MapperSet::Publish(std::move(firstMapperSet));
+    TEST_ASSERT(firstGeneration == kFirstMapperSet->GetGeneration());
+    TEST_ASSERT(firstGeneration == MapperSet::GetPublishedGeneration());
+
+    MapperSetReader reader;
+    TEST_ASSERT(kFirstMapperSet == reader.Get());
+    TEST_ASSERT(false == reader.Refresh());
+
+    std::unique_ptr<MapperSet> secondMapperSet = MakeTestMapperSet(EButton::B2);
+    const MapperSet* const kSecondMapperSet = secondMapperSet.get();
+    const uint64_t secondGeneration = MapperSet::Publish(std::move(secondMapperSet));
+    TEST_ASSERT(secondGeneration > firstGeneration);
+    TEST_ASSERT(secondGeneration == MapperSet::GetPublishedGeneration());
+
+    TEST_ASSERT(kFirstMapperSet == reader.Get());
+    TEST_ASSERT(true == reader.Refresh());
+    TEST_ASSERT(kSecondMapperSet == reader.Get());
+    TEST_ASSERT(false == reader.Refresh());
+  }
+
+  // Verifies that a replaced mapper set is not reclaimed while any reader, including a copy of a
+  // reader, is still reading from it, and that it is reclaimed once all such readers move on.
+  TEST_CASE(MapperSet_ReclaimedOnlyWithoutReaders)
+  {
+    const ConfiguredMapperRestorer configuredMapperRestorer;
+
+    MapperSet::Publish(MakeTestMapperSet(EButton::B1));
+    TEST_ASSERT(0 == MapperSet::ReclaimRetired());
+
+    MapperSetReader reader;
+    MapperSetReader readerCopy(reader);
+    TEST_ASSERT(reader.Get() == readerCopy.Get());
+
+    MapperSet::Publish(MakeTestMapperSet(EButton::B2));
+    TEST_ASSERT(1 == MapperSet::ReclaimRetired());
+
+    TEST_ASSERT(true == reader.Refresh());
+    TEST_ASSERT(1 == MapperSet::ReclaimRetired());
+
+    TEST_ASSERT(true == readerCopy.Refresh());
+    TEST_ASSERT(0 == MapperSet::ReclaimRetired());
+  }
+
+  // Verifies that the configured mappers can be replaced by publishing a new mapper set, and that
+  // mapping contexts that follow them switch over at the next mapping without being recreated.
+  TEST_CASE(MappingContext_FollowsConfiguredMapper)
+  {
+    constexpr TControllerIdentifier kTestControllerIdentifier = 1;
+    constexpr uint32_t kOpaqueSourceIdentifier = 0;
+
+    SPhysicalState testPhysicalState = {.deviceStatus = EPhysicalDeviceStatus::Ok};
+    testPhysicalState[EPhysicalButton::A] = true;
+
+    const ConfiguredMapperRestorer configuredMapperRestorer;
+
+    MapperSet::Publish(MakeTestMapperSet(EButton::B1));
+    MappingContext mappingContext(kTestControllerIdentifier, kOpaqueSourceIdentifier);
+    TEST_ASSERT(
+        Mapper::GetConfigured(kTestControllerIdentifier) == mappingContext.GetMapper());
+
+    SState expectedState = {};
+    expectedState[EButton::B1] = true;
+    TEST_ASSERT(expectedState == mappingContext.MapStatePhysicalToVirtual(testPhysicalState));
+
+    MapperSet::Publish(MakeTestMapperSet(EButton::B2));
+
+    expectedState = {};
+    expectedState[EButton::B2] = true;
+    TEST_ASSERT(expectedState == mappingContext.MapStatePhysicalToVirtual(testPhysicalState));
+    TEST_ASSERT(
+        Mapper::GetConfigured(kTestControllerIdentifier) == mappingContext.GetMapper());
+    TEST_ASSERT(false == mappingContext.Refresh());
+  }
+
+  // Verifies that many concurrent readers only ever see mappers that belong to the mapper set
+  // from which they are reading while a single writer continuously publishes new mapper sets,
+  // each of which owns its mappers. Once all readers are gone every replaced mapper set is
+  // expected to have been reclaimed.
+  TEST_CASE(MapperSet_Stress)
+  {
+    const ConfiguredMapperRestorer configuredMapperRestorer;
+
+    uint64_t nextGeneration = 1 + MapperSetReader()->GetGeneration();
+    TEST_ASSERT(
+        nextGeneration ==
+        MapperSet::Publish(MakeTestMapperSet(StressTestButtonForGeneration(nextGeneration))));
+    nextGeneration += 1;
+
+    std::atomic<bool> writerFinished = false;
+    std::atomic<unsigned int> inconsistentReadCount = 0;
+    std::atomic<unsigned int> outOfOrderReadCount = 0;
+
+    std::vector<std::thread> readerThreads;
+    for (unsigned int i = 0; i < kStressTestReaderCount; ++i)
+    {
+      readerThreads.emplace_back(
+          [&writerFinished, &inconsistentReadCount, &outOfOrderReadCount]() -> void
+          {
+            MapperSetReader reader;
+            uint64_t lastGenerationSeen = 0;
+
+            while (false == writerFinished)
+            {
+              reader.Refresh();
+
+              const uint64_t generation = reader->GetGeneration();
+              if (generation < lastGenerationSeen) outOfOrderReadCount += 1;
+              lastGenerationSeen = generation;
+
+              for (TControllerIdentifier j = 0; j < kPhysicalControllerCount; ++j)
+                if ((1 + (int)StressTestButtonForGeneration(generation)) !=
+                    reader->GetMapper(j)->GetCapabilities().numButtons)
+                  inconsistentReadCount += 1;
+            }
+          });
+    }
+
+    for (uint64_t i = 0; i < kStressTestPublishCount; ++i)
+    {
+      TEST_ASSERT(
+          nextGeneration ==
+          MapperSet::Publish(MakeTestMapperSet(StressTestButtonForGeneration(nextGeneration))));
+      nextGeneration += 1;
+    }
+
+    writerFinished = true;
+    for (auto& readerThread : readerThreads)
+      readerThread.join();
+
+    TEST_ASSERT(0 == inconsistentReadCount);
+    TEST_ASSERT(0 == outOfOrderReadCount);
+    TEST_ASSERT(0 == MapperSet::ReclaimRetired());
+  }
+} // namespace XidiTest
@@ -11,21 +11,27 @@
 
 #include "Mapper.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <limits>
 #include <memory>
+#include <optional>
+#include <span>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <Infra/Test/TestCase.h>
 
 #include "ApiBitSet.h"
 #include "ApiWindows.h"
+#include "ControllerMath.h"
 #include "ControllerTypes.h"
 #include "ElementMapper.h"
 #include "ForceFeedbackTypes.h"
 #include "MockElementMapper.h"
+#include "TestPseudoRandom.h"
 
 namespace XidiTest
 {
@@ -604,6 +610,387 @@ namespace XidiTest
     TEST_ASSERT(1 == numContributions);
   }
 
+  /// Creates an element mapper that nests every kind of composite element mapper inside one
+  /// another. Used to exercise the flattening that a mapper performs on its element mappers.
+  /// @return Nested composite element mapper.
+  static std::unique_ptr<IElementMapper> MakeNestedCompositeTestElementMapper(void)
+  {
+    CompoundMapper::TElementMappers positiveElementMappers;
+    positiveElementMappers[0] = std::make_unique<AxisMapper>(EAxis::X, EAxisDirection::Positive);
+    positiveElementMappers[1] = std::make_unique<ButtonMapper>(EButton::B1);
+    positiveElementMappers[2] = std::make_unique<SplitMapper>(
+        std::make_unique<DigitalAxisMapper>(EAxis::Y),
+        std::make_unique<InvertMapper>(std::make_unique<PovMapper>(EPovDirection::Up)));
+
+    CompoundMapper::TElementMappers negativeElementMappers;
+    negativeElementMappers[0] = std::make_unique<AxisMapper>(EAxis::Z);
+    negativeElementMappers[1] =
+        std::make_unique<InvertMapper>(std::make_unique<ButtonMapper>(EButton::B2));
+
+    return std::make_unique<SplitMapper>(
+        std::make_unique<InvertMapper>(
+            std::make_unique<CompoundMapper>(std::move(positiveElementMappers))),
+        std::make_unique<CompoundMapper>(std::move(negativeElementMappers)));
+  }
+
+  // Nested composite element mappers on an analog stick, a trigger, and a button.
+  // Mappers flatten their element mappers before using them, so the virtual controller state they
+  // produce is verified to be identical to the state that results from asking each element mapper
+  // directly for its contribution, across the full range of input values.
+  TEST_CASE(Mapper_MapStatePhysicalToVirtual_NestedCompositesMatchElementMappers)
+  {
+    const Mapper kTestMapper(
+        {.stickLeftX = MakeNestedCompositeTestElementMapper(),
+         .triggerLT = MakeNestedCompositeTestElementMapper(),
+         .buttonA = MakeNestedCompositeTestElementMapper()});
+
+    for (int32_t analogValue = kAnalogValueMin; analogValue <= kAnalogValueMax; analogValue += 127)
+    {
+      for (int32_t triggerValue = kTriggerValueMin; triggerValue <= kTriggerValueMax;
+           triggerValue += 5)
+      {
+        for (bool buttonValue : {false, true})
+        {
+          SState expectedState;
+          ZeroMemory(&expectedState, sizeof(expectedState));
+          kTestMapper.ElementMap().named.stickLeftX->ContributeFromAnalogValue(
+              expectedState, (int16_t)analogValue, kOpaqueSourceIdentifier);
+          kTestMapper.ElementMap().named.triggerLT->ContributeFromTriggerValue(
+              expectedState, (uint8_t)triggerValue, kOpaqueSourceIdentifier);
+          kTestMapper.ElementMap().named.buttonA->ContributeFromButtonValue(
+              expectedState, buttonValue, kOpaqueSourceIdentifier);
+          for (int32_t& axisValue : expectedState.axis)
+            axisValue = std::min(std::max(axisValue, kAnalogValueMin), kAnalogValueMax);
+
+          SPhysicalState physicalState = {
+              .deviceStatus = EPhysicalDeviceStatus::Ok,
+              .stick = {(int16_t)analogValue, 0, 0, 0},
+              .trigger = {(uint8_t)triggerValue, 0}};
+          physicalState[EPhysicalButton::A] = buttonValue;
+
+          const SState actualState =
+              kTestMapper.MapStatePhysicalToVirtual(physicalState, kOpaqueSourceIdentifier);
+          TEST_ASSERT(actualState == expectedState);
+        }
+      }
+    }
+  }
+
+  // Sequence of physical states, each differing from the previous in only a few controller
+  // elements, mapped both incrementally and from scratch.
+  // Incremental mapping is expected to produce the same virtual controller state every time, even
+  // when switching between mappers partway through.
+  TEST_CASE(Mapper_MapStatePhysicalToVirtual_IncrementalMatchesFull)
+  {
+    const Mapper kTestMappers[] = {
+        Mapper(
+            {.stickLeftX = MakeNestedCompositeTestElementMapper(),
+             .stickLeftY = std::make_unique<AxisMapper>(EAxis::Y),
+             .stickRightX = std::make_unique<DigitalAxisMapper>(EAxis::RotX),
+             .stickRightY = MakeNestedCompositeTestElementMapper(),
+             .dpadUp = std::make_unique<PovMapper>(EPovDirection::Up),
+             .dpadDown = std::make_unique<PovMapper>(EPovDirection::Down),
+             .triggerLT = MakeNestedCompositeTestElementMapper(),
+             .triggerRT = std::make_unique<AxisMapper>(EAxis::Z, EAxisDirection::Negative),
+             .buttonA = std::make_unique<ButtonMapper>(EButton::B1),
+             .buttonB = std::make_unique<ButtonMapper>(EButton::B1),
+             .buttonX = MakeNestedCompositeTestElementMapper(),
+             .buttonY = std::make_unique<AxisMapper>(EAxis::X)}),
+        Mapper(
+            {.stickLeftX = std::make_unique<AxisMapper>(EAxis::X),
+             .stickLeftY = std::make_unique<AxisMapper>(EAxis::Y),
+             .triggerLT = std::make_unique<ButtonMapper>(EButton::B3),
+             .buttonA = std::make_unique<ButtonMapper>(EButton::B1)})};
+
+    constexpr int kTestStepCount = 2000;
+    constexpr int kTestStepsPerMapper = 700;
+
+    Mapper::SIncrementalMappingState incrementalState;
+    SPhysicalState physicalState = {.deviceStatus = EPhysicalDeviceStatus::Ok};
+    TestPseudoRandom pseudoRandom;
+
+    for (int step = 0; step < kTestStepCount; ++step)
+    {
+      const Mapper& testMapper =
+          kTestMappers[(step / kTestStepsPerMapper) % _countof(kTestMappers)];
+
+      const uint32_t pseudoRandomValue = pseudoRandom.Next();
+      switch ((pseudoRandomValue >> 8) % 4)
+      {
+        case 0:
+          physicalState.stick[(pseudoRandomValue >> 12) % physicalState.stick.size()] =
+              (int16_t)(pseudoRandomValue >> 16);
+          break;
+        case 1:
+          physicalState.trigger[(pseudoRandomValue >> 12) % physicalState.trigger.size()] =
+              (uint8_t)(pseudoRandomValue >> 16);
+          break;
+        default:
+          physicalState.button ^= (uint16_t)(1u << ((pseudoRandomValue >> 12) % 16));
+          break;
+      }
+
+      const SState expectedState =
+          testMapper.MapStatePhysicalToVirtual(physicalState, kOpaqueSourceIdentifier);
+      const SState actualState = testMapper.MapStatePhysicalToVirtual(
+          physicalState, kOpaqueSourceIdentifier, incrementalState);
+      TEST_ASSERT(actualState == expectedState);
+    }
+  }
+
+  // Element mapper whose contributions cannot be undone, mapped incrementally several times without
+  // any change to the physical state.
+  // Element mappers like this one are expected to be invoked every time.
+  TEST_CASE(Mapper_MapStatePhysicalToVirtual_IncrementalIrreversibleEveryTime)
+  {
+    constexpr int kTestMappingCount = 5;
+
+    int numContributions = 0;
+    const Mapper mapper(
+        {.stickLeftX = std::make_unique<AxisMapper>(EAxis::X),
+         .buttonA = std::make_unique<MockElementMapper>(
+             MockElementMapper::EExpectedSource::Button, true, &numContributions)});
+
+    SPhysicalState physicalState = {
+        .deviceStatus = EPhysicalDeviceStatus::Ok, .stick = {1000, 0, 0, 0}};
+    physicalState[EPhysicalButton::A] = true;
+
+    Mapper::SIncrementalMappingState incrementalState;
+    for (int i = 0; i < kTestMappingCount; ++i)
+    {
+      const SState actualState = mapper.MapStatePhysicalToVirtual(
+          physicalState, kOpaqueSourceIdentifier, incrementalState);
+      TEST_ASSERT(1000 == actualState[EAxis::X]);
+    }
+
+    TEST_ASSERT(kTestMappingCount == numContributions);
+  }
+
+  /// Generates a sequence of pseudo-random physical controller states that starts with the
+  /// extreme and neutral positions of every analog stick and trigger.
+  /// @param [in] count Number of physical controller states to generate.
+  /// @return Generated physical controller states.
+  static std::vector<SPhysicalState> MakeTestPhysicalStateSequence(size_t count)
+  {
+    std::vector<SPhysicalState> physicalStates;
+    physicalStates.reserve(count);
+
+    for (int16_t stickValue : {std::numeric_limits<int16_t>::min(),
+                               std::numeric_limits<int16_t>::max(),
+                               (int16_t)0})
+    {
+      physicalStates.push_back(
+          {.deviceStatus = EPhysicalDeviceStatus::Ok,
+           .stick = {stickValue, stickValue, stickValue, (int16_t)-stickValue},
+           .trigger = {(uint8_t)stickValue, (uint8_t)-stickValue}});
+    }
+
+    TestPseudoRandom pseudoRandom;
+    while (physicalStates.size() < count)
+    {
+      SPhysicalState physicalState = {.deviceStatus = EPhysicalDeviceStatus::Ok};
+      for (auto& stickValue : physicalState.stick)
+        stickValue = (int16_t)(pseudoRandom.Next() >> 16);
+      for (auto& triggerValue : physicalState.trigger)
+        triggerValue = (uint8_t)(pseudoRandom.Next() >> 24);
+      physicalState.button = (uint16_t)(pseudoRandom.Next() >> 16);
+
+      physicalStates.push_back(physicalState);
+    }
+
+    physicalStates.resize(count);
+    return physicalStates;
+  }
+
+  // Several different mappers, each used to map sequences of physical states of varying lengths
+  // all at once. Lengths are chosen to cover partial, full, and multiple blocks of states.
+  // Each resulting virtual controller state is expected to be identical to what is produced by
+  // mapping the same physical state by itself.
+  TEST_CASE(Mapper_MapStatesPhysicalToVirtual_MatchesIndividualMapping)
+  {
+    const Mapper kTestMappers[] = {
+        Mapper({}),
+        Mapper(
+            {.stickLeftX = MakeNestedCompositeTestElementMapper(),
+             .stickLeftY = std::make_unique<AxisMapper>(EAxis::Y),
+             .stickRightX = std::make_unique<DigitalAxisMapper>(EAxis::RotX),
+             .stickRightY = MakeNestedCompositeTestElementMapper(),
+             .dpadUp = std::make_unique<PovMapper>(EPovDirection::Up),
+             .dpadDown = std::make_unique<PovMapper>(EPovDirection::Down),
+             .triggerLT = MakeNestedCompositeTestElementMapper(),
+             .triggerRT = std::make_unique<AxisMapper>(EAxis::Z, EAxisDirection::Negative),
+             .buttonA = std::make_unique<ButtonMapper>(EButton::B1),
+             .buttonB = std::make_unique<ButtonMapper>(EButton::B1),
+             .buttonX = MakeNestedCompositeTestElementMapper(),
+             .buttonY = std::make_unique<AxisMapper>(EAxis::X),
+             .buttonLB = std::make_unique<ButtonMapper>(EButton::B16),
+             .buttonRS = std::make_unique<DigitalAxisMapper>(EAxis::X)}),
+        Mapper(
+            {.stickLeftX = std::make_unique<AxisMapper>(EAxis::X),
+             .stickLeftY = std::make_unique<AxisMapper>(EAxis::X),
+             .triggerLT = std::make_unique<ButtonMapper>(EButton::B3),
+             .buttonA = std::make_unique<MockElementMapper>(),
+             .buttonStart = std::make_unique<AxisMapper>(EAxis::X)})};
+
+    for (size_t stateCount : {0, 1, 7, 64, 65, 1000})
+    {
+      const std::vector<SPhysicalState> physicalStates = MakeTestPhysicalStateSequence(stateCount);
+
+      for (const auto& testMapper : kTestMappers)
+      {
+        std::vector<SState> actualStates(stateCount);
+        testMapper.MapStatesPhysicalToVirtual(
+            physicalStates, actualStates, kOpaqueSourceIdentifier);
+
+        for (size_t i = 0; i < stateCount; ++i)
+          TEST_ASSERT(
+              actualStates[i] ==
+              testMapper.MapStatePhysicalToVirtual(physicalStates[i], kOpaqueSourceIdentifier));
+      }
+    }
+  }
+
+  // Element mapper whose contributions cannot be undone, used to map a sequence of physical states
+  // all at once. It is expected to be invoked exactly once per physical state.
+  TEST_CASE(Mapper_MapStatesPhysicalToVirtual_IrreversibleOncePerState)
+  {
+    constexpr size_t kTestStateCount = 100;
+
+    int numContributions = 0;
+    const Mapper mapper(
+        {.buttonA = std::make_unique<MockElementMapper>(
+             MockElementMapper::EExpectedSource::Button, std::nullopt, &numContributions)});
+
+    const std::vector<SPhysicalState> physicalStates =
+        MakeTestPhysicalStateSequence(kTestStateCount);
+    std::vector<SState> actualStates(kTestStateCount);
+    mapper.MapStatesPhysicalToVirtual(physicalStates, actualStates, kOpaqueSourceIdentifier);
+
+    TEST_ASSERT(kTestStateCount == numContributions);
+  }
+
+  // Output span shorter than the input span.
+  // Only as many states are expected to be mapped as there is space to hold them.
+  TEST_CASE(Mapper_MapStatesPhysicalToVirtual_SizeMismatch)
+  {
+    constexpr size_t kTestOutputCount = 10;
+
+    const Mapper mapper({.stickLeftX = std::make_unique<AxisMapper>(EAxis::X)});
+    const std::vector<SPhysicalState> physicalStates = MakeTestPhysicalStateSequence(100);
+
+    constexpr SState kUnmappedState = {.axis = {1, 2, 3, 4, 5, 6}};
+    std::vector<SState> actualStates(1 + kTestOutputCount, kUnmappedState);
+    mapper.MapStatesPhysicalToVirtual(
+        physicalStates,
+        std::span<SState>(actualStates.data(), kTestOutputCount),
+        kOpaqueSourceIdentifier);
+
+    for (size_t i = 0; i < kTestOutputCount; ++i)
+      TEST_ASSERT(
+          actualStates[i] ==
+          mapper.MapStatePhysicalToVirtual(physicalStates[i], kOpaqueSourceIdentifier));
+    TEST_ASSERT(kUnmappedState == actualStates[kTestOutputCount]);
+  }
+
+  // Mapper that uses every kind of reversible contribution, including all four POV directions and
+  // both halves of a split trigger axis, used to map a sequence of physical states spanning many
+  // blocks all at once. Each resulting virtual controller state is expected to be identical to
+  // what is produced by mapping the same physical state by itself.
+  TEST_CASE(Mapper_MapStatesPhysicalToVirtual_AllReversibleContributions)
+  {
+    constexpr size_t kTestStateCount = 4096;
+
+    const Mapper mapper(
+        {.stickLeftX = MakeNestedCompositeTestElementMapper(),
+         .stickLeftY = std::make_unique<AxisMapper>(EAxis::Y),
+         .stickRightX = std::make_unique<AxisMapper>(EAxis::RotX),
+         .stickRightY = std::make_unique<AxisMapper>(EAxis::RotY),
+         .dpadUp = std::make_unique<PovMapper>(EPovDirection::Up),
+         .dpadDown = std::make_unique<PovMapper>(EPovDirection::Down),
+         .dpadLeft = std::make_unique<PovMapper>(EPovDirection::Left),
+         .dpadRight = std::make_unique<PovMapper>(EPovDirection::Right),
+         .triggerLT = std::make_unique<AxisMapper>(EAxis::Z, EAxisDirection::Positive),
+         .triggerRT = std::make_unique<AxisMapper>(EAxis::Z, EAxisDirection::Negative),
+         .buttonA = std::make_unique<ButtonMapper>(EButton::B1),
+         .buttonB = std::make_unique<ButtonMapper>(EButton::B2),
+         .buttonX = std::make_unique<ButtonMapper>(EButton::B3),
+         .buttonY = std::make_unique<ButtonMapper>(EButton::B4)});
+
+    const std::vector<SPhysicalState> physicalStates =
+        MakeTestPhysicalStateSequence(kTestStateCount);
+    std::vector<SState> actualStates(kTestStateCount);
+    mapper.MapStatesPhysicalToVirtual(physicalStates, actualStates, kOpaqueSourceIdentifier);
+
+    for (size_t i = 0; i < kTestStateCount; ++i)
+      TEST_ASSERT(
+          actualStates[i] ==
+          mapper.MapStatePhysicalToVirtual(physicalStates[i], kOpaqueSourceIdentifier));
+  }
+
+  // Sequence of physical states mapped through a mapping context.
+  // Each resulting virtual controller state is expected to be identical to what the mapper itself
+  // produces, both for actual physical states and for a neutral physical state.
+  TEST_CASE(MappingContext_MatchesMapper)
+  {
+    const Mapper mapper(
+        {.stickLeftX = MakeNestedCompositeTestElementMapper(),
+         .stickRightY = std::make_unique<AxisMapper>(EAxis::RotY),
+         .triggerRT = std::make_unique<ButtonMapper>(EButton::B2),
+         .buttonA = std::make_unique<ButtonMapper>(EButton::B1),
+         .buttonB = std::make_unique<PovMapper>(EPovDirection::Left)});
+
+    MappingContext mappingContext(&mapper, kOpaqueSourceIdentifier);
+    TEST_ASSERT(&mapper == mappingContext.GetMapper());
+
+    for (const auto& physicalState : MakeTestPhysicalStateSequence(200))
+      TEST_ASSERT(
+          mapper.MapStatePhysicalToVirtual(physicalState, kOpaqueSourceIdentifier) ==
+          mappingContext.MapStatePhysicalToVirtual(physicalState));
+
+    TEST_ASSERT(
+        mapper.MapNeutralPhysicalToVirtual(kOpaqueSourceIdentifier) ==
+        mappingContext.MapNeutralPhysicalToVirtual());
+  }
+
+  // Mapping context created with its own transformations for raw analog values, in this case a
+  // large deadzone on the left stick.
+  // Those transformations are expected to be used instead of the configured ones, and switching
+  // between them while mapping incrementally is expected to start over from scratch.
+  TEST_CASE(MappingContext_UsesSpecifiedTransforms)
+  {
+    constexpr int16_t kTestStickValue = 10000;
+
+    const std::unique_ptr<Mapper::SPhysicalControllerTransforms> transforms(
+        new Mapper::SPhysicalControllerTransforms{
+            .circleToSquareStickLeft = Math::CircleToSquareTransform(0.0),
+            .circleToSquareStickRight = Math::CircleToSquareTransform(0.0),
+            .rawStickLeft = Math::RawAnalogTransformTable(50, 100),
+            .rawStickRight = Math::RawAnalogTransformTable(0, 100),
+            .rawTriggerLT = Math::RawTriggerTransformTable(0, 100),
+            .rawTriggerRT = Math::RawTriggerTransformTable(0, 100)});
+
+    const Mapper mapper({.stickLeftX = std::make_unique<AxisMapper>(EAxis::X)});
+    const SPhysicalState physicalState = {
+        .deviceStatus = EPhysicalDeviceStatus::Ok, .stick = {kTestStickValue, 0, 0, 0}};
+
+    MappingContext mappingContext(&mapper, kOpaqueSourceIdentifier, *transforms);
+    TEST_ASSERT(0 == mappingContext.MapStatePhysicalToVirtual(physicalState)[EAxis::X]);
+
+    Mapper::SIncrementalMappingState incrementalState;
+    TEST_ASSERT(
+        kTestStickValue ==
+        mapper.MapStatePhysicalToVirtual(physicalState, kOpaqueSourceIdentifier, incrementalState)
+            [EAxis::X]);
+    TEST_ASSERT(
+        0 ==
+        mapper.MapStatePhysicalToVirtual(
+            physicalState, kOpaqueSourceIdentifier, incrementalState, *transforms)[EAxis::X]);
+    TEST_ASSERT(
+        kTestStickValue ==
+        mapper.MapStatePhysicalToVirtual(physicalState, kOpaqueSourceIdentifier, incrementalState)
+            [EAxis::X]);
+  }
+
   // Empty mapper.
   // Nothing should be present on the virtual controller.
   TEST_CASE(Mapper_Capabilities_EmptyMapper)
@@ -793,6 +1180,26 @@ namespace XidiTest
     TEST_ASSERT(actualCapabilities == expectedCapabilities);
   }
 
+  // Verifies that the default mapper is the first built-in mapper and that built-in mappers share
+  // element mappers that are not owned by any of them, including with mappers created at runtime.
+  TEST_CASE(Mapper_BuiltIn_SharedElementMappers)
+  {
+    const std::span<const Mapper> builtInMappers = Mapper::GetBuiltIn();
+    TEST_ASSERT(false == builtInMappers.empty());
+    TEST_ASSERT(&builtInMappers.front() == Mapper::GetDefault());
+    TEST_ASSERT(&builtInMappers.front() == Mapper::GetByName(L"StandardGamepad"));
+
+    const Mapper::SElementMap& standardElements =
+        Mapper::GetByName(L"StandardGamepad")->ElementMap().named;
+    const Mapper::SElementMap& extendedElements =
+        Mapper::GetByName(L"ExtendedGamepad")->ElementMap().named;
+    TEST_ASSERT(standardElements.stickLeftX == extendedElements.stickLeftX);
+    TEST_ASSERT(0 == standardElements.stickLeftX.use_count());
+
+    const Mapper runtimeMapper({.stickLeftX = std::make_unique<AxisMapper>(EAxis::X)});
+    TEST_ASSERT(standardElements.stickLeftX == runtimeMapper.ElementMap().named.stickLeftX);
+  }
+
   // StandardGamepad, a known and documented mapper.
   TEST_CASE(Mapper_Capabilities_StandardGamepad)
   {
@@ -0,0 +1,293 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file PeriodicJobSchedulerTest.cpp
+ *   Unit tests for the deadline-based periodic job scheduler.
+ **************************************************************************************************/
+
+#include "PeriodicJobScheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <Infra/Test/TestCase.h>
+
+namespace XidiTest
+{
+  using namespace ::Xidi;
+
+  /// Amount of time for which each test lets the scheduler run. Intentionally generous relative to
+  /// the job periods used in the tests so that the tests are not sensitive to timer resolution.
+  static constexpr std::chrono::milliseconds kTestDuration = std::chrono::milliseconds(500);
+
+  /// Creates a job function that counts its own invocations and always reports the same result.
+  /// @param [in] invocationCount Counter to increment on each invocation.
+  /// @param [in] jobResult Result that the job function should report.
+  /// @return Job function suitable for adding to a scheduler.
+  static PeriodicJobScheduler::TJobFunction CountingJob(
+      std::atomic<unsigned int>& invocationCount, PeriodicJobScheduler::EJobResult jobResult)
+  {
+    return [&invocationCount, jobResult]() -> PeriodicJobScheduler::EJobResult
+    {
+      invocationCount += 1;
+      return jobResult;
+    };
+  }
+
+  // Verifies that jobs are not invoked at all until the scheduler is started.
+  TEST_CASE(PeriodicJobScheduler_NotStarted)
+  {
+    std::atomic<unsigned int> invocationCount = 0;
+
+    PeriodicJobScheduler scheduler;
+    const auto jobIdentifier = scheduler.AddJob(
+        {.period = std::chrono::milliseconds(1),
+         .errorBackoffPeriod = std::chrono::milliseconds(1)},
+        CountingJob(invocationCount, PeriodicJobScheduler::EJobResult::Success));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    TEST_ASSERT(false == scheduler.IsRunning());
+    TEST_ASSERT(0 == invocationCount);
+    TEST_ASSERT(0 == scheduler.GetJobInvocationCount(jobIdentifier));
+  }
+
+  // Verifies that a single worker thread services multiple jobs, each according to its own period.
+  // A job with a short period should be invoked many more times than a job with a long period.
+  TEST_CASE(PeriodicJobScheduler_MultipleJobPeriods)
+  {
+    std::atomic<unsigned int> fastInvocationCount = 0;
+    std::atomic<unsigned int> slowInvocationCount = 0;
+
+    PeriodicJobScheduler scheduler;
+    scheduler.AddJob(
+        {.period = std::chrono::milliseconds(2),
+         .errorBackoffPeriod = std::chrono::milliseconds(1000)},
+        CountingJob(fastInvocationCount, PeriodicJobScheduler::EJobResult::Success));
+    scheduler.AddJob(
+        {.period = std::chrono::milliseconds(100),
+         .errorBackoffPeriod = std::chrono::milliseconds(1000)},
+        CountingJob(slowInvocationCount, PeriodicJobScheduler::EJobResult::Success));
+
+    scheduler.Start();
+    std::this_thread::sleep_for(kTestDuration);
+    scheduler.Stop();
+
+    TEST_ASSERT(false == scheduler.IsRunning());
+    TEST_ASSERT(slowInvocationCount >= 1);
+    TEST_ASSERT(slowInvocationCount <= 5);
+    TEST_ASSERT(fastInvocationCount > (4 * slowInvocationCount));
+  }
+
+  // Verifies that a job reporting an error is delayed by its error backoff period rather than by
+  // its normal period, and that this does not affect other jobs serviced by the same scheduler.
+  TEST_CASE(PeriodicJobScheduler_ErrorBackoff)
+  {
+    std::atomic<unsigned int> successInvocationCount = 0;
+    std::atomic<unsigned int> errorInvocationCount = 0;
+
+    PeriodicJobScheduler scheduler;
+    scheduler.AddJob(
+        {.period = std::chrono::milliseconds(2),
+         .errorBackoffPeriod = std::chrono::milliseconds(2)},
+        CountingJob(successInvocationCount, PeriodicJobScheduler::EJobResult::Success));
+    const auto errorJobIdentifier = scheduler.AddJob(
+        {.period = std::chrono::milliseconds(2),
+         .errorBackoffPeriod = std::chrono::milliseconds(10000)},
+        CountingJob(errorInvocationCount, PeriodicJobScheduler::EJobResult::Error));
+
+    scheduler.Start();
+    std::this_thread::sleep_for(kTestDuration);
+    scheduler.Stop();
+
+    TEST_ASSERT(1 == errorInvocationCount);
+    TEST_ASSERT(1 == scheduler.GetJobInvocationCount(errorJobIdentifier));
+    TEST_ASSERT(successInvocationCount > 10);
+  }
+
+  // Verifies that a job reporting that it is idle is invoked progressively less frequently, until
+  // its period reaches the idle period, whereas an otherwise-identical job that is never idle keeps
+  // being invoked at its nominal period.
+  TEST_CASE(PeriodicJobScheduler_IdleDecay)
+  {
+    std::atomic<unsigned int> activeInvocationCount = 0;
+    std::atomic<unsigned int> idleInvocationCount = 0;
+
+    constexpr PeriodicJobScheduler::SJobPolicy kAdaptivePolicy = {
+        .period = std::chrono::milliseconds(2),
+        .errorBackoffPeriod = std::chrono::milliseconds(10000),
+        .idlePeriod = std::chrono::milliseconds(50),
+        .idleDecayPeriod = std::chrono::milliseconds(100)};
+
+    PeriodicJobScheduler scheduler;
+    scheduler.AddJob(
+        kAdaptivePolicy,
+        CountingJob(activeInvocationCount, PeriodicJobScheduler::EJobResult::Success));
+    scheduler.AddJob(
+        kAdaptivePolicy, CountingJob(idleInvocationCount, PeriodicJobScheduler::EJobResult::Idle));
+
+    scheduler.Start();
+    std::this_thread::sleep_for(kTestDuration);
+    scheduler.Stop();
+
+    // Over the test duration the idle job can be invoked at most a few times during the decay
+    // period plus once per idle period thereafter.
+    TEST_ASSERT(idleInvocationCount >= 5);
+    TEST_ASSERT(idleInvocationCount <= 30);
+    TEST_ASSERT(activeInvocationCount > (3 * idleInvocationCount));
+  }
+
+  // Verifies that jobs can be added while the scheduler is already running and that a newly-added
+  // job with an earlier deadline than all existing jobs wakes the worker thread.
+  TEST_CASE(PeriodicJobScheduler_AddWhileRunning)
+  {
+    std::atomic<unsigned int> slowInvocationCount = 0;
+    std::atomic<unsigned int> fastInvocationCount = 0;
+
+    PeriodicJobScheduler scheduler;
+    scheduler.AddJob(
+        {.period = std::chrono::milliseconds(10000),
+         .errorBackoffPeriod = std::chrono::milliseconds(10000)},
+        CountingJob(slowInvocationCount, PeriodicJobScheduler::EJobResult::Success));
+
+    scheduler.Start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    scheduler.AddJob(
+        {.period = std::chrono::milliseconds(2),
+         .errorBackoffPeriod = std::chrono::milliseconds(2)},
+        CountingJob(fastInvocationCount, PeriodicJobScheduler::EJobResult::Success));
+    std::this_thread::sleep_for(kTestDuration);
+    scheduler.Stop();
+
+    TEST_ASSERT(0 == slowInvocationCount);
+    TEST_ASSERT(fastInvocationCount > 10);
+  }
+
+  // Verifies that a job that parks itself is not invoked again until it is resumed, and that once
+  // resumed it runs again according to its policy.
+  TEST_CASE(PeriodicJobScheduler_ParkAndResume)
+  {
+    constexpr unsigned int kInvocationsBeforePark = 3;
+    std::atomic<unsigned int> invocationCount = 0;
+    std::atomic<bool> shouldPark = true;
+
+    PeriodicJobScheduler scheduler;
+    const auto jobIdentifier = scheduler.AddJob(
+        {.period = std::chrono::milliseconds(2),
+         .errorBackoffPeriod = std::chrono::milliseconds(2)},
+        [&invocationCount, &shouldPark]() -> PeriodicJobScheduler::EJobResult
+        {
+          invocationCount += 1;
+          if ((true == shouldPark) && (invocationCount >= kInvocationsBeforePark))
+            return PeriodicJobScheduler::EJobResult::Park;
+          return PeriodicJobScheduler::EJobResult::Success;
+        });
+
+    scheduler.Start();
+    std::this_thread::sleep_for(kTestDuration);
+
+    TEST_ASSERT(kInvocationsBeforePark == invocationCount);
+    TEST_ASSERT(kInvocationsBeforePark == scheduler.GetJobInvocationCount(jobIdentifier));
+
+    shouldPark = false;
+    scheduler.ResumeJob(jobIdentifier);
+    std::this_thread::sleep_for(kTestDuration);
+    scheduler.Stop();
+
+    TEST_ASSERT(invocationCount > (kInvocationsBeforePark + 10));
+  }
+
+  // Verifies that resuming a job while it is being invoked takes effect even if that same
+  // invocation asks for the job to be parked, so that no resume request is ever lost.
+  TEST_CASE(PeriodicJobScheduler_ResumeWhileInvoked)
+  {
+    std::atomic<unsigned int> invocationCount = 0;
+    std::atomic<bool> isFirstInvocationInProgress = false;
+    std::atomic<bool> canFirstInvocationFinish = false;
+
+    PeriodicJobScheduler scheduler;
+    const auto jobIdentifier = scheduler.AddJob(
+        {.period = std::chrono::milliseconds(2),
+         .errorBackoffPeriod = std::chrono::milliseconds(2)},
+        [&invocationCount,
+         &isFirstInvocationInProgress,
+         &canFirstInvocationFinish]() -> PeriodicJobScheduler::EJobResult
+        {
+          invocationCount += 1;
+          if (1 == invocationCount)
+          {
+            isFirstInvocationInProgress = true;
+            isFirstInvocationInProgress.notify_all();
+            canFirstInvocationFinish.wait(false);
+          }
+          return PeriodicJobScheduler::EJobResult::Park;
+        });
+
+    scheduler.Start();
+    isFirstInvocationInProgress.wait(false);
+
+    scheduler.ResumeJob(jobIdentifier);
+    canFirstInvocationFinish = true;
+    canFirstInvocationFinish.notify_all();
+
+    std::this_thread::sleep_for(kTestDuration);
+    scheduler.Stop();
+
+    TEST_ASSERT(2 == invocationCount);
+  }
+
+  // Verifies that resuming a job that reported being idle invokes it immediately instead of waiting
+  // for its idle period to elapse, and that it does not leave the job invoked more often afterwards.
+  TEST_CASE(PeriodicJobScheduler_ResumeIdle)
+  {
+    std::atomic<unsigned int> invocationCount = 0;
+
+    PeriodicJobScheduler scheduler;
+    const auto jobIdentifier = scheduler.AddJob(
+        {.period = std::chrono::milliseconds(2),
+         .errorBackoffPeriod = std::chrono::milliseconds(10000),
+         .idlePeriod = std::chrono::milliseconds(10000),
+         .idleDecayPeriod = std::chrono::milliseconds(0)},
+        CountingJob(invocationCount, PeriodicJobScheduler::EJobResult::Idle));
+
+    scheduler.Start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    TEST_ASSERT(1 == invocationCount);
+
+    scheduler.ResumeJob(jobIdentifier);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    TEST_ASSERT(2 == invocationCount);
+
+    scheduler.ResumeJob(jobIdentifier);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    scheduler.Stop();
+
+    TEST_ASSERT(3 == invocationCount);
+  }
+
+  // Verifies that resuming a job that is not parked has no effect on how often it is invoked.
+  TEST_CASE(PeriodicJobScheduler_ResumeNotParked)
+  {
+    std::atomic<unsigned int> invocationCount = 0;
+
+    PeriodicJobScheduler scheduler;
+    const auto jobIdentifier = scheduler.AddJob(
+        {.period = std::chrono::milliseconds(10000),
+         .errorBackoffPeriod = std::chrono::milliseconds(10000)},
+        CountingJob(invocationCount, PeriodicJobScheduler::EJobResult::Success));
+
+    scheduler.Start();
+    scheduler.ResumeJob(jobIdentifier);
+    scheduler.ResumeJob(jobIdentifier + 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    scheduler.Stop();
+
+    TEST_ASSERT(0 == invocationCount);
+  }
+} // namespace XidiTest
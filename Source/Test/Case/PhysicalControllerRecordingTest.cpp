@@ -0,0 +1,230 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file PhysicalControllerRecordingTest.cpp
+ *   Unit tests for recording physical controller sessions and replaying them through a mapper.
+ **************************************************************************************************/
+
+#include "PhysicalControllerRecording.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <Infra/Test/TestCase.h>
+
+#include "ControllerTypes.h"
+#include "ElementMapper.h"
+#include "Mapper.h"
+#include "PhysicalControllerSource.h"
+
+namespace XidiTest
+{
+  using namespace ::Xidi::Controller;
+
+  /// Creates a physical state that is distinguishable from others by the specified value.
+  /// @param [in] value Value used to distinguish the physical state.
+  /// @return Physical state.
+  static SPhysicalState MakeTestPhysicalState(int16_t value)
+  {
+    SPhysicalState physicalState = {
+        .deviceStatus = EPhysicalDeviceStatus::Ok,
+        .stick = {value, (int16_t)-value, (int16_t)(value / 2), 0},
+        .trigger = {(uint8_t)value, (uint8_t)(255 - (uint8_t)value)}};
+    physicalState.button = (uint16_t)value;
+    physicalState[EPhysicalButton::UnusedGuide] = false;
+    physicalState[EPhysicalButton::UnusedShare] = false;
+    return physicalState;
+  }
+
+  /// Encodes a sequence of samples into a complete recording.
+  /// @param [in] samples Samples to encode, each with its controller identifier.
+  /// @return Encoded recording.
+  static std::vector<uint8_t> EncodeTestRecording(
+      const std::vector<std::pair<TControllerIdentifier, SReplaySample>>& samples)
+  {
+    std::vector<uint8_t> encodedRecording;
+    Recording::Encoder encoder;
+
+    Recording::Encoder::EncodeHeader(encodedRecording);
+    for (const auto& sample : samples)
+      encoder.EncodeRecord(
+          sample.first,
+          sample.second.timestampMicroseconds,
+          sample.second.physicalState,
+          encodedRecording);
+
+    return encodedRecording;
+  }
+
+  // Verifies that samples from multiple physical controllers survive a round trip through the
+  // encoder and decoder with their timestamps and full physical states intact.
+  TEST_CASE(PhysicalControllerRecording_RoundTrip)
+  {
+    const std::vector<std::pair<TControllerIdentifier, SReplaySample>> kTestSamples = {
+        {0, {.timestampMicroseconds = 0, .physicalState = MakeTestPhysicalState(10)}},
+        {2, {.timestampMicroseconds = 15, .physicalState = MakeTestPhysicalState(20)}},
+        {0, {.timestampMicroseconds = 1000, .physicalState = MakeTestPhysicalState(11)}},
+        {0,
+         {.timestampMicroseconds = 5000000000ull,
+          .physicalState = {.deviceStatus = EPhysicalDeviceStatus::Error}}},
+        {2, {.timestampMicroseconds = 5000000001ull, .physicalState = MakeTestPhysicalState(-30)}},
+        {0, {.timestampMicroseconds = 5000000500ull, .physicalState = MakeTestPhysicalState(12)}},
+    };
+
+    const std::vector<uint8_t> encodedRecording = EncodeTestRecording(kTestSamples);
+
+    ReplayPhysicalControllerSource::TRecording decodedRecording;
+    TEST_ASSERT(
+        true ==
+        Recording::Decode(encodedRecording.data(), encodedRecording.size(), decodedRecording));
+
+    std::array<size_t, kPhysicalControllerCount> nextSampleIndex = {};
+    for (const auto& testSample : kTestSamples)
+    {
+      const auto& decodedSamples = decodedRecording[testSample.first];
+      const size_t sampleIndex = nextSampleIndex[testSample.first]++;
+
+      TEST_ASSERT(sampleIndex < decodedSamples.size());
+      TEST_ASSERT(
+          testSample.second.timestampMicroseconds ==
+          decodedSamples[sampleIndex].timestampMicroseconds);
+      TEST_ASSERT(testSample.second.physicalState == decodedSamples[sampleIndex].physicalState);
+    }
+
+    for (TControllerIdentifier i = 0; i < kPhysicalControllerCount; ++i)
+      TEST_ASSERT(nextSampleIndex[i] == decodedRecording[i].size());
+  }
+
+  // Verifies that records only contain the fields that changed, and that states identical to the
+  // previous one for the same physical controller are not recorded at all.
+  TEST_CASE(PhysicalControllerRecording_DeltaEncoding)
+  {
+    Recording::Encoder encoder;
+    std::vector<uint8_t> buffer;
+
+    SPhysicalState physicalState = MakeTestPhysicalState(100);
+    TEST_ASSERT(true == encoder.EncodeRecord(1, 0, physicalState, buffer));
+    buffer.clear();
+
+    TEST_ASSERT(false == encoder.EncodeRecord(1, 10, physicalState, buffer));
+    TEST_ASSERT(true == buffer.empty());
+
+    // One timestamp byte, one controller byte, one field mask byte, and two bytes of stick data.
+    physicalState[EPhysicalStick::RightY] = 12345;
+    TEST_ASSERT(true == encoder.EncodeRecord(1, 20, physicalState, buffer));
+    TEST_ASSERT(5 == buffer.size());
+    buffer.clear();
+
+    // The same state is still new for a different physical controller.
+    TEST_ASSERT(true == encoder.EncodeRecord(3, 30, physicalState, buffer));
+    TEST_ASSERT(buffer.size() > 5);
+  }
+
+  // Verifies that a recording with nothing but a header decodes successfully to an empty
+  // recording.
+  TEST_CASE(PhysicalControllerRecording_HeaderOnly)
+  {
+    const std::vector<uint8_t> encodedRecording = EncodeTestRecording({});
+    TEST_ASSERT(sizeof(Recording::SRecordingHeader) == encodedRecording.size());
+
+    ReplayPhysicalControllerSource::TRecording decodedRecording;
+    decodedRecording[0].push_back({});
+
+    TEST_ASSERT(
+        true ==
+        Recording::Decode(encodedRecording.data(), encodedRecording.size(), decodedRecording));
+    for (const auto& decodedSamples : decodedRecording)
+      TEST_ASSERT(true == decodedSamples.empty());
+  }
+
+  // Verifies that malformed recordings are rejected. Covers missing or incorrect headers,
+  // truncated records, and records with out-of-range contents.
+  TEST_CASE(PhysicalControllerRecording_Malformed)
+  {
+    const std::vector<uint8_t> kValidRecording = EncodeTestRecording(
+        {{1, {.timestampMicroseconds = 300, .physicalState = MakeTestPhysicalState(55)}}});
+    constexpr size_t kControllerIdentifierOffset = sizeof(Recording::SRecordingHeader) + 2;
+    constexpr size_t kDeviceStatusOffset = sizeof(Recording::SRecordingHeader) + 4;
+
+    ReplayPhysicalControllerSource::TRecording decodedRecording;
+    TEST_ASSERT(
+        true ==
+        Recording::Decode(kValidRecording.data(), kValidRecording.size(), decodedRecording));
+
+    TEST_ASSERT(false == Recording::Decode(kValidRecording.data(), 0, decodedRecording));
+    TEST_ASSERT(false == Recording::Decode(kValidRecording.data(), 5, decodedRecording));
+    TEST_ASSERT(
+        false ==
+        Recording::Decode(kValidRecording.data(), kValidRecording.size() - 1, decodedRecording));
+
+    std::vector<uint8_t> badMagic = kValidRecording;
+    badMagic[0] ^= 0xff;
+    TEST_ASSERT(false == Recording::Decode(badMagic.data(), badMagic.size(), decodedRecording));
+
+    std::vector<uint8_t> badVersion = kValidRecording;
+    badVersion[4] += 1;
+    TEST_ASSERT(
+        false == Recording::Decode(badVersion.data(), badVersion.size(), decodedRecording));
+
+    std::vector<uint8_t> badControllerIdentifier = kValidRecording;
+    badControllerIdentifier[kControllerIdentifierOffset] = kPhysicalControllerCount;
+    TEST_ASSERT(
+        false ==
+        Recording::Decode(
+            badControllerIdentifier.data(), badControllerIdentifier.size(), decodedRecording));
+
+    std::vector<uint8_t> badDeviceStatus = kValidRecording;
+    badDeviceStatus[kDeviceStatusOffset] = (uint8_t)EPhysicalDeviceStatus::Count;
+    TEST_ASSERT(
+        false ==
+        Recording::Decode(badDeviceStatus.data(), badDeviceStatus.size(), decodedRecording));
+  }
+
+  // Verifies that replaying a recording through a mapper produces exactly the virtual controller
+  // states that the mapper produces for each recorded physical state, in order, and that
+  // throughput is reported.
+  TEST_CASE(PhysicalControllerRecording_Replay)
+  {
+    constexpr int16_t kTestSampleCount = 1000;
+
+    const Mapper kTestMapper(
+        {.stickLeftX = std::make_unique<AxisMapper>(EAxis::X),
+         .stickLeftY = std::make_unique<AxisMapper>(EAxis::Y),
+         .triggerLT = std::make_unique<AxisMapper>(EAxis::Z),
+         .buttonA = std::make_unique<ButtonMapper>(EButton::B1),
+         .buttonB = std::make_unique<ButtonMapper>(EButton::B2)});
+
+    ReplayPhysicalControllerSource::TRecording recording;
+    for (int16_t i = 0; i < kTestSampleCount; ++i)
+    {
+      recording[0].push_back(
+          {.timestampMicroseconds = (uint64_t)i, .physicalState = MakeTestPhysicalState(i)});
+      recording[3].push_back(
+          {.timestampMicroseconds = (uint64_t)i,
+           .physicalState = MakeTestPhysicalState((int16_t)-i)});
+    }
+
+    const Recording::SReplayResult replayResult = Recording::Replay(
+        recording, kTestMapper, ReplayPhysicalControllerSource::ESpeed::Maximum);
+
+    TEST_ASSERT((2 * kTestSampleCount) == replayResult.sampleCount);
+    TEST_ASSERT(replayResult.SamplesPerSecond() > 0.0);
+
+    for (TControllerIdentifier i = 0; i < kPhysicalControllerCount; ++i)
+    {
+      TEST_ASSERT(recording[i].size() == replayResult.virtualStates[i].size());
+
+      for (size_t j = 0; j < recording[i].size(); ++j)
+        TEST_ASSERT(
+            kTestMapper.MapStatePhysicalToVirtual(recording[i][j].physicalState, i) ==
+            replayResult.virtualStates[i][j]);
+    }
+  }
+} // namespace XidiTest
@@ -0,0 +1,324 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file PhysicalControllerSourceTest.cpp
+ *   Unit tests for the synthetic and replay sources of physical controller data.
+ **************************************************************************************************/
+
+#include "PhysicalControllerSource.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <stop_token>
+#include <utility>
+
+#include <Infra/Test/TestCase.h>
+
+#include "ControllerTypes.h"
+#include "ForceFeedbackTypes.h"
+#include "PhysicalPacketFilter.h"
+
+namespace XidiTest
+{
+  using namespace ::Xidi::Controller;
+
+  /// Sample rate to use for tests that wait for synthetic samples. Set to the maximum so that
+  /// tests complete quickly.
+  static constexpr unsigned int kTestSampleRateHz =
+      SyntheticPhysicalControllerSource::kSampleRateMaxHz;
+
+  /// Number of synthetic samples to check in tests that examine waveforms.
+  static constexpr uint64_t kTestWaveformSampleCount = 4000;
+
+  /// Creates a physical state that is distinguishable from others by the specified value.
+  /// @param [in] value Value used to distinguish the physical state.
+  /// @return Physical state.
+  static SPhysicalState MakeTestPhysicalState(int16_t value)
+  {
+    return {
+        .deviceStatus = EPhysicalDeviceStatus::Ok,
+        .stick = {value, (int16_t)-value, 0, 0},
+        .trigger = {(uint8_t)value, 0}};
+  }
+
+  // Verifies that synthetic states depend only on the sample index and not on the source object,
+  // and that each physical controller produces a different state for the same sample.
+  TEST_CASE(SyntheticPhysicalControllerSource_Deterministic)
+  {
+    const SyntheticPhysicalControllerSource::SWaveformScript kScript = {
+        .sampleRateHz = kTestSampleRateHz};
+    SyntheticPhysicalControllerSource sourceA(kScript);
+    SyntheticPhysicalControllerSource sourceB(kScript);
+
+    for (TControllerIdentifier i = 0; i < kPhysicalControllerCount; ++i)
+    {
+      PhysicalPacketFilter::TPacketNumber packetNumberA = 1;
+      PhysicalPacketFilter::TPacketNumber packetNumberB = 1;
+
+      const SPhysicalState stateA = sourceA.ReadState(i, packetNumberA);
+      const SPhysicalState stateB = sourceB.ReadState(i, packetNumberB);
+
+      TEST_ASSERT(EPhysicalDeviceStatus::Ok == stateA.deviceStatus);
+      TEST_ASSERT(stateA == stateB);
+      TEST_ASSERT(packetNumberA == packetNumberB);
+      TEST_ASSERT(0 == packetNumberA);
+      TEST_ASSERT(SyntheticPhysicalControllerSource::StateAtSample(kScript, i, 0) == stateA);
+    }
+
+    for (TControllerIdentifier i = 1; i < kPhysicalControllerCount; ++i)
+    {
+      TEST_ASSERT(
+          SyntheticPhysicalControllerSource::StateAtSample(kScript, 0, 123) !=
+          SyntheticPhysicalControllerSource::StateAtSample(kScript, i, 123));
+    }
+  }
+
+  // Verifies that synthetic waveforms stay within their expected ranges and actually move. Sticks
+  // trace circles at full deflection, triggers always add up to the maximum trigger value, unused
+  // buttons are never pressed, and every used button is pressed at some point.
+  TEST_CASE(SyntheticPhysicalControllerSource_WaveformRanges)
+  {
+    const SyntheticPhysicalControllerSource::SWaveformScript kScript = {
+        .sampleRateHz = kTestSampleRateHz,
+        .stickPeriod = std::chrono::milliseconds(100),
+        .triggerPeriod = std::chrono::milliseconds(50),
+        .buttonPeriod = std::chrono::milliseconds(1)};
+
+    for (TControllerIdentifier i = 0; i < kPhysicalControllerCount; ++i)
+    {
+      SPhysicalState buttonsEverPressed = {};
+      int32_t leftTriggerMin = kTriggerValueMax;
+      int32_t leftTriggerMax = 0;
+
+      for (uint64_t sampleIndex = 0; sampleIndex < kTestWaveformSampleCount; ++sampleIndex)
+      {
+        const SPhysicalState state =
+            SyntheticPhysicalControllerSource::StateAtSample(kScript, i, sampleIndex);
+        TEST_ASSERT(EPhysicalDeviceStatus::Ok == state.deviceStatus);
+
+        const double leftStickMagnitude = std::hypot(
+            (double)state[EPhysicalStick::LeftX], (double)state[EPhysicalStick::LeftY]);
+        const double rightStickMagnitude = std::hypot(
+            (double)state[EPhysicalStick::RightX], (double)state[EPhysicalStick::RightY]);
+        TEST_ASSERT(std::abs(leftStickMagnitude - kAnalogValueMax) < 2.0);
+        TEST_ASSERT(std::abs(rightStickMagnitude - kAnalogValueMax) < 2.0);
+
+        TEST_ASSERT(
+            kTriggerValueMax ==
+            ((int32_t)state[EPhysicalTrigger::LT] + (int32_t)state[EPhysicalTrigger::RT]));
+        leftTriggerMin = std::min<int32_t>(leftTriggerMin, state[EPhysicalTrigger::LT]);
+        leftTriggerMax = std::max<int32_t>(leftTriggerMax, state[EPhysicalTrigger::LT]);
+
+        TEST_ASSERT(false == state[EPhysicalButton::UnusedGuide]);
+        TEST_ASSERT(false == state[EPhysicalButton::UnusedShare]);
+        buttonsEverPressed.button |= state.button;
+      }
+
+      TEST_ASSERT(leftTriggerMin <= 5);
+      TEST_ASSERT(leftTriggerMax >= (kTriggerValueMax - 5));
+
+      for (int b = 0; b < static_cast<int>(EPhysicalButton::Count); ++b)
+      {
+        const EPhysicalButton button = static_cast<EPhysicalButton>(b);
+        if ((EPhysicalButton::UnusedGuide == button) || (EPhysicalButton::UnusedShare == button))
+          continue;
+
+        TEST_ASSERT(true == buttonsEverPressed[button]);
+      }
+    }
+  }
+
+  // Verifies that waiting for the next synthetic sample advances the sample index and packet
+  // number by one each time, that samples are paced according to the sample rate, and that
+  // physical controllers advance independently of each other.
+  TEST_CASE(SyntheticPhysicalControllerSource_WaitForNextSample)
+  {
+    constexpr unsigned int kWaitCount = 40;
+    constexpr TControllerIdentifier kControllerIdentifier = 2;
+
+    SyntheticPhysicalControllerSource source({.sampleRateHz = kTestSampleRateHz});
+    TEST_ASSERT(true == source.SupportsWaitForNextSample());
+
+    const auto startTime = SyntheticPhysicalControllerSource::TClock::now();
+    for (unsigned int i = 1; i <= kWaitCount; ++i)
+    {
+      TEST_ASSERT(true == source.WaitForNextSample(kControllerIdentifier, std::stop_token()));
+      TEST_ASSERT(i == source.GetSampleIndex(kControllerIdentifier));
+
+      PhysicalPacketFilter::TPacketNumber packetNumber = 0;
+      source.ReadState(kControllerIdentifier, packetNumber);
+      TEST_ASSERT(i == packetNumber);
+    }
+    const auto elapsedTime = SyntheticPhysicalControllerSource::TClock::now() - startTime;
+
+    // The first sample is due one sample period after the source was created, so the last one
+    // can be no earlier than the total duration of all of the samples minus that one period.
+    TEST_ASSERT(
+        elapsedTime >=
+        std::chrono::duration<double>((double)(kWaitCount - 1) / (double)kTestSampleRateHz));
+
+    for (TControllerIdentifier i = 0; i < kPhysicalControllerCount; ++i)
+    {
+      if (kControllerIdentifier != i) TEST_ASSERT(0 == source.GetSampleIndex(i));
+    }
+  }
+
+  // Verifies that a wait for the next synthetic sample is abandoned without advancing if a stop
+  // is requested.
+  TEST_CASE(SyntheticPhysicalControllerSource_WaitForNextSampleStopRequested)
+  {
+    SyntheticPhysicalControllerSource source(
+        {.sampleRateHz = SyntheticPhysicalControllerSource::kSampleRateMinHz});
+
+    std::stop_source stopSource;
+    stopSource.request_stop();
+
+    TEST_ASSERT(false == source.WaitForNextSample(0, stopSource.get_token()));
+    TEST_ASSERT(0 == source.GetSampleIndex(0));
+  }
+
+  // Verifies that the synthetic source remembers the most recent vibration command written to
+  // each physical controller.
+  TEST_CASE(SyntheticPhysicalControllerSource_WriteVibration)
+  {
+    constexpr ForceFeedback::SPhysicalActuatorComponents kTestVibration = {
+        .leftMotor = 1111,
+        .rightMotor = 2222,
+        .leftImpulseTrigger = 3333,
+        .rightImpulseTrigger = 4444};
+
+    SyntheticPhysicalControllerSource source;
+    TEST_ASSERT(true == source.WriteVibration(1, kTestVibration));
+
+    TEST_ASSERT(kTestVibration == source.GetLastVibration(1));
+    TEST_ASSERT(ForceFeedback::SPhysicalActuatorComponents() == source.GetLastVibration(0));
+    TEST_ASSERT(false == source.WriteVibration(kPhysicalControllerCount, kTestVibration));
+  }
+
+  // Verifies that recorded samples are played back in order, one per wait, with packet numbers
+  // that change each time, and that playback reports being finished after the last sample.
+  TEST_CASE(ReplayPhysicalControllerSource_Nominal)
+  {
+    constexpr TControllerIdentifier kControllerIdentifier = 1;
+    constexpr int16_t kTestSampleCount = 5;
+
+    ReplayPhysicalControllerSource::TRecording recording;
+    for (int16_t i = 0; i < kTestSampleCount; ++i)
+      recording[kControllerIdentifier].push_back(
+          {.timestampMicroseconds = (uint64_t)(1000 * i),
+           .physicalState = MakeTestPhysicalState(1 + i)});
+
+    ReplayPhysicalControllerSource source(
+        std::move(recording), ReplayPhysicalControllerSource::ESpeed::Maximum);
+
+    for (int16_t i = 0; i < kTestSampleCount; ++i)
+    {
+      if (0 != i)
+        TEST_ASSERT(true == source.WaitForNextSample(kControllerIdentifier, std::stop_token()));
+
+      PhysicalPacketFilter::TPacketNumber packetNumber = 0;
+      TEST_ASSERT(
+          MakeTestPhysicalState(1 + i) == source.ReadState(kControllerIdentifier, packetNumber));
+      TEST_ASSERT((PhysicalPacketFilter::TPacketNumber)i == packetNumber);
+      TEST_ASSERT(false == source.IsFinished(kControllerIdentifier));
+    }
+
+    TEST_ASSERT(false == source.WaitForNextSample(kControllerIdentifier, std::stop_token()));
+    TEST_ASSERT(true == source.IsFinished(kControllerIdentifier));
+
+    // The last sample remains available after playback is finished.
+    PhysicalPacketFilter::TPacketNumber packetNumber = 0;
+    TEST_ASSERT(
+        MakeTestPhysicalState(kTestSampleCount) ==
+        source.ReadState(kControllerIdentifier, packetNumber));
+  }
+
+  // Verifies that physical controllers without any recorded samples are reported as not
+  // connected and are immediately finished.
+  TEST_CASE(ReplayPhysicalControllerSource_EmptyRecording)
+  {
+    ReplayPhysicalControllerSource::TRecording recording;
+    recording[0].push_back({.timestampMicroseconds = 0, .physicalState = MakeTestPhysicalState(1)});
+
+    ReplayPhysicalControllerSource source(
+        std::move(recording), ReplayPhysicalControllerSource::ESpeed::Maximum);
+
+    TEST_ASSERT(false == source.IsFinished(0));
+    for (TControllerIdentifier i = 1; i < kPhysicalControllerCount; ++i)
+    {
+      PhysicalPacketFilter::TPacketNumber packetNumber = 0;
+      TEST_ASSERT(
+          EPhysicalDeviceStatus::NotConnected == source.ReadState(i, packetNumber).deviceStatus);
+      TEST_ASSERT(true == source.IsFinished(i));
+      TEST_ASSERT(false == source.WaitForNextSample(i, std::stop_token()));
+    }
+  }
+
+  // Verifies that playback at the original speed reproduces the spacing between recorded samples.
+  TEST_CASE(ReplayPhysicalControllerSource_OriginalSpeed)
+  {
+    constexpr auto kSampleSpacing = std::chrono::milliseconds(5);
+    constexpr int16_t kTestSampleCount = 4;
+
+    ReplayPhysicalControllerSource::TRecording recording;
+    for (int16_t i = 0; i < kTestSampleCount; ++i)
+      recording[0].push_back(
+          {.timestampMicroseconds =
+               (uint64_t)(1000000 + (std::chrono::microseconds(kSampleSpacing).count() * i)),
+           .physicalState = MakeTestPhysicalState(1 + i)});
+
+    const auto startTime = ReplayPhysicalControllerSource::TClock::now();
+    ReplayPhysicalControllerSource source(
+        std::move(recording), ReplayPhysicalControllerSource::ESpeed::Original);
+
+    for (int16_t i = 1; i < kTestSampleCount; ++i)
+      TEST_ASSERT(true == source.WaitForNextSample(0, std::stop_token()));
+
+    const auto elapsedTime = ReplayPhysicalControllerSource::TClock::now() - startTime;
+    TEST_ASSERT(elapsedTime >= (kSampleSpacing * (kTestSampleCount - 1)));
+  }
+
+  // Verifies that synthetic samples recorded into a replay recording are played back exactly,
+  // which is how a synthetic load test can be captured once and then repeated.
+  TEST_CASE(ReplayPhysicalControllerSource_RoundTripSynthetic)
+  {
+    const SyntheticPhysicalControllerSource::SWaveformScript kScript = {
+        .sampleRateHz = kTestSampleRateHz};
+
+    ReplayPhysicalControllerSource::TRecording recording;
+    for (TControllerIdentifier i = 0; i < kPhysicalControllerCount; ++i)
+    {
+      for (uint64_t sampleIndex = 0; sampleIndex < kTestWaveformSampleCount; ++sampleIndex)
+        recording[i].push_back(
+            {.timestampMicroseconds = (sampleIndex * 1000000) / kTestSampleRateHz,
+             .physicalState =
+                 SyntheticPhysicalControllerSource::StateAtSample(kScript, i, sampleIndex)});
+    }
+
+    ReplayPhysicalControllerSource source(
+        std::move(recording), ReplayPhysicalControllerSource::ESpeed::Maximum);
+
+    for (TControllerIdentifier i = 0; i < kPhysicalControllerCount; ++i)
+    {
+      uint64_t sampleIndex = 0;
+      do
+      {
+        PhysicalPacketFilter::TPacketNumber packetNumber = 0;
+        TEST_ASSERT(
+            SyntheticPhysicalControllerSource::StateAtSample(kScript, i, sampleIndex) ==
+            source.ReadState(i, packetNumber));
+        sampleIndex += 1;
+      }
+      while (true == source.WaitForNextSample(i, std::stop_token()));
+
+      TEST_ASSERT(kTestWaveformSampleCount == sampleIndex);
+      TEST_ASSERT(true == source.IsFinished(i));
+    }
+  }
+} // namespace XidiTest
@@ -0,0 +1,80 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file PhysicalPacketFilterTest.cpp
+ *   Unit tests for the filter that skips physical controller samples based on packet number.
+ **************************************************************************************************/
+
+#include "PhysicalPacketFilter.h"
+
+#include <cstdint>
+
+#include <Infra/Test/TestCase.h>
+
+#include "ControllerTypes.h"
+
+namespace XidiTest
+{
+  using namespace ::Xidi::Controller;
+
+  // Verifies that the first sample is always new and that repeated packet numbers are skipped
+  // while changed packet numbers are not.
+  TEST_CASE(PhysicalPacketFilter_Nominal)
+  {
+    PhysicalPacketFilter packetFilter;
+
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 100));
+    TEST_ASSERT(false == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 100));
+    TEST_ASSERT(false == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 100));
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 101));
+    TEST_ASSERT(false == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 101));
+  }
+
+  // Verifies that the very first packet number is treated as new even if it happens to be zero.
+  TEST_CASE(PhysicalPacketFilter_FirstPacketZero)
+  {
+    PhysicalPacketFilter packetFilter;
+
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 0));
+    TEST_ASSERT(false == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 0));
+  }
+
+  // Verifies that packet numbers are compared for equality only, so wrapping around is not
+  // mistaken for a repeated packet.
+  TEST_CASE(PhysicalPacketFilter_Wraparound)
+  {
+    PhysicalPacketFilter packetFilter;
+
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, UINT32_MAX));
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 0));
+  }
+
+  // Verifies that samples with an unsuccessful device status are always processed and that they
+  // reset the filter, so the same packet number seen again after a reconnection is still new.
+  TEST_CASE(PhysicalPacketFilter_DeviceStatusResets)
+  {
+    PhysicalPacketFilter packetFilter;
+
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 5));
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::NotConnected, 5));
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::NotConnected, 5));
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 5));
+    TEST_ASSERT(false == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 5));
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Error, 5));
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 5));
+  }
+
+  // Verifies that explicitly resetting the filter causes the next sample to be processed.
+  TEST_CASE(PhysicalPacketFilter_Reset)
+  {
+    PhysicalPacketFilter packetFilter;
+
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 7));
+    packetFilter.Reset();
+    TEST_ASSERT(true == packetFilter.IsNewPacket(EPhysicalDeviceStatus::Ok, 7));
+  }
+} // namespace XidiTest
@@ -0,0 +1,196 @@
+/***************************************************************************************************
+ * Xidi
+ *   DirectInput interface for XInput controllers.
+ ***************************************************************************************************
+ * Authored by Samuel Grossman
+ * Copyright (c) 2016-2025
+ ***********************************************************************************************//**
+ * @file SampleHistoryRingTest.cpp
+ *   Unit tests for the lock-free sample history ring.
+ **************************************************************************************************/
+
+#include "SampleHistoryRing.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <Infra/Test/TestCase.h>
+
+namespace XidiTest
+{
+  using namespace ::Xidi;
+
+  /// Sample type used for tests. Every sample fills all of the values with the same number, so a
+  /// read that observes anything other than identical values indicates that it saw a
+  /// partially-completed write.
+  struct STestSample
+  {
+    std::array<uint32_t, 13> values;
+
+    constexpr bool operator==(const STestSample& other) const = default;
+  };
+
+  /// Capacity of the rings used for tests.
+  static constexpr unsigned int kTestCapacity = 8;
+
+  /// Ring type used for tests.
+  using TTestRing = SampleHistoryRing<STestSample, kTestCapacity>;
+
+  /// Number of reader threads to use for stress tests.
+  static constexpr unsigned int kStressTestReaderCount = 8;
+
+  /// Number of samples the writer thread appends in stress tests.
+  static constexpr uint32_t kStressTestWriteCount = 200000;
+
+  /// Creates a test sample with all values set to the specified number.
+  /// @param [in] value Number to use for all values.
+  /// @return Test sample.
+  static constexpr STestSample MakeTestSample(uint32_t value)
+  {
+    STestSample testSample = {};
+    for (auto& testSampleValue : testSample.values)
+      testSampleValue = value;
+    return testSample;
+  }
+
+  // Verifies that an empty ring has nothing to read.
+  TEST_CASE(SampleHistoryRing_Empty)
+  {
+    const TTestRing ring;
+    TTestRing::TCursor cursor = ring.GetWriteCursor();
+    STestSample sample = {};
+
+    TEST_ASSERT(0 == cursor);
+    TEST_ASSERT(false == ring.Read(cursor, sample));
+    TEST_ASSERT(0 == cursor);
+  }
+
+  // Verifies that samples are read back in the order in which they were appended, and that the
+  // cursor ends up at the write position once all samples are read.
+  TEST_CASE(SampleHistoryRing_ReadInOrder)
+  {
+    TTestRing ring;
+    TTestRing::TCursor cursor = ring.GetWriteCursor();
+
+    for (uint32_t i = 1; i <= 5; ++i)
+      ring.Append(MakeTestSample(i));
+
+    for (uint32_t i = 1; i <= 5; ++i)
+    {
+      STestSample sample = {};
+      TEST_ASSERT(true == ring.Read(cursor, sample));
+      TEST_ASSERT(MakeTestSample(i) == sample);
+    }
+
+    STestSample sample = {};
+    TEST_ASSERT(false == ring.Read(cursor, sample));
+    TEST_ASSERT(ring.GetWriteCursor() == cursor);
+  }
+
+  // Verifies that consumers with independent cursors do not interfere with each other, and that a
+  // consumer starting at the current write position only sees samples appended afterwards.
+  TEST_CASE(SampleHistoryRing_IndependentCursors)
+  {
+    TTestRing ring;
+    TTestRing::TCursor earlyCursor = ring.GetWriteCursor();
+
+    ring.Append(MakeTestSample(1));
+    ring.Append(MakeTestSample(2));
+
+    TTestRing::TCursor lateCursor = ring.GetWriteCursor();
+    ring.Append(MakeTestSample(3));
+
+    STestSample sample = {};
+    TEST_ASSERT(true == ring.Read(lateCursor, sample));
+    TEST_ASSERT(MakeTestSample(3) == sample);
+    TEST_ASSERT(false == ring.Read(lateCursor, sample));
+
+    for (uint32_t i = 1; i <= 3; ++i)
+    {
+      TEST_ASSERT(true == ring.Read(earlyCursor, sample));
+      TEST_ASSERT(MakeTestSample(i) == sample);
+    }
+    TEST_ASSERT(false == ring.Read(earlyCursor, sample));
+  }
+
+  // Verifies that a consumer that falls more than a full ring behind skips ahead to the oldest
+  // sample still available and then continues in order from there.
+  TEST_CASE(SampleHistoryRing_Overrun)
+  {
+    TTestRing ring;
+    TTestRing::TCursor cursor = ring.GetWriteCursor();
+
+    constexpr uint32_t kAppendCount = (3 * kTestCapacity) + 3;
+    for (uint32_t i = 1; i <= kAppendCount; ++i)
+      ring.Append(MakeTestSample(i));
+
+    for (uint32_t i = (kAppendCount - kTestCapacity + 1); i <= kAppendCount; ++i)
+    {
+      STestSample sample = {};
+      TEST_ASSERT(true == ring.Read(cursor, sample));
+      TEST_ASSERT(MakeTestSample(i) == sample);
+    }
+
+    STestSample sample = {};
+    TEST_ASSERT(false == ring.Read(cursor, sample));
+  }
+
+  // Verifies that many concurrent readers never observe a partially-completed sample and never
+  // observe samples out of order while a single writer continuously appends. Readers that keep up
+  // see every sample, and readers that fall behind may skip some, but values must always increase.
+  TEST_CASE(SampleHistoryRing_Stress)
+  {
+    TTestRing ring;
+    std::atomic<bool> writerFinished = false;
+    std::atomic<unsigned int> inconsistentReadCount = 0;
+    std::atomic<unsigned int> outOfOrderReadCount = 0;
+    std::atomic<unsigned int> missingFinalSampleCount = 0;
+
+    std::vector<std::thread> readerThreads;
+    for (unsigned int i = 0; i < kStressTestReaderCount; ++i)
+    {
+      readerThreads.emplace_back(
+          [&ring,
+           &writerFinished,
+           &inconsistentReadCount,
+           &outOfOrderReadCount,
+           &missingFinalSampleCount]() -> void
+          {
+            TTestRing::TCursor cursor = 0;
+            uint32_t lastValueSeen = 0;
+
+            while (true)
+            {
+              const bool writerWasFinished = writerFinished;
+
+              STestSample sample = {};
+              while (true == ring.Read(cursor, sample))
+              {
+                if (MakeTestSample(sample.values[0]) != sample) inconsistentReadCount += 1;
+                if (sample.values[0] <= lastValueSeen) outOfOrderReadCount += 1;
+
+                lastValueSeen = sample.values[0];
+              }
+
+              if (true == writerWasFinished) break;
+            }
+
+            if (kStressTestWriteCount != lastValueSeen) missingFinalSampleCount += 1;
+          });
+    }
+
+    for (uint32_t i = 1; i <= kStressTestWriteCount; ++i)
+      ring.Append(MakeTestSample(i));
+
+    writerFinished = true;
+    for (auto& readerThread : readerThreads)
+      readerThread.join();
+
+    TEST_ASSERT(0 == inconsistentReadCount);
+    TEST_ASSERT(0 == outOfOrderReadCount);
+    TEST_ASSERT(0 == missingFinalSampleCount);
+  }
+} // namespace XidiTest
@@ -11,7 +11,10 @@
 
 #include "StateChangeEventBuffer.h"
 
+#include <atomic>
 #include <cstdint>
+#include <thread>
+#include <vector>
 
 #include <Infra/Test/TestCase.h>
 
@@ -54,6 +57,42 @@ namespace XidiTest
   /// This set of tests does not exercise timestamp generation functionality.
   constexpr uint32_t kTimestamp = 0;
 
+  /// Number of events appended by the producer in concurrency stress tests.
+  constexpr uint32_t kStressTestEventCount = 200000;
+
+  /// Appends events for concurrency stress tests. Each event is for the same axis, and its value
+  /// is its position in the overall sequence of appended events. Events are appended in batches of
+  /// varying sizes.
+  /// @param [in,out] eventBuffer Event buffer to which events are appended.
+  /// @param [in] shouldAvoidOverflow Whether or not to wait for room in the event buffer before
+  /// appending each batch of events.
+  static void StressTestProduceEvents(StateChangeEventBuffer& eventBuffer, bool shouldAvoidOverflow)
+  {
+    constexpr uint32_t kMaxBatchSize = 7;
+    StateChangeEventBuffer::SEventData batch[kMaxBatchSize];
+
+    uint32_t nextValue = 0;
+    for (uint32_t batchSize = 1; nextValue < kStressTestEventCount;
+         batchSize = ((batchSize % kMaxBatchSize) + 1))
+    {
+      if (batchSize > (kStressTestEventCount - nextValue))
+        batchSize = kStressTestEventCount - nextValue;
+
+      if (true == shouldAvoidOverflow)
+      {
+        while ((eventBuffer.GetCount() + batchSize) >= eventBuffer.GetCapacity())
+          std::this_thread::yield();
+      }
+
+      for (uint32_t i = 0; i < batchSize; ++i)
+        batch[i] = {
+            .element = {.type = EElementType::Axis, .axis = EAxis::X},
+            .value = {.axis = (int32_t)nextValue++}};
+
+      eventBuffer.AppendEvents(std::span(batch, batchSize), kTimestamp);
+    }
+  }
+
   // Verifies correct behavior in the nominal case of inserting some events and then removing them
   // in order. The event buffer capacity is well above number of events being inserted, so there is
   // no issue and therefore the buffer should never report overflow. Insertion and removal is
@@ -182,6 +221,344 @@ namespace XidiTest
     }
   }
 
+  // Verifies that appending multiple events at once stores them in order with the same timestamp
+  // and consecutive sequence numbers, and that appending no events at all is a no-op.
+  TEST_CASE(StateChangeEventBuffer_AppendMultiple_Nominal)
+  {
+    constexpr uint32_t kEventBufferCapacity = (1 + _countof(kTestEventData));
+    constexpr uint32_t kTestTimestamp = 12345;
+
+    StateChangeEventBuffer testEventBuffer;
+    testEventBuffer.SetCapacity(kEventBufferCapacity);
+
+    testEventBuffer.AppendEvents({}, kTestTimestamp);
+    TEST_ASSERT(0 == testEventBuffer.GetCount());
+
+    testEventBuffer.AppendEvents(kTestEventData, kTestTimestamp);
+    TEST_ASSERT(_countof(kTestEventData) == testEventBuffer.GetCount());
+    TEST_ASSERT(false == testEventBuffer.IsOverflowed());
+
+    for (int i = 0; i < _countof(kTestEventData); ++i)
+    {
+      TEST_ASSERT(kTestEventData[i] == testEventBuffer[i].data);
+      TEST_ASSERT(kTestTimestamp == testEventBuffer[i].timestamp);
+      TEST_ASSERT((testEventBuffer[0].sequence + i) == testEventBuffer[i].sequence);
+    }
+  }
+
+  // Verifies that appending multiple events at once results in the same buffer contents and
+  // overflow condition as appending them one at a time, when more events are appended than the
+  // buffer can hold.
+  TEST_CASE(StateChangeEventBuffer_AppendMultiple_Overflow)
+  {
+    constexpr uint32_t kEventBufferCapacity = _countof(kTestEventData) / 4;
+
+    StateChangeEventBuffer testEventBufferSingle;
+    testEventBufferSingle.SetCapacity(kEventBufferCapacity);
+    for (const auto& testEventData : kTestEventData)
+      testEventBufferSingle.AppendEvent(testEventData, kTimestamp);
+
+    StateChangeEventBuffer testEventBufferMultiple;
+    testEventBufferMultiple.SetCapacity(kEventBufferCapacity);
+    testEventBufferMultiple.AppendEvents(kTestEventData, kTimestamp);
+
+    TEST_ASSERT(true == testEventBufferMultiple.IsOverflowed());
+    TEST_ASSERT(testEventBufferSingle.IsOverflowed() == testEventBufferMultiple.IsOverflowed());
+    TEST_ASSERT(testEventBufferSingle.GetCount() == testEventBufferMultiple.GetCount());
+
+    for (uint32_t i = 0; i < testEventBufferMultiple.GetCount(); ++i)
+      TEST_ASSERT(testEventBufferSingle[i].data == testEventBufferMultiple[i].data);
+  }
+
+  // Verifies that reading events without removing them leaves the buffer unchanged and that
+  // reading events while removing them removes exactly the events read and clears the overflow
+  // condition.
+  TEST_CASE(StateChangeEventBuffer_ReadOldestEvents_Nominal)
+  {
+    constexpr uint32_t kEventBufferCapacity = _countof(kTestEventData) / 2;
+    constexpr uint32_t kNumEventsToRead = 3;
+
+    StateChangeEventBuffer testEventBuffer;
+    testEventBuffer.SetCapacity(kEventBufferCapacity);
+    testEventBuffer.AppendEvents(kTestEventData, kTimestamp);
+    TEST_ASSERT(true == testEventBuffer.IsOverflowed());
+
+    // Events retained after overflow are the most recent ones.
+    constexpr uint32_t kFirstRetainedIndex = _countof(kTestEventData) - (kEventBufferCapacity - 1);
+
+    for (int i = 0; i < 2; ++i)
+    {
+      const StateChangeEventBuffer::SReadResult peekResult = testEventBuffer.ReadOldestEvents(
+          kNumEventsToRead,
+          false,
+          [](uint32_t index, const StateChangeEventBuffer::SEvent& event) -> void
+          {
+            TEST_ASSERT(index < kNumEventsToRead);
+            TEST_ASSERT(event.data == kTestEventData[kFirstRetainedIndex + index]);
+          });
+
+      TEST_ASSERT(kNumEventsToRead == peekResult.count);
+      TEST_ASSERT(true == peekResult.overflowed);
+      TEST_ASSERT((kEventBufferCapacity - 1) == testEventBuffer.GetCount());
+      TEST_ASSERT(true == testEventBuffer.IsOverflowed());
+    }
+
+    const StateChangeEventBuffer::SReadResult popResult = testEventBuffer.ReadOldestEvents(
+        kNumEventsToRead,
+        true,
+        [](uint32_t index, const StateChangeEventBuffer::SEvent& event) -> void
+        {
+          TEST_ASSERT(index < kNumEventsToRead);
+          TEST_ASSERT(event.data == kTestEventData[kFirstRetainedIndex + index]);
+        });
+
+    TEST_ASSERT(kNumEventsToRead == popResult.count);
+    TEST_ASSERT(true == popResult.overflowed);
+    TEST_ASSERT((kEventBufferCapacity - 1 - kNumEventsToRead) == testEventBuffer.GetCount());
+    TEST_ASSERT(false == testEventBuffer.IsOverflowed());
+    TEST_ASSERT(
+        testEventBuffer[0].data == kTestEventData[kFirstRetainedIndex + kNumEventsToRead]);
+
+    const StateChangeEventBuffer::SReadResult remainingResult = testEventBuffer.ReadOldestEvents(
+        UINT32_MAX, true, [](uint32_t, const StateChangeEventBuffer::SEvent&) -> void {});
+    TEST_ASSERT((kEventBufferCapacity - 1 - kNumEventsToRead) == remainingResult.count);
+    TEST_ASSERT(false == remainingResult.overflowed);
+    TEST_ASSERT(0 == testEventBuffer.GetCount());
+  }
+
+  // Verifies that an event buffer with a capacity of 1, which cannot hold any events, discards
+  // every appended event and indicates an overflow condition.
+  TEST_CASE(StateChangeEventBuffer_CapacityOne)
+  {
+    StateChangeEventBuffer testEventBuffer;
+    testEventBuffer.SetCapacity(1);
+
+    testEventBuffer.AppendEvent(kTestEventData[0], kTimestamp);
+    TEST_ASSERT(0 == testEventBuffer.GetCount());
+    TEST_ASSERT(true == testEventBuffer.IsOverflowed());
+  }
+
+  // Appends events on one thread while concurrently reading and removing them on another, with the
+  // producer always leaving enough room that no overflow occurs. Every event should be received
+  // exactly once and in order, and no overflow condition should ever be indicated.
+  TEST_CASE(StateChangeEventBuffer_Concurrent_NoOverflow)
+  {
+    constexpr uint32_t kEventBufferCapacity = 97;
+
+    StateChangeEventBuffer testEventBuffer;
+    testEventBuffer.SetCapacity(kEventBufferCapacity);
+
+    std::thread producer(StressTestProduceEvents, std::ref(testEventBuffer), true);
+
+    uint32_t nextExpectedValue = 0;
+    uint32_t lastSequenceSeen = 0;
+    bool overflowSeen = false;
+
+    for (uint32_t maxEventsToRead = 1; nextExpectedValue < kStressTestEventCount;
+         maxEventsToRead = ((maxEventsToRead % 150) + 1))
+    {
+      // Alternate between peeking and reading with removal, checking that peeking sees exactly
+      // the same events that are subsequently removed.
+      std::vector<int32_t> peekedValues;
+      const StateChangeEventBuffer::SReadResult peekResult = testEventBuffer.ReadOldestEvents(
+          maxEventsToRead,
+          false,
+          [&peekedValues](uint32_t index, const StateChangeEventBuffer::SEvent& event) -> void
+          {
+            peekedValues.resize(index);
+            peekedValues.push_back(event.data.value.axis);
+          });
+      TEST_ASSERT(peekResult.count == peekedValues.size());
+
+      const StateChangeEventBuffer::SReadResult popResult = testEventBuffer.ReadOldestEvents(
+          maxEventsToRead,
+          true,
+          [&](uint32_t index, const StateChangeEventBuffer::SEvent& event) -> void
+          {
+            TEST_ASSERT(event.data.value.axis == (int32_t)nextExpectedValue);
+            TEST_ASSERT((0 == nextExpectedValue) || (event.sequence > lastSequenceSeen));
+            if (index < peekedValues.size())
+              TEST_ASSERT(event.data.value.axis == peekedValues[index]);
+
+            lastSequenceSeen = event.sequence;
+            nextExpectedValue += 1;
+          });
+
+      TEST_ASSERT(popResult.count >= peekResult.count);
+      overflowSeen = (overflowSeen || peekResult.overflowed || popResult.overflowed);
+
+      if (0 == popResult.count) std::this_thread::yield();
+    }
+
+    producer.join();
+
+    TEST_ASSERT(kStressTestEventCount == nextExpectedValue);
+    TEST_ASSERT(0 == testEventBuffer.GetCount());
+    TEST_ASSERT(false == overflowSeen);
+  }
+
+  // Appends events on one thread as fast as possible while concurrently reading and removing them
+  // on another, using a buffer small enough that overflows occur. Events received should always be
+  // in order, each peek should see a contiguous run of events, every gap in the received events
+  // should be accompanied by an overflow indication, and the most recent event should always be
+  // retained.
+  TEST_CASE(StateChangeEventBuffer_Concurrent_Overflow)
+  {
+    constexpr uint32_t kEventBufferCapacity = 8;
+
+    StateChangeEventBuffer testEventBuffer;
+    testEventBuffer.SetCapacity(kEventBufferCapacity);
+
+    std::atomic<bool> producerFinished = false;
+    std::thread producer(
+        [&testEventBuffer, &producerFinished]() -> void
+        {
+          StressTestProduceEvents(testEventBuffer, false);
+          producerFinished = true;
+        });
+
+    int32_t lastValueSeen = -1;
+    bool gapSeen = false;
+    bool overflowSeen = false;
+
+    for (uint32_t maxEventsToRead = 1; true; maxEventsToRead = ((maxEventsToRead % 10) + 1))
+    {
+      const bool producerWasFinished = producerFinished;
+
+      std::vector<int32_t> peekedValues;
+      const StateChangeEventBuffer::SReadResult peekResult = testEventBuffer.ReadOldestEvents(
+          maxEventsToRead,
+          false,
+          [&peekedValues](uint32_t index, const StateChangeEventBuffer::SEvent& event) -> void
+          {
+            peekedValues.resize(index);
+            peekedValues.push_back(event.data.value.axis);
+          });
+
+      TEST_ASSERT(peekResult.count == peekedValues.size());
+      for (size_t i = 1; i < peekedValues.size(); ++i)
+        TEST_ASSERT(peekedValues[i] == (peekedValues[i - 1] + 1));
+
+      const StateChangeEventBuffer::SReadResult popResult = testEventBuffer.ReadOldestEvents(
+          maxEventsToRead,
+          true,
+          [&](uint32_t index, const StateChangeEventBuffer::SEvent& event) -> void
+          {
+            TEST_ASSERT(event.data.value.axis > lastValueSeen);
+            if (event.data.value.axis != (lastValueSeen + 1)) gapSeen = true;
+            lastValueSeen = event.data.value.axis;
+          });
+
+      overflowSeen = (overflowSeen || peekResult.overflowed || popResult.overflowed);
+      if (0 == popResult.count)
+      {
+        if (true == producerWasFinished) break;
+        std::this_thread::yield();
+      }
+    }
+
+    producer.join();
+
+    TEST_ASSERT((int32_t)(kStressTestEventCount - 1) == lastValueSeen);
+    TEST_ASSERT((false == gapSeen) || (true == overflowSeen) || testEventBuffer.IsOverflowed());
+  }
+
+  // Appends batches of events that are each larger than the capacity of the event buffer on one
+  // thread while concurrently removing events without reading them on another. The count should
+  // never exceed what the event buffer can hold, events that are peeked should always be in order,
+  // and once the producer is finished the event buffer should still be usable and hold exactly the
+  // most recent events.
+  TEST_CASE(StateChangeEventBuffer_Concurrent_BatchLargerThanCapacity)
+  {
+    constexpr uint32_t kEventBufferCapacity = 5;
+    constexpr uint32_t kBatchSize = 3 * kEventBufferCapacity;
+    constexpr uint32_t kBatchCount = kStressTestEventCount / kBatchSize;
+
+    StateChangeEventBuffer testEventBuffer;
+    testEventBuffer.SetCapacity(kEventBufferCapacity);
+
+    std::atomic<bool> producerFinished = false;
+    std::thread producer(
+        [&testEventBuffer, &producerFinished]() -> void
+        {
+          StateChangeEventBuffer::SEventData batch[kBatchSize];
+          int32_t nextValue = 0;
+
+          for (uint32_t batchIndex = 0; batchIndex < kBatchCount; ++batchIndex)
+          {
+            for (auto& eventData : batch)
+              eventData = {
+                  .element = {.type = EElementType::Axis, .axis = EAxis::X},
+                  .value = {.axis = nextValue++}};
+
+            testEventBuffer.AppendEvents(batch, kTimestamp);
+          }
+
+          producerFinished = true;
+        });
+
+    for (uint32_t numEventsToPop = 1; false == producerFinished;
+         numEventsToPop = ((numEventsToPop % 3) + 1))
+    {
+      TEST_ASSERT(testEventBuffer.GetCount() < kEventBufferCapacity);
+
+      int32_t lastValuePeeked = -1;
+      testEventBuffer.ReadOldestEvents(
+          kEventBufferCapacity,
+          false,
+          [&lastValuePeeked](uint32_t index, const StateChangeEventBuffer::SEvent& event) -> void
+          {
+            if (0 != index) TEST_ASSERT(event.data.value.axis == (lastValuePeeked + 1));
+            lastValuePeeked = event.data.value.axis;
+          });
+
+      testEventBuffer.PopOldestEvents(numEventsToPop);
+    }
+
+    producer.join();
+
+    const uint32_t remainingCount = testEventBuffer.GetCount();
+    TEST_ASSERT(remainingCount < kEventBufferCapacity);
+
+    const int32_t lastValueAppended = (int32_t)((kBatchCount * kBatchSize) - 1);
+    const StateChangeEventBuffer::SReadResult drainResult = testEventBuffer.ReadOldestEvents(
+        kEventBufferCapacity,
+        true,
+        [remainingCount, lastValueAppended](
+            uint32_t index, const StateChangeEventBuffer::SEvent& event) -> void
+        {
+          TEST_ASSERT(
+              event.data.value.axis ==
+              (lastValueAppended - (int32_t)(remainingCount - 1) + (int32_t)index));
+        });
+    TEST_ASSERT(remainingCount == drainResult.count);
+    TEST_ASSERT(0 == testEventBuffer.GetCount());
+
+    testEventBuffer.AppendEvent(kTestEventData[0], kTimestamp);
+    TEST_ASSERT(1 == testEventBuffer.GetCount());
+    TEST_ASSERT(kTestEventData[0] == testEventBuffer[0].data);
+  }
+
+  // Verifies that an overflow triggered after events are removed is not lost, even if the events
+  // were removed while the event buffer was overflowed.
+  TEST_CASE(StateChangeEventBuffer_OverflowAfterPopRetained)
+  {
+    constexpr uint32_t kEventBufferCapacity = 3;
+
+    StateChangeEventBuffer testEventBuffer;
+    testEventBuffer.SetCapacity(kEventBufferCapacity);
+
+    testEventBuffer.AppendEvents(std::span(kTestEventData, 3), kTimestamp);
+    TEST_ASSERT(true == testEventBuffer.IsOverflowed());
+
+    testEventBuffer.PopOldestEvents(1);
+    TEST_ASSERT(false == testEventBuffer.IsOverflowed());
+
+    testEventBuffer.AppendEvents(std::span(&kTestEventData[3], 2), kTimestamp);
+    TEST_ASSERT(true == testEventBuffer.IsOverflowed());
+    TEST_ASSERT(kTestEventData[4] == testEventBuffer[1].data);
+  }
+
   // Verifies correct behavior in the case of an overflow due to appending events and then shrinking
   // the buffer. The most recent events should remain, and the buffer should indicate an overflow
   // condition.
@@ -226,11 +603,36 @@ namespace XidiTest
     TEST_ASSERT(true == testEventBuffer.IsOverflowed());
 
     // Popping 0 events should be a no-op.
-    testEventBuffer.PopOldestEvents(0);
+    TEST_ASSERT(false == testEventBuffer.PopOldestEvents(0));
     TEST_ASSERT(true == testEventBuffer.IsOverflowed());
 
-    // Actually popping something is what is supposed to clear the overflow condition.
-    testEventBuffer.PopOldestEvents(1);
+    // Actually popping something is what is supposed to clear the overflow condition, and the
+    // overflow condition that was cleared should be reported.
+    TEST_ASSERT(true == testEventBuffer.PopOldestEvents(1));
+    TEST_ASSERT(false == testEventBuffer.IsOverflowed());
+
+    TEST_ASSERT(false == testEventBuffer.PopOldestEvents(1));
+  }
+
+  // Verifies that events discarded after being peeked but before being removed are reported as an
+  // overflow condition when they are removed, so that peeking and then removing events never loses
+  // events silently.
+  TEST_CASE(StateChangeEventBuffer_OverflowBetweenPeekAndPopReported)
+  {
+    constexpr uint32_t kEventBufferCapacity = 4;
+
+    StateChangeEventBuffer testEventBuffer;
+    testEventBuffer.SetCapacity(kEventBufferCapacity);
+
+    testEventBuffer.AppendEvents(std::span(kTestEventData, 2), kTimestamp);
+
+    const StateChangeEventBuffer::SReadResult peekResult = testEventBuffer.ReadOldestEvents(
+        2, false, [](uint32_t, const StateChangeEventBuffer::SEvent&) -> void {});
+    TEST_ASSERT(2 == peekResult.count);
+    TEST_ASSERT(false == peekResult.overflowed);
+
+    testEventBuffer.AppendEvents(std::span(&kTestEventData[2], 2), kTimestamp);
+    TEST_ASSERT(true == testEventBuffer.PopOldestEvents(peekResult.count));
     TEST_ASSERT(false == testEventBuffer.IsOverflowed());
   }
 
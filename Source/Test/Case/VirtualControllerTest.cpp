@@ -11,13 +11,18 @@
 
 #include "VirtualController.h"
 
+#include <atomic>
 #include <bitset>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <deque>
 #include <initializer_list>
+#include <limits>
 #include <memory>
 #include <optional>
+#include <thread>
+#include <vector>
 
 #include <Infra/Test/TestCase.h>
 
@@ -153,6 +158,53 @@ namespace XidiTest
     return controllerState[kTestSingleAxis];
   }
 
+  /// Transforms a raw axis value by computing the result directly from the supplied axis
+  /// properties, including a division. Used as the reference against which virtual controllers,
+  /// which instead use compiled axis transforms, are compared.
+  /// @param [in] axisValueRaw Raw axis value to transform.
+  /// @param [in] axisProperties Axis properties to apply.
+  /// @return Axis value that results from applying the transformation.
+  static int32_t ReferenceTransformAxisValue(
+      int32_t axisValueRaw, const VirtualController::SAxisProperties& axisProperties)
+  {
+    if (true != axisProperties.transformationsEnabled) return axisValueRaw;
+
+    int32_t oldRangeOrigin = 0;
+    int32_t oldRangeDispMax = 0;
+    int32_t newRangeDispMax = 0;
+
+    if (axisValueRaw > Controller::kAnalogValueNeutral)
+    {
+      if (axisValueRaw <= axisProperties.deadzoneRawCutoffPositive)
+        return axisProperties.rangeNeutral;
+      else if (axisValueRaw >= axisProperties.saturationRawCutoffPositive)
+        return axisProperties.rangeMax;
+
+      oldRangeOrigin = axisProperties.deadzoneRawCutoffPositive;
+      oldRangeDispMax = axisProperties.saturationRawCutoffPositive;
+      newRangeDispMax = axisProperties.rangeMax;
+    }
+    else
+    {
+      if (axisValueRaw >= axisProperties.deadzoneRawCutoffNegative)
+        return axisProperties.rangeNeutral;
+      else if (axisValueRaw <= axisProperties.saturationRawCutoffNegative)
+        return axisProperties.rangeMin;
+
+      oldRangeOrigin = axisProperties.deadzoneRawCutoffNegative;
+      oldRangeDispMax = axisProperties.saturationRawCutoffNegative;
+      newRangeDispMax = axisProperties.rangeMin;
+    }
+
+    const int64_t oldRangeValueDisp = (int64_t)axisValueRaw - (int64_t)oldRangeOrigin;
+    const int64_t newRangeMagnitudeMax =
+        (int64_t)newRangeDispMax - (int64_t)axisProperties.rangeNeutral;
+    const int64_t oldRangeMagnitudeMax = (int64_t)oldRangeDispMax - (int64_t)oldRangeOrigin;
+
+    return axisProperties.rangeNeutral +
+        (int32_t)((oldRangeValueDisp * newRangeMagnitudeMax) / oldRangeMagnitudeMax);
+  }
+
   /// Main test body for all axis property tests.
   /// Axis properties are deadzone, range, and saturation. The net result is to divide the expected
   /// output values into 5 regions. Region 1 is the negative saturation region, from extreme
@@ -325,7 +377,7 @@ namespace XidiTest
     for (int i = 0; i < _countof(kExpectedStates); ++i)
     {
       controller.RefreshState(
-          kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[i], kControllerIndex));
+          kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[i], kControllerIndex), i);
 
       const Controller::SState actualState = controller.GetState();
       TEST_ASSERT(actualState == kExpectedStates[i]);
@@ -383,7 +435,7 @@ namespace XidiTest
     for (const auto& expectedState : kExpectedStates)
     {
       controller.RefreshState(
-          kTestMapper.MapStatePhysicalToVirtual(kPhysicalState, kControllerIndex));
+          kTestMapper.MapStatePhysicalToVirtual(kPhysicalState, kControllerIndex), 0);
 
       const Controller::SState actualState = controller.GetState();
       TEST_ASSERT(actualState == expectedState);
@@ -438,13 +490,98 @@ namespace XidiTest
     for (int i = 0; i < _countof(kExpectedStates); ++i)
     {
       controller.RefreshState(
-          kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[i], kControllerIndex));
+          kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[i], kControllerIndex), i);
 
       const Controller::SState actualState = controller.GetState();
       TEST_ASSERT(actualState == kExpectedStates[i]);
     }
   }
 
+  // Verifies that retrieving a virtual controller's state does not wait for another thread that
+  // holds the virtual controller's lock, such as one that is in the middle of reading buffered
+  // events.
+  TEST_CASE(VirtualController_GetState_DoesNotWaitForLock)
+  {
+    MockPhysicalController physicalController(0, kTestMapper);
+    VirtualController controller(0);
+
+    std::atomic<bool> lockHeld = false;
+    std::atomic<bool> lockReleaseRequested = false;
+    std::thread lockHolderThread(
+        [&controller, &lockHeld, &lockReleaseRequested]() -> void
+        {
+          auto lock = controller.Lock();
+          lockHeld = true;
+
+          while (false == lockReleaseRequested)
+            std::this_thread::yield();
+        });
+
+    while (false == lockHeld)
+      std::this_thread::yield();
+
+    std::atomic<bool> stateRetrieved = false;
+    std::thread stateReaderThread(
+        [&controller, &stateRetrieved]() -> void
+        {
+          controller.GetState();
+          stateRetrieved = true;
+        });
+
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(kTestStateChangeEventTimeoutMilliseconds));
+    const bool stateRetrievedWhileLockHeld = stateRetrieved;
+
+    lockReleaseRequested = true;
+    lockHolderThread.join();
+    stateReaderThread.join();
+
+    TEST_ASSERT(true == stateRetrievedWhileLockHeld);
+  }
+
+  // Verifies that virtual controller states retrieved while another thread is refreshing the
+  // virtual controller's state are always complete and never a mixture of old and new states.
+  TEST_CASE(VirtualController_GetState_ConsistentWhileRefreshing)
+  {
+    constexpr int kRefreshCount = 100000;
+
+    MockPhysicalController physicalController(0, kTestMapper);
+    VirtualController controller(0);
+    controller.SetAllAxisRange(Controller::kAnalogValueMin, Controller::kAnalogValueMax);
+
+    std::atomic<bool> refreshFinished = false;
+    std::thread refreshThread(
+        [&controller, &refreshFinished]() -> void
+        {
+          for (int i = 0; i < kRefreshCount; ++i)
+          {
+            const int16_t axisValue = (int16_t)(i & 0x7fff);
+
+            Controller::SState newState = {};
+            newState[EAxis::X] = axisValue;
+            newState[EAxis::Y] = axisValue;
+            newState[EAxis::RotX] = axisValue;
+            newState[EAxis::RotY] = axisValue;
+            controller.RefreshState(newState, (uint32_t)i);
+          }
+
+          refreshFinished = true;
+        });
+
+    bool allStatesConsistent = true;
+    while (false == refreshFinished)
+    {
+      const Controller::SState actualState = controller.GetState();
+      if ((actualState[EAxis::X] != actualState[EAxis::Y]) ||
+          (actualState[EAxis::X] != actualState[EAxis::RotX]) ||
+          (actualState[EAxis::X] != actualState[EAxis::RotY]))
+        allStatesConsistent = false;
+    }
+
+    refreshThread.join();
+    TEST_ASSERT(true == allStatesConsistent);
+  }
+
   // Verifies that attempting to obtain a controller lock results in an object that does, in fact,
   // own the mutex with which it is associated.
   TEST_CASE(VirtualController_Lock)
@@ -591,6 +728,55 @@ namespace XidiTest
     }
   }
 
+  // Verifies that compiled axis transforms produce results identical to computing them directly
+  // from axis properties, over the entire domain of raw axis values. Covers a variety of deadzone,
+  // saturation, and range combinations, including those whose deadzone and saturation cutoffs meet
+  // or cross and those whose ranges are at the limits of what can be represented.
+  TEST_CASE(VirtualController_ApplyAxisProperties_MatchesReference)
+  {
+    constexpr uint32_t kTestDeadzones[] = {0, 1, 2500, 9999, 10000};
+    constexpr uint32_t kTestSaturations[] = {0, 1, 7500, 9999, 10000};
+    constexpr std::pair<int32_t, int32_t> kTestRanges[] = {
+        {VirtualController::kRangeMinDefault, VirtualController::kRangeMaxDefault},
+        {-1, 0},
+        {-1, 1},
+        {-10000000, 10000000},
+        {0, std::numeric_limits<int32_t>::max()},
+        {std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()}};
+
+    MockPhysicalController physicalController(0, kTestMapper);
+    VirtualController controller(0);
+
+    for (const auto& range : kTestRanges)
+    {
+      for (const uint32_t deadzone : kTestDeadzones)
+      {
+        for (const uint32_t saturation : kTestSaturations)
+        {
+          VirtualController::SAxisProperties axisProperties;
+          axisProperties.SetDeadzone(deadzone);
+          axisProperties.SetRange(range.first, range.second);
+          axisProperties.SetSaturation(saturation);
+
+          TEST_ASSERT(true == controller.SetAxisDeadzone(kTestSingleAxis, deadzone));
+          TEST_ASSERT(true == controller.SetAxisRange(kTestSingleAxis, range.first, range.second));
+          TEST_ASSERT(true == controller.SetAxisSaturation(kTestSingleAxis, saturation));
+
+          for (int32_t inputAxisValue = Controller::kAnalogValueMin;
+               inputAxisValue <= Controller::kAnalogValueMax;
+               ++inputAxisValue)
+          {
+            const int32_t expectedAxisValue =
+                ReferenceTransformAxisValue(inputAxisValue, axisProperties);
+            const int32_t actualAxisValue =
+                GetAxisPropertiesApplyResult(controller, inputAxisValue);
+            TEST_ASSERT(actualAxisValue == expectedAxisValue);
+          }
+        }
+      }
+    }
+  }
+
   // Valid deadzone value set on a single axis and then on all axes.
   TEST_CASE(VirtualController_SetProperty_DeadzoneValid)
   {
@@ -800,7 +986,7 @@ namespace XidiTest
     MockPhysicalController physicalController(0, kTestMapper);
     VirtualController controller(0);
 
-    controller.RefreshState(kTestMapper.MapStatePhysicalToVirtual(kPhysicalState, 0));
+    controller.RefreshState(kTestMapper.MapStatePhysicalToVirtual(kPhysicalState, 0), 0);
     controller.SetAllAxisRange(kTestOldAxisRangeMin, kTestOldAxisRangeMax);
     const Controller::SState actualStateBefore = controller.GetState();
     TEST_ASSERT(actualStateBefore == kExpectedStateBefore);
@@ -850,7 +1036,7 @@ namespace XidiTest
 
     for (int i = 0; i < _countof(kPhysicalStates); ++i)
       controller.RefreshState(
-          kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[i], kControllerIndex));
+          kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[i], kControllerIndex), i);
 
     TEST_ASSERT(0 == controller.GetEventBufferCount());
   }
@@ -909,7 +1095,7 @@ namespace XidiTest
       for (unsigned int j = 0; j < i; ++j)
       {
         controller.RefreshState(
-            kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[j], kControllerIndex));
+            kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[j], kControllerIndex), j);
 
         TEST_ASSERT(controller.GetEventBufferCount() > lastEventCount);
         lastEventCount = controller.GetEventBufferCount();
@@ -980,7 +1166,7 @@ namespace XidiTest
       for (unsigned int j = 0; j < i; ++j)
       {
         controller.RefreshState(
-            kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[j], kControllerIndex));
+            kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[j], kControllerIndex), j);
 
         TEST_ASSERT(controller.GetEventBufferCount() >= lastEventCount);
         lastEventCount = controller.GetEventBufferCount();
@@ -997,6 +1183,104 @@ namespace XidiTest
     }
   }
 
+  // Applies state updates that change many controller elements at once, with some controller
+  // elements filtered out, and verifies that each update generates exactly one event per changed
+  // unfiltered controller element. Events from the same update are expected in filter order, which
+  // is all axes, then all buttons, then the POV, and they share the timestamp supplied with the
+  // update and have consecutive sequence numbers.
+  TEST_CASE(VirtualController_EventBuffer_ManyElementsWithFilter)
+  {
+    constexpr TControllerIdentifier kControllerIndex = 0;
+    constexpr uint32_t kEventBufferCapacity = 256;
+
+    constexpr Controller::SElementIdentifier kFilteredElements[] = {
+        {.type = EElementType::Axis, .axis = EAxis::Y},
+        {.type = EElementType::Axis, .axis = EAxis::RotZ},
+        {.type = EElementType::Button, .button = EButton::B3},
+        {.type = EElementType::Button, .button = EButton::B10}};
+
+    constexpr Controller::SState kControllerStates[] = {
+        {.axis = {100, 200, 300, 400, 500, 600},
+         .button = 0b1111'1111'1111'1111,
+         .povDirection = {.components = {true, false, false, false}}},
+        {.axis = {100, -200, 300, -400, 500, -600},
+         .button = 0b1010'1010'1010'1010,
+         .povDirection = {.components = {true, false, false, false}}},
+        {.axis = {100, -200, 300, -400, 500, -600},
+         .button = 0b1010'1010'1010'1010,
+         .povDirection = {.components = {false, true, false, true}}},
+        {.axis = {0, 0, 0, 0, 0, 0}, .button = 0b0000'0010'0000'0100},
+        {.axis = {-32767, 32767, -32767, 32767, -32767, 32767},
+         .button = 0b0101'0101'0101'0101,
+         .povDirection = {.components = {false, false, true, false}}}};
+
+    MockPhysicalController physicalController(kControllerIndex, kTestMapper);
+    VirtualController controller(kControllerIndex);
+
+    controller.SetAllAxisRange(Controller::kAnalogValueMin, Controller::kAnalogValueMax);
+    controller.SetEventBufferCapacity(kEventBufferCapacity);
+    VirtualController::EventFilter expectedEventFilter;
+    for (const auto& filteredElement : kFilteredElements)
+    {
+      controller.EventFilterRemoveElement(filteredElement);
+      expectedEventFilter.Remove(filteredElement);
+    }
+
+    Controller::SState previousState = controller.GetState();
+    uint32_t timestamp = 1000;
+
+    for (const auto& controllerState : kControllerStates)
+    {
+      std::vector<StateChangeEventBuffer::SEventData> expectedEvents;
+
+      for (unsigned int i = 0; i < controllerState.axis.size(); ++i)
+      {
+        const Controller::SElementIdentifier element = {
+            .type = EElementType::Axis, .axis = (EAxis)i};
+        if ((previousState.axis[i] != controllerState.axis[i]) &&
+            (true == expectedEventFilter.Contains(element)))
+          expectedEvents.push_back(
+              {.element = element, .value = {.axis = controllerState.axis[i]}});
+      }
+
+      for (unsigned int i = 0; i < controllerState.button.size(); ++i)
+      {
+        const Controller::SElementIdentifier element = {
+            .type = EElementType::Button, .button = (EButton)i};
+        if ((previousState.button[i] != controllerState.button[i]) &&
+            (true == expectedEventFilter.Contains(element)))
+          expectedEvents.push_back(
+              {.element = element, .value = {.button = controllerState.button[i]}});
+      }
+
+      if (previousState.povDirection != controllerState.povDirection)
+        expectedEvents.push_back(
+            {.element = {.type = EElementType::Pov},
+             .value = {.povDirection = controllerState.povDirection}});
+
+      const uint32_t eventCountBefore = controller.GetEventBufferCount();
+      controller.RefreshState(controllerState, timestamp);
+      TEST_ASSERT(controller.GetState() == controllerState);
+      TEST_ASSERT(
+          (eventCountBefore + expectedEvents.size()) == controller.GetEventBufferCount());
+
+      for (unsigned int i = 0; i < expectedEvents.size(); ++i)
+      {
+        const StateChangeEventBuffer::SEvent& firstEvent =
+            controller.GetEventBufferEvent(eventCountBefore);
+        const StateChangeEventBuffer::SEvent& actualEvent =
+            controller.GetEventBufferEvent(eventCountBefore + i);
+
+        TEST_ASSERT(actualEvent.data == expectedEvents[i]);
+        TEST_ASSERT(actualEvent.timestamp == timestamp);
+        TEST_ASSERT(actualEvent.sequence == (firstEvent.sequence + i));
+      }
+
+      previousState = controllerState;
+      timestamp += 10;
+    }
+  }
+
   // Submits multiple physical state changes to the physical controller associated with a virtual
   // controller such that every single physical state change causes a virtual controller state
   // change. Enables state change notifications and verifies that each physical controller state
@@ -1037,6 +1321,53 @@ namespace XidiTest
     }
   }
 
+  // Submits multiple physical state changes to the physical controller associated with a virtual
+  // controller, with the event buffer enabled, and verifies that the events generated by each
+  // physical state change carry the timestamp at which that physical state was sampled rather than
+  // the time at which it was dispatched. The mock physical controller uses the index of each
+  // physical state as its sample timestamp.
+  TEST_CASE(VirtualController_EventBuffer_SampleTimestamps)
+  {
+    constexpr TControllerIdentifier kControllerIndex = 2;
+    constexpr uint32_t kEventBufferCapacity = 64;
+
+    // All of the buttons used in these physical states are part of the test mapper defined at the
+    // top of this file.
+    constexpr SPhysicalState kPhysicalStates[] = {
+        {.deviceStatus = EPhysicalDeviceStatus::Ok},
+        {.deviceStatus = EPhysicalDeviceStatus::Ok, .button = ButtonSet({EPhysicalButton::A})},
+        {.deviceStatus = EPhysicalDeviceStatus::Ok,
+         .button = ButtonSet({EPhysicalButton::A, EPhysicalButton::B})},
+        {.deviceStatus = EPhysicalDeviceStatus::Ok, .button = ButtonSet({EPhysicalButton::B})},
+        {.deviceStatus = EPhysicalDeviceStatus::Ok}};
+
+    const HANDLE stateChangeEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    TEST_ASSERT((nullptr != stateChangeEvent) && (INVALID_HANDLE_VALUE != stateChangeEvent));
+
+    MockPhysicalController physicalController(
+        kControllerIndex, kTestMapper, kPhysicalStates, _countof(kPhysicalStates));
+
+    VirtualController controller(kControllerIndex);
+    controller.SetEventBufferCapacity(kEventBufferCapacity);
+    controller.SetStateChangeEvent(stateChangeEvent);
+
+    for (uint32_t i = 1; i < _countof(kPhysicalStates); ++i)
+    {
+      const uint32_t eventCountBefore = controller.GetEventBufferCount();
+
+      physicalController.RequestAdvancePhysicalState();
+      TEST_ASSERT(
+          WAIT_OBJECT_0 ==
+          WaitForSingleObject(stateChangeEvent, kTestStateChangeEventTimeoutMilliseconds));
+
+      const uint32_t eventCountAfter = controller.GetEventBufferCount();
+      TEST_ASSERT(eventCountAfter > eventCountBefore);
+
+      for (uint32_t j = eventCountBefore; j < eventCountAfter; ++j)
+        TEST_ASSERT(i == controller.GetEventBufferEvent(j).timestamp);
+    }
+  }
+
   // Submits multiple physical state changes to the physical controller associated with a virtual
   // controller such that every other physical state change causes a virtual controller state
   // change. Enables state change notifications and verifies that each physical controller state
@@ -1096,6 +1427,123 @@ namespace XidiTest
     }
   }
 
+  // Submits multiple physical state changes to the physical controller associated with a virtual
+  // controller, each of which would cause a virtual controller state change, but only some of
+  // which are accompanied by a new packet number. Verifies that notifications are only fired for
+  // the physical states with new packet numbers, since the others are skipped without being mapped.
+  TEST_CASE(VirtualController_StateChangeNotification_UnchangedPacketNumber)
+  {
+    constexpr TControllerIdentifier kControllerIndex = 1;
+
+    constexpr SPhysicalState kPhysicalStates[] = {
+        {.deviceStatus = EPhysicalDeviceStatus::Ok},
+        {.deviceStatus = EPhysicalDeviceStatus::Ok, .button = ButtonSet({EPhysicalButton::A})},
+        {.deviceStatus = EPhysicalDeviceStatus::Ok,
+         .button = ButtonSet({EPhysicalButton::A, EPhysicalButton::B})},
+        {.deviceStatus = EPhysicalDeviceStatus::Ok, .button = ButtonSet({EPhysicalButton::B})},
+        {.deviceStatus = EPhysicalDeviceStatus::Ok}};
+    static_assert(
+        0 != (_countof(kPhysicalStates) % 2),
+        "An even number of states is required beyond the initial physical state.");
+
+    const HANDLE stateChangeEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    TEST_ASSERT((nullptr != stateChangeEvent) && (INVALID_HANDLE_VALUE != stateChangeEvent));
+
+    MockPhysicalController physicalController(
+        kControllerIndex, kTestMapper, kPhysicalStates, _countof(kPhysicalStates));
+
+    VirtualController controller(kControllerIndex);
+    controller.SetAllAxisRange(Controller::kAnalogValueMin, Controller::kAnalogValueMax);
+    controller.SetStateChangeEvent(stateChangeEvent);
+
+    for (int i = 1; i < _countof(kPhysicalStates); i += 2)
+    {
+      physicalController.RequestAdvancePhysicalState(false);
+      TEST_ASSERT(
+          WAIT_TIMEOUT ==
+          WaitForSingleObject(stateChangeEvent, kTestStateChangeEventTimeoutMilliseconds));
+
+      physicalController.RequestAdvancePhysicalState(true);
+      TEST_ASSERT(
+          WAIT_OBJECT_0 ==
+          WaitForSingleObject(stateChangeEvent, kTestStateChangeEventTimeoutMilliseconds));
+      TEST_ASSERT(
+          controller.GetState() ==
+          kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[i + 1], kControllerIndex));
+    }
+  }
+
+  // Creates multiple virtual controllers associated with the same physical controller, all of
+  // which share a single background thread, and submits physical state changes to that physical
+  // controller. Verifies that every virtual controller is notified of every state change, including
+  // virtual controllers created after some state changes have already happened, and that the
+  // remaining virtual controllers continue to be notified after one of them is destroyed.
+  TEST_CASE(VirtualController_StateChangeNotification_MultipleVirtualControllers)
+  {
+    constexpr TControllerIdentifier kControllerIndex = 3;
+
+    constexpr SPhysicalState kPhysicalStates[] = {
+        {.deviceStatus = EPhysicalDeviceStatus::Ok},
+        {.deviceStatus = EPhysicalDeviceStatus::Ok, .button = ButtonSet({EPhysicalButton::A})},
+        {.deviceStatus = EPhysicalDeviceStatus::Ok,
+         .button = ButtonSet({EPhysicalButton::A, EPhysicalButton::B})},
+        {.deviceStatus = EPhysicalDeviceStatus::Ok, .button = ButtonSet({EPhysicalButton::B})},
+        {.deviceStatus = EPhysicalDeviceStatus::Ok}};
+
+    MockPhysicalController physicalController(
+        kControllerIndex, kTestMapper, kPhysicalStates, _countof(kPhysicalStates));
+
+    std::unique_ptr<VirtualController> controllers[3];
+    HANDLE stateChangeEvents[_countof(controllers)];
+
+    for (int i = 0; i < _countof(controllers); ++i)
+    {
+      stateChangeEvents[i] = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+      TEST_ASSERT(
+          (nullptr != stateChangeEvents[i]) && (INVALID_HANDLE_VALUE != stateChangeEvents[i]));
+    }
+
+    for (int i = 0; i < (_countof(controllers) - 1); ++i)
+    {
+      controllers[i] = std::make_unique<VirtualController>(kControllerIndex);
+      controllers[i]->SetAllAxisRange(Controller::kAnalogValueMin, Controller::kAnalogValueMax);
+      controllers[i]->SetStateChangeEvent(stateChangeEvents[i]);
+    }
+
+    for (int i = 1; i < _countof(kPhysicalStates); ++i)
+    {
+      // One virtual controller is created late and another is destroyed early, in both cases
+      // while the others are still receiving state changes.
+      if (2 == i)
+      {
+        controllers[2] = std::make_unique<VirtualController>(kControllerIndex);
+        controllers[2]->SetAllAxisRange(Controller::kAnalogValueMin, Controller::kAnalogValueMax);
+        controllers[2]->SetStateChangeEvent(stateChangeEvents[2]);
+        TEST_ASSERT(
+            controllers[2]->GetState() ==
+            kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[1], kControllerIndex));
+      }
+      else if (3 == i)
+      {
+        controllers[0] = nullptr;
+      }
+
+      physicalController.RequestAdvancePhysicalState();
+
+      for (int j = 0; j < _countof(controllers); ++j)
+      {
+        if (nullptr == controllers[j]) continue;
+
+        TEST_ASSERT(
+            WAIT_OBJECT_0 ==
+            WaitForSingleObject(stateChangeEvents[j], kTestStateChangeEventTimeoutMilliseconds));
+        TEST_ASSERT(
+            controllers[j]->GetState() ==
+            kTestMapper.MapStatePhysicalToVirtual(kPhysicalStates[i], kControllerIndex));
+      }
+    }
+  }
+
   // Verifies that a single virtual controller can register and unregister successfully, and this
   // changes the device pointer it returns.
   TEST_CASE(VirtualController_ForceFeedback_Nominal)
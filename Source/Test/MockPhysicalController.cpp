@@ -51,6 +51,14 @@ namespace XidiTest
         kMockPhysicalStateCount(mockPhysicalStateCount),
         currentPhysicalStateIndex(0),
         advanceRequested(false),
+        advancePacketNumberRequested(false),
+        currentPacketNumber(0),
+        packetFilter(),
+        publishedPhysicalState(),
+        publishedRawVirtualState(),
+        physicalStateGeneration(0),
+        rawVirtualStateGeneration(0),
+        sampleHistory(),
         forceFeedbackDevice(0),
         mapper(mapper),
         forceFeedbackRegistration()
@@ -68,6 +76,10 @@ namespace XidiTest
           controllerIdentifier);
 
     mockPhysicalController[kControllerIdentifier] = this;
+    ConsumeCurrentPacket();
+
+    publishedPhysicalState = GetCurrentPhysicalState();
+    publishedRawVirtualState = GetCurrentRawVirtualState();
   }
 
   MockPhysicalController::~MockPhysicalController(void)
@@ -85,7 +97,18 @@ namespace XidiTest
           kControllerIdentifier);
 
     currentPhysicalStateIndex += 1;
+    if (true == advancePacketNumberRequested) currentPacketNumber += 1;
+
     advanceRequested = false;
+    advancePacketNumberRequested = false;
+  }
+
+  void MockPhysicalController::AppendCurrentSampleToHistory(void)
+  {
+    sampleHistory.Append(
+        {.timestamp = (uint32_t)currentPhysicalStateIndex,
+         .physicalState = GetCurrentPhysicalState(),
+         .rawVirtualState = GetCurrentRawVirtualState()});
   }
 
   SCapabilities MockPhysicalController::GetControllerCapabilities(void) const
@@ -105,7 +128,24 @@ namespace XidiTest
     return mapper.MapStatePhysicalToVirtual(GetCurrentPhysicalState(), kControllerIdentifier);
   }
 
-  void MockPhysicalController::RequestAdvancePhysicalState(void)
+  void MockPhysicalController::PublishCurrentState(void)
+  {
+    const SPhysicalState currentPhysicalState = GetCurrentPhysicalState();
+    if (currentPhysicalState != publishedPhysicalState)
+    {
+      publishedPhysicalState = currentPhysicalState;
+      physicalStateGeneration += 1;
+    }
+
+    const SState currentRawVirtualState = GetCurrentRawVirtualState();
+    if (currentRawVirtualState != publishedRawVirtualState)
+    {
+      publishedRawVirtualState = currentRawVirtualState;
+      rawVirtualStateGeneration += 1;
+    }
+  }
+
+  void MockPhysicalController::RequestAdvancePhysicalState(bool advancePacketNumber)
   {
     std::unique_lock lock(mockPhysicalStateGuard[kControllerIdentifier]);
 
@@ -122,6 +162,7 @@ namespace XidiTest
           kControllerIdentifier);
 
     advanceRequested = true;
+    advancePacketNumberRequested = advancePacketNumber;
   }
 } // namespace XidiTest
 
@@ -182,6 +223,60 @@ namespace Xidi
             controllerIdentifier);
     }
 
+    TControllerStateGeneration GetPhysicalControllerStateGeneration(
+        TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount)
+        TEST_FAILED_BECAUSE(
+            L"%s: Invalid controller identifier (%u).", __FUNCTIONW__, controllerIdentifier);
+
+      std::shared_lock lock(mockPhysicalStateGuard[controllerIdentifier]);
+
+      if (nullptr != mockPhysicalController[controllerIdentifier])
+        return mockPhysicalController[controllerIdentifier]->GetPhysicalStateGeneration();
+      else
+        TEST_FAILED_BECAUSE(
+            L"%s: No mock physical controller associated with identifier %u.",
+            __FUNCTIONW__,
+            controllerIdentifier);
+    }
+
+    TControllerStateGeneration GetRawVirtualControllerStateGeneration(
+        TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount)
+        TEST_FAILED_BECAUSE(
+            L"%s: Invalid controller identifier (%u).", __FUNCTIONW__, controllerIdentifier);
+
+      std::shared_lock lock(mockPhysicalStateGuard[controllerIdentifier]);
+
+      if (nullptr != mockPhysicalController[controllerIdentifier])
+        return mockPhysicalController[controllerIdentifier]->GetRawVirtualStateGeneration();
+      else
+        TEST_FAILED_BECAUSE(
+            L"%s: No mock physical controller associated with identifier %u.",
+            __FUNCTIONW__,
+            controllerIdentifier);
+    }
+
+    TPhysicalSampleHistoryCursor GetPhysicalControllerSampleHistoryCursor(
+        TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount)
+        TEST_FAILED_BECAUSE(
+            L"%s: Invalid controller identifier (%u).", __FUNCTIONW__, controllerIdentifier);
+
+      std::shared_lock lock(mockPhysicalStateGuard[controllerIdentifier]);
+
+      if (nullptr != mockPhysicalController[controllerIdentifier])
+        return mockPhysicalController[controllerIdentifier]->GetSampleHistory().GetWriteCursor();
+      else
+        TEST_FAILED_BECAUSE(
+            L"%s: No mock physical controller associated with identifier %u.",
+            __FUNCTIONW__,
+            controllerIdentifier);
+    }
+
     ForceFeedback::Device* PhysicalControllerForceFeedbackRegister(
         TControllerIdentifier controllerIdentifier, const VirtualController* virtualController)
     {
@@ -201,6 +296,14 @@ namespace Xidi
       return nullptr;
     }
 
+    void PhysicalControllerForceFeedbackNotifyEffectStarted(
+        TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount)
+        TEST_FAILED_BECAUSE(
+            L"%s: Invalid controller identifier (%u).", __FUNCTIONW__, controllerIdentifier);
+    }
+
     void PhysicalControllerForceFeedbackUnregister(
         TControllerIdentifier controllerIdentifier, const VirtualController* virtualController)
     {
@@ -217,8 +320,50 @@ namespace Xidi
       }
     }
 
+    void PhysicalControllerNotifyInUse(TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount)
+        TEST_FAILED_BECAUSE(
+            L"%s: Invalid controller identifier (%u).", __FUNCTIONW__, controllerIdentifier);
+    }
+
+    void PhysicalControllerStateChangeNotificationRegister(
+        TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount)
+        TEST_FAILED_BECAUSE(
+            L"%s: Invalid controller identifier (%u).", __FUNCTIONW__, controllerIdentifier);
+    }
+
+    void PhysicalControllerStateChangeNotificationUnregister(
+        TControllerIdentifier controllerIdentifier)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount)
+        TEST_FAILED_BECAUSE(
+            L"%s: Invalid controller identifier (%u).", __FUNCTIONW__, controllerIdentifier);
+    }
+
+    bool ReadPhysicalControllerSampleHistory(
+        TControllerIdentifier controllerIdentifier,
+        TPhysicalSampleHistoryCursor& cursor,
+        SPhysicalSample& sample)
+    {
+      if (controllerIdentifier >= kPhysicalControllerCount)
+        TEST_FAILED_BECAUSE(
+            L"%s: Invalid controller identifier (%u).", __FUNCTIONW__, controllerIdentifier);
+
+      std::shared_lock lock(mockPhysicalStateGuard[controllerIdentifier]);
+
+      if (nullptr != mockPhysicalController[controllerIdentifier])
+        return mockPhysicalController[controllerIdentifier]->GetSampleHistory().Read(
+            cursor, sample);
+
+      return false;
+    }
+
     bool WaitForPhysicalControllerStateChange(
         TControllerIdentifier controllerIdentifier,
+        TControllerStateGeneration& lastKnownGeneration,
         SPhysicalState& state,
         std::stop_token stopToken)
     {
@@ -239,14 +384,20 @@ namespace Xidi
             if (mockPhysicalController[controllerIdentifier]->IsAdvanceStateRequested())
             {
               mockPhysicalController[controllerIdentifier]->AdvancePhysicalState();
+              if (false == mockPhysicalController[controllerIdentifier]->ConsumeCurrentPacket())
+                continue;
+
+              mockPhysicalController[controllerIdentifier]->AppendCurrentSampleToHistory();
+              mockPhysicalController[controllerIdentifier]->PublishCurrentState();
+            }
 
-              SPhysicalState newState =
-                  mockPhysicalController[controllerIdentifier]->GetCurrentPhysicalState();
-              if (newState != state)
-              {
-                state = newState;
-                return true;
-              }
+            const TControllerStateGeneration currentGeneration =
+                mockPhysicalController[controllerIdentifier]->GetPhysicalStateGeneration();
+            if (currentGeneration != lastKnownGeneration)
+            {
+              lastKnownGeneration = currentGeneration;
+              state = mockPhysicalController[controllerIdentifier]->GetCurrentPhysicalState();
+              return true;
             }
           }
         }
@@ -256,7 +407,10 @@ namespace Xidi
     }
 
     bool WaitForRawVirtualControllerStateChange(
-        TControllerIdentifier controllerIdentifier, SState& state, std::stop_token stopToken)
+        TControllerIdentifier controllerIdentifier,
+        TControllerStateGeneration& lastKnownGeneration,
+        SState& state,
+        std::stop_token stopToken)
     {
       if (controllerIdentifier >= kPhysicalControllerCount)
         TEST_FAILED_BECAUSE(
@@ -275,14 +429,20 @@ namespace Xidi
             if (mockPhysicalController[controllerIdentifier]->IsAdvanceStateRequested())
             {
               mockPhysicalController[controllerIdentifier]->AdvancePhysicalState();
+              if (false == mockPhysicalController[controllerIdentifier]->ConsumeCurrentPacket())
+                continue;
 
-              SState newState =
-                  mockPhysicalController[controllerIdentifier]->GetCurrentRawVirtualState();
-              if (newState != state)
-              {
-                state = newState;
-                return true;
-              }
+              mockPhysicalController[controllerIdentifier]->AppendCurrentSampleToHistory();
+              mockPhysicalController[controllerIdentifier]->PublishCurrentState();
+            }
+
+            const TControllerStateGeneration currentGeneration =
+                mockPhysicalController[controllerIdentifier]->GetRawVirtualStateGeneration();
+            if (currentGeneration != lastKnownGeneration)
+            {
+              lastKnownGeneration = currentGeneration;
+              state = mockPhysicalController[controllerIdentifier]->GetCurrentRawVirtualState();
+              return true;
             }
           }
         }
@@ -11,194 +11,420 @@
 
 #include "VirtualController.h"
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstdint>
+#include <mutex>
+#include <span>
 #include <stop_token>
 #include <thread>
+#include <vector>
 
 #include <Infra/Core/Message.h>
 
 #include "ControllerTypes.h"
 #include "ForceFeedbackTypes.h"
 #include "ImportApiWinMM.h"
+#include "LatencyInstrumentation.h"
 #include "Mapper.h"
 #include "PhysicalController.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define XIDI_VIRTUAL_CONTROLLER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Xidi
 {
   namespace Controller
   {
-    /// Maps a value in one range to its corresponding value in another range.
-    /// Ranges are specified as origin values and displacements, essentially one-dimensional vectors
-    /// with direction either positive (maximum displacement value is greater than origin value) or
-    /// negative (maximum displacement value is less than origin value). It is not necessary that
-    /// the direction of the vectors be the same for both old and new range.
-    /// @param [in] oldRangeValue Raw value to transform in the old range.
-    /// @param [in] oldRangeOrigin Origin value of the old range.
-    /// @param [in] oldRangeDispMax Maximum displacement value in the old range.
-    /// @param [in] newRangeOrigin Origin value of the new range.
-    /// @param [in] newRangeDispMax Maximum displacement value in the new range.
-    /// @return Result of mapping the input value from the old range to the new range.
-    static inline int32_t MapValueInRangeToRange(
-        int32_t oldRangeValue,
-        int32_t oldRangeOrigin,
-        int32_t oldRangeDispMax,
-        int32_t newRangeOrigin,
-        int32_t newRangeDispMax)
-    {
-      const int64_t oldRangeValueDisp = (int64_t)oldRangeValue - (int64_t)oldRangeOrigin;
-      const int64_t newRangeMagnitudeMax = (int64_t)newRangeDispMax - (int64_t)newRangeOrigin;
-      const int64_t oldRangeMagnitudeMax = (int64_t)oldRangeDispMax - (int64_t)oldRangeOrigin;
-
-      return newRangeOrigin +
-          (int32_t)((oldRangeValueDisp * newRangeMagnitudeMax) / oldRangeMagnitudeMax);
-    }
-
-    /// Monitors for changes in an associated physical controller's state and, on state change,
-    /// causes a virtual controller to refresh its state. Intended to be the entry point for
-    /// per-virtual-controller background threads.
-    /// @param [in] thisController Controller object for which state is to be monitored.
-    /// @param [in] initialState Initial physical state of the controller. Used as the basis for
-    /// looking for changes.
-    /// @param [in] stopMonitoringToken Used to indicate that the monitoring should stop and the
-    /// thread should exit.
-    static void MonitorPhysicalControllerState(
-        VirtualController* thisController,
-        const SState& initialState,
-        std::stop_token stopMonitoringToken)
-    {
-      const TControllerIdentifier controllerIdentifier = thisController->GetIdentifier();
-      SState state = initialState;
-
-      while (false == stopMonitoringToken.stop_requested())
+    /// Fans out state changes of a single physical controller to all of the virtual controllers
+    /// associated with it. Applications and middleware often create many virtual controller objects
+    /// for the same physical controller, so all of them are serviced by one background thread that
+    /// exists only while at least one virtual controller is subscribed.
+    class PhysicalControllerStateDispatcher
+    {
+    public:
+
+      /// Subscribes the specified virtual controller to state changes, starting the background
+      /// thread if this is the first subscriber. Before this method returns, the virtual controller
+      /// is brought up to date with the most recent state that was dispatched. Concurrency-safe.
+      /// @param [in] virtualController Virtual controller to subscribe.
+      void Subscribe(VirtualController* virtualController)
+      {
+        std::scoped_lock lifecycleLock(lifecycleMutex);
+
+        if (false == dispatchThread.joinable())
+        {
+          // The generation is obtained first so that any change published while the remaining
+          // starting points are obtained causes the background thread to wake up and catch up.
+          const TControllerIdentifier controllerIdentifier = virtualController->GetIdentifier();
+          const TControllerStateGeneration initialStateGeneration =
+              GetRawVirtualControllerStateGeneration(controllerIdentifier);
+          const TPhysicalSampleHistoryCursor initialSampleHistoryCursor =
+              GetPhysicalControllerSampleHistoryCursor(controllerIdentifier);
+
+          dispatchedState = GetCurrentRawVirtualControllerState(controllerIdentifier);
+          dispatchedTimestamp = ImportApiWinMM::timeGetTime();
+          dispatchThread = std::jthread(
+              [this, controllerIdentifier, initialStateGeneration, initialSampleHistoryCursor](
+                  std::stop_token stopToken) -> void
+              {
+                DispatchStateChanges(
+                    controllerIdentifier,
+                    initialStateGeneration,
+                    initialSampleHistoryCursor,
+                    stopToken);
+              });
+
+          Infra::Message::OutputFormatted(
+              Infra::Message::ESeverity::Info,
+              L"Started dispatching state changes to virtual controllers with identifier %u.",
+              (1 + controllerIdentifier));
+        }
+
+        std::scoped_lock subscriberLock(subscriberMutex);
+        virtualController->RefreshState(dispatchedState, dispatchedTimestamp);
+        subscribers.push_back(virtualController);
+      }
+
+      /// Unsubscribes the specified virtual controller from state changes, stopping the background
+      /// thread if no subscribers remain. Once this method returns, no further state changes are
+      /// dispatched to the virtual controller. Concurrency-safe.
+      /// @param [in] virtualController Virtual controller to unsubscribe.
+      void Unsubscribe(VirtualController* virtualController)
+      {
+        std::scoped_lock lifecycleLock(lifecycleMutex);
+        bool subscribersRemain = true;
+
+        {
+          std::scoped_lock subscriberLock(subscriberMutex);
+          std::erase(subscribers, virtualController);
+          subscribersRemain = (false == subscribers.empty());
+        }
+
+        // The background thread does not acquire the lifecycle mutex, so it can be joined while
+        // holding it. Doing so prevents a concurrent subscriber from starting a second thread.
+        if (false == subscribersRemain)
+        {
+          dispatchThread.request_stop();
+          dispatchThread.join();
+
+          Infra::Message::OutputFormatted(
+              Infra::Message::ESeverity::Info,
+              L"Stopped dispatching state changes to virtual controllers with identifier %u.",
+              (1 + virtualController->GetIdentifier()));
+        }
+      }
+
+    private:
+
+      /// Waits for changes in the physical controller's state and, on state change, causes all
+      /// subscribed virtual controllers to refresh their states. Entry point for the background
+      /// thread.
+      /// @param [in] controllerIdentifier Identifier of the physical controller to monitor.
+      /// @param [in] initialStateGeneration Generation of the physical controller's raw virtual
+      /// state as of when the initial dispatched state was obtained.
+      /// @param [in] initialSampleHistoryCursor Position in the physical controller's sample
+      /// history as of when the initial dispatched state was obtained.
+      /// @param [in] stopToken Used to indicate that dispatching should stop and the thread should
+      /// exit.
+      void DispatchStateChanges(
+          TControllerIdentifier controllerIdentifier,
+          TControllerStateGeneration initialStateGeneration,
+          TPhysicalSampleHistoryCursor initialSampleHistoryCursor,
+          std::stop_token stopToken)
       {
-        if (true ==
-            WaitForRawVirtualControllerStateChange(
-                controllerIdentifier, state, stopMonitoringToken))
+        SState state;
+        TControllerStateGeneration stateGeneration = initialStateGeneration;
+        TPhysicalSampleHistoryCursor sampleHistoryCursor = initialSampleHistoryCursor;
+        std::vector<SPhysicalSample> pendingSamples;
+
+        while (false == stopToken.stop_requested())
         {
-          if (true == thisController->RefreshState(state)) thisController->SignalStateChangeEvent();
+          // Waking up is based on generation rather than on the state itself, so a change that is
+          // undone before this thread observes it still results in a dispatch.
+          if (false ==
+              WaitForRawVirtualControllerStateChange(
+                  controllerIdentifier, stateGeneration, state, stopToken))
+            continue;
+
+          // Every sample recorded since the last dispatch is applied in order, so that changes
+          // that were superseded before this thread woke up, such as quick button taps, still
+          // generate buffered events stamped with the time at which they were sampled. Samples are
+          // recorded before they are published, so the history is always at least as new as the
+          // state that ended the wait. If the history has nothing to offer then all of its samples
+          // were already dispatched during a previous wake-up.
+          SPhysicalSample sample;
+          pendingSamples.clear();
+
+          while (true ==
+                 ReadPhysicalControllerSampleHistory(
+                     controllerIdentifier, sampleHistoryCursor, sample))
+            pendingSamples.push_back(sample);
+
+          if (true == pendingSamples.empty()) continue;
+
+          std::scoped_lock subscriberLock(subscriberMutex);
+
+          for (VirtualController* subscriber : subscribers)
+          {
+            bool stateChanged = false;
+
+            for (const SPhysicalSample& pendingSample : pendingSamples)
+              if (true ==
+                  subscriber->RefreshState(pendingSample.rawVirtualState, pendingSample.timestamp))
+                stateChanged = true;
+
+            if (true == stateChanged) subscriber->SignalStateChangeEvent();
+          }
+
+          dispatchedState = pendingSamples.back().rawVirtualState;
+          dispatchedTimestamp = pendingSamples.back().timestamp;
         }
       }
+
+      /// Serializes subscribing and unsubscribing, which start and stop the background thread.
+      std::mutex lifecycleMutex;
+
+      /// Protects the subscribers and the most recently dispatched state. Held by the background
+      /// thread while it dispatches state changes.
+      std::mutex subscriberMutex;
+
+      /// Virtual controllers to which state changes are dispatched.
+      std::vector<VirtualController*> subscribers;
+
+      /// Most recent raw virtual controller state dispatched to subscribers. Used to bring new
+      /// subscribers up to date.
+      SState dispatchedState;
+
+      /// Time at which the most recently dispatched raw virtual controller state was sampled.
+      uint32_t dispatchedTimestamp;
+
+      /// Background thread that dispatches state changes, which exists only while there are
+      /// subscribers.
+      std::jthread dispatchThread;
+    };
+
+    /// Retrieves the state change dispatcher for the specified physical controller. Dispatchers
+    /// are created on first use and never destroyed, because destroying one might require joining
+    /// its background thread, which is unsafe during process or library teardown.
+    /// @param [in] controllerIdentifier Identifier of the physical controller of interest.
+    /// @return Reference to the state change dispatcher.
+    static PhysicalControllerStateDispatcher& GetStateDispatcher(
+        TControllerIdentifier controllerIdentifier)
+    {
+      static PhysicalControllerStateDispatcher* const stateDispatchers =
+          new PhysicalControllerStateDispatcher[kPhysicalControllerCount];
+      return stateDispatchers[controllerIdentifier];
+    }
+
+    /// Computes a mask of the axes whose values differ between two virtual controller state
+    /// objects.
+    /// @param [in] oldState Old controller state.
+    /// @param [in] newState New controller state.
+    /// @return Mask with one bit per axis, in which set bits identify axes whose values differ.
+    static inline uint64_t ChangedAxisMask(const SState& oldState, const SState& newState)
+    {
+#ifdef XIDI_VIRTUAL_CONTROLLER_USE_SSE2
+      static_assert(6 == (int)EAxis::Count, "Axis comparison assumes exactly six axes.");
+
+      // Two overlapping loads cover all six axes. Lanes 0-3 come from the first and lanes 2-5 from
+      // the second, so the overlapping lanes are simply compared twice.
+      const __m128i oldLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&oldState.axis[0]));
+      const __m128i oldHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&oldState.axis[2]));
+      const __m128i newLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&newState.axis[0]));
+      const __m128i newHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&newState.axis[2]));
+
+      const unsigned int equalLow =
+          (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(oldLow, newLow)));
+      const unsigned int equalHigh =
+          (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(oldHigh, newHigh)));
+
+      return (uint64_t)(~(equalLow | (equalHigh << 2)) & 0b111111);
+#else
+      uint64_t changedAxisMask = 0;
+
+      for (unsigned int i = 0; i < oldState.axis.size(); ++i)
+        changedAxisMask |= (uint64_t)(oldState.axis[i] != newState.axis[i]) << i;
+
+      return changedAxisMask;
+#endif
     }
 
     /// Looks for differences between two virtual controller state objects and submits them as
     /// events to the specified event buffer. Events are only submitted if the associated virtual
-    /// controller element is included in the event filter.
+    /// controller element is included in the event filter. Differences are computed for all
+    /// controller elements at once as a mask whose layout matches the event filter, and the events
+    /// that remain after filtering are submitted to the event buffer together.
     /// @param [in] oldState Old controller state, the baseline.
     /// @param [in] newState New controller state, which is compared with the old controller state.
     /// If different, controller element values submitted to the event buffer come from this object.
     /// @param [in] eventFilter Filter which specifies which virtual controller elements are allowed
     /// to generate events.
     /// @param [in,out] eventBuffer Event buffer object to which events are submitted.
+    /// @param [in] timestamp Timestamp to apply to all submitted events.
     static inline void SubmitStateChangeEvents(
         const SState& oldState,
         const SState& newState,
         const VirtualController::EventFilter& eventFilter,
-        StateChangeEventBuffer& eventBuffer)
+        StateChangeEventBuffer& eventBuffer,
+        uint32_t timestamp)
     {
+      using EventFilter = VirtualController::EventFilter;
+
       if (true == eventBuffer.IsEnabled())
       {
-        const uint32_t timestamp = ImportApiWinMM::timeGetTime();
+        const uint64_t changedElementMask =
+            (ChangedAxisMask(oldState, newState) << EventFilter::kBaseIndexAxis) |
+            ((oldState.button ^ newState.button).to_ullong() << EventFilter::kBaseIndexButton) |
+            ((uint64_t)(oldState.povDirection.all != newState.povDirection.all)
+             << EventFilter::kBaseIndexPov);
 
-        for (unsigned int i = 0; i < oldState.axis.size(); ++i)
-        {
-          if (oldState.axis[i] != newState.axis[i])
-          {
-            const SElementIdentifier axisElement = {.type = EElementType::Axis, .axis = (EAxis)i};
+        uint64_t eventElementMask = eventFilter.Apply(changedElementMask);
+        if (0 == eventElementMask) return;
 
-            if (eventFilter.Contains(axisElement))
-              eventBuffer.AppendEvent(
-                  {.element = axisElement, .value = {.axis = newState.axis[i]}}, timestamp);
-          }
-        }
+        std::array<StateChangeEventBuffer::SEventData, EventFilter::kElementCount> events;
+        unsigned int eventCount = 0;
 
-        for (unsigned int i = 0; i < oldState.button.size(); ++i)
+        for (; 0 != eventElementMask; eventElementMask &= (eventElementMask - 1))
         {
-          if (oldState.button[i] != newState.button[i])
-          {
-            const SElementIdentifier buttonElement = {
-                .type = EElementType::Button, .button = (EButton)i};
+          const unsigned int index = (unsigned int)std::countr_zero(eventElementMask);
 
-            if (eventFilter.Contains(buttonElement))
-              eventBuffer.AppendEvent(
-                  {.element = buttonElement, .value = {.button = newState.button[i]}}, timestamp);
+          if (index < EventFilter::kBaseIndexButton)
+          {
+            const unsigned int axis = index - EventFilter::kBaseIndexAxis;
+            events[eventCount++] = {
+                .element = {.type = EElementType::Axis, .axis = (EAxis)axis},
+                .value = {.axis = newState.axis[axis]}};
+          }
+          else if (index < EventFilter::kBaseIndexPov)
+          {
+            const unsigned int button = index - EventFilter::kBaseIndexButton;
+            events[eventCount++] = {
+                .element = {.type = EElementType::Button, .button = (EButton)button},
+                .value = {.button = newState.button[button]}};
+          }
+          else
+          {
+            events[eventCount++] = {
+                .element = {.type = EElementType::Pov},
+                .value = {.povDirection = {.all = newState.povDirection.all}}};
           }
         }
 
-        if (oldState.povDirection.all != newState.povDirection.all)
-        {
-          const SElementIdentifier povElement = {.type = EElementType::Pov};
-
-          if (eventFilter.Contains(povElement))
-            eventBuffer.AppendEvent(
-                {.element = povElement,
-                 .value = {.povDirection = {.all = newState.povDirection.all}}},
-                timestamp);
-        }
+        eventBuffer.AppendEvents(std::span(events.data(), eventCount), timestamp);
       }
     }
 
-    /// Transforms a raw axis value using the supplied axis properties.
-    /// @param [in] axisValueRaw Raw axis value as obtained from a mapper.
-    /// @param [in] axisProperties Axis properties to apply.
-    /// @return Axis value that results from applying the transformation.
-    static int32_t TransformAxisValue(
-        int32_t axisValueRaw, const VirtualController::SAxisProperties& axisProperties)
+    /// Number of fractional bits in the fixed-point reciprocal of the raw distance between the
+    /// deadzone and saturation cutoffs. Raw distances are at most 2^15, and the products divided by
+    /// them are always less than the square of the raw distance, so this many bits make every
+    /// quotient exact without overflowing 64 bits.
+    static constexpr unsigned int kRawDistanceReciprocalBits = 45;
+
+    /// Compiles the coefficients for transforming raw axis values on one side of the neutral
+    /// position.
+    /// @param [in] deadzoneRawCutoff Raw analog value on this side at which the deadzone region
+    /// ends.
+    /// @param [in] saturationRawCutoff Raw analog value on this side at which the saturation region
+    /// begins.
+    /// @param [in] rangeNeutral Reportable value for raw values within the deadzone region.
+    /// @param [in] rangeExtreme Reportable value for raw values within the saturation region.
+    /// @param [in] direction Either 1 or -1, based on whether this is the positive or negative
+    /// side.
+    /// @return Compiled coefficients for the side.
+    static VirtualController::SAxisTransform::SSide CompileAxisTransformSide(
+        int32_t deadzoneRawCutoff,
+        int32_t saturationRawCutoff,
+        int32_t rangeNeutral,
+        int32_t rangeExtreme,
+        int32_t direction)
     {
-      if (true != axisProperties.transformationsEnabled) return axisValueRaw;
+      const uint64_t rawDistance = (uint64_t)std::max<int64_t>(
+          1, ((int64_t)saturationRawCutoff - (int64_t)deadzoneRawCutoff) * direction);
+      const uint64_t rangeDistance =
+          (uint64_t)(((int64_t)rangeExtreme - (int64_t)rangeNeutral) * direction);
+
+      return {
+          .deadzoneRawCutoff = deadzoneRawCutoff,
+          .direction = direction,
+          .rawDistance = (uint32_t)rawDistance,
+          .wholeStep = rangeDistance / rawDistance,
+          .fractionStep = rangeDistance % rawDistance,
+          .rawDistanceReciprocal =
+              (((uint64_t)1 << kRawDistanceReciprocalBits) + rawDistance - 1) / rawDistance};
+    }
 
-      if (axisValueRaw > kAnalogValueNeutral)
-      {
-        if (axisValueRaw <= axisProperties.deadzoneRawCutoffPositive)
-          return axisProperties.rangeNeutral;
-        else if (axisValueRaw >= axisProperties.saturationRawCutoffPositive)
-          return axisProperties.rangeMax;
-        else
-          return MapValueInRangeToRange(
-              axisValueRaw,
+    /// Compiles the supplied axis properties into a transform.
+    /// @param [in] axisProperties Axis properties to compile.
+    /// @return Compiled axis transform.
+    static VirtualController::SAxisTransform CompileAxisTransform(
+        const VirtualController::SAxisProperties& axisProperties)
+    {
+      return {
+          .transformationsEnabled = axisProperties.transformationsEnabled,
+          .rangeNeutral = axisProperties.rangeNeutral,
+          .positive = CompileAxisTransformSide(
               axisProperties.deadzoneRawCutoffPositive,
               axisProperties.saturationRawCutoffPositive,
               axisProperties.rangeNeutral,
-              axisProperties.rangeMax);
-      }
-      else
-      {
-        if (axisValueRaw >= axisProperties.deadzoneRawCutoffNegative)
-          return axisProperties.rangeNeutral;
-        else if (axisValueRaw <= axisProperties.saturationRawCutoffNegative)
-          return axisProperties.rangeMin;
-        else
-          return MapValueInRangeToRange(
-              axisValueRaw,
+              axisProperties.rangeMax,
+              1),
+          .negative = CompileAxisTransformSide(
               axisProperties.deadzoneRawCutoffNegative,
               axisProperties.saturationRawCutoffNegative,
               axisProperties.rangeNeutral,
-              axisProperties.rangeMin);
-      }
+              axisProperties.rangeMin,
+              -1)};
+    }
+
+    /// Transforms a raw axis value using the supplied compiled axis transform. Raw values within
+    /// the deadzone region report neutral, raw values within the saturation region report the
+    /// range extreme, and raw values in between are linearly scaled from neutral to the range
+    /// extreme, rounding towards neutral.
+    /// @param [in] axisValueRaw Raw axis value as obtained from a mapper.
+    /// @param [in] axisTransform Compiled axis transform to apply.
+    /// @return Axis value that results from applying the transformation.
+    static inline int32_t TransformAxisValue(
+        int32_t axisValueRaw, const VirtualController::SAxisTransform& axisTransform)
+    {
+      if (true != axisTransform.transformationsEnabled) return axisValueRaw;
+
+      const VirtualController::SAxisTransform::SSide& side =
+          ((axisValueRaw > kAnalogValueNeutral) ? axisTransform.positive : axisTransform.negative);
+
+      const uint64_t rawDistance = (uint64_t)std::clamp<int64_t>(
+          ((int64_t)axisValueRaw - (int64_t)side.deadzoneRawCutoff) * side.direction,
+          0,
+          side.rawDistance);
+      const uint64_t rangeDistance = (rawDistance * side.wholeStep) +
+          (((rawDistance * side.fractionStep) * side.rawDistanceReciprocal) >>
+           kRawDistanceReciprocalBits);
+
+      return (int32_t)(
+          (int64_t)axisTransform.rangeNeutral + ((int64_t)rangeDistance * side.direction));
     }
 
     VirtualController::VirtualController(TControllerIdentifier controllerId)
         : kControllerIdentifier(controllerId),
           controllerMutex(),
+          eventBufferConsumerMutex(),
           eventBuffer(),
           eventFilter(),
           properties(),
+          axisTransforms(),
           stateRaw(),
           stateProcessed(),
+          undeliveredSampleTimestamps(),
           stateChangeEventHandle(NULL),
-          physicalControllerMonitor(),
-          physicalControllerMonitorStop(),
+          cachedCapabilities(),
+          cachedCapabilitiesMapperSetGeneration(kCapabilitiesNotCached),
           physicalControllerForceFeedbackBuffer()
     {
-      const SState initialState = GetCurrentRawVirtualControllerState(kControllerIdentifier);
-
-      RefreshState(initialState);
       ReapplyProperties();
-
-      physicalControllerMonitor = std::thread(
-          MonitorPhysicalControllerState,
-          this,
-          initialState,
-          physicalControllerMonitorStop.get_token());
+      GetStateDispatcher(kControllerIdentifier).Subscribe(this);
 
       Infra::Message::OutputFormatted(
           Infra::Message::ESeverity::Info,
@@ -209,9 +435,8 @@ namespace Xidi
     VirtualController::~VirtualController(void)
     {
       ForceFeedbackUnregister();
-
-      physicalControllerMonitorStop.request_stop();
-      physicalControllerMonitor.join();
+      SetStateChangeEvent(NULL);
+      GetStateDispatcher(kControllerIdentifier).Unsubscribe(this);
 
       Infra::Message::OutputFormatted(
           Infra::Message::ESeverity::Info,
@@ -221,15 +446,21 @@ namespace Xidi
 
     void VirtualController::ApplyProperties(SState& controllerState) const
     {
-      const SCapabilities capabilities = GetCapabilities();
+      const SCapabilities& capabilities = GetCachedCapabilities();
 
       for (int i = 0; i < capabilities.numAxes; ++i)
       {
         const EAxis axis = capabilities.axisCapabilities[i].type;
-        controllerState[axis] = TransformAxisValue(controllerState[axis], properties[axis]);
+        controllerState[axis] =
+            TransformAxisValue(controllerState[axis], axisTransforms[static_cast<int>(axis)]);
       }
     }
 
+    void VirtualController::ForceFeedbackNotifyEffectStarted(void) const
+    {
+      PhysicalControllerForceFeedbackNotifyEffectStarted(kControllerIdentifier);
+    }
+
     bool VirtualController::ForceFeedbackRegister(void)
     {
       auto lock = Lock();
@@ -249,6 +480,20 @@ namespace Xidi
       physicalControllerForceFeedbackBuffer = nullptr;
     }
 
+    const SCapabilities& VirtualController::GetCachedCapabilities(void) const
+    {
+      // The generation is read before the capabilities are obtained, so a mapper set published
+      // in between is detected the next time.
+      const uint64_t publishedGeneration = MapperSet::GetPublishedGeneration();
+      if (publishedGeneration != cachedCapabilitiesMapperSetGeneration)
+      {
+        cachedCapabilities = GetCapabilities();
+        cachedCapabilitiesMapperSetGeneration = publishedGeneration;
+      }
+
+      return cachedCapabilities;
+    }
+
     SCapabilities VirtualController::GetCapabilities(void) const
     {
       return GetControllerCapabilities(kControllerIdentifier);
@@ -256,23 +501,63 @@ namespace Xidi
 
     SState VirtualController::GetState(void)
     {
+      NotifyPhysicalControllerInUse();
+
+      if (false == Latency::IsEnabled()) return stateProcessed.Get();
+
+      // The processed state and the timestamps of the sample that produced it are only ever
+      // updated together while holding this virtual controller's lock, so reading the state under
+      // the same lock guarantees that delivery is attributed to the sample actually returned.
       auto lock = Lock();
-      return stateProcessed;
+      const SState deliveredState = stateProcessed.Get();
+      RecordLatencyApplicationDelivery();
+      return deliveredState;
     }
 
-    void VirtualController::PopEventBufferOldestEvents(uint32_t numEventsToPop)
+    void VirtualController::NotifyPhysicalControllerInUse(void) const
     {
-      auto lock = Lock();
-      eventBuffer.PopOldestEvents(numEventsToPop);
+      PhysicalControllerNotifyInUse(kControllerIdentifier);
+    }
+
+    bool VirtualController::PopEventBufferOldestEvents(uint32_t numEventsToPop)
+    {
+      NotifyPhysicalControllerInUse();
+
+      std::unique_lock consumerLock(eventBufferConsumerMutex);
+      const bool overflowed = eventBuffer.PopOldestEvents(numEventsToPop);
+      consumerLock.unlock();
+
+      if ((numEventsToPop > 0) && (true == Latency::IsEnabled()))
+      {
+        auto lock = Lock();
+        RecordLatencyApplicationDelivery();
+      }
+
+      return overflowed;
+    }
+
+    void VirtualController::RecordLatencyApplicationDelivery(void)
+    {
+      if (false == Latency::IsEnabled()) return;
+
+      // Only the first delivery of each refreshed state is measured. Subsequent reads of the same
+      // state would otherwise be dominated by how often the application polls.
+      Latency::RecordApplicationDelivery(
+          kControllerIdentifier, undeliveredSampleTimestamps, Latency::Now());
+      undeliveredSampleTimestamps = Latency::SSampleTimestamps();
     }
 
     void VirtualController::ReapplyProperties(void)
     {
-      stateProcessed = stateRaw;
-      ApplyProperties(stateProcessed);
+      for (size_t i = 0; i < axisTransforms.size(); ++i)
+        axisTransforms[i] = CompileAxisTransform(properties.axis[i]);
+
+      SState newStateProcessed = stateRaw;
+      ApplyProperties(newStateProcessed);
+      stateProcessed.Set(newStateProcessed);
     }
 
-    bool VirtualController::RefreshState(SState newStateRaw)
+    bool VirtualController::RefreshState(SState newStateRaw, uint32_t timestamp)
     {
       auto lock = Lock();
       stateRaw = newStateRaw;
@@ -285,10 +570,23 @@ namespace Xidi
       // deadzone might result in filtering out changes in analog stick position, or if a particular
       // XInput controller element is ignored by the mapper then a change in that element does not
       // influence the virtual controller state.
-      if (newStateProcessed == stateProcessed) return false;
+      // Only this virtual controller's lock holder ever writes the processed state, so this read
+      // never needs to retry. The new processed state is published before events are submitted so
+      // that the buffered events never describe a state newer than the one reported as current.
+      const SState oldStateProcessed = stateProcessed.Get();
+      if (newStateProcessed == oldStateProcessed) return false;
+
+      stateProcessed.Set(newStateProcessed);
+      SubmitStateChangeEvents(
+          oldStateProcessed, newStateProcessed, eventFilter, eventBuffer, timestamp);
+
+      if (true == Latency::IsEnabled())
+      {
+        undeliveredSampleTimestamps = Latency::GetPublishedSampleTimestamps(kControllerIdentifier);
+        undeliveredSampleTimestamps.refreshed = Latency::Now();
+        Latency::RecordVirtualRefresh(kControllerIdentifier, undeliveredSampleTimestamps);
+      }
 
-      SubmitStateChangeEvents(stateProcessed, newStateProcessed, eventFilter, eventBuffer);
-      stateProcessed = newStateProcessed;
       return true;
     }
 
@@ -408,7 +706,10 @@ namespace Xidi
     {
       if (capacity != eventBuffer.GetCapacity())
       {
+        // Changing the capacity requires exclusive access to the event buffer, so both the producer
+        // and the consumer need to be excluded.
         auto lock = Lock();
+        std::scoped_lock consumerLock(eventBufferConsumerMutex);
         eventBuffer.SetCapacity(capacity);
       }
 
@@ -430,6 +731,16 @@ namespace Xidi
 
     void VirtualController::SetStateChangeEvent(HANDLE eventHandle)
     {
+      auto lock = Lock();
+
+      // An application waiting on the state change event might not read this virtual controller
+      // again until the event is signalled, so the physical controller must not be parked while
+      // the event is set.
+      if ((NULL == stateChangeEventHandle) && (NULL != eventHandle))
+        PhysicalControllerStateChangeNotificationRegister(kControllerIdentifier);
+      else if ((NULL != stateChangeEventHandle) && (NULL == eventHandle))
+        PhysicalControllerStateChangeNotificationUnregister(kControllerIdentifier);
+
       stateChangeEventHandle = eventHandle;
     }
 
@@ -32,6 +32,7 @@
 #include "ForceFeedbackTypes.h"
 #include "Globals.h"
 #include "PhysicalController.h"
+#include "StateChangeEventBuffer.h"
 #include "Strings.h"
 #include "VirtualController.h"
 #include "VirtualDirectInputEffect.h"
@@ -1697,50 +1698,62 @@ namespace Xidi
     if (false == controller->IsEventBufferEnabled())
       LOG_INVOCATION_AND_RETURN(DIERR_NOTBUFFERED, kMethodSeverityForError);
 
-    auto lock = controller->Lock();
-    const DWORD numEventsAffected = std::min(*pdwInOut, (DWORD)controller->GetEventBufferCount());
-    const bool eventBufferOverflowed = controller->IsEventBufferOverflowed();
+    // Events are read without acquiring the controller's lock, so retrieving buffered events never
+    // waits for state refreshes in progress on other threads. If the oldest events are discarded
+    // while peeking, the same indices can be filled in again from the new oldest event. Events are
+    // always peeked and only removed once they have all been copied out successfully, so that a
+    // failure does not lose them.
     const bool shouldPopEvents = (0 == (dwFlags & DIGDD_PEEK));
-
-    if (nullptr != rgdod)
-    {
-      for (DWORD i = 0; i < numEventsAffected; ++i)
-      {
-        const Controller::StateChangeEventBuffer::SEvent& event =
-            controller->GetEventBufferEvent(i);
-        ZeroMemory(&rgdod[i], sizeof(rgdod[i]));
-        rgdod[i].dwOfs = dataFormat->GetOffsetForElement(event.data.element)
-                             .value(); // A value should always be present.
-        rgdod[i].dwTimeStamp = event.timestamp;
-        rgdod[i].dwSequence = event.sequence;
-
-        switch (event.data.element.type)
-        {
-          case Controller::EElementType::Axis:
-            rgdod[i].dwData = (DWORD)DataFormat::DirectInputAxisValue(event.data.value.axis);
-            break;
-
-          case Controller::EElementType::Button:
-            rgdod[i].dwData = (DWORD)DataFormat::DirectInputButtonValue(event.data.value.button);
-            break;
-
-          case Controller::EElementType::Pov:
-            rgdod[i].dwData = (DWORD)DataFormat::DirectInputPovValue(event.data.value.povDirection);
-            break;
-
-          default:
-            LOG_INVOCATION_AND_RETURN(
-                DIERR_GENERIC, kMethodSeverityForError); // This should never happen.
-            break;
-        }
-      }
-    }
-
-    if (true == shouldPopEvents) controller->PopEventBufferOldestEvents(numEventsAffected);
-
-    *pdwInOut = numEventsAffected;
-    LOG_INVOCATION_AND_RETURN(
-        ((true == eventBufferOverflowed) ? DI_BUFFEROVERFLOW : DI_OK), kMethodSeverity);
+    bool eventElementTypeInvalid = false;
+
+    const Controller::StateChangeEventBuffer::SReadResult readResult =
+        controller->ReadEventBufferOldestEvents(
+            *pdwInOut,
+            false,
+            [this, rgdod, &eventElementTypeInvalid](
+                DWORD i, const Controller::StateChangeEventBuffer::SEvent& event) -> void
+            {
+              if (nullptr == rgdod) return;
+
+              ZeroMemory(&rgdod[i], sizeof(rgdod[i]));
+              rgdod[i].dwOfs = dataFormat->GetOffsetForElement(event.data.element)
+                                   .value(); // A value should always be present.
+              rgdod[i].dwTimeStamp = event.timestamp;
+              rgdod[i].dwSequence = event.sequence;
+
+              switch (event.data.element.type)
+              {
+                case Controller::EElementType::Axis:
+                  rgdod[i].dwData = (DWORD)DataFormat::DirectInputAxisValue(event.data.value.axis);
+                  break;
+
+                case Controller::EElementType::Button:
+                  rgdod[i].dwData =
+                      (DWORD)DataFormat::DirectInputButtonValue(event.data.value.button);
+                  break;
+
+                case Controller::EElementType::Pov:
+                  rgdod[i].dwData =
+                      (DWORD)DataFormat::DirectInputPovValue(event.data.value.povDirection);
+                  break;
+
+                default:
+                  eventElementTypeInvalid = true; // This should never happen.
+                  break;
+              }
+            });
+
+    if (true == eventElementTypeInvalid)
+      LOG_INVOCATION_AND_RETURN(DIERR_GENERIC, kMethodSeverityForError);
+
+    // If more events were discarded between peeking and removing them, the overflow condition
+    // present at removal reports the loss, because removing events clears it.
+    bool overflowed = readResult.overflowed;
+    if ((true == shouldPopEvents) && (readResult.count > 0))
+      overflowed = controller->PopEventBufferOldestEvents(readResult.count);
+
+    *pdwInOut = (DWORD)readResult.count;
+    LOG_INVOCATION_AND_RETURN(((true == overflowed) ? DI_BUFFEROVERFLOW : DI_OK), kMethodSeverity);
   }
 
   template <EDirectInputVersion diVersion> HRESULT
@@ -1775,11 +1788,10 @@ namespace Xidi
         (cbData < dataFormat->GetPacketSizeBytes()))
       LOG_INVOCATION_AND_RETURN(DIERR_INVALIDPARAM, kMethodSeverityForError);
 
-    bool writeDataPacketResult = false;
-    {
-      auto lock = controller->Lock();
-      writeDataPacketResult = dataFormat->WriteDataPacket(lpvData, cbData, controller->GetState());
-    }
+    // The controller's state is retrieved as a consistent snapshot, so there is no need to hold the
+    // controller's lock while writing the data packet.
+    const bool writeDataPacketResult =
+        dataFormat->WriteDataPacket(lpvData, cbData, controller->GetState());
     LOG_INVOCATION_AND_RETURN(
         ((true == writeDataPacketResult) ? DI_OK : DIERR_INVALIDPARAM), kMethodSeverity);
   }
@@ -672,6 +672,8 @@ namespace Xidi
             (1 + associatedDevice.GetVirtualController().GetIdentifier()));
         return DIERR_GENERIC;
       }
+
+      associatedDevice.GetVirtualController().ForceFeedbackNotifyEffectStarted();
     }
 
     return DI_OK;
@@ -721,6 +723,7 @@ namespace Xidi
       return DIERR_GENERIC;
     }
 
+    associatedDevice.GetVirtualController().ForceFeedbackNotifyEffectStarted();
     return DI_OK;
   }
 
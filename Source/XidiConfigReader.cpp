@@ -65,6 +65,9 @@ namespace Xidi
                   Strings::kStrConfigurationSettingLogEnabled, EValueType::Boolean),
               ConfigurationFileLayoutNameAndValueType(
                   Strings::kStrConfigurationSettingLogLevel, EValueType::Integer),
+              ConfigurationFileLayoutNameAndValueType(
+                  Strings::kStrConfigurationSettingLogLatencyReportIntervalSeconds,
+                  EValueType::Integer),
           }),
       ConfigurationFileLayoutSection(
           Strings::kStrConfigurationSectionMapper,
@@ -81,6 +84,28 @@ namespace Xidi
               ConfigurationFileLayoutNameAndValueType(
                   Strings::kStrConfigurationSettingPropertiesMouseSpeedScalingFactorPercent,
                   EValueType::Integer),
+              ConfigurationFileLayoutNameAndValueType(
+                  Strings::kStrConfigurationSettingPropertiesPollingPeriodFastMilliseconds,
+                  EValueType::Integer),
+              ConfigurationFileLayoutNameAndValueType(
+                  Strings::kStrConfigurationSettingPropertiesPollingPeriodSlowMilliseconds,
+                  EValueType::Integer),
+              ConfigurationFileLayoutNameAndValueType(
+                  Strings::kStrConfigurationSettingPropertiesPollingPeriodDecayMilliseconds,
+                  EValueType::Integer),
+              ConfigurationFileLayoutNameAndValueType(
+                  Strings::kStrConfigurationSettingPropertiesParkAfterInactivityMilliseconds,
+                  EValueType::Integer),
+              ConfigurationFileLayoutNameAndValueType(
+                  Strings::kStrConfigurationSettingPropertiesPhysicalControllerSource,
+                  EValueType::String),
+              ConfigurationFileLayoutNameAndValueType(
+                  Strings::kStrConfigurationSettingPropertiesSyntheticSampleRateHz,
+                  EValueType::Integer),
+              ConfigurationFileLayoutNameAndValueType(
+                  Strings::kStrConfigurationSettingPropertiesReplayFile, EValueType::String),
+              ConfigurationFileLayoutNameAndValueType(
+                  Strings::kStrConfigurationSettingPropertiesRecordFile, EValueType::String),
               ConfigurationFileLayoutNameAndValueType(
                   Strings::kStrConfigurationSettingsPropertiesUseBuiltinProperties,
                   EValueType::Boolean),